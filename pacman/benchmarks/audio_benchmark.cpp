@@ -0,0 +1,219 @@
+#include "benchmark.h"
+#include "audio/audio_cache.h"
+#include "audio/music_stream.h"
+#include "audio/software_audio_backend.h"
+#include "audio/waveloader.h"
+#include "job_system.h"
+#include "config.h"
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+/* Length of the music track, about as long as the game's theme */
+constexpr unsigned TRACK_SECONDS = 80u;
+
+/* Updates per simulated second while the track plays */
+constexpr unsigned UPDATES_PER_SECOND = 60u;
+
+/* Sound effects in the cache, every other one is authored at half the mix frequency in 8-bit so it has to be resampled */
+constexpr unsigned CACHE_SOUNDS = 32u;
+constexpr float CACHE_SOUND_SECONDS = 1.5f;
+
+float milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*!
+ * \brief write_wav writes a WAV file of a 440Hz tone in integer PCM
+ * \return false if the file could not be written
+ */
+bool write_wav(const std::string& fp, uint32_t frequency, uint16_t channels, uint16_t bits, uint32_t frames)
+{
+    const uint32_t block_align = channels * bits / 8u;
+    const uint32_t data_bytes = frames * block_align;
+
+    std::vector<uint8_t> bytes(44u + data_bytes);
+    const auto write_u16 = [&bytes](std::size_t at, uint16_t value) {
+        bytes[at] = static_cast<uint8_t>(value);
+        bytes[at + 1u] = static_cast<uint8_t>(value >> 8u);
+    };
+    const auto write_u32 = [&write_u16](std::size_t at, uint32_t value) {
+        write_u16(at, static_cast<uint16_t>(value));
+        write_u16(at + 2u, static_cast<uint16_t>(value >> 16u));
+    };
+
+    std::memcpy(bytes.data(), "RIFF", 4u);
+    write_u32(4u, 36u + data_bytes);
+    std::memcpy(bytes.data() + 8, "WAVEfmt ", 8u);
+    write_u32(16u, 16u);
+    write_u16(20u, 1u);
+    write_u16(22u, channels);
+    write_u32(24u, frequency);
+    write_u32(28u, frequency * block_align);
+    write_u16(32u, static_cast<uint16_t>(block_align));
+    write_u16(34u, bits);
+    std::memcpy(bytes.data() + 36, "data", 4u);
+    write_u32(40u, data_bytes);
+
+    for (uint32_t frame = 0u; frame < frames; ++frame)
+    {
+        const auto sample = 0.5f * std::sin(2.f * 3.14159265f * 440.f * frame / frequency);
+        for (uint16_t channel = 0u; channel < channels; ++channel)
+        {
+            const auto at = 44u + frame * block_align + channel * bits / 8u;
+            if (bits == 8u)
+            {
+                bytes[at] = static_cast<uint8_t>(128.f + sample * 127.f);
+            }
+            else
+            {
+                write_u16(at, static_cast<uint16_t>(static_cast<int16_t>(sample * 32767.f)));
+            }
+        }
+    }
+
+    std::ofstream file(fp, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+/*!
+ * \brief benchmark_music_stream writes a music track, and loads it whole into a buffer the way music was loaded before it was
+ * streamed and opens it as a MusicStream, logging the time and resident memory of each. Then it plays the stream to the end on
+ * a software backend paced by the simulation, and logs the time spent refilling per update and the underruns.
+ */
+void benchmark_music_stream()
+{
+    const auto fp = (std::filesystem::temp_directory_path() / "pac_benchmark_music.wav").string();
+    if (!write_wav(fp, AUDIO_MIX_FREQUENCY, 2u, 16u, AUDIO_MIX_FREQUENCY * TRACK_SECONDS))
+    {
+        GFX_WARN("Can not benchmark music streaming, %s could not be written.", fp.c_str());
+        return;
+    }
+
+    SoftwareAudioBackend backend{{}, true};
+
+    /* The whole track in one buffer */
+    auto start = std::chrono::steady_clock::now();
+    std::size_t whole_bytes = 0u;
+    {
+        const loadio::WaveFile wave(fp);
+        const auto buffer = backend.create_buffer();
+        backend.set_buffer_data(buffer, wave.getFormat(), wave.data(), wave.size());
+        whole_bytes = wave.size();
+        backend.delete_buffer(buffer);
+    }
+    const auto whole_ms = milliseconds_since(start);
+
+    /* Streamed through a ring of small buffers */
+    MusicStream stream{};
+    start = std::chrono::steady_clock::now();
+    if (!stream.open(backend, fp))
+    {
+        GFX_WARN("Can not benchmark music streaming, %s could not be opened.", fp.c_str());
+        return;
+    }
+    const auto open_ms = milliseconds_since(start);
+    GFX_INFO("Music track of %us: %.3fms and %.1fKiB to load whole, %.3fms and %.1fKiB to open as a stream.", TRACK_SECONDS,
+             whole_ms, whole_bytes / 1024.f, open_ms, stream.get_resident_bytes() / 1024.f);
+
+    /* Played to the end, refilling after every update like the streaming thread does */
+    const auto source = backend.create_source();
+    stream.start(source, false);
+    unsigned updates = 0u;
+    float update_ms = 0.f;
+    float peak_update_ms = 0.f;
+    while (!stream.is_finished() && updates < (TRACK_SECONDS + 1u) * UPDATES_PER_SECOND)
+    {
+        backend.advance(1.f / UPDATES_PER_SECOND);
+        start = std::chrono::steady_clock::now();
+        stream.update();
+        const auto ms = milliseconds_since(start);
+        update_ms += ms;
+        peak_update_ms = std::max(peak_update_ms, ms);
+        ++updates;
+    }
+    const auto finished = stream.is_finished();
+    stream.stop();
+    backend.delete_source(source);
+
+    GFX_INFO("Streamed it in %u updates: %.4fms per update, %.4fms at most, %u underruns%s.", updates,
+             updates > 0u ? update_ms / updates : 0.f, peak_update_ms, stream.get_underruns(),
+             finished ? "" : " (it did not finish)");
+    std::filesystem::remove(fp);
+}
+
+/*!
+ * \brief benchmark_audio_cache writes sound effects in two formats, converts them into an audio cache the way the first start
+ * (or a changed sound) does and loads the saved cache the way every other start does, and logs the time of each
+ */
+void benchmark_audio_cache()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "pac_benchmark_audio";
+    std::filesystem::create_directories(directory);
+
+    std::vector<AudioCacheSource> sources{};
+    for (auto i = 0u; i < CACHE_SOUNDS; ++i)
+    {
+        const auto fp = (directory / ("sound_" + std::to_string(i) + ".wav")).string();
+        const auto frequency = i % 2u == 0u ? AUDIO_MIX_FREQUENCY : AUDIO_MIX_FREQUENCY / 2u;
+        const auto frames = static_cast<uint32_t>(frequency * CACHE_SOUND_SECONDS);
+        if (!write_wav(fp, frequency, 1u, i % 2u == 0u ? 16u : 8u, frames))
+        {
+            GFX_WARN("Can not benchmark the audio cache, %s could not be written.", fp.c_str());
+            return;
+        }
+        sources.push_back({"sound_" + std::to_string(i), fp, std::filesystem::file_size(fp),
+                           static_cast<int64_t>(std::filesystem::last_write_time(fp).time_since_epoch().count())});
+    }
+
+    const auto cache_path = (directory / "audio_cache.bin").string();
+    AudioCache built{};
+    const auto stats = built.build(sources);
+    if (!built.save(cache_path))
+    {
+        GFX_WARN("Can not benchmark the audio cache, %s could not be written.", cache_path.c_str());
+        return;
+    }
+
+    AudioCache loaded{};
+    const auto start = std::chrono::steady_clock::now();
+    const auto ok = loaded.load(cache_path, sources);
+    const auto load_ms = milliseconds_since(start);
+
+    GFX_INFO("Audio cache of %zu sounds (%.1fKiB): %.3fms to convert (%zu resampled, %.3fms resampling on %u workers), "
+             "%.3fms to load.",
+             stats.converted, built.get_file_size() / 1024.f, stats.convert_ms, stats.resampled, stats.resample_ms,
+             get_job_system().get_thread_count(), load_ms);
+    if (!ok || loaded.get_clip_count() != sources.size())
+    {
+        GFX_WARN("The saved audio cache did not load.");
+    }
+    std::filesystem::remove_all(directory);
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(music_stream, "A long music track loaded whole against streamed, and the cost of refilling the stream")
+{
+    pac::benchmark_music_stream();
+}
+
+PAC_BENCHMARK(audio_cache, "Sound effects converted into the audio cache against loading the saved cache")
+{
+    pac::benchmark_audio_cache();
+}
@@ -0,0 +1,46 @@
+/*!
+ * \file benchmark.h contains a minimal benchmark runner. Benchmarks register themselves by name, and the pacman_benchmarks
+ * executable runs the ones named on its command line (or all of them) and prints what they measured.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <sol/state_view.hpp>
+
+namespace pac::benchmark
+{
+/*!
+ * \brief The BenchmarkCase struct is a registered benchmark. It is given the lua state of a headless game, with the game's
+ * bindings set up, for benchmarks that load entities or call into lua.
+ */
+struct BenchmarkCase
+{
+    const char* name = nullptr;
+    const char* description = nullptr;
+    void (*fn)(sol::state_view lua) = nullptr;
+};
+
+/*!
+ * \brief get_benchmarks returns every registered benchmark, in the order they were registered
+ */
+std::vector<BenchmarkCase>& get_benchmarks();
+
+/*!
+ * \brief The Registration struct adds a benchmark to get_benchmarks() when it is constructed
+ */
+struct Registration
+{
+    Registration(const char* name, const char* description, void (*fn)(sol::state_view))
+    {
+        get_benchmarks().push_back({name, description, fn});
+    }
+};
+}  // namespace pac::benchmark
+
+/* Defines a benchmark function and registers it under the name, the function has the lua state as its parameter lua */
+#define PAC_BENCHMARK(name, description)                                                                                     \
+    static void benchmark_##name(sol::state_view lua);                                                                       \
+    static const ::pac::benchmark::Registration benchmark_##name##_registration{#name, description, &benchmark_##name};      \
+    static void benchmark_##name([[maybe_unused]] sol::state_view lua)
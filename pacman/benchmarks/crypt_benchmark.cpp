@@ -0,0 +1,95 @@
+#include "benchmark.h"
+#include "encrypt/keystream_encryptor.h"
+#include "encrypt/vignere_encryptor.h"
+#include "encrypt/crypt_stream.h"
+#include "config.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+/* Position the buffer starts at in the stream, not a multiple of any block size so the unaligned start is measured */
+constexpr uint64_t BENCHMARK_POSITION = 4093u;
+
+/* Most bytes the VignereEncryption is given, it is slow enough that more only makes the benchmark longer */
+constexpr std::size_t VIGNERE_MAX_BYTES = 16u * 1024u * 1024u;
+
+float gigabytes_per_second(std::size_t bytes, std::chrono::steady_clock::time_point start)
+{
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds > 0.0 ? static_cast<float>(bytes / seconds / 1e9) : 0.f;
+}
+
+/*!
+ * \brief benchmark_encryption encrypts and decrypts a buffer with the VignereEncryption and with every keystream path the CPU
+ * supports, in memory and through a stream, and logs the throughput. That the paths round trip and agree is checked by the
+ * crypt test suite, not here.
+ * \param bytes is the size of the buffer
+ */
+void benchmark_encryption(std::size_t bytes)
+{
+    std::vector<uint8_t> original(bytes);
+    for (std::size_t i = 0u; i < bytes; ++i)
+    {
+        original[i] = static_cast<uint8_t>(i * 131u + (i >> 8u));
+    }
+
+    /* The old string encryptor, for comparison (it only changes letters, so it is given text) */
+    std::string text(std::min(bytes, VIGNERE_MAX_BYTES), '\0');
+    for (std::size_t i = 0u; i < text.size(); ++i)
+    {
+        text[i] = static_cast<char>('a' + i % 26u);
+    }
+    VignereEncryption vignere(ENCRYPTION_STRING);
+    auto start = std::chrono::steady_clock::now();
+    vignere.encrypt(text);
+    const auto vignere_encrypt = gigabytes_per_second(text.size(), start);
+    start = std::chrono::steady_clock::now();
+    vignere.decrypt(text);
+    GFX_INFO("Vignere: %.3f GB/s encrypt, %.3f GB/s decrypt (%zu bytes).", vignere_encrypt,
+             gigabytes_per_second(text.size(), start), text.size());
+
+    /* Every keystream path, the crypt test suite checks that they all give the same bytes */
+    KeystreamEncryption crypt(ENCRYPTION_STRING);
+    std::vector<uint8_t> data = original;
+    for (auto path = EKeystreamPath::Scalar; path <= KeystreamEncryption::best_path();
+         path = static_cast<EKeystreamPath>(static_cast<int>(path) + 1))
+    {
+        crypt.set_path(path);
+        start = std::chrono::steady_clock::now();
+        crypt.encrypt(data.data(), data.size(), BENCHMARK_POSITION);
+        const auto encrypt_speed = gigabytes_per_second(bytes, start);
+
+        start = std::chrono::steady_clock::now();
+        crypt.decrypt(data.data(), data.size(), BENCHMARK_POSITION);
+        GFX_INFO("Keystream %s: %.3f GB/s encrypt, %.3f GB/s decrypt (%zu bytes).", keystream_path_name(path), encrypt_speed,
+                 gigabytes_per_second(bytes, start), bytes);
+    }
+
+    /* Through a stream, which is how files are written and read */
+    crypt.set_path(KeystreamEncryption::best_path());
+    std::stringstream stream{};
+    start = std::chrono::steady_clock::now();
+    write_encrypted(stream, crypt, original.data(), bytes, BENCHMARK_POSITION);
+    const auto write_speed = gigabytes_per_second(bytes, start);
+
+    start = std::chrono::steady_clock::now();
+    read_encrypted(stream, crypt, data.data(), bytes, BENCHMARK_POSITION);
+    GFX_INFO("Keystream %s stream: %.3f GB/s write, %.3f GB/s read in %u byte chunks.",
+             keystream_path_name(crypt.get_path()), write_speed, gigabytes_per_second(bytes, start), CRYPT_STREAM_CHUNK_BYTES);
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(encryption, "Vignere and every keystream path the CPU supports, in memory and through a stream")
+{
+    pac::benchmark_encryption(64u * 1024u * 1024u);
+}
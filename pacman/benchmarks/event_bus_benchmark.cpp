@@ -0,0 +1,102 @@
+#include "benchmark.h"
+#include "entity/events.h"
+#include "alloc_tracker.h"
+#include "event_bus.h"
+#include "common.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include <gfx.h>
+#include <entt/signal/dispatcher.hpp>
+
+namespace pac
+{
+namespace
+{
+/* Updates per simulated second */
+constexpr std::size_t UPDATES_PER_SECOND = 60u;
+
+/*!
+ * \brief The BenchmarkListener struct sums up what it receives, so the compiler can not skip the work
+ */
+struct BenchmarkListener
+{
+    long long sum = 0;
+
+    void recieve(const EvEntityMoved& event) { sum += event.new_position.x + event.new_position.y; }
+};
+
+/*!
+ * \brief The BenchmarkResult struct contains the time a run took, and how many allocations it made (if tracked)
+ */
+struct BenchmarkResult
+{
+    float ms = 0.f;
+    unsigned long long allocations = 0u;
+};
+
+/*!
+ * \brief run_benchmark pushes events through Bus and returns the time it took
+ */
+template<typename Bus>
+BenchmarkResult run_benchmark(Bus& bus, std::size_t events_per_update, BenchmarkListener& listener)
+{
+#ifdef PAC_ENABLE_ALLOC_TRACKER
+    const AllocCounter allocations{};
+#endif
+    bus.template sink<EvEntityMoved>().template connect<&BenchmarkListener::recieve>(listener);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t update = 0u; update < UPDATES_PER_SECOND; ++update)
+    {
+        for (std::size_t i = 0u; i < events_per_update; ++i)
+        {
+            bus.enqueue(EvEntityMoved{{}, {1, 0}, {static_cast<int>(i), static_cast<int>(update)}});
+        }
+        bus.update();
+    }
+    const auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    bus.template sink<EvEntityMoved>().template disconnect<&BenchmarkListener::recieve>(listener);
+
+#ifdef PAC_ENABLE_ALLOC_TRACKER
+    return {ms, allocations.allocations()};
+#else
+    return {ms, 0u};
+#endif
+}
+
+/*!
+ * \brief benchmark_event_dispatch queues and delivers one simulated second of events (at 60 updates per second) through both
+ * the EventBus and an entt::dispatcher with one listener, and logs the time taken and the resulting throughput
+ * \param events_per_second is the number of events to push through in the simulated second
+ */
+void benchmark_event_dispatch(std::size_t events_per_second)
+{
+    const auto events_per_update = std::max<std::size_t>(events_per_second / UPDATES_PER_SECOND, 1u);
+    const auto total_events = static_cast<float>(events_per_update * UPDATES_PER_SECOND);
+
+    BenchmarkListener bus_listener{};
+    EventBus bus{events_per_update};
+    const auto bus_result = run_benchmark(bus, events_per_update, bus_listener);
+
+    BenchmarkListener dispatcher_listener{};
+    entt::dispatcher dispatcher{};
+    const auto dispatcher_result = run_benchmark(dispatcher, events_per_update, dispatcher_listener);
+
+    GFX_ASSERT(bus_listener.sum == dispatcher_listener.sum, "The event bus and dispatcher delivered different events.");
+    GFX_INFO("%zu events/s (%zu per update): EventBus %.3fms (%.1fM events/s, %llu allocations), entt::dispatcher %.3fms "
+             "(%.1fM events/s, %llu allocations)",
+             events_per_second, events_per_update, bus_result.ms, total_events / bus_result.ms / 1000.f,
+             bus_result.allocations, dispatcher_result.ms, total_events / dispatcher_result.ms / 1000.f,
+             dispatcher_result.allocations);
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(events, "EventBus against entt::dispatcher, queueing and delivering to one listener")
+{
+    pac::benchmark_event_dispatch(10'000u);
+    pac::benchmark_event_dispatch(1'000'000u);
+}
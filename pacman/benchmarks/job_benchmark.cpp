@@ -0,0 +1,253 @@
+#include "benchmark.h"
+#include "job_system.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+/* Rows and columns of the nested parallel_for, and how many of each a piece gets */
+constexpr std::size_t NESTED_ROWS = 256u;
+constexpr std::size_t NESTED_COLUMNS = 4096u;
+constexpr std::size_t NESTED_COLUMN_GRAIN = 256u;
+
+/* Chains of dependent jobs, and the jobs in each */
+constexpr std::size_t CHAINS = 64u;
+constexpr std::size_t CHAIN_LENGTH = 64u;
+
+/* Elements of the workload timed for every thread count, and how many a piece gets */
+constexpr std::size_t SCALING_ELEMENTS = 1u << 22u;
+constexpr std::size_t SCALING_GRAIN = 1u << 14u;
+
+float milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*!
+ * \brief work is the work done for every element of the scaling workload, a few rounds of a hash so it is bound by the CPU
+ */
+uint64_t work(uint64_t x)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        x = (x ^ (x >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27u)) * 0x94D049BB133111EBull;
+    }
+    return x ^ (x >> 31u);
+}
+
+/*!
+ * \brief run_workload sums the work of every element with a parallel_for on the given job system
+ */
+uint64_t run_workload(JobSystem& jobs)
+{
+    std::vector<uint64_t> partial_sums((SCALING_ELEMENTS + SCALING_GRAIN - 1u) / SCALING_GRAIN, 0u);
+    const auto sum_piece = [&partial_sums](std::size_t first, std::size_t last) {
+        uint64_t sum = 0u;
+        for (auto i = first; i < last; ++i)
+        {
+            sum += work(i);
+        }
+        partial_sums[first / SCALING_GRAIN] = sum;
+    };
+    jobs.parallel_for("Scaling Piece", 0u, SCALING_ELEMENTS, SCALING_GRAIN, sum_piece);
+
+    uint64_t sum = 0u;
+    for (auto partial_sum : partial_sums)
+    {
+        sum += partial_sum;
+    }
+    return sum;
+}
+
+/*!
+ * \brief log_shares logs how many of the jobs each worker ran, and how many of those it stole
+ */
+void log_shares(const JobSystem::Stats& stats)
+{
+    uint64_t total = stats.helped;
+    for (auto executed : stats.executed)
+    {
+        total += executed;
+    }
+
+    std::string shares{};
+    for (std::size_t i = 0u; i < stats.executed.size(); ++i)
+    {
+        char share[64] = {};
+        std::snprintf(share, sizeof(share), "%s%.1f%% (%llu stolen)", i > 0u ? ", " : "",
+                      total > 0u ? 100.f * stats.executed[i] / total : 0.f, static_cast<unsigned long long>(stats.stolen[i]));
+        shares += share;
+    }
+    GFX_INFO("Jobs per worker: %s, %.1f%% run by waiting threads.", shares.c_str(),
+             total > 0u ? 100.f * stats.helped / total : 0.f);
+}
+
+/*!
+ * \brief benchmark_jobs runs many tiny jobs, nested parallel_for loops and chains of dependent jobs on the job system of the
+ * game, and logs the time taken and how the jobs were spread over the workers. It then times the same workload on job systems
+ * of one thread up to the size of the game's, and logs the speedup of each. A warning is logged if a job is lost or run twice.
+ * \param jobs is the number of tiny jobs to run
+ */
+void benchmark_jobs(std::size_t jobs)
+{
+    auto& job_system = get_job_system();
+    job_system.take_stats();
+    bool ok = true;
+
+    /* Tiny jobs all started by one job, so the other workers have to steal them */
+    std::atomic<std::size_t> tiny_done = 0u;
+    auto start = std::chrono::steady_clock::now();
+    {
+        JobCounter spawner{};
+        job_system.run("Tiny Job Spawner",
+                       [&job_system, &tiny_done, jobs] {
+                           JobCounter tiny{};
+                           for (std::size_t i = 0u; i < jobs; ++i)
+                           {
+                               job_system.run("Tiny Job", [&tiny_done] { ++tiny_done; }, &tiny);
+                           }
+                           job_system.wait(tiny);
+                       },
+                       &spawner);
+        job_system.wait(spawner);
+    }
+    const auto tiny_ms = milliseconds_since(start);
+    GFX_INFO("%zu tiny jobs: %.3fms (%.0f jobs per ms) on %u workers.", jobs, tiny_ms, tiny_ms > 0.f ? jobs / tiny_ms : 0.f,
+             job_system.get_thread_count());
+    log_shares(job_system.take_stats());
+    if (tiny_done != jobs)
+    {
+        GFX_WARN("%zu of %zu tiny jobs were run.", tiny_done.load(), jobs);
+        ok = false;
+    }
+
+    /* A parallel_for in every piece of a parallel_for, every cell must be visited once */
+    std::vector<uint8_t> visits(NESTED_ROWS * NESTED_COLUMNS, 0u);
+    start = std::chrono::steady_clock::now();
+    job_system.parallel_for("Nested Row", 0u, NESTED_ROWS, 1u, [&job_system, &visits](std::size_t row, std::size_t) {
+        job_system.parallel_for("Nested Columns", 0u, NESTED_COLUMNS, NESTED_COLUMN_GRAIN,
+                                [&visits, row](std::size_t first, std::size_t last) {
+                                    for (auto column = first; column < last; ++column)
+                                    {
+                                        ++visits[row * NESTED_COLUMNS + column];
+                                    }
+                                });
+    });
+    GFX_INFO("Nested parallel_for of %zu rows: %.3fms.", NESTED_ROWS, milliseconds_since(start));
+    log_shares(job_system.take_stats());
+    for (auto visited : visits)
+    {
+        if (visited != 1u)
+        {
+            GFX_WARN("A nested parallel_for visited a cell %u times.", static_cast<unsigned>(visited));
+            ok = false;
+            break;
+        }
+    }
+
+    /* Chains where every job is started by the one before it finishing, each must run in order */
+    std::vector<std::unique_ptr<JobCounter>> links{};
+    std::vector<std::vector<std::size_t>> chain_order(CHAINS);
+    links.reserve(CHAINS * CHAIN_LENGTH);
+    for (std::size_t i = 0u; i < CHAINS * CHAIN_LENGTH; ++i)
+    {
+        links.push_back(std::make_unique<JobCounter>());
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t chain = 0u; chain < CHAINS; ++chain)
+    {
+        auto& order = chain_order[chain];
+        order.reserve(CHAIN_LENGTH);
+        for (std::size_t link = 0u; link < CHAIN_LENGTH; ++link)
+        {
+            auto* counter = links[chain * CHAIN_LENGTH + link].get();
+            auto fn = [&order, link] { order.push_back(link); };
+            if (link == 0u)
+            {
+                job_system.run("Chain Link", fn, counter);
+            }
+            else
+            {
+                job_system.run_after(*links[chain * CHAIN_LENGTH + link - 1u], "Chain Link", fn, counter);
+            }
+        }
+    }
+    for (std::size_t chain = 0u; chain < CHAINS; ++chain)
+    {
+        job_system.wait(*links[chain * CHAIN_LENGTH + CHAIN_LENGTH - 1u]);
+    }
+    GFX_INFO("%zu chains of %zu dependent jobs: %.3fms.", CHAINS, CHAIN_LENGTH, milliseconds_since(start));
+    log_shares(job_system.take_stats());
+    for (const auto& order : chain_order)
+    {
+        bool in_order = order.size() == CHAIN_LENGTH;
+        for (std::size_t i = 0u; in_order && i < order.size(); ++i)
+        {
+            in_order = order[i] == i;
+        }
+
+        if (!in_order)
+        {
+            GFX_WARN("A chain of dependent jobs did not run in order.");
+            ok = false;
+            break;
+        }
+    }
+
+    /* The same workload on the calling thread alone, and on job systems of more and more threads */
+    start = std::chrono::steady_clock::now();
+    uint64_t expected = 0u;
+    for (std::size_t i = 0u; i < SCALING_ELEMENTS; ++i)
+    {
+        expected += work(i);
+    }
+    const auto serial_ms = milliseconds_since(start);
+    GFX_INFO("Workload of %zu elements: %.3fms on the calling thread.", SCALING_ELEMENTS, serial_ms);
+
+    /* Doubling the threads each time, and ending with as many as the game has */
+    const auto max_threads = std::max(job_system.get_thread_count(), 1u);
+    for (auto threads = 1u;; threads = std::min(threads * 2u, max_threads))
+    {
+        JobSystem scaling{threads};
+        start = std::chrono::steady_clock::now();
+        const auto sum = run_workload(scaling);
+        const auto ms = milliseconds_since(start);
+        GFX_INFO("Workload on %u workers and the calling thread: %.3fms (%.2fx).", threads, ms,
+                 ms > 0.f ? serial_ms / ms : 0.f);
+        if (sum != expected)
+        {
+            GFX_WARN("The workload on %u workers does not match the one on the calling thread.", threads);
+            ok = false;
+        }
+
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+
+    if (ok)
+    {
+        GFX_INFO("Every job ran once, and every chain ran in order.");
+    }
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(jobs, "Tiny jobs, nested parallel_for and dependent chains on the job system, and its scaling")
+{
+    pac::benchmark_jobs(100'000u);
+}
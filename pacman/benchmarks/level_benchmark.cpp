@@ -0,0 +1,88 @@
+#include "benchmark.h"
+#include "level.h"
+#include "level_preloader.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gfx.h>
+#include <cglutil.h>
+#include <entt/entity/registry.hpp>
+
+namespace pac
+{
+namespace
+{
+float milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*!
+ * \brief benchmark_level_load loads every level of the level file twice, once parsed on the main thread the way a level was
+ * loaded before it could be preloaded, and once parsed by the LevelPreloader ahead of time and only instantiated on the main
+ * thread, and logs the time the main thread spent on each
+ */
+void benchmark_level_load(sol::state_view& lua)
+{
+    /* The level file holds every level, so running it gives their names */
+    lua.script_file(cgl::native_absolute_path("res/levels.lua"));
+    std::vector<std::string> level_names{};
+    sol::table levels = lua["levels"];
+    for (const auto& [name, _] : levels)
+    {
+        level_names.push_back(name.as<std::string>());
+    }
+
+    float sync_ms = 0.f;
+    float preloaded_ms = 0.f;
+    float background_ms = 0.f;
+    for (const auto& level_name : level_names)
+    {
+        /* Parsed and instantiated on the main thread */
+        {
+            entt::registry reg{};
+            Level level{};
+            const auto start = std::chrono::steady_clock::now();
+            level.instantiate(lua, reg, Level::parse(lua, level_name));
+            sync_ms += milliseconds_since(start);
+        }
+
+        /* Parsed in the background while the main thread waits here, which is where the game keeps running the menu */
+        {
+            LevelPreloader preloader{};
+            auto start = std::chrono::steady_clock::now();
+            preloader.request(level_name);
+            while (!preloader.is_ready(level_name))
+            {
+                std::this_thread::yield();
+            }
+            background_ms += milliseconds_since(start);
+
+            entt::registry reg{};
+            Level level{};
+            start = std::chrono::steady_clock::now();
+            const auto data = preloader.take(level_name);
+            if (!data)
+            {
+                GFX_WARN("The preloader did not hand over level %s.", level_name.c_str());
+                continue;
+            }
+            level.instantiate(lua, reg, *data);
+            preloaded_ms += milliseconds_since(start);
+        }
+    }
+
+    GFX_INFO("Loading %zu levels: %.3fms on the main thread parsing them there, %.3fms with them preloaded (%.3fms parsing in "
+             "the background).",
+             level_names.size(), sync_ms, preloaded_ms, background_ms);
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(level_load, "Every level parsed on the main thread against preloaded in the background")
+{
+    pac::benchmark_level_load(lua);
+}
@@ -0,0 +1,98 @@
+#include "benchmark.h"
+#include "entity/events.h"
+#include "event_bus.h"
+#include "common.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+/* Updates per simulated second */
+constexpr std::size_t UPDATES_PER_SECOND = 60u;
+
+/*!
+ * \brief The LuaDeliveryResult struct contains the calls into lua and time per update of a lua delivery run
+ */
+struct LuaDeliveryResult
+{
+    double calls_per_update = 0.0;
+    double ms_per_update = 0.0;
+    long long sum = 0;
+};
+
+/*!
+ * \brief run_lua_delivery pushes Pickup events through bus to whatever lua functions are connected to it
+ */
+LuaDeliveryResult run_lua_delivery(sol::state_view& lua, EventBus& bus, std::size_t events_per_update)
+{
+    lua["pac_benchmark_sum"] = 0;
+    const auto before = get_lua_call_stats();
+    EvPacPickup pickup{"Benchmark", 0};
+    for (std::size_t update = 0u; update < UPDATES_PER_SECOND; ++update)
+    {
+        for (std::size_t i = 0u; i < events_per_update; ++i)
+        {
+            pickup.score_delta = static_cast<int>(i);
+            bus.enqueue(pickup);
+        }
+        bus.update();
+    }
+
+    const auto& after = get_lua_call_stats();
+    return {static_cast<double>(after.calls - before.calls) / UPDATES_PER_SECOND,
+            (after.ms - before.ms) / UPDATES_PER_SECOND, lua.get<long long>("pac_benchmark_sum")};
+}
+
+/*!
+ * \brief benchmark_lua_event_delivery delivers one simulated second of Pickup events (at 60 updates per second) to a lua
+ * function that sums their scores, first connected like connect does and then like connect_batched does, and logs the calls
+ * into lua and the time spent per update for each
+ * \param lua is the lua state to run the functions in
+ * \param events_per_update is the number of Pickup events in each update (a pellet-heavy frame has a handful)
+ */
+void benchmark_lua_event_delivery(sol::state_view lua, std::size_t events_per_update)
+{
+    sol::function single = lua.script("return function(e) pac_benchmark_sum = pac_benchmark_sum + e.score_delta end");
+    sol::function batched = lua.script("return function(events, count) "
+                                       "for i = 1, count do pac_benchmark_sum = pac_benchmark_sum + events[i].score_delta end "
+                                       "end");
+
+    /* A bus of its own, so the game's listeners are left out of it */
+    EventBus bus{events_per_update};
+    LuaDeliveryResult single_result{};
+    {
+        ScopedConnection connection = lua_binder<EvPacPickup>(bus, single);
+        single_result = run_lua_delivery(lua, bus, events_per_update);
+    }
+
+    std::vector<std::shared_ptr<LuaEventBatchBase>> batches{};
+    LuaDeliveryResult batched_result{};
+    {
+        LuaBatchConnection connection = lua_batch_binder<EvPacPickup>(bus, batches, batched);
+        batched_result = run_lua_delivery(lua, bus, events_per_update);
+    }
+    remove_released_lua_batches(batches);
+
+    GFX_ASSERT(single_result.sum == batched_result.sum, "Single and batched delivery gave lua different events.");
+    GFX_INFO("%zu Pickup events per update: one at a time %.1f lua calls and %.4fms per update, batched %.1f lua calls and "
+             "%.4fms per update (%.2fx).",
+             events_per_update, single_result.calls_per_update, single_result.ms_per_update, batched_result.calls_per_update,
+             batched_result.ms_per_update,
+             batched_result.ms_per_update > 0.0 ? single_result.ms_per_update / batched_result.ms_per_update : 0.0);
+    lua["pac_benchmark_sum"] = sol::lua_nil;
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(lua_events, "Pickup events delivered to lua one at a time against in batches")
+{
+    pac::benchmark_lua_event_delivery(lua, 1u);
+    pac::benchmark_lua_event_delivery(lua, 16u);
+    pac::benchmark_lua_event_delivery(lua, 256u);
+}
@@ -0,0 +1,112 @@
+#include "benchmark.h"
+#include "game.h"
+#include "config.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <GLFW/glfw3.h>
+
+namespace pac::benchmark
+{
+std::vector<BenchmarkCase>& get_benchmarks()
+{
+    static std::vector<BenchmarkCase> benchmarks{};
+    return benchmarks;
+}
+}  // namespace pac::benchmark
+
+/*!
+ * \brief main runs every benchmark named on the command line in the order they are given, or every benchmark if none is named.
+ * They run in a headless game (drawn and mixed by the software backends), so they need neither a window nor a sound card,
+ * unless --window is given to open the game's window and draw with OpenGL (LIBGL_ALWAYS_SOFTWARE=1 runs it on llvmpipe).
+ * \return 0 if every benchmark ran, 1 for a bad option or if the window can not be opened, and 2 if a name matches no
+ * benchmark
+ */
+int main(int argc, char* argv[])
+{
+    const auto& benchmarks = pac::benchmark::get_benchmarks();
+
+    pac::LaunchOptions options = {};
+    options.headless = true;
+    std::vector<const pac::benchmark::BenchmarkCase*> to_run{};
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--list") == 0)
+        {
+            for (const auto& benchmark : benchmarks)
+            {
+                std::printf("%-16s %s\n", benchmark.name, benchmark.description);
+            }
+            return 0;
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            options.workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--window") == 0)
+        {
+            options.headless = false;
+        }
+        else if (argv[i][0] == '-')
+        {
+            std::fprintf(stderr, "Unknown option %s. Usage: %s [--list] [--workers <threads>] [--window] [benchmark...]\n",
+                         argv[i], argv[0]);
+            return 1;
+        }
+        else
+        {
+            const auto* found = static_cast<const pac::benchmark::BenchmarkCase*>(nullptr);
+            for (const auto& benchmark : benchmarks)
+            {
+                found = std::strcmp(argv[i], benchmark.name) == 0 ? &benchmark : found;
+            }
+
+            if (!found)
+            {
+                std::fprintf(stderr, "No benchmark is called %s, run %s --list to list them.\n", argv[i], argv[0]);
+                return 2;
+            }
+            to_run.push_back(found);
+        }
+    }
+
+    if (to_run.empty())
+    {
+        for (const auto& benchmark : benchmarks)
+        {
+            to_run.push_back(&benchmark);
+        }
+    }
+
+    if (!options.headless && !glfwInit())
+    {
+        std::fprintf(stderr, "Could not initialize GLFW for --window.\n");
+        return 1;
+    }
+
+    /* The game sets up the job system, the backends and the lua bindings the benchmarks use */
+    {
+        pac::Game game(std::string("OpenGL Pacman Benchmarks ") + pac::VERSION_STRING, {pac::SCREEN_W, pac::SCREEN_H}, options);
+        for (const auto* benchmark : to_run)
+        {
+            std::printf("[ RUN  ] %s: %s\n", benchmark->name, benchmark->description);
+            std::fflush(stdout);
+            const auto start = std::chrono::steady_clock::now();
+            benchmark->fn(game.get_lua());
+            const auto seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+            std::printf("[ DONE ] %s in %.2fs\n", benchmark->name, seconds);
+            std::fflush(stdout);
+        }
+    }
+
+    if (!options.headless)
+    {
+        glfwTerminate();
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "benchmark.h"
+#include "rendering/renderer.h"
+#include "config.h"
+
+#include <cstdint>
+#include <iterator>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+/* Frames drawn before the counters are read, so the instance ring has grown to fit the sprites, and frames timed after */
+constexpr unsigned WARM_UP_FRAMES = 4u;
+constexpr unsigned RENDER_FRAMES = 120u;
+
+/* A screen full of tiles */
+constexpr unsigned TILES_X = SCREEN_W / TILE_SIZE<unsigned>;
+constexpr unsigned TILES_Y = SCREEN_H / TILE_SIZE<unsigned>;
+constexpr unsigned TILES = TILES_X * TILES_Y;
+
+/* Layers the sprites are spread over (every layer but the tiles) */
+constexpr ELayer SPRITE_LAYERS[] = {ELayer::Background, ELayer::Entities, ELayer::Overlay, ELayer::Interface};
+
+/*!
+ * \brief The RenderResult struct is the average of the renderer's counters over the timed frames
+ */
+struct RenderResult
+{
+    float submit_ms = 0.f;
+    float sort_ms = 0.f;
+    float backend_ms = 0.f;
+    float fence_wait_ms = 0.f;
+    float batches = 0.f;
+    float kib_uploaded = 0.f;
+    unsigned fence_stalls = 0u;
+};
+
+Renderer::Sprite tile_sprite(unsigned tile, TextureID texture)
+{
+    return {{HALF_TILE + (tile % TILES_X) * TILE_SIZE<float>, HALF_TILE + (tile / TILES_X) * TILE_SIZE<float>},
+            {TILE_SIZE<float>, TILE_SIZE<float>},
+            {1.f, 1.f, 1.f},
+            texture};
+}
+
+/*!
+ * \brief run_frames draws a screen of tiles and the given number of small sprites every frame, and returns the averages
+ * \param retained is true to keep the tiles in the static layer, and false to draw every tile again each frame
+ */
+RenderResult run_frames(std::size_t sprites, bool retained)
+{
+    auto& r = get_renderer();
+    const auto texture = r.get_tileset_texture(0u);
+
+    /* Whoever owns the static layer only needs a unique address */
+    const int owner = 0;
+    if (retained)
+    {
+        r.set_static_layer(&owner, TILES);
+        for (auto tile = 0u; tile < TILES; ++tile)
+        {
+            r.set_static_instance(tile, tile_sprite(tile, texture));
+        }
+    }
+
+    RenderResult result{};
+    for (auto frame = 0u; frame < WARM_UP_FRAMES + RENDER_FRAMES; ++frame)
+    {
+        if (retained)
+        {
+            r.draw_static_layer();
+        }
+        else
+        {
+            for (auto tile = 0u; tile < TILES; ++tile)
+            {
+                r.draw(tile_sprite(tile, texture), ELayer::Tiles);
+            }
+        }
+
+        /* Spread over the layers and many depths, like the render stress test */
+        for (std::size_t i = 0u; i < sprites; ++i)
+        {
+            const auto x = static_cast<float>((i * 4u) % SCREEN_W);
+            const auto y = static_cast<float>(((i * 4u) / SCREEN_W * 4u) % SCREEN_H);
+            r.draw({{x, y}, {4.f, 4.f}, {1.f, 1.f, 0.f}, {}}, SPRITE_LAYERS[i % std::size(SPRITE_LAYERS)],
+                   static_cast<uint16_t>((i * 7919u) & 0xFFFFu));
+        }
+        r.submit_work();
+
+        if (frame >= WARM_UP_FRAMES)
+        {
+            const auto& stats = r.get_frame_stats();
+            result.submit_ms += stats.submit_ms;
+            result.sort_ms += stats.sort_ms;
+            result.backend_ms += stats.backend_ms;
+            result.fence_wait_ms += stats.fence_wait_ms;
+            result.batches += stats.batches;
+            result.kib_uploaded += stats.bytes_uploaded / 1024.f;
+            result.fence_stalls += stats.fence_stalled ? 1u : 0u;
+        }
+    }
+
+    if (retained)
+    {
+        r.release_static_layer(&owner);
+    }
+
+    result.submit_ms /= RENDER_FRAMES;
+    result.sort_ms /= RENDER_FRAMES;
+    result.backend_ms /= RENDER_FRAMES;
+    result.fence_wait_ms /= RENDER_FRAMES;
+    result.batches /= RENDER_FRAMES;
+    result.kib_uploaded /= RENDER_FRAMES;
+    return result;
+}
+
+void log_result(const char* tiles, const RenderResult& result)
+{
+    GFX_INFO("  Tiles %s: %.3fms submit (%.3fms sort, %.3fms backend), %.1f batches, %.1fKiB uploaded, %.4fms waiting on "
+             "fences (%u of %u frames stalled).",
+             tiles, result.submit_ms, result.sort_ms, result.backend_ms, result.batches, result.kib_uploaded,
+             result.fence_wait_ms, result.fence_stalls, RENDER_FRAMES);
+}
+
+/*!
+ * \brief benchmark_render draws a screen of level tiles and the given number of sprites for a number of frames, once with the
+ * tiles retained in the static layer and once with them drawn again every frame, and logs the renderer's counters per frame
+ */
+void benchmark_render(std::size_t sprites)
+{
+    GFX_INFO("%u tiles and %zu sprites per frame on the %s backend:", TILES, sprites,
+             get_renderer().get_backend_type() == ERenderBackend::Software ? "software" : "OpenGL");
+    log_result("retained", run_frames(sprites, true));
+    log_result("drawn every frame", run_frames(sprites, false));
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(render, "Tiles retained against drawn every frame, and sprites past one instance segment (--window for OpenGL)")
+{
+    pac::benchmark_render(1'000u);
+    pac::benchmark_render(10'000u);
+    pac::benchmark_render(100'000u);
+}
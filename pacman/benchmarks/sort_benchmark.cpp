@@ -0,0 +1,105 @@
+#include "benchmark.h"
+#include "rendering/sprite_sort.h"
+
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+/* Times each sort is run, the fastest run is reported */
+constexpr int RUNS = 5;
+
+/*!
+ * \brief make_key builds a key the way Renderer::draw does, the sort key in the upper 32 bits and the index in the lower
+ */
+uint64_t make_key(uint32_t layer, uint32_t depth, uint32_t texture, std::size_t index)
+{
+    const uint64_t key = (layer << 24u) | ((depth & 0xFFFFu) << 8u) | (texture & 0xFFu);
+    return (key << 32u) | index;
+}
+
+/*!
+ * \brief time_sort runs sort on copies of keys and returns the fastest time in milliseconds, leaving the result in sorted
+ */
+template <typename Fn>
+float time_sort(const std::vector<uint64_t>& keys, std::vector<uint64_t>& sorted, Fn sort)
+{
+    auto best_ms = 0.f;
+    for (int run = 0; run < RUNS; ++run)
+    {
+        sorted = keys;
+        const auto start = std::chrono::steady_clock::now();
+        sort(sorted);
+        const auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best_ms = run == 0 ? ms : std::min(best_ms, ms);
+    }
+    return best_ms;
+}
+
+/*!
+ * \brief compare sorts keys with both sorts, logs their times and returns true if they gave the same order
+ */
+bool compare(const char* name, const std::vector<uint64_t>& keys)
+{
+    std::vector<uint64_t> scratch{};
+    std::vector<uint64_t> radix_sorted{};
+    const auto radix_ms = time_sort(keys, radix_sorted, [&scratch](auto& to_sort) { radix_sort_keys(to_sort, scratch); });
+
+    std::vector<uint64_t> std_sorted{};
+    const auto std_ms = time_sort(keys, std_sorted, [](auto& to_sort) {
+        std::stable_sort(to_sort.begin(), to_sort.end(), [](uint64_t a, uint64_t b) { return (a >> 32u) < (b >> 32u); });
+    });
+
+    GFX_INFO("Sorting %zu %s sprites: %.3fms radix sort, %.3fms std::stable_sort (%.2fx).", keys.size(), name, radix_ms,
+             std_ms, radix_ms > 0.f ? std_ms / radix_ms : 0.f);
+    if (radix_sorted != std_sorted)
+    {
+        GFX_WARN("The radix sort of %zu %s sprites does not match std::stable_sort.", keys.size(), name);
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief benchmark_sprite_sort sorts the keys of the given number of sprites with the renderer's radix sort and with
+ * std::stable_sort, and logs the time taken by each. It does so for sprites spread over every layer and many depths, and for
+ * sprites like those of a level, where most share a layer and only a few depths are used. A warning is logged if the radix
+ * sort does not give the same order as std::stable_sort.
+ */
+void benchmark_sprite_sort(std::size_t sprites)
+{
+    /* Spread over every layer, many depths and a few textures, so every pass of the radix sort is needed */
+    std::vector<uint64_t> keys(sprites);
+    for (std::size_t i = 0u; i < sprites; ++i)
+    {
+        keys[i] = make_key(static_cast<uint32_t>(i % 5u), static_cast<uint32_t>(i * 7919u), static_cast<uint32_t>(i % 3u), i);
+    }
+    auto ok = compare("spread", keys);
+
+    /* Like a level, mostly entities at a handful of depths with one texture, so most passes are skipped */
+    for (std::size_t i = 0u; i < sprites; ++i)
+    {
+        keys[i] = make_key(i % 16u == 0u ? 3u : 2u, static_cast<uint32_t>(i % 4u), 1u, i);
+    }
+    ok &= compare("level-like", keys);
+
+    if (ok)
+    {
+        GFX_INFO("The radix sort matched std::stable_sort for every sprite.");
+    }
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(sprite_sort, "Radix sort of sprite keys against std::stable_sort")
+{
+    pac::benchmark_sprite_sort(10'000u);
+    pac::benchmark_sprite_sort(100'000u);
+    pac::benchmark_sprite_sort(1'000'000u);
+}
@@ -0,0 +1,87 @@
+#include "benchmark.h"
+#include "entity/factory.h"
+#include "entity/components.h"
+
+#include <chrono>
+#include <vector>
+
+#include <gfx.h>
+#include <entt/entity/registry.hpp>
+
+namespace pac
+{
+namespace
+{
+/* The entity every level has the most of */
+constexpr const char* BENCHMARK_ENTITY = "food";
+
+/* Width of the made up level the entities are placed in */
+constexpr int BENCHMARK_LEVEL_WIDTH = 100;
+
+float milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*!
+ * \brief benchmark_spawn spawns food the way a level with that many pellets does, once one entity at a time and once with
+ * every pellet spawned in one go, into registries of its own, and logs the time each took
+ * \param state is the lua state the entity is loaded in
+ * \param count is the number of entities to spawn
+ */
+void benchmark_spawn(sol::state_view& state, std::size_t count)
+{
+    std::vector<int> xs(count);
+    std::vector<int> ys(count);
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+        xs[i] = static_cast<int>(i) % BENCHMARK_LEVEL_WIDTH;
+        ys[i] = static_cast<int>(i) / BENCHMARK_LEVEL_WIDTH;
+    }
+
+    /* One entity at a time, reading the entity file for each */
+    entt::registry single_reg{};
+    EntityFactory single_factory(single_reg);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+        auto e = single_factory.spawn(state, BENCHMARK_ENTITY);
+        if (e == entt::null)
+        {
+            GFX_WARN("Can not benchmark spawning, there is no %s entity.", BENCHMARK_ENTITY);
+            return;
+        }
+        single_reg.get<CPosition>(e).position = {xs[i], ys[i]};
+        single_reg.get<CPosition>(e).spawn = {xs[i], ys[i]};
+    }
+    const auto single_ms = milliseconds_since(start);
+
+    /* Every entity at once, the way levels are loaded */
+    entt::registry bulk_reg{};
+    EntityFactory bulk_factory(bulk_reg);
+    std::vector<entt::entity> entities(count);
+    start = std::chrono::steady_clock::now();
+    bulk_reg.reserve(count);
+    bulk_factory.spawn(state, BENCHMARK_ENTITY, entities.data(), entities.data() + entities.size());
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+        auto& position = bulk_reg.get<CPosition>(entities[i]);
+        position.position = position.spawn = {xs[i], ys[i]};
+    }
+    const auto bulk_ms = milliseconds_since(start);
+
+    if (single_reg.size<CPickup>() != count || bulk_reg.size<CPickup>() != count)
+    {
+        GFX_WARN("Spawning %zu entities made %zu one at a time and %zu at once.", count, single_reg.size<CPickup>(),
+                 bulk_reg.size<CPickup>());
+    }
+    GFX_INFO("Spawning %zu %s entities: %.3fms one at a time, %.3fms at once (%.1fx).", count, BENCHMARK_ENTITY, single_ms,
+             bulk_ms, bulk_ms > 0.f ? single_ms / bulk_ms : 0.f);
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(spawn, "Spawning the food of a level one entity at a time against all at once")
+{
+    pac::benchmark_spawn(lua, 10'000u);
+}
@@ -0,0 +1,182 @@
+#include "benchmark.h"
+#include "entity/system_scheduler.h"
+#include "entity/animation_system.h"
+#include "entity/movement_system.h"
+#include "entity/ai_system.h"
+#include "entity/components.h"
+#include "entity/events.h"
+#include "level.h"
+#include "config.h"
+
+#include <memory>
+#include <vector>
+
+#include <gfx.h>
+#include <entt/entity/registry.hpp>
+
+namespace pac
+{
+namespace
+{
+/* Ghosts per row of the level, which has a wall around it */
+constexpr int BENCHMARK_LEVEL_WIDTH = 64;
+
+/* Frames timed in each mode, after one frame of warm-up */
+constexpr unsigned BENCHMARK_FRAMES = 240u;
+
+/* Tileset frame used for the walls */
+constexpr int BENCHMARK_WALL_TILE = 0;
+
+Level::Data make_level(std::size_t ghosts)
+{
+    Level::Data data{};
+    data.name = "System Benchmark";
+    const auto rows = static_cast<int>((ghosts + BENCHMARK_LEVEL_WIDTH - 1u) / BENCHMARK_LEVEL_WIDTH) + 1;
+    data.size = {BENCHMARK_LEVEL_WIDTH + 2, rows + 2};
+
+    data.tiles.resize(static_cast<std::size_t>(data.size.x * data.size.y), -1);
+    for (int y = 0; y < data.size.y; ++y)
+    {
+        for (int x = 0; x < data.size.x; ++x)
+        {
+            if (x == 0 || y == 0 || x == data.size.x - 1 || y == data.size.y - 1)
+            {
+                data.tiles[y * data.size.x + x] = BENCHMARK_WALL_TILE;
+            }
+        }
+    }
+
+    /* Pacman gets the first row to itself, and the ghosts fill the rest */
+    data.spawns.push_back({"pacman", {1}, {1}});
+    Level::Data::Spawns ghost_spawns{"ghost", {}, {}};
+    for (std::size_t i = 0u; i < ghosts; ++i)
+    {
+        ghost_spawns.x.push_back(1 + static_cast<int>(i) % BENCHMARK_LEVEL_WIDTH);
+        ghost_spawns.y.push_back(2 + static_cast<int>(i) / BENCHMARK_LEVEL_WIDTH);
+    }
+    data.spawns.push_back(std::move(ghost_spawns));
+    return data;
+}
+
+/*!
+ * \brief run_frames updates the systems for BENCHMARK_FRAMES frames and returns the average frame time
+ */
+float run_frames(SystemScheduler& scheduler, EventBus& bus, unsigned& worker_systems)
+{
+    float total_ms = 0.f;
+    for (auto i = 0u; i < BENCHMARK_FRAMES; ++i)
+    {
+        scheduler.run(1.f / 60.f, bus);
+        bus.update();
+        total_ms += scheduler.get_stats().frame_ms;
+        worker_systems = scheduler.get_stats().worker_systems;
+    }
+    return total_ms / BENCHMARK_FRAMES;
+}
+
+/*!
+ * \brief run_repath_frames makes every ghost ask the AISystem for a new path before each of BENCHMARK_FRAMES frames, and
+ * returns the average frame time
+ */
+float run_repath_frames(entt::registry& reg, AISystem& ai, SystemScheduler& scheduler, EventBus& bus)
+{
+    float total_ms = 0.f;
+    for (auto i = 0u; i < BENCHMARK_FRAMES; ++i)
+    {
+        /* Every ghost reached a new tile, which is the most requests a tick can have */
+        auto ghosts = reg.view<CAI, CPosition, CMovement>();
+        ghosts.each([&ai](entt::entity e, const CAI&, const CPosition& pos, const CMovement& mov) {
+            ai.recieve(EvEntityMoved{e, mov.current_direction, pos.position});
+        });
+        scheduler.run(1.f / 60.f, bus);
+        bus.update();
+        total_ms += scheduler.get_stats().frame_ms;
+    }
+    return total_ms / BENCHMARK_FRAMES;
+}
+
+/*!
+ * \brief benchmark_systems fills a level of its own with ghosts and updates the systems that can run on workers, once one
+ * after another and once with the SystemScheduler running them in parallel, and logs the average frame time of each
+ * \param state is the lua state the entities are loaded in
+ * \param ghosts is the number of ghosts
+ */
+void benchmark_systems(sol::state_view& state, std::size_t ghosts)
+{
+    entt::registry reg{};
+    Level level{};
+    level.instantiate(state, reg, make_level(ghosts));
+
+    /* The systems that do not need the main thread, in the order the game state has them */
+    std::vector<std::unique_ptr<System>> systems{};
+    systems.emplace_back(std::make_unique<AISystem>(reg, level));
+    systems.emplace_back(std::make_unique<MovementSystem>(reg, level));
+    systems.emplace_back(std::make_unique<AnimationSystem>(reg));
+
+    /* Events go to a bus of their own with no listeners, the game's listeners must not hear about these entities */
+    EventBus bus{};
+    SystemScheduler scheduler{};
+    scheduler.set_systems(systems);
+
+    unsigned worker_systems = 0u;
+    scheduler.set_parallel(false);
+    run_frames(scheduler, bus, worker_systems);
+    const auto sequential_ms = run_frames(scheduler, bus, worker_systems);
+
+    scheduler.set_parallel(true);
+    run_frames(scheduler, bus, worker_systems);
+    const auto parallel_ms = run_frames(scheduler, bus, worker_systems);
+
+    GFX_INFO("Systems for %zu ghosts: %.3fms per frame one after another, %.3fms in parallel (%.2fx, %u of %zu systems on %u "
+             "workers).",
+             ghosts, sequential_ms, parallel_ms, parallel_ms > 0.f ? sequential_ms / parallel_ms : 0.f, worker_systems,
+             systems.size(), get_job_system().get_thread_count());
+}
+
+/*!
+ * \brief benchmark_repath fills a level of its own with ghosts that all ask for a new path every tick, and logs the average
+ * tick time of the AISystem with the searches solved on one thread and split over the job system
+ * \param state is the lua state the entities are loaded in
+ * \param ghosts is the number of ghosts
+ */
+void benchmark_repath(sol::state_view& state, std::size_t ghosts)
+{
+    entt::registry reg{};
+    Level level{};
+    level.instantiate(state, reg, make_level(ghosts));
+
+    std::vector<std::unique_ptr<System>> systems{};
+    auto& ai = static_cast<AISystem&>(*systems.emplace_back(std::make_unique<AISystem>(reg, level)));
+
+    /* Ghost state changes go to a bus of their own, the game's listeners must not hear about these entities */
+    EventBus bus{};
+    SystemScheduler scheduler{};
+    scheduler.set_systems(systems);
+
+    ai.set_parallel_repath(false);
+    run_repath_frames(reg, ai, scheduler, bus);
+    const auto sequential_ms = run_repath_frames(reg, ai, scheduler, bus);
+
+    ai.set_parallel_repath(true);
+    run_repath_frames(reg, ai, scheduler, bus);
+    const auto parallel_ms = run_repath_frames(reg, ai, scheduler, bus);
+
+    GFX_INFO("Repathing %zu ghosts every tick: %.3fms per tick on one thread, %.3fms split over the job system (%.2fx, %u "
+             "workers, batches of %u or more are split).",
+             ghosts, sequential_ms, parallel_ms, parallel_ms > 0.f ? sequential_ms / parallel_ms : 0.f,
+             get_job_system().get_thread_count(), AI_REPATH_PARALLEL_MIN);
+}
+}  // namespace
+}  // namespace pac
+
+PAC_BENCHMARK(systems, "AI, movement and animation of a level full of ghosts, one after another against in parallel")
+{
+    pac::benchmark_systems(lua, 5'000u);
+}
+
+PAC_BENCHMARK(repath, "Every ghost asking for a new path every tick, on one thread against split over the job system")
+{
+    pac::benchmark_repath(lua, 4u);
+    pac::benchmark_repath(lua, 64u);
+    pac::benchmark_repath(lua, 1'024u);
+}
@@ -1,8 +1,28 @@
--- Pickup Sound Effect
-function psound(data)
-    if data.pickup_name ~= "food" then
+-- Sound priorities (0 to 255, higher steals voices from lower) and voice limits (0 for no limit, otherwise the sound restarts)
+configure_sound("food_pickup", 64, 1)
+configure_sound("powerup_pickup", 128, 2)
+configure_sound("ghost_die", 192, 2)
+configure_sound("game_over", 255, 1)
+
+-- Which voice a sound takes when every voice is busy (OLDEST, or LOWEST_PRIORITY and the oldest of those)
+set_voice_steal_policy(VoiceStealPolicy.LOWEST_PRIORITY)
+
+-- Pickup Sound Effect (batched, gets every pickup of the frame at once and plays each sound only once)
+function psound(pickups, count)
+    local food = false
+    local powerup = false
+    for i = 1, count do
+        if pickups[i].pickup_name ~= "food" then
+            powerup = true
+        else
+            food = true
+        end
+    end
+
+    if powerup then
         play_sound("powerup_pickup")
-    else
+    end
+    if food then
         play_sound("food_pickup")
     end
 end
@@ -29,7 +49,7 @@ end
 
 -- Subscribe to Events with functions
 event_sub = {
-    pickup_sound = connect("Pickup", psound),
+    pickup_sound = connect_batched("Pickup", psound),
     ghost_sound = connect("GhostStateChanged", gdsound),
     pac_sound = connect("PacLifeChanged", plsound)
 }
@@ -1,7 +1,7 @@
 #version 450 core
 /* Input attributes */
 layout(location = 0) in vec2 vs_uv;
-layout(location = 1) in vec3 vs_col;
+layout(location = 1) in vec4 vs_col;
 layout(location = 2) in flat uint vs_tex_id;
 layout(location = 3) in flat uint vs_frame_no;
 
@@ -21,5 +21,5 @@ vec4 sample_texture()
 
 void main()
 {
-    fs_color = vec4(vs_col, 1.) * sample_texture();    
+    fs_color = vs_col * sample_texture();    
 }
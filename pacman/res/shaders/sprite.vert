@@ -3,12 +3,14 @@
 layout(location = 0) in vec2 a_pos;
 layout(location = 1) in vec2 a_uv;
 
-/* Per instance attributes */
-layout(location = 2) in vec2 ai_pos;
-layout(location = 3) in vec2 ai_scale;
-layout(location = 4) in vec3 ai_col;
+/* Per instance attributes (packed, position and scale are 12.4 fixed point and colour is RGBA8, see instance_packing.h) */
+layout(location = 2) in ivec2 ai_pos;
+layout(location = 3) in uvec2 ai_scale;
+layout(location = 4) in uvec4 ai_col;
 layout(location = 5) in uint ai_tex_id;
 
+const float FIXED_POINT_SCALE = 1. / 16.;
+
 /* Uniforms */
 layout(binding = 0, std140) uniform Matrices
 {
@@ -18,15 +20,17 @@ layout(binding = 0, std140) uniform Matrices
 
 /* Output attributes */
 layout(location = 0) out vec2 vs_uv;
-layout(location = 1) out vec3 vs_col;
+layout(location = 1) out vec4 vs_col;
 layout(location = 2) out flat uint vs_tex_id;
 layout(location = 3) out flat uint vs_frame_no;
 
 void main()
 {
     vs_uv = a_uv;
-    vs_col = ai_col;
+    vs_col = vec4(ai_col) / 255.;
     vs_tex_id = bitfieldExtract(ai_tex_id, 0, 8);
     vs_frame_no = bitfieldExtract(ai_tex_id, 8, 8);
-    gl_Position = projection_matrix * view_matrix * vec4(ai_scale * a_pos + ai_pos, 0., 1.);        
+    vec2 pos = vec2(ai_pos) * FIXED_POINT_SCALE;
+    vec2 scale = vec2(ai_scale) * FIXED_POINT_SCALE;
+    gl_Position = projection_matrix * view_matrix * vec4(scale * a_pos + pos, 0., 1.);        
 }
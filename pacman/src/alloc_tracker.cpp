@@ -0,0 +1,299 @@
+#include "alloc_tracker.h"
+
+#ifdef PAC_ENABLE_ALLOC_TRACKER
+
+#include "profiler.h"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+
+#include <gfx.h>
+#include <imgui/imgui.h>
+
+namespace pac
+{
+namespace
+{
+/* Zone used for allocations made outside of any profiler zone (or when the profiler is disabled) */
+constexpr const char* NO_ZONE = "(no zone)";
+
+/* Number of zones listed by log_summary */
+constexpr std::size_t SUMMARY_ZONES = 8u;
+
+/*!
+ * \brief The ZoneCounters struct is a slot in the open addressed table the hook attributes allocations to. Slots are claimed
+ * by storing the zone name, and are never released, so a slot index always refers to the same zone.
+ */
+struct ZoneCounters
+{
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> allocations{0u};
+    std::atomic<uint64_t> bytes{0u};
+};
+
+/* Everything the hook touches is constant initialized, so it works for allocations made before main */
+ZoneCounters g_zones[ALLOC_TRACKER_ZONE_SLOTS] = {};
+std::atomic<uint64_t> g_frame_allocations{0u};
+std::atomic<uint64_t> g_frame_frees{0u};
+std::atomic<uint64_t> g_frame_bytes{0u};
+
+/* Totals of the calling thread, read by AllocCounter */
+thread_local uint64_t t_allocations = 0u;
+thread_local uint64_t t_bytes = 0u;
+
+/*!
+ * \brief record_allocation counts an allocation and attributes it to the innermost zone. Must not allocate.
+ */
+void record_allocation(std::size_t size) noexcept
+{
+    ++t_allocations;
+    t_bytes += size;
+    g_frame_allocations.fetch_add(1u, std::memory_order_relaxed);
+    g_frame_bytes.fetch_add(size, std::memory_order_relaxed);
+
+#ifdef PAC_ENABLE_PROFILER
+    const auto* zone = Profiler::current_zone();
+    zone = zone ? zone : NO_ZONE;
+#else
+    const auto* zone = NO_ZONE;
+#endif
+
+    /* Zone names are literals, so the pointer identifies the zone */
+    auto slot = (reinterpret_cast<uintptr_t>(zone) >> 3u) % ALLOC_TRACKER_ZONE_SLOTS;
+    for (auto probe = 0u; probe < ALLOC_TRACKER_ZONE_SLOTS; ++probe, slot = (slot + 1u) % ALLOC_TRACKER_ZONE_SLOTS)
+    {
+        auto& counters = g_zones[slot];
+        const char* name = counters.name.load(std::memory_order_acquire);
+        if (!name && counters.name.compare_exchange_strong(name, zone, std::memory_order_acq_rel))
+        {
+            name = zone;
+        }
+
+        if (name == zone)
+        {
+            counters.allocations.fetch_add(1u, std::memory_order_relaxed);
+            counters.bytes.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    /* The table is full, the allocation is still part of the frame totals */
+}
+
+void* allocate(std::size_t size, std::size_t alignment) noexcept
+{
+    size = std::max<std::size_t>(size, 1u);
+
+    /* Alignment 0 is the plain operator new, the aligned ones always go through the aligned allocator so delete matches */
+    void* out = nullptr;
+    if (alignment == 0u)
+    {
+        out = std::malloc(size);
+    }
+    else
+    {
+#ifdef _MSC_VER
+        out = _aligned_malloc(size, alignment);
+#else
+        /* aligned_alloc requires the size to be a multiple of the alignment */
+        out = std::aligned_alloc(alignment, (size + alignment - 1u) / alignment * alignment);
+#endif
+    }
+
+    if (out)
+    {
+        record_allocation(size);
+    }
+    return out;
+}
+
+void* allocate_or_throw(std::size_t size, std::size_t alignment)
+{
+    /* Same contract as the default operator new, call the new handler until it gives up */
+    while (true)
+    {
+        if (auto* out = allocate(size, alignment))
+        {
+            return out;
+        }
+
+        if (auto handler = std::get_new_handler())
+        {
+            handler();
+        }
+        else
+        {
+            throw std::bad_alloc();
+        }
+    }
+}
+
+void deallocate(void* ptr, bool aligned) noexcept
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    g_frame_frees.fetch_add(1u, std::memory_order_relaxed);
+#ifdef _MSC_VER
+    aligned ? _aligned_free(ptr) : std::free(ptr);
+#else
+    (void)aligned;
+    std::free(ptr);
+#endif
+}
+}  // namespace
+
+AllocCounter::AllocCounter() noexcept : m_start_allocations(t_allocations), m_start_bytes(t_bytes) {}
+
+uint64_t AllocCounter::allocations() const noexcept { return t_allocations - m_start_allocations; }
+
+uint64_t AllocCounter::bytes() const noexcept { return t_bytes - m_start_bytes; }
+
+AllocBudget::AllocBudget(const char* name, uint64_t max_allocations) noexcept
+    : m_name(name), m_max_allocations(max_allocations)
+{
+}
+
+AllocBudget::~AllocBudget() noexcept
+{
+    const auto allocations = m_counter.allocations();
+    if (allocations > m_max_allocations && get_alloc_tracker().get_frame_count() >= ALLOC_BUDGET_WARMUP_FRAMES)
+    {
+        get_alloc_tracker().report_over_budget(m_name, allocations, m_max_allocations);
+    }
+}
+
+void AllocTracker::new_frame()
+{
+    m_last_frame.allocations = g_frame_allocations.exchange(0u, std::memory_order_relaxed);
+    m_last_frame.frees = g_frame_frees.exchange(0u, std::memory_order_relaxed);
+    m_last_frame.bytes = g_frame_bytes.exchange(0u, std::memory_order_relaxed);
+
+    for (std::size_t i = 0u; i < ALLOC_TRACKER_ZONE_SLOTS; ++i)
+    {
+        auto& zone = m_last_frame_zones[i];
+        zone.name = g_zones[i].name.load(std::memory_order_acquire);
+        zone.allocations = g_zones[i].allocations.exchange(0u, std::memory_order_relaxed);
+        zone.bytes = g_zones[i].bytes.exchange(0u, std::memory_order_relaxed);
+
+        m_total_zones[i].name = zone.name;
+        m_total_zones[i].allocations += zone.allocations;
+        m_total_zones[i].bytes += zone.bytes;
+    }
+
+    m_total.allocations += m_last_frame.allocations;
+    m_total.frees += m_last_frame.frees;
+    m_total.bytes += m_last_frame.bytes;
+    m_peak_allocations = std::max(m_peak_allocations, m_last_frame.allocations);
+    ++m_frames;
+}
+
+uint64_t AllocTracker::get_frame_count() const { return m_frames; }
+
+const AllocTracker::FrameStats& AllocTracker::get_last_frame() const { return m_last_frame; }
+
+void AllocTracker::draw_overlay() const
+{
+    ImGui::Text("Allocations: %llu (%.2fKiB)  Frees: %llu", static_cast<unsigned long long>(m_last_frame.allocations),
+                m_last_frame.bytes / 1024.f, static_cast<unsigned long long>(m_last_frame.frees));
+
+    if (ImGui::TreeNode("Allocations by Zone"))
+    {
+        /* Sort a copy so the busiest zones come first */
+        auto zones = m_last_frame_zones;
+        std::sort(zones.begin(), zones.end(), [](const auto& a, const auto& b) { return a.allocations > b.allocations; });
+        for (const auto& zone : zones)
+        {
+            if (zone.allocations == 0u)
+            {
+                break;
+            }
+            ImGui::Text("%-28s %6llu  %8.2fKiB", zone.name, static_cast<unsigned long long>(zone.allocations),
+                        zone.bytes / 1024.f);
+        }
+        ImGui::TreePop();
+    }
+}
+
+void AllocTracker::log_summary() const
+{
+    const auto frames = std::max<uint64_t>(m_frames, 1u);
+    GFX_INFO("Allocations over %llu frames: %llu (%.2fKiB), %.1f per frame, peak %llu in one frame, %llu frees.",
+             static_cast<unsigned long long>(m_frames), static_cast<unsigned long long>(m_total.allocations),
+             m_total.bytes / 1024.0, static_cast<double>(m_total.allocations) / frames,
+             static_cast<unsigned long long>(m_peak_allocations), static_cast<unsigned long long>(m_total.frees));
+
+    auto zones = m_total_zones;
+    std::sort(zones.begin(), zones.end(), [](const auto& a, const auto& b) { return a.allocations > b.allocations; });
+    for (std::size_t i = 0u; i < SUMMARY_ZONES && zones[i].allocations > 0u; ++i)
+    {
+        GFX_INFO("  %-28s %10llu allocations, %.1f per frame, %.2fKiB", zones[i].name,
+                 static_cast<unsigned long long>(zones[i].allocations),
+                 static_cast<double>(zones[i].allocations) / frames, zones[i].bytes / 1024.0);
+    }
+}
+
+uint64_t AllocTracker::get_over_budget_count() const { return m_over_budget_count.load(std::memory_order_relaxed); }
+
+void AllocTracker::set_over_budget_handler(OverBudgetHandler handler)
+{
+    m_over_budget_handler.store(handler, std::memory_order_relaxed);
+}
+
+void AllocTracker::report_over_budget(const char* name, uint64_t allocations, uint64_t max_allocations)
+{
+    m_over_budget_count.fetch_add(1u, std::memory_order_relaxed);
+    if (auto handler = m_over_budget_handler.load(std::memory_order_relaxed))
+    {
+        handler(name, allocations, max_allocations);
+    }
+
+    std::lock_guard lock(m_warned_budgets_mutex);
+    if (m_warned_budgets.insert(name).second)
+    {
+        GFX_WARN("Allocation budget %s exceeded: %llu allocations (budget is %llu).", name,
+                 static_cast<unsigned long long>(allocations), static_cast<unsigned long long>(max_allocations));
+    }
+}
+
+AllocTracker& get_alloc_tracker()
+{
+    static AllocTracker tracker{};
+    return tracker;
+}
+}  // namespace pac
+
+/* Replacements for every global allocation function, see [new.delete] */
+void* operator new(std::size_t size) { return pac::allocate_or_throw(size, 0u); }
+void* operator new[](std::size_t size) { return pac::allocate_or_throw(size, 0u); }
+void* operator new(std::size_t size, std::align_val_t al) { return pac::allocate_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return pac::allocate_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return pac::allocate(size, 0u); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return pac::allocate(size, 0u); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+    return pac::allocate(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+    return pac::allocate(size, static_cast<std::size_t>(al));
+}
+
+void operator delete(void* ptr) noexcept { pac::deallocate(ptr, false); }
+void operator delete[](void* ptr) noexcept { pac::deallocate(ptr, false); }
+void operator delete(void* ptr, std::size_t) noexcept { pac::deallocate(ptr, false); }
+void operator delete[](void* ptr, std::size_t) noexcept { pac::deallocate(ptr, false); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { pac::deallocate(ptr, false); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { pac::deallocate(ptr, false); }
+void operator delete(void* ptr, std::align_val_t) noexcept { pac::deallocate(ptr, true); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { pac::deallocate(ptr, true); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { pac::deallocate(ptr, true); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { pac::deallocate(ptr, true); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { pac::deallocate(ptr, true); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { pac::deallocate(ptr, true); }
+
+#endif
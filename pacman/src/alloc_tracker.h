@@ -0,0 +1,192 @@
+/*!
+ * \file alloc_tracker.h contains an opt-in allocation tracker. When the PACMAN_ALLOC_TRACKER CMake option is on, the global
+ * operator new and delete are replaced with versions that count allocations and bytes per frame, and attribute them to the
+ * innermost profiler zone (see profiler.h). When the option is off, the macros compile to nothing.
+ */
+
+#pragma once
+
+#ifdef PAC_ENABLE_ALLOC_TRACKER
+
+#include "config.h"
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <unordered_set>
+
+#define PAC_ALLOC_CONCAT_IMPL(a, b) a##b
+#define PAC_ALLOC_CONCAT(a, b) PAC_ALLOC_CONCAT_IMPL(a, b)
+
+/* Mark the start of a new frame for the allocation counters (call once per frame, from the main thread) */
+#define PAC_ALLOC_FRAME() ::pac::get_alloc_tracker().new_frame()
+
+/* Report if the rest of the current scope makes more than max_allocations allocations on this thread (after warm-up) */
+#define PAC_ALLOC_BUDGET(name, max_allocations) \
+    const ::pac::AllocBudget PAC_ALLOC_CONCAT(pac_alloc_budget_, __LINE__)(name, max_allocations)
+
+namespace pac
+{
+/*!
+ * \brief The AllocCounter class counts the allocations made on the calling thread since it was created. It is meant for
+ * asserting allocation budgets, for example that a system makes no allocations once the game has warmed up.
+ */
+class AllocCounter
+{
+private:
+    /* Thread totals when the counter was created */
+    uint64_t m_start_allocations = 0u;
+    uint64_t m_start_bytes = 0u;
+
+public:
+    AllocCounter() noexcept;
+
+    /*!
+     * \brief allocations returns the number of allocations made on this thread since the counter was created
+     */
+    uint64_t allocations() const noexcept;
+
+    /*!
+     * \brief bytes returns the number of bytes allocated on this thread since the counter was created
+     */
+    uint64_t bytes() const noexcept;
+};
+
+/*!
+ * \brief The AllocBudget class reports to the AllocTracker when the scope it lives in makes more allocations than allowed.
+ * Budgets are only checked after ALLOC_BUDGET_WARMUP_FRAMES frames, so containers have had time to reach their steady state
+ * capacity.
+ */
+class AllocBudget
+{
+private:
+    /* Name of the budget, must have static storage */
+    const char* m_name = nullptr;
+
+    /* Allowed number of allocations */
+    uint64_t m_max_allocations = 0u;
+
+    /* Counts the allocations made in the scope */
+    AllocCounter m_counter = {};
+
+public:
+    AllocBudget(const char* name, uint64_t max_allocations) noexcept;
+
+    AllocBudget(const AllocBudget&) = delete;
+    AllocBudget(AllocBudget&&) = delete;
+    AllocBudget& operator=(const AllocBudget&) = delete;
+    AllocBudget& operator=(AllocBudget&&) = delete;
+    ~AllocBudget() noexcept;
+};
+
+/*!
+ * \brief The AllocTracker class owns the per-frame totals of the allocation hook, and knows how to show and summarize them
+ */
+class AllocTracker
+{
+public:
+    /*!
+     * \brief OverBudgetHandler is called every time a budget is exceeded, with the name of the budget, the allocations made in
+     * its scope and the allowed number of allocations. Tests set one to fail when a budget is broken.
+     */
+    using OverBudgetHandler = void (*)(const char* name, uint64_t allocations, uint64_t max_allocations);
+
+    /*!
+     * \brief The ZoneStats struct contains the allocations attributed to a single zone
+     */
+    struct ZoneStats
+    {
+        const char* name = nullptr;
+        uint64_t allocations = 0u;
+        uint64_t bytes = 0u;
+    };
+
+    /*!
+     * \brief The FrameStats struct contains the allocation totals of a frame
+     */
+    struct FrameStats
+    {
+        uint64_t allocations = 0u;
+        uint64_t frees = 0u;
+        uint64_t bytes = 0u;
+    };
+
+private:
+    /* Totals of the previous frame */
+    FrameStats m_last_frame = {};
+
+    /* Allocations of the previous frame and of the whole run per zone (indexed like the slots of the hook) */
+    std::array<ZoneStats, ALLOC_TRACKER_ZONE_SLOTS> m_last_frame_zones = {};
+    std::array<ZoneStats, ALLOC_TRACKER_ZONE_SLOTS> m_total_zones = {};
+
+    /* Totals of the whole run */
+    FrameStats m_total = {};
+    uint64_t m_frames = 0u;
+    uint64_t m_peak_allocations = 0u;
+
+    /* Budgets that have been exceeded already, so each only warns once */
+    std::unordered_set<const char*> m_warned_budgets = {};
+    std::mutex m_warned_budgets_mutex = {};
+
+    /* Times any budget was exceeded, and what to call when it happens */
+    std::atomic<uint64_t> m_over_budget_count{0u};
+    std::atomic<OverBudgetHandler> m_over_budget_handler{nullptr};
+
+public:
+    /*!
+     * \brief new_frame moves the counters of the hook into the previous frame stats and starts counting a new frame
+     */
+    void new_frame();
+
+    /*!
+     * \brief get_frame_count returns the number of finished frames
+     */
+    uint64_t get_frame_count() const;
+
+    /*!
+     * \brief get_last_frame returns the totals of the previous frame
+     */
+    const FrameStats& get_last_frame() const;
+
+    /*!
+     * \brief draw_overlay adds the allocations of the previous frame to the current ImGui window
+     */
+    void draw_overlay() const;
+
+    /*!
+     * \brief log_summary logs the totals of the whole run, and the zones that allocated the most
+     */
+    void log_summary() const;
+
+    /*!
+     * \brief get_over_budget_count returns the number of times any budget was exceeded
+     */
+    uint64_t get_over_budget_count() const;
+
+    /*!
+     * \brief set_over_budget_handler sets a function to call every time a budget is exceeded (null for none)
+     */
+    void set_over_budget_handler(OverBudgetHandler handler);
+
+    /*!
+     * \brief report_over_budget counts an exceeded budget and calls the handler, and warns the first time it is exceeded
+     * \param name is the name of the budget
+     * \param allocations is the number of allocations made in the budgeted scope
+     * \param max_allocations is the allowed number of allocations
+     */
+    void report_over_budget(const char* name, uint64_t allocations, uint64_t max_allocations);
+};
+
+/*!
+ * \brief get_alloc_tracker returns the allocation tracker singleton
+ */
+AllocTracker& get_alloc_tracker();
+}  // namespace pac
+
+#else
+
+#define PAC_ALLOC_FRAME()
+#define PAC_ALLOC_BUDGET(name, max_allocations)
+
+#endif
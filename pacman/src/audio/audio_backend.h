@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief The EAudioBackend enum lists the available audio backends
+ */
+enum class EAudioBackend
+{
+    OpenAL,
+    Null,
+    Software
+};
+
+/*!
+ * \brief The AudioFormat struct describes PCM sample data
+ */
+struct AudioFormat
+{
+    /* Interleaved channels (OpenAL plays 1 (mono) or 2 (stereo), the software backend downmixes the rest to stereo) */
+    uint16_t channels = 0u;
+
+    /* 8 (unsigned), 16, 24 or 32 (signed, or float if is_float is set), OpenAL plays 8 and 16 only */
+    uint16_t bits_per_sample = 0u;
+
+    /* Sample frames per second */
+    uint32_t frequency = 0u;
+
+    /* Samples are IEEE floats rather than integers */
+    bool is_float = false;
+};
+
+/*!
+ * \brief The AudioMixStats struct contains the cost of mixing on the CPU (all zero for backends that do not mix)
+ */
+struct AudioMixStats
+{
+    /* Mixed blocks of AUDIO_MIX_BLOCK_MS each */
+    uint64_t blocks = 0u;
+
+    /* CPU time per block in milliseconds, averaged over the last second and the most it has been since the start */
+    float block_ms = 0.f;
+    float peak_block_ms = 0.f;
+
+    /* Sources that were mixed into the last block, and how many of them had to be resampled */
+    unsigned voices = 0u;
+    unsigned resampled_voices = 0u;
+};
+
+/*!
+ * \brief The AudioBackend class is the interface the SoundManager plays audio through. Sources and buffers work like OpenAL
+ * sources and buffers: a source plays one looping buffer or a queue of buffers, and queued buffers are processed once played.
+ * Handles are never 0. The functions may be called from both the main thread and the stream thread.
+ */
+class AudioBackend
+{
+public:
+    virtual ~AudioBackend() = default;
+
+    /*!
+     * \brief create_buffer creates an empty buffer
+     */
+    virtual unsigned create_buffer() = 0;
+
+    /*!
+     * \brief delete_buffer deletes a buffer that is not queued on any source
+     */
+    virtual void delete_buffer(unsigned buffer) = 0;
+
+    /*!
+     * \brief set_buffer_data copies sample data into a buffer
+     * \param buffer is the buffer to fill
+     * \param format is the format of the data
+     * \param data is the sample data, it is not used after the call
+     * \param size is the size of the data in bytes
+     */
+    virtual void set_buffer_data(unsigned buffer, const AudioFormat& format, const void* data, std::size_t size) = 0;
+
+    /*!
+     * \brief create_source creates a stopped source
+     */
+    virtual unsigned create_source() = 0;
+
+    /*!
+     * \brief delete_source deletes a source
+     */
+    virtual void delete_source(unsigned source) = 0;
+
+    /*!
+     * \brief play plays a single buffer on a source from the start, replacing anything the source played before
+     * \param looped is true to loop the buffer until the source is stopped
+     */
+    virtual void play(unsigned source, unsigned buffer, bool looped) = 0;
+
+    /*!
+     * \brief restart plays whatever the source holds again from the start
+     */
+    virtual void restart(unsigned source, bool looped) = 0;
+
+    /*!
+     * \brief stop stops a source, removes its buffers and turns looping off
+     */
+    virtual void stop(unsigned source) = 0;
+
+    /*!
+     * \brief is_playing returns false once a source has played to the end or has been stopped
+     */
+    virtual bool is_playing(unsigned source) = 0;
+
+    /*!
+     * \brief queue adds a buffer to the end of a source's queue, it does not start the source
+     */
+    virtual void queue(unsigned source, unsigned buffer) = 0;
+
+    /*!
+     * \brief unqueue_processed removes the first buffer from a source's queue if it has been played
+     * \return the buffer, or 0 if the first buffer has not been played yet
+     */
+    virtual unsigned unqueue_processed(unsigned source) = 0;
+
+    /*!
+     * \brief get_queued returns the number of buffers in a source's queue, played or not
+     */
+    virtual unsigned get_queued(unsigned source) = 0;
+
+    /*!
+     * \brief resume starts a stopped source again with the buffers in its queue, without changing them
+     */
+    virtual void resume(unsigned source) = 0;
+
+    /*!
+     * \brief advance moves the clock of a backend that is paced by the simulation instead of real time forward, and plays
+     * what falls within that time. Backends with a clock of their own do nothing.
+     * \param dt is the simulated time since the last call in seconds
+     */
+    virtual void advance(float /*dt*/) {}
+
+    /*!
+     * \brief get_mix_stats returns the cost of mixing, for backends that mix on the CPU
+     */
+    virtual AudioMixStats get_mix_stats() const { return {}; }
+};
+}  // namespace pac
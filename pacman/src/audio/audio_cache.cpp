@@ -0,0 +1,306 @@
+#include "audio_cache.h"
+#include "waveloader.h"
+#include "job_system.h"
+#include "config.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+constexpr char CACHE_MAGIC[4] = {'P', 'A', 'C', 'A'};
+constexpr uint32_t CACHE_VERSION = 1u;
+
+/* Samples of every clip start on this alignment */
+constexpr std::size_t SAMPLE_ALIGNMENT = 16u;
+
+template <typename T>
+void append_le(std::vector<uint8_t>& out, T value)
+{
+    for (auto i = 0u; i < sizeof(T); ++i)
+    {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8u * i)));
+    }
+}
+
+/*!
+ * \brief The Reader struct reads little endian values from the cache file, and remembers if it ever read past the end
+ */
+struct Reader
+{
+    const std::vector<uint8_t>& bytes;
+    std::size_t position = 0u;
+    bool ok = true;
+
+    template <typename T>
+    T read()
+    {
+        if (!ok || bytes.size() - position < sizeof(T))
+        {
+            ok = false;
+            return T{};
+        }
+
+        uint64_t value = 0u;
+        for (auto i = 0u; i < sizeof(T); ++i)
+        {
+            value |= static_cast<uint64_t>(bytes[position + i]) << (8u * i);
+        }
+        position += sizeof(T);
+        return static_cast<T>(value);
+    }
+
+    std::string read_string(std::size_t length)
+    {
+        if (!ok || bytes.size() - position < length)
+        {
+            ok = false;
+            return {};
+        }
+
+        std::string out(reinterpret_cast<const char*>(bytes.data() + position), length);
+        position += length;
+        return out;
+    }
+};
+
+/*!
+ * \brief convert_source decodes a WAV file, resamples it to AUDIO_MIX_FREQUENCY and quantizes it to 16 bits
+ * \param out is given the samples
+ * \param stats is counted up with what the conversion cost (except convert_ms)
+ * \return the number of channels, or 0 if the file could not be read
+ */
+uint16_t convert_source(const AudioCacheSource& source, std::vector<int16_t>& out, AudioCacheBuildStats& stats)
+{
+    loadio::WaveFile wave = {};
+    try
+    {
+        wave.loadFromFile(source.path.c_str());
+    }
+    catch (const std::exception& e)
+    {
+        GFX_WARN("Not caching audio file: %s", e.what());
+        ++stats.skipped;
+        return 0u;
+    }
+
+    const auto bits = wave.bitsPerSample();
+    if ((bits != 8u && bits != 16u && bits != 24u && bits != 32u) || (wave.isFloat() && bits != 32u))
+    {
+        GFX_WARN("Not caching audio file (%s), it has %u bit samples.", source.path.c_str(), bits);
+        ++stats.skipped;
+        return 0u;
+    }
+
+    /* Decode to floats, keeping mono as mono and the first two channels of anything else */
+    const auto in_channels = wave.channels();
+    const auto out_channels = std::min<uint16_t>(in_channels, 2u);
+    const auto bytes_per_sample = wave.blockAlign() / in_channels;
+    const std::size_t frames = wave.size() / wave.blockAlign();
+    std::vector<float> decoded(frames * out_channels);
+    for (std::size_t frame = 0u; frame < frames; ++frame)
+    {
+        for (auto channel = 0u; channel < out_channels; ++channel)
+        {
+            const auto* sample = wave.data() + frame * wave.blockAlign() + channel * bytes_per_sample;
+            decoded[frame * out_channels + channel] = loadio::detail::decode_sample(sample, bits, wave.isFloat());
+        }
+    }
+
+    /* Resample to the target rate with linear interpolation */
+    const auto* samples = &decoded;
+    std::vector<float> resampled = {};
+    std::size_t out_frames = frames;
+    if (wave.frequency() != AUDIO_MIX_FREQUENCY && frames > 0u && wave.frequency() > 0u)
+    {
+        const auto resample_start = std::chrono::steady_clock::now();
+        out_frames = static_cast<std::size_t>(uint64_t{frames} * AUDIO_MIX_FREQUENCY / wave.frequency());
+        resampled.resize(out_frames * out_channels);
+        const double step = static_cast<double>(wave.frequency()) / AUDIO_MIX_FREQUENCY;
+        for (std::size_t frame = 0u; frame < out_frames; ++frame)
+        {
+            const auto position = frame * step;
+            const auto first = std::min(static_cast<std::size_t>(position), frames - 1u);
+            const auto second = std::min(first + 1u, frames - 1u);
+            const auto t = static_cast<float>(position - first);
+            for (auto channel = 0u; channel < out_channels; ++channel)
+            {
+                const auto a = decoded[first * out_channels + channel];
+                const auto b = decoded[second * out_channels + channel];
+                resampled[frame * out_channels + channel] = a + (b - a) * t;
+            }
+        }
+
+        samples = &resampled;
+        ++stats.resampled;
+        stats.resample_ms +=
+            std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - resample_start).count();
+    }
+
+    /* Quantize to 16 bits */
+    out.resize(out_frames * out_channels);
+    for (std::size_t sample = 0u; sample < out.size(); ++sample)
+    {
+        out[sample] = static_cast<int16_t>(std::lround(std::clamp((*samples)[sample], -1.f, 1.f) * 32767.f));
+    }
+
+    ++stats.converted;
+    return out_channels;
+}
+}  // namespace
+
+bool AudioCache::load(const std::string& fp, const std::vector<AudioCacheSource>& sources)
+{
+    m_file.clear();
+    m_clips.clear();
+
+    /* The one read */
+    std::ifstream file(fp, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return false;
+    }
+
+    m_file.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(m_file.data()), static_cast<std::streamsize>(m_file.size())))
+    {
+        m_file.clear();
+        return false;
+    }
+
+    /* Check the header, then that every clip belongs to an unchanged source and fits in the file */
+    Reader reader{m_file};
+    const auto magic = reader.read_string(sizeof(CACHE_MAGIC));
+    const auto version = reader.read<uint32_t>();
+    const auto frequency = reader.read<uint32_t>();
+    const auto count = reader.read<uint32_t>();
+    bool valid = reader.ok && std::memcmp(magic.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 version == CACHE_VERSION && frequency == AUDIO_MIX_FREQUENCY && count == sources.size();
+
+    for (uint32_t i = 0u; valid && i < count; ++i)
+    {
+        Clip clip = {};
+        clip.name = reader.read_string(reader.read<uint16_t>());
+        clip.channels = reader.read<uint16_t>();
+        clip.frames = reader.read<uint32_t>();
+        clip.offset = reader.read<uint64_t>();
+        const auto source_size = reader.read<uint64_t>();
+        const auto source_modified = reader.read<int64_t>();
+
+        const auto source = std::find_if(sources.begin(), sources.end(),
+                                         [&clip](const AudioCacheSource& s) { return s.name == clip.name; });
+        const auto bytes = uint64_t{clip.frames} * clip.channels * sizeof(int16_t);
+        valid = reader.ok && source != sources.end() && source->size == source_size && source->modified == source_modified &&
+                clip.channels <= 2u && clip.offset % SAMPLE_ALIGNMENT == 0u && clip.offset <= m_file.size() &&
+                bytes <= m_file.size() - clip.offset;
+        m_clips.push_back(std::move(clip));
+    }
+
+    if (!valid)
+    {
+        m_file.clear();
+        m_clips.clear();
+    }
+    return valid;
+}
+
+AudioCacheBuildStats AudioCache::build(const std::vector<AudioCacheSource>& sources)
+{
+    AudioCacheBuildStats stats = {};
+    const auto build_start = std::chrono::steady_clock::now();
+
+    /* Convert every source in parallel, a source that can not be read is kept as an empty clip so the cache still matches the
+     * sources. Every source counts its own stats, which are added up afterwards. */
+    std::vector<std::vector<int16_t>> converted(sources.size());
+    std::vector<AudioCacheBuildStats> source_stats(sources.size());
+    m_clips.assign(sources.size(), {});
+    get_job_system().parallel_for("Audio Cache Source", 0u, sources.size(), 1u, [&](std::size_t i, std::size_t) {
+        m_clips[i].name = sources[i].name;
+        m_clips[i].channels = convert_source(sources[i], converted[i], source_stats[i]);
+        m_clips[i].frames = m_clips[i].channels > 0u ? static_cast<uint32_t>(converted[i].size() / m_clips[i].channels) : 0u;
+    });
+
+    for (const auto& source : source_stats)
+    {
+        stats.converted += source.converted;
+        stats.resampled += source.resampled;
+        stats.skipped += source.skipped;
+        stats.resample_ms += source.resample_ms;
+    }
+
+    /* Lay the file out: header, index and then the samples of every clip */
+    std::size_t index_bytes = sizeof(CACHE_MAGIC) + 3u * sizeof(uint32_t);
+    for (const auto& clip : m_clips)
+    {
+        index_bytes += sizeof(uint16_t) + clip.name.size() + 2u * sizeof(uint16_t) + sizeof(uint32_t) + 3u * sizeof(uint64_t);
+    }
+
+    auto offset = (index_bytes + SAMPLE_ALIGNMENT - 1u) / SAMPLE_ALIGNMENT * SAMPLE_ALIGNMENT;
+    for (std::size_t i = 0u; i < m_clips.size(); ++i)
+    {
+        m_clips[i].offset = offset;
+        offset += (converted[i].size() * sizeof(int16_t) + SAMPLE_ALIGNMENT - 1u) / SAMPLE_ALIGNMENT * SAMPLE_ALIGNMENT;
+    }
+
+    m_file.clear();
+    m_file.reserve(offset);
+    m_file.insert(m_file.end(), std::begin(CACHE_MAGIC), std::end(CACHE_MAGIC));
+    append_le(m_file, CACHE_VERSION);
+    append_le(m_file, AUDIO_MIX_FREQUENCY);
+    append_le(m_file, static_cast<uint32_t>(m_clips.size()));
+    for (std::size_t i = 0u; i < m_clips.size(); ++i)
+    {
+        append_le(m_file, static_cast<uint16_t>(m_clips[i].name.size()));
+        m_file.insert(m_file.end(), m_clips[i].name.begin(), m_clips[i].name.end());
+        append_le(m_file, m_clips[i].channels);
+        append_le(m_file, m_clips[i].frames);
+        append_le(m_file, m_clips[i].offset);
+        append_le(m_file, sources[i].size);
+        append_le(m_file, sources[i].modified);
+    }
+
+    for (std::size_t i = 0u; i < m_clips.size(); ++i)
+    {
+        m_file.resize(m_clips[i].offset, 0u);
+        const auto* bytes = reinterpret_cast<const uint8_t*>(converted[i].data());
+        m_file.insert(m_file.end(), bytes, bytes + converted[i].size() * sizeof(int16_t));
+    }
+    m_file.resize(offset, 0u);
+
+    stats.convert_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+    return stats;
+}
+
+bool AudioCache::save(const std::string& fp) const
+{
+    std::ofstream file(fp, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(m_file.data()), static_cast<std::streamsize>(m_file.size()));
+    return static_cast<bool>(file);
+}
+
+std::size_t AudioCache::get_clip_count() const { return m_clips.size(); }
+
+const std::string& AudioCache::get_name(std::size_t clip) const { return m_clips[clip].name; }
+
+AudioFormat AudioCache::get_format(std::size_t clip) const { return {m_clips[clip].channels, 16u, AUDIO_MIX_FREQUENCY}; }
+
+const int16_t* AudioCache::get_samples(std::size_t clip) const
+{
+    return reinterpret_cast<const int16_t*>(m_file.data() + m_clips[clip].offset);
+}
+
+std::size_t AudioCache::get_bytes(std::size_t clip) const
+{
+    return std::size_t{m_clips[clip].frames} * m_clips[clip].channels * sizeof(int16_t);
+}
+
+std::size_t AudioCache::get_file_size() const { return m_file.size(); }
+}  // namespace pac
@@ -0,0 +1,126 @@
+/*!
+ * \file audio_cache.h contains the audio cache, which holds every sound effect converted to one format in a single file
+ */
+
+#pragma once
+
+#include "audio_backend.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief The AudioCacheSource struct is a WAV file that belongs in the cache, and what it looked like when it was converted
+ */
+struct AudioCacheSource
+{
+    /* Name the sound is played by */
+    std::string name{};
+
+    std::string path{};
+
+    /* Size and modification time of the file, if either changes the cache is rebuilt */
+    uint64_t size = 0u;
+    int64_t modified = 0;
+};
+
+/*!
+ * \brief The AudioCacheBuildStats struct tells what converting the sources cost
+ */
+struct AudioCacheBuildStats
+{
+    /* Sources that were converted, and those that had to be resampled to the target rate */
+    std::size_t converted = 0u;
+    std::size_t resampled = 0u;
+
+    /* Sources that could not be read */
+    std::size_t skipped = 0u;
+
+    /* Time spent converting, and the time every thread spent resampling added up (sources are converted in parallel, so it
+     * can be more than the time spent converting) */
+    float convert_ms = 0.f;
+    float resample_ms = 0.f;
+};
+
+/*!
+ * \brief The AudioCache class keeps sound effects as 16-bit samples at AUDIO_MIX_FREQUENCY (mono or stereo, as authored), so
+ * they never need to be converted or resampled at play time. The cache file is a small index followed by the samples, and is
+ * loaded with a single read. The samples handed out point into the loaded file.
+ */
+class AudioCache
+{
+private:
+    /*!
+     * \brief The Clip struct is an index entry
+     */
+    struct Clip
+    {
+        std::string name{};
+        uint16_t channels = 0u;
+        uint32_t frames = 0u;
+
+        /* Offset of the samples in the file */
+        uint64_t offset = 0u;
+    };
+
+    /* The whole cache file, exactly as it is stored */
+    std::vector<uint8_t> m_file = {};
+
+    std::vector<Clip> m_clips = {};
+
+public:
+    /*!
+     * \brief load reads a cache file, and checks that it was built from exactly the given sources
+     * \param fp is the cache file
+     * \param sources are the files the cache should contain
+     * \return false if the file is missing, broken or out of date (the cache is then empty)
+     */
+    bool load(const std::string& fp, const std::vector<AudioCacheSource>& sources);
+
+    /*!
+     * \brief build converts the sources into the cache, replacing what it held
+     * \return what the conversion cost
+     */
+    AudioCacheBuildStats build(const std::vector<AudioCacheSource>& sources);
+
+    /*!
+     * \brief save writes the cache to a file
+     * \return true if the file was written
+     */
+    bool save(const std::string& fp) const;
+
+    /*!
+     * \brief get_clip_count returns the number of sounds in the cache
+     */
+    std::size_t get_clip_count() const;
+
+    /*!
+     * \brief get_name returns the name of a sound in the cache
+     */
+    const std::string& get_name(std::size_t clip) const;
+
+    /*!
+     * \brief get_format returns the format of a sound in the cache
+     */
+    AudioFormat get_format(std::size_t clip) const;
+
+    /*!
+     * \brief get_samples returns the samples of a sound in the cache
+     */
+    const int16_t* get_samples(std::size_t clip) const;
+
+    /*!
+     * \brief get_bytes returns the size of the samples of a sound in the cache
+     */
+    std::size_t get_bytes(std::size_t clip) const;
+
+    /*!
+     * \brief get_file_size returns the size of the cache file
+     */
+    std::size_t get_file_size() const;
+};
+}  // namespace pac
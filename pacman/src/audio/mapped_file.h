@@ -0,0 +1,62 @@
+/*!
+ * \file mapped_file.h contains a read only memory mapping of a file
+ */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief The MappedFile class maps a whole file into memory for reading. The pages are loaded by the OS on first access, so
+ * mapping a file is cheap and nothing is copied until the contents are read.
+ */
+class MappedFile
+{
+private:
+    const uint8_t* m_data = nullptr;
+    std::size_t m_size = 0u;
+
+#ifdef _WIN32
+    /* File and file mapping handles */
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    ~MappedFile() noexcept;
+
+    /*!
+     * \brief open maps a file, unmapping the current one first
+     * \param fp is the file to map
+     * \return false if the file could not be opened or mapped (empty files can not be mapped)
+     */
+    bool open(const std::string& fp);
+
+    /*!
+     * \brief close unmaps the file
+     */
+    void close();
+
+    /*!
+     * \brief data returns the start of the mapped file, or nullptr if nothing is mapped
+     */
+    const uint8_t* data() const;
+
+    /*!
+     * \brief size returns the size of the mapped file in bytes
+     */
+    std::size_t size() const;
+};
+}  // namespace pac
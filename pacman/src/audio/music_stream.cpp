@@ -0,0 +1,160 @@
+#include "music_stream.h"
+#include "waveloader.h"
+#include "audio_backend.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+MusicStream::MusicStream() = default;
+
+MusicStream::~MusicStream() noexcept
+{
+    stop();
+    if (m_buffers[0] != 0u)
+    {
+        for (auto buffer : m_buffers)
+        {
+            m_backend->delete_buffer(buffer);
+        }
+    }
+}
+
+bool MusicStream::open(AudioBackend& backend, const std::string& fp)
+{
+    m_backend = &backend;
+    try
+    {
+        m_wave = std::make_unique<loadio::WaveFile>(fp);
+    }
+    catch (const std::exception& e)
+    {
+        GFX_WARN("Could not open %s for streaming: %s", fp.c_str(), e.what());
+        m_wave = nullptr;
+        return false;
+    }
+
+    if (m_wave->getALformat() == 0 || m_wave->size() == 0u)
+    {
+        GFX_WARN("%s is not a WAV file that can be streamed.", fp.c_str());
+        m_wave = nullptr;
+        return false;
+    }
+
+    /* Whole sample frames only, so a buffer never splits a frame */
+    m_buffer_bytes = std::max<std::size_t>(AUDIO_STREAM_BUFFER_BYTES / m_wave->blockAlign(), 1u) * m_wave->blockAlign();
+    m_scratch.resize(m_buffer_bytes);
+    for (auto& buffer : m_buffers)
+    {
+        buffer = m_backend->create_buffer();
+    }
+    return true;
+}
+
+void MusicStream::start(unsigned source, bool looped)
+{
+    stop();
+
+    m_source = source;
+    m_looped = looped;
+    m_finished = false;
+    m_position = 0u;
+
+    /* The stream does the looping, so the source must not (stopping turns it off) */
+    m_backend->stop(m_source);
+    for (auto buffer : m_buffers)
+    {
+        if (fill(buffer))
+        {
+            m_backend->queue(m_source, buffer);
+        }
+    }
+    m_backend->resume(m_source);
+}
+
+void MusicStream::stop()
+{
+    if (m_source == 0u)
+    {
+        return;
+    }
+
+    m_backend->stop(m_source);
+    m_source = 0u;
+    m_finished = false;
+}
+
+void MusicStream::update()
+{
+    if (m_source == 0u || m_finished)
+    {
+        return;
+    }
+
+    for (auto buffer = m_backend->unqueue_processed(m_source); buffer != 0u; buffer = m_backend->unqueue_processed(m_source))
+    {
+        if (fill(buffer))
+        {
+            m_backend->queue(m_source, buffer);
+        }
+    }
+
+    if (!m_backend->is_playing(m_source))
+    {
+        /* If buffers are still queued the source ran dry before they were refilled, otherwise the track is over */
+        if (m_backend->get_queued(m_source) > 0u)
+        {
+            ++m_underruns;
+            m_backend->resume(m_source);
+        }
+        else
+        {
+            m_finished = true;
+        }
+    }
+}
+
+unsigned MusicStream::get_source() const { return m_source; }
+
+bool MusicStream::is_finished() const { return m_finished; }
+
+std::size_t MusicStream::get_resident_bytes() const { return m_buffers.size() * m_buffer_bytes + m_scratch.size(); }
+
+unsigned MusicStream::get_underruns() const { return m_underruns; }
+
+bool MusicStream::fill(unsigned buffer)
+{
+    const auto data_size = m_wave->size();
+    if (m_position == data_size)
+    {
+        if (!m_looped)
+        {
+            return false;
+        }
+        m_position = 0u;
+    }
+
+    /* Most buffers are handed to the backend straight from the mapping, only the one where a looping track wraps is copied */
+    const uint8_t* source = m_wave->data() + m_position;
+    auto count = std::min(m_buffer_bytes, data_size - m_position);
+    m_position += count;
+    if (m_looped && count < m_buffer_bytes)
+    {
+        std::memcpy(m_scratch.data(), source, count);
+        while (count < m_buffer_bytes)
+        {
+            const auto wrapped = std::min(m_buffer_bytes - count, data_size);
+            std::memcpy(m_scratch.data() + count, m_wave->data(), wrapped);
+            count += wrapped;
+            m_position = wrapped;
+        }
+        source = m_scratch.data();
+    }
+
+    m_backend->set_buffer_data(buffer, m_wave->getFormat(), source, count);
+    return true;
+}
+}  // namespace pac
@@ -0,0 +1,123 @@
+/*!
+ * \file music_stream.h contains streaming playback of long WAV files (music tracks), so they do not have to be loaded into
+ * audio buffers in full.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/* Forward Declarations */
+namespace loadio
+{
+class WaveFile;
+}
+
+namespace pac
+{
+class AudioBackend;
+
+/*!
+ * \brief The MusicStream class plays a WAV file through a small ring of AUDIO_STREAM_BUFFERS audio buffers. The buffers are
+ * queued on a source and refilled from the memory mapped file as the source finishes them. Looping is done by wrapping the
+ * read position while filling, so there is no gap between the end and the start of the track.
+ * \note A stream is not thread safe. The SoundManager only touches it with its stream mutex held.
+ */
+class MusicStream
+{
+private:
+    /* What the buffers are played through */
+    AudioBackend* m_backend = nullptr;
+
+    /* The mapped file */
+    std::unique_ptr<loadio::WaveFile> m_wave{};
+
+    /* Read position in the PCM data */
+    std::size_t m_position = 0u;
+
+    /* Bytes handed to the backend per buffer (whole sample frames) */
+    std::size_t m_buffer_bytes = 0u;
+
+    /* The buffers that are filled and queued, and where the end and the start of a looping track are joined */
+    std::array<unsigned, AUDIO_STREAM_BUFFERS> m_buffers = {};
+    std::vector<uint8_t> m_scratch = {};
+
+    /* Source the stream is playing on (0 when stopped) */
+    unsigned m_source = 0u;
+
+    bool m_looped = false;
+
+    /* True when a stream that does not loop has played to the end */
+    bool m_finished = false;
+
+    /* Times the source ran out of queued audio and had to be restarted */
+    unsigned m_underruns = 0u;
+
+public:
+    MusicStream();
+
+    MusicStream(const MusicStream&) = delete;
+    MusicStream(MusicStream&&) = delete;
+    MusicStream& operator=(const MusicStream&) = delete;
+    MusicStream& operator=(MusicStream&&) = delete;
+    ~MusicStream() noexcept;
+
+    /*!
+     * \brief open opens a WAV file for streaming and creates the stream buffers
+     * \param backend is the backend to create the buffers with and play them through, it must outlive the stream
+     * \param fp is the file to stream
+     * \return true if the file is a WAV file in a format that can be played
+     */
+    bool open(AudioBackend& backend, const std::string& fp);
+
+    /*!
+     * \brief start starts playing the stream from the beginning
+     * \param source is the source to play on, the stream uses it until stop is called
+     * \param looped is true to loop the track forever
+     */
+    void start(unsigned source, bool looped);
+
+    /*!
+     * \brief stop stops the stream and unqueues its buffers from the source
+     */
+    void stop();
+
+    /*!
+     * \brief update refills and requeues the buffers the source has finished, call regularly while the stream is playing
+     */
+    void update();
+
+    /*!
+     * \brief get_source returns the source the stream is playing on, or 0 if it is stopped
+     */
+    unsigned get_source() const;
+
+    /*!
+     * \brief is_finished returns true if the stream did not loop and has played to the end (it still holds its source)
+     */
+    bool is_finished() const;
+
+    /*!
+     * \brief get_resident_bytes returns the size of the stream buffers
+     */
+    std::size_t get_resident_bytes() const;
+
+    /*!
+     * \brief get_underruns returns the number of times the source ran dry before it was refilled
+     */
+    unsigned get_underruns() const;
+
+private:
+    /*!
+     * \brief fill reads the next part of the track into a buffer
+     * \return false if there is nothing left to read
+     */
+    bool fill(unsigned buffer);
+};
+}  // namespace pac
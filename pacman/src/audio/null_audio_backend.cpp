@@ -0,0 +1,30 @@
+#include "null_audio_backend.h"
+
+namespace pac
+{
+unsigned NullAudioBackend::create_buffer() { return ++m_handles; }
+
+void NullAudioBackend::delete_buffer(unsigned) {}
+
+void NullAudioBackend::set_buffer_data(unsigned, const AudioFormat&, const void*, std::size_t) {}
+
+unsigned NullAudioBackend::create_source() { return ++m_handles; }
+
+void NullAudioBackend::delete_source(unsigned) {}
+
+void NullAudioBackend::play(unsigned, unsigned, bool) {}
+
+void NullAudioBackend::restart(unsigned, bool) {}
+
+void NullAudioBackend::stop(unsigned) {}
+
+bool NullAudioBackend::is_playing(unsigned) { return false; }
+
+void NullAudioBackend::queue(unsigned, unsigned) {}
+
+unsigned NullAudioBackend::unqueue_processed(unsigned) { return 0u; }
+
+unsigned NullAudioBackend::get_queued(unsigned) { return 0u; }
+
+void NullAudioBackend::resume(unsigned) {}
+}  // namespace pac
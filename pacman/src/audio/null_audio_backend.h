@@ -0,0 +1,46 @@
+#pragma once
+
+#include "audio_backend.h"
+
+#include <atomic>
+
+namespace pac
+{
+/*!
+ * \brief The NullAudioBackend class plays nothing. Sources are stopped as soon as they are played, so voices are handed back
+ * right away and streams finish immediately. Used when there is no audio device, or when audio is not wanted.
+ */
+class NullAudioBackend : public AudioBackend
+{
+private:
+    /* Handles given out so far (buffers and sources share the counter) */
+    std::atomic<unsigned> m_handles{0u};
+
+public:
+    unsigned create_buffer() override;
+
+    void delete_buffer(unsigned buffer) override;
+
+    void set_buffer_data(unsigned buffer, const AudioFormat& format, const void* data, std::size_t size) override;
+
+    unsigned create_source() override;
+
+    void delete_source(unsigned source) override;
+
+    void play(unsigned source, unsigned buffer, bool looped) override;
+
+    void restart(unsigned source, bool looped) override;
+
+    void stop(unsigned source) override;
+
+    bool is_playing(unsigned source) override;
+
+    void queue(unsigned source, unsigned buffer) override;
+
+    unsigned unqueue_processed(unsigned source) override;
+
+    unsigned get_queued(unsigned source) override;
+
+    void resume(unsigned source) override;
+};
+}  // namespace pac
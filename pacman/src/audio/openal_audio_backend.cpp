@@ -0,0 +1,158 @@
+#include "openal_audio_backend.h"
+
+#include <gfx.h>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+namespace pac
+{
+namespace
+{
+/*!
+ * \brief to_al_format returns the OpenAL format enum of a sample format, or 0 if OpenAL can not play it
+ */
+ALenum to_al_format(const AudioFormat& format)
+{
+    if (format.channels == 2u && format.bits_per_sample == 16u)
+    {
+        return AL_FORMAT_STEREO16;
+    }
+    else if (format.channels == 2u && format.bits_per_sample == 8u)
+    {
+        return AL_FORMAT_STEREO8;
+    }
+    else if (format.channels == 1u && format.bits_per_sample == 16u)
+    {
+        return AL_FORMAT_MONO16;
+    }
+    else if (format.channels == 1u && format.bits_per_sample == 8u)
+    {
+        return AL_FORMAT_MONO8;
+    }
+
+    return 0;
+}
+}  // namespace
+
+OpenALAudioBackend::OpenALAudioBackend()
+{
+    /* Initialize device and context */
+    m_audio_device = alcOpenDevice(nullptr);
+    if (!m_audio_device)
+    {
+        return;
+    }
+
+    m_audio_context = alcCreateContext(m_audio_device, nullptr);
+    if (!m_audio_context)
+    {
+        alcCloseDevice(m_audio_device);
+        m_audio_device = nullptr;
+        return;
+    }
+    alcMakeContextCurrent(m_audio_context);
+
+    const auto* device_name = alcGetString(m_audio_device, ALC_DEVICE_SPECIFIER);
+    GFX_INFO("Using audio device: %s", device_name);
+
+    /* Set listener position and velocity to 0 */
+    alListener3f(AL_POSITION, 0.f, 0.f, 0.f);
+    alListener3f(AL_VELOCITY, 0.f, 0.f, 0.f);
+}
+
+OpenALAudioBackend::~OpenALAudioBackend()
+{
+    if (m_audio_context)
+    {
+        alcMakeContextCurrent(nullptr);
+        alcDestroyContext(m_audio_context);
+        alcCloseDevice(m_audio_device);
+    }
+}
+
+bool OpenALAudioBackend::is_open() const { return m_audio_context != nullptr; }
+
+unsigned OpenALAudioBackend::create_buffer()
+{
+    ALuint buffer = 0u;
+    alGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void OpenALAudioBackend::delete_buffer(unsigned buffer) { alDeleteBuffers(1, &buffer); }
+
+void OpenALAudioBackend::set_buffer_data(unsigned buffer, const AudioFormat& format, const void* data, std::size_t size)
+{
+    alBufferData(buffer, to_al_format(format), data, static_cast<ALsizei>(size), static_cast<ALsizei>(format.frequency));
+}
+
+unsigned OpenALAudioBackend::create_source()
+{
+    ALuint source = 0u;
+    alGenSources(1, &source);
+
+    /* Set all positions and velocities to 0 */
+    alSource3f(source, AL_POSITION, 0.f, 0.f, 0.f);
+    alSource3f(source, AL_VELOCITY, 0.f, 0.f, 0.f);
+    alSourcei(source, AL_LOOPING, 0);
+    return source;
+}
+
+void OpenALAudioBackend::delete_source(unsigned source) { alDeleteSources(1, &source); }
+
+void OpenALAudioBackend::play(unsigned source, unsigned buffer, bool looped)
+{
+    alSourceStop(source);
+    alSourcei(source, AL_LOOPING, static_cast<int>(looped));
+    alSourcei(source, AL_BUFFER, static_cast<ALint>(buffer));
+    alSourcePlay(source);
+}
+
+void OpenALAudioBackend::restart(unsigned source, bool looped)
+{
+    alSourcei(source, AL_LOOPING, static_cast<int>(looped));
+    alSourceRewind(source);
+    alSourcePlay(source);
+}
+
+void OpenALAudioBackend::stop(unsigned source)
+{
+    /* Stopping marks every queued buffer as processed, and clearing the buffer unqueues them all */
+    alSourceStop(source);
+    alSourcei(source, AL_BUFFER, 0);
+    alSourcei(source, AL_LOOPING, 0);
+}
+
+bool OpenALAudioBackend::is_playing(unsigned source)
+{
+    ALint state = 0;
+    alGetSourcei(source, AL_SOURCE_STATE, &state);
+    return state != AL_STOPPED;
+}
+
+void OpenALAudioBackend::queue(unsigned source, unsigned buffer) { alSourceQueueBuffers(source, 1, &buffer); }
+
+unsigned OpenALAudioBackend::unqueue_processed(unsigned source)
+{
+    ALint processed = 0;
+    alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+    if (processed == 0)
+    {
+        return 0u;
+    }
+
+    ALuint buffer = 0u;
+    alSourceUnqueueBuffers(source, 1, &buffer);
+    return buffer;
+}
+
+unsigned OpenALAudioBackend::get_queued(unsigned source)
+{
+    ALint queued = 0;
+    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+    return static_cast<unsigned>(queued);
+}
+
+void OpenALAudioBackend::resume(unsigned source) { alSourcePlay(source); }
+}  // namespace pac
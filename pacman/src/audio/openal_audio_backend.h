@@ -0,0 +1,64 @@
+#pragma once
+
+#include "audio_backend.h"
+
+/* Forward Declarations */
+typedef struct ALCcontext_struct ALCcontext;
+typedef struct ALCdevice_struct ALCdevice;
+
+namespace pac
+{
+/*!
+ * \brief The OpenALAudioBackend class plays audio on the default OpenAL device
+ */
+class OpenALAudioBackend : public AudioBackend
+{
+private:
+    /* Audio Device */
+    ALCdevice* m_audio_device = nullptr;
+
+    /* OpenAL Context */
+    ALCcontext* m_audio_context = nullptr;
+
+public:
+    /*!
+     * \brief OpenALAudioBackend opens the default device, check is_open afterwards
+     */
+    OpenALAudioBackend();
+
+    OpenALAudioBackend(const OpenALAudioBackend&) = delete;
+    OpenALAudioBackend& operator=(const OpenALAudioBackend&) = delete;
+    ~OpenALAudioBackend() override;
+
+    /*!
+     * \brief is_open returns true if a device was opened and a context created on it
+     */
+    bool is_open() const;
+
+    unsigned create_buffer() override;
+
+    void delete_buffer(unsigned buffer) override;
+
+    void set_buffer_data(unsigned buffer, const AudioFormat& format, const void* data, std::size_t size) override;
+
+    unsigned create_source() override;
+
+    void delete_source(unsigned source) override;
+
+    void play(unsigned source, unsigned buffer, bool looped) override;
+
+    void restart(unsigned source, bool looped) override;
+
+    void stop(unsigned source) override;
+
+    bool is_playing(unsigned source) override;
+
+    void queue(unsigned source, unsigned buffer) override;
+
+    unsigned unqueue_processed(unsigned source) override;
+
+    unsigned get_queued(unsigned source) override;
+
+    void resume(unsigned source) override;
+};
+}  // namespace pac
@@ -0,0 +1,496 @@
+#include "software_audio_backend.h"
+#include "waveloader.h"
+#include "config.h"
+
+#include <array>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include <gfx.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PAC_SOFTWARE_MIXER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace pac
+{
+namespace
+{
+/* Sample frames in one mixed block */
+constexpr std::size_t BLOCK_FRAMES = AUDIO_MIX_FREQUENCY * AUDIO_MIX_BLOCK_MS / 1000u;
+
+/* One sample frame in 48.16 fixed point */
+constexpr uint64_t FRAME_ONE = 1u << 16u;
+
+/* Scale from 16-bit samples to the [-1, 1] range of the mix */
+constexpr float SAMPLE_SCALE = 1.f / 32768.f;
+
+/*!
+ * \brief write_u32 appends a little endian 32 bit value
+ */
+void write_u32(uint8_t* out, uint32_t value)
+{
+    for (auto i = 0u; i < 4u; ++i)
+    {
+        out[i] = static_cast<uint8_t>(value >> (8u * i));
+    }
+}
+
+/*!
+ * \brief wav_header returns the 44 byte header of a 16-bit stereo WAV file at the mix frequency
+ * \param data_bytes is the size of the samples that follow it
+ */
+std::array<uint8_t, 44> wav_header(uint32_t data_bytes)
+{
+    std::array<uint8_t, 44> header = {};
+    std::memcpy(header.data(), "RIFF", 4u);
+    write_u32(header.data() + 4, 36u + data_bytes);
+    std::memcpy(header.data() + 8, "WAVEfmt ", 8u);
+    write_u32(header.data() + 16, 16u);
+    write_u32(header.data() + 20, 1u | (2u << 16u));
+    write_u32(header.data() + 24, AUDIO_MIX_FREQUENCY);
+    write_u32(header.data() + 28, AUDIO_MIX_FREQUENCY * 4u);
+    write_u32(header.data() + 32, 4u | (16u << 16u));
+    std::memcpy(header.data() + 36, "data", 4u);
+    write_u32(header.data() + 40, data_bytes);
+    return header;
+}
+
+/*!
+ * \brief to_int16 clamps a sample to [-1, 1] and converts it to a signed 16-bit sample
+ */
+int16_t to_int16(float sample) { return static_cast<int16_t>(std::clamp(sample, -1.f, 1.f) * 32767.f); }
+
+/*!
+ * \brief convert_samples converts sample data of any format the WAV loader accepts to signed 16-bit mono or stereo. Channels
+ * past the first two are downmixed, by averaging the even ones into the left side and the odd ones into the right side.
+ * \param out is given the converted samples
+ * \return the channels of the converted samples (1 or 2), or 0 if the format is not supported
+ */
+uint16_t convert_samples(const AudioFormat& format, const void* data, std::size_t size, std::vector<int16_t>& out)
+{
+    const auto bits = format.bits_per_sample;
+    if (format.channels == 0u || (bits != 8u && bits != 16u && bits != 24u && bits != 32u) || (format.is_float && bits != 32u))
+    {
+        return 0u;
+    }
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    const std::size_t bytes_per_sample = bits / 8u;
+    const std::size_t frames = size / (bytes_per_sample * format.channels);
+    const uint16_t out_channels = std::min<uint16_t>(format.channels, 2u);
+    out.resize(frames * out_channels);
+
+    /* Mono and stereo 8 and 16-bit data (everything the game ships with) is copied or widened as it is */
+    if (format.channels <= 2u && bits == 16u)
+    {
+        std::memcpy(out.data(), bytes, out.size() * sizeof(int16_t));
+        return out_channels;
+    }
+    if (format.channels <= 2u && bits == 8u)
+    {
+        for (std::size_t i = 0u; i < out.size(); ++i)
+        {
+            out[i] = static_cast<int16_t>((bytes[i] - 128) * 256);
+        }
+        return out_channels;
+    }
+
+    /* Everything else is decoded one sample at a time, and downmixed to stereo */
+    const float left_weight = 1.f / ((format.channels + 1u) / 2u);
+    const float right_weight = format.channels > 1u ? 1.f / (format.channels / 2u) : 0.f;
+    for (std::size_t frame = 0u; frame < frames; ++frame)
+    {
+        float sides[2] = {0.f, 0.f};
+        for (auto channel = 0u; channel < format.channels; ++channel)
+        {
+            const auto* sample = bytes + (frame * format.channels + channel) * bytes_per_sample;
+            sides[channel & 1u] += loadio::detail::decode_sample(sample, bits, format.is_float);
+        }
+
+        out[frame * out_channels] = to_int16(sides[0] * left_weight);
+        if (out_channels == 2u)
+        {
+            out[frame * out_channels + 1u] = to_int16(sides[1] * right_weight);
+        }
+    }
+    return out_channels;
+}
+
+/*!
+ * \brief mix_span adds count sample frames at the mix frequency to the interleaved stereo mix (mono is copied to both sides)
+ * \param channels is 1 or 2, set_buffer_data converts everything else
+ */
+void mix_span(float* out, const int16_t* samples, std::size_t count, uint16_t channels)
+{
+    GFX_ASSERT(channels == 1u || channels == 2u, "The software mixer can not mix %u channels.", channels);
+    std::size_t i = 0u;
+#ifdef PAC_SOFTWARE_MIXER_SSE2
+    const auto scale = _mm_set1_ps(SAMPLE_SCALE);
+    if (channels == 2u)
+    {
+        /* Four stereo frames (8 samples) at a time */
+        for (; i + 4u <= count; i += 4u)
+        {
+            const auto packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i * 2u));
+            const auto lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+            const auto hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+            _mm_storeu_ps(out + i * 2u, _mm_add_ps(_mm_loadu_ps(out + i * 2u), _mm_mul_ps(lo, scale)));
+            _mm_storeu_ps(out + i * 2u + 4u, _mm_add_ps(_mm_loadu_ps(out + i * 2u + 4u), _mm_mul_ps(hi, scale)));
+        }
+    }
+    else
+    {
+        /* Four mono frames at a time, each duplicated to left and right */
+        for (; i + 4u <= count; i += 4u)
+        {
+            const auto packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples + i));
+            const auto mono = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16)), scale);
+            _mm_storeu_ps(out + i * 2u, _mm_add_ps(_mm_loadu_ps(out + i * 2u), _mm_unpacklo_ps(mono, mono)));
+            _mm_storeu_ps(out + i * 2u + 4u, _mm_add_ps(_mm_loadu_ps(out + i * 2u + 4u), _mm_unpackhi_ps(mono, mono)));
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const auto left = samples[i * channels] * SAMPLE_SCALE;
+        const auto right = samples[i * channels + channels - 1u] * SAMPLE_SCALE;
+        out[i * 2u] += left;
+        out[i * 2u + 1u] += right;
+    }
+}
+
+/*!
+ * \brief convert_mix clamps the mix to [-1, 1] and converts it to signed 16-bit samples
+ */
+void convert_mix(const float* mix, int16_t* out, std::size_t count)
+{
+    std::size_t i = 0u;
+#ifdef PAC_SOFTWARE_MIXER_SSE2
+    /* Packing saturates, so clamping is free */
+    const auto scale = _mm_set1_ps(32767.f);
+    for (; i + 8u <= count; i += 8u)
+    {
+        const auto lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(mix + i), scale));
+        const auto hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(mix + i + 4u), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        out[i] = to_int16(mix[i]);
+    }
+}
+}  // namespace
+
+SoftwareAudioBackend::SoftwareAudioBackend(const std::string& capture_path, bool paced_by_simulation)
+    : m_paced_by_simulation(paced_by_simulation)
+{
+    m_mix.resize(BLOCK_FRAMES * 2u);
+    m_output.resize(BLOCK_FRAMES * 2u);
+
+    if (!capture_path.empty())
+    {
+        m_capture.open(capture_path, std::ios::binary);
+        if (m_capture)
+        {
+            const auto header = wav_header(0u);
+            m_capture.write(reinterpret_cast<const char*>(header.data()), header.size());
+            GFX_INFO("Writing the mixed audio to %s", capture_path.c_str());
+        }
+        else
+        {
+            GFX_WARN("Could not open %s to write the mixed audio to.", capture_path.c_str());
+        }
+    }
+
+    GFX_INFO("Using the software audio backend (%uHz, %ums blocks, paced by %s).", AUDIO_MIX_FREQUENCY, AUDIO_MIX_BLOCK_MS,
+             m_paced_by_simulation ? "the simulation" : "real time");
+    if (!m_paced_by_simulation)
+    {
+        m_running = true;
+        m_thread = std::thread(&SoftwareAudioBackend::mixer_thread_main, this);
+    }
+}
+
+SoftwareAudioBackend::~SoftwareAudioBackend()
+{
+    m_running = false;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    /* Now that the size is known, fix up the header */
+    if (m_capture.is_open())
+    {
+        const auto header = wav_header(static_cast<uint32_t>(m_captured_bytes));
+        m_capture.seekp(0);
+        m_capture.write(reinterpret_cast<const char*>(header.data()), header.size());
+    }
+
+    if (m_stats.blocks > 0u)
+    {
+        GFX_INFO("Software mixer: %llu blocks of %ums, %.4fms per block on average and %.4fms at most.",
+                 static_cast<unsigned long long>(m_stats.blocks), AUDIO_MIX_BLOCK_MS, m_total_ms / m_stats.blocks,
+                 m_stats.peak_block_ms);
+    }
+}
+
+unsigned SoftwareAudioBackend::create_buffer()
+{
+    std::lock_guard lock(m_mutex);
+    m_buffers[++m_handles] = {};
+    return m_handles;
+}
+
+void SoftwareAudioBackend::delete_buffer(unsigned buffer)
+{
+    std::lock_guard lock(m_mutex);
+    m_buffers.erase(buffer);
+}
+
+void SoftwareAudioBackend::set_buffer_data(unsigned buffer, const AudioFormat& format, const void* data, std::size_t size)
+{
+    /* Convert outside the lock, so the mixer is not held up by long buffers */
+    Buffer converted = {0u, format.frequency, {}};
+    converted.channels = convert_samples(format, data, size, converted.samples);
+    if (converted.channels == 0u)
+    {
+        GFX_WARN("The software mixer can not play %u channel %u-bit%s samples, the buffer is left silent.", format.channels,
+                 format.bits_per_sample, format.is_float ? " float" : "");
+    }
+
+    std::lock_guard lock(m_mutex);
+    if (auto found = m_buffers.find(buffer); found != m_buffers.end())
+    {
+        found->second = std::move(converted);
+    }
+}
+
+unsigned SoftwareAudioBackend::create_source()
+{
+    std::lock_guard lock(m_mutex);
+    m_sources[++m_handles] = {};
+    return m_handles;
+}
+
+void SoftwareAudioBackend::delete_source(unsigned source)
+{
+    std::lock_guard lock(m_mutex);
+    m_sources.erase(source);
+}
+
+void SoftwareAudioBackend::play(unsigned source, unsigned buffer, bool looped)
+{
+    std::lock_guard lock(m_mutex);
+    auto& src = m_sources[source];
+    src.queue.assign(1u, buffer);
+    src.current = 0u;
+    src.position = 0u;
+    src.looping = looped;
+    src.playing = true;
+}
+
+void SoftwareAudioBackend::restart(unsigned source, bool looped)
+{
+    std::lock_guard lock(m_mutex);
+    auto& src = m_sources[source];
+    src.current = 0u;
+    src.position = 0u;
+    src.looping = looped;
+    src.playing = !src.queue.empty();
+}
+
+void SoftwareAudioBackend::stop(unsigned source)
+{
+    std::lock_guard lock(m_mutex);
+    m_sources[source] = {};
+}
+
+bool SoftwareAudioBackend::is_playing(unsigned source)
+{
+    std::lock_guard lock(m_mutex);
+    return m_sources[source].playing;
+}
+
+void SoftwareAudioBackend::queue(unsigned source, unsigned buffer)
+{
+    std::lock_guard lock(m_mutex);
+    m_sources[source].queue.push_back(buffer);
+}
+
+unsigned SoftwareAudioBackend::unqueue_processed(unsigned source)
+{
+    std::lock_guard lock(m_mutex);
+    auto& src = m_sources[source];
+    if (src.current == 0u)
+    {
+        return 0u;
+    }
+
+    const auto buffer = src.queue.front();
+    src.queue.erase(src.queue.begin());
+    --src.current;
+    return buffer;
+}
+
+unsigned SoftwareAudioBackend::get_queued(unsigned source)
+{
+    std::lock_guard lock(m_mutex);
+    return static_cast<unsigned>(m_sources[source].queue.size());
+}
+
+void SoftwareAudioBackend::resume(unsigned source)
+{
+    std::lock_guard lock(m_mutex);
+    auto& src = m_sources[source];
+    if (src.playing)
+    {
+        return;
+    }
+
+    /* Like OpenAL, a source that played to the end starts over from the first buffer in its queue */
+    if (src.current >= src.queue.size())
+    {
+        src.current = 0u;
+        src.position = 0u;
+    }
+    src.playing = !src.queue.empty();
+}
+
+void SoftwareAudioBackend::advance(float dt)
+{
+    if (!m_paced_by_simulation)
+    {
+        return;
+    }
+
+    /* Mix the whole blocks that fit in the simulated time (to the nearest frame, so a float time step that falls just short of a
+     * block still completes it), the rest is mixed once a later call completes its block */
+    m_simulated_frames += static_cast<double>(dt) * AUDIO_MIX_FREQUENCY;
+    const auto simulated_frames = static_cast<uint64_t>(std::llround(m_simulated_frames));
+    while (m_mixed_frames + BLOCK_FRAMES <= simulated_frames)
+    {
+        mix_block();
+        m_mixed_frames += BLOCK_FRAMES;
+    }
+}
+
+AudioMixStats SoftwareAudioBackend::get_mix_stats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+void SoftwareAudioBackend::mixer_thread_main()
+{
+    const auto block_duration = std::chrono::milliseconds(AUDIO_MIX_BLOCK_MS);
+    auto next_block = std::chrono::steady_clock::now();
+    while (m_running)
+    {
+        mix_block();
+
+        /* Keep to the sample clock, a block that was late is caught up on right away */
+        next_block += block_duration;
+        std::this_thread::sleep_until(next_block);
+    }
+}
+
+void SoftwareAudioBackend::mix_block()
+{
+    std::unique_lock lock(m_mutex);
+    const auto mix_start = std::chrono::steady_clock::now();
+
+    std::fill(m_mix.begin(), m_mix.end(), 0.f);
+    unsigned voices = 0u;
+    unsigned resampled_voices = 0u;
+    for (auto& [handle, source] : m_sources)
+    {
+        if (source.playing)
+        {
+            resampled_voices += mix_source(source, m_mix.data(), BLOCK_FRAMES) ? 1u : 0u;
+            ++voices;
+        }
+    }
+    convert_mix(m_mix.data(), m_output.data(), m_output.size());
+
+    /* Update the cost, the average is published once a second */
+    const auto block_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mix_start).count();
+    ++m_stats.blocks;
+    m_stats.voices = voices;
+    m_stats.resampled_voices = resampled_voices;
+    m_stats.peak_block_ms = std::max(m_stats.peak_block_ms, block_ms);
+    m_total_ms += block_ms;
+    m_window_ms += block_ms;
+    if (++m_window_blocks == 1000u / AUDIO_MIX_BLOCK_MS)
+    {
+        m_stats.block_ms = m_window_ms / m_window_blocks;
+        m_window_ms = 0.f;
+        m_window_blocks = 0u;
+    }
+
+    /* The output is only used by whoever mixes, so the file is written without holding up the main and stream threads */
+    lock.unlock();
+    if (m_capture.is_open())
+    {
+        m_capture.write(reinterpret_cast<const char*>(m_output.data()), m_output.size() * sizeof(int16_t));
+        m_captured_bytes += m_output.size() * sizeof(int16_t);
+    }
+}
+
+bool SoftwareAudioBackend::mix_source(Source& source, float* out, std::size_t frames)
+{
+    bool resampled = false;
+    while (frames > 0u && source.playing)
+    {
+        /* Move on to the next buffer (or back to the first one when looping) once a buffer has been played */
+        const auto buffer_itr =
+            source.current < source.queue.size() ? m_buffers.find(source.queue[source.current]) : m_buffers.end();
+        if (buffer_itr == m_buffers.end() || buffer_itr->second.channels == 0u)
+        {
+            source.playing = false;
+            break;
+        }
+
+        const auto& buffer = buffer_itr->second;
+        const std::size_t buffer_frames = buffer.samples.size() / buffer.channels;
+        auto frame = static_cast<std::size_t>(source.position >> 16u);
+        if (frame >= buffer_frames)
+        {
+            source.position = 0u;
+            source.current = source.looping ? (source.current + 1u) % source.queue.size() : source.current + 1u;
+            source.playing = source.current < source.queue.size() && (buffer_frames > 0u || !source.looping);
+            continue;
+        }
+
+        /* Buffers at the mix frequency are added as they are, others are resampled one frame at a time */
+        if (buffer.frequency == AUDIO_MIX_FREQUENCY)
+        {
+            const auto count = std::min(frames, buffer_frames - frame);
+            mix_span(out, buffer.samples.data() + frame * buffer.channels, count, buffer.channels);
+            source.position += count * FRAME_ONE;
+            out += count * 2u;
+            frames -= count;
+            continue;
+        }
+
+        resampled = true;
+        const auto step = (static_cast<uint64_t>(buffer.frequency) << 16u) / AUDIO_MIX_FREQUENCY;
+        for (; frames > 0u && frame < buffer_frames; --frames, out += 2)
+        {
+            out[0] += buffer.samples[frame * buffer.channels] * SAMPLE_SCALE;
+            out[1] += buffer.samples[frame * buffer.channels + buffer.channels - 1u] * SAMPLE_SCALE;
+            source.position += step;
+            frame = static_cast<std::size_t>(source.position >> 16u);
+        }
+    }
+
+    return resampled;
+}
+}  // namespace pac
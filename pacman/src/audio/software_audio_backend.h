@@ -0,0 +1,146 @@
+#pragma once
+
+#include "audio_backend.h"
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+
+#include "robinhood/robinhood.h"
+
+namespace pac
+{
+/*!
+ * \brief The SoftwareAudioBackend class mixes the playing sources on the CPU, so audio can be exercised on machines without an
+ * audio device. A mixer thread mixes a block of AUDIO_MIX_BLOCK_MS every AUDIO_MIX_BLOCK_MS into 16-bit stereo at
+ * AUDIO_MIX_FREQUENCY (using SSE2 where available), and can write everything it mixes to a WAV file. When it is paced by the
+ * simulation there is no mixer thread, and blocks are mixed by advance() as simulated time passes instead, so a capture matches
+ * the game however fast it runs. Buffers at another sample rate are resampled with nearest sampling.
+ */
+class SoftwareAudioBackend : public AudioBackend
+{
+private:
+    /*!
+     * \brief The Buffer struct holds samples as signed 16-bit mono or stereo (other formats are converted when the data is set)
+     */
+    struct Buffer
+    {
+        /* 1 or 2, or 0 if the data was in a format that can not be played */
+        uint16_t channels = 1u;
+        uint32_t frequency = 0u;
+        std::vector<int16_t> samples = {};
+    };
+
+    /*!
+     * \brief The Source struct is a queue of buffers and the play position in it
+     */
+    struct Source
+    {
+        std::vector<unsigned> queue = {};
+
+        /* Index of the buffer that is playing, the ones before it have been processed */
+        std::size_t current = 0u;
+
+        /* Play position in the current buffer in sample frames, as 48.16 fixed point */
+        uint64_t position = 0u;
+
+        bool looping = false;
+        bool playing = false;
+    };
+
+    /* Interleaved stereo mix of the current block, and the same converted to 16-bit. These and the capture are only used by
+     * whoever mixes (the mixer thread, or the caller of advance when paced by the simulation), so they are not guarded */
+    std::vector<float> m_mix = {};
+    std::vector<int16_t> m_output = {};
+
+    /* File everything is written to (not open if there is no capture), and the bytes of samples written so far */
+    std::ofstream m_capture{};
+    uint64_t m_captured_bytes = 0u;
+
+    /* Simulated time in sample frames and the frames mixed so far, when paced by the simulation */
+    const bool m_paced_by_simulation = false;
+    double m_simulated_frames = 0.0;
+    uint64_t m_mixed_frames = 0u;
+
+    /* Guards everything below, it is held while a block is mixed but not while it is written to the capture */
+    mutable std::mutex m_mutex{};
+
+    robin_hood::unordered_map<unsigned, Buffer> m_buffers{};
+    robin_hood::unordered_map<unsigned, Source> m_sources{};
+
+    /* Handles given out so far (buffers and sources share the counter) */
+    unsigned m_handles = 0u;
+
+    /* Mixing cost, and the sum over the current one second window and the whole run */
+    AudioMixStats m_stats = {};
+    float m_window_ms = 0.f;
+    unsigned m_window_blocks = 0u;
+    double m_total_ms = 0.0;
+
+    std::thread m_thread{};
+    std::atomic<bool> m_running{false};
+
+public:
+    /*!
+     * \brief SoftwareAudioBackend starts the mixer thread, unless it is paced by the simulation
+     * \param capture_path is a WAV file to write the mixed audio to, or empty to not write it
+     * \param paced_by_simulation is true to mix only when advance is called, rather than in real time
+     */
+    explicit SoftwareAudioBackend(const std::string& capture_path = {}, bool paced_by_simulation = false);
+
+    SoftwareAudioBackend(const SoftwareAudioBackend&) = delete;
+    SoftwareAudioBackend& operator=(const SoftwareAudioBackend&) = delete;
+    ~SoftwareAudioBackend() override;
+
+    unsigned create_buffer() override;
+
+    void delete_buffer(unsigned buffer) override;
+
+    void set_buffer_data(unsigned buffer, const AudioFormat& format, const void* data, std::size_t size) override;
+
+    unsigned create_source() override;
+
+    void delete_source(unsigned source) override;
+
+    void play(unsigned source, unsigned buffer, bool looped) override;
+
+    void restart(unsigned source, bool looped) override;
+
+    void stop(unsigned source) override;
+
+    bool is_playing(unsigned source) override;
+
+    void queue(unsigned source, unsigned buffer) override;
+
+    unsigned unqueue_processed(unsigned source) override;
+
+    unsigned get_queued(unsigned source) override;
+
+    void resume(unsigned source) override;
+
+    void advance(float dt) override;
+
+    AudioMixStats get_mix_stats() const override;
+
+private:
+    /*!
+     * \brief mixer_thread_main mixes a block every AUDIO_MIX_BLOCK_MS until the backend is destroyed
+     */
+    void mixer_thread_main();
+
+    /*!
+     * \brief mix_block mixes one block of every playing source, and writes it to the capture file after releasing the lock
+     */
+    void mix_block();
+
+    /*!
+     * \brief mix_source adds a source to the mix, advancing it through its queue
+     * \param frames is the number of sample frames to mix
+     * \return true if any of it was resampled
+     */
+    bool mix_source(Source& source, float* out, std::size_t frames);
+};
+}  // namespace pac
@@ -1,131 +1,431 @@
 #include "sound_manager.h"
-#include "waveloader.h"
+#include "audio_cache.h"
+#include "profiler.h"
+#include "null_audio_backend.h"
+#include "openal_audio_backend.h"
+#include "software_audio_backend.h"
 
+#include <chrono>
 #include <future>
+#include <cstdlib>
+#include <optional>
 #include <algorithm>
 #include <filesystem>
+#include <string_view>
 
 #include <gfx.h>
 #include <cglutil.h>
 
-#include <AL/al.h>
-#include <AL/alc.h>
+namespace pac
+{
+namespace
+{
+/* Backend requested with set_audio_backend, if any, where the software backend writes its mix and what paces it */
+std::optional<EAudioBackend> g_requested_backend = std::nullopt;
+std::string g_capture_path = {};
+bool g_paced_by_simulation = false;
 
-#include <gfx.h>
+/* Set once the sound manager has been created, so late calls to set_audio_backend can be caught */
+bool g_sound_created = false;
 
-namespace pac
+EAudioBackend audio_backend_from_environment()
 {
-pac::SoundManager::SoundManager()
+    const auto* value = std::getenv("PAC_AUDIO_BACKEND");
+    if (value && std::string_view(value) == "null")
+    {
+        return EAudioBackend::Null;
+    }
+    else if (value && std::string_view(value) == "software")
+    {
+        return EAudioBackend::Software;
+    }
+
+    if (value && std::string_view(value) != "openal")
+    {
+        GFX_WARN("Unknown audio backend '%s' in PAC_AUDIO_BACKEND, using OpenAL.", value);
+    }
+
+    return EAudioBackend::OpenAL;
+}
+}  // namespace
+
+pac::SoundManager::SoundManager(EAudioBackend backend, const std::string& capture_path, bool paced_by_simulation)
+    : m_backend_type(backend)
 {
-    /* Initialize device and context */
-    m_audio_device = alcOpenDevice(nullptr);
-    GFX_ASSERT(m_audio_device, "Audio device failed to initialize.");
+    PAC_PROFILE_SCOPE("Load Sounds");
+    const auto load_start = std::chrono::steady_clock::now();
 
-    m_audio_context = alcCreateContext(m_audio_device, nullptr);
-    GFX_ASSERT(m_audio_device, "Audio context failed to initialize.");
-    alcMakeContextCurrent(m_audio_context);
+    /* Without an audio device, the game still runs but plays nothing */
+    if (backend == EAudioBackend::OpenAL)
+    {
+        auto openal = std::make_unique<OpenALAudioBackend>();
+        if (openal->is_open())
+        {
+            m_backend = std::move(openal);
+        }
+        else
+        {
+            GFX_WARN("Audio device failed to initialize, playing no audio.");
+            m_backend_type = EAudioBackend::Null;
+        }
+    }
+    else if (backend == EAudioBackend::Software)
+    {
+        m_backend = std::make_unique<SoftwareAudioBackend>(capture_path, paced_by_simulation);
+    }
 
-    const auto* device_name = alcGetString(m_audio_device, ALC_DEVICE_SPECIFIER);
-    GFX_INFO("Using audio device: %s", device_name);
+    if (m_backend_type == EAudioBackend::Null)
+    {
+        GFX_INFO("Using the null audio backend.");
+        m_backend = std::make_unique<NullAudioBackend>();
+    }
 
     /* Iterate all files in resource folder */
+    std::size_t resident_bytes = 0u;
+    std::vector<AudioCacheSource> cache_sources = {};
     const auto res_path = std::filesystem::path(cgl::native_absolute_path("res/audio"));
     for (auto entry = std::filesystem::directory_iterator(res_path); entry != std::filesystem::directory_iterator(); ++entry)
     {
-        /* If file is a .wav file, load it! */
+        /* If file is a .wav file, cache it (or open it for streaming if it is a long track) */
         if (entry->path().extension() == ".wav")
         {
-            GFX_DEBUG("Loading audio file (%s) as (%s)", entry->path().c_str(), entry->path().stem().c_str());
-            auto sound = loadio::WaveFile(entry->path().string());
-            m_sound_buffers[entry->path().stem().string()] = sound.createOpenalBuffer();
+            if (entry->file_size() >= AUDIO_STREAM_MIN_BYTES)
+            {
+                GFX_DEBUG("Streaming audio file (%s) as (%s)", entry->path().c_str(), entry->path().stem().c_str());
+                auto stream = std::make_unique<MusicStream>();
+                if (stream->open(*m_backend, entry->path().string()))
+                {
+                    resident_bytes += stream->get_resident_bytes();
+                    m_streams[entry->path().stem().string()] = std::move(stream);
+                }
+                continue;
+            }
+
+            cache_sources.push_back({entry->path().stem().string(), entry->path().string(), entry->file_size(),
+                                     static_cast<int64_t>(entry->last_write_time().time_since_epoch().count())});
         }
     }
 
-    GFX_INFO("Loaded %u sound effects / music tracks.", m_sound_buffers.size());
+    /* Load the sound effects from the cache, converting them again if any of them changed */
+    const auto cache_start = std::chrono::steady_clock::now();
+    const auto cache_path = cgl::native_absolute_path("res/audio_cache.bin");
+    AudioCache cache = {};
+    if (cache.load(cache_path, cache_sources))
+    {
+        GFX_INFO("Read %zu sound effects from the audio cache (%.1fKiB in one read) in %.2fms.", cache.get_clip_count(),
+                 cache.get_file_size() / 1024.f,
+                 std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cache_start).count());
+    }
+    else
+    {
+        const auto build_stats = cache.build(cache_sources);
+        GFX_INFO("Rebuilt the audio cache from %zu sound effects in %.2fms (%zu resampled in %.2fms, %zu skipped).",
+                 build_stats.converted, build_stats.convert_ms, build_stats.resampled, build_stats.resample_ms,
+                 build_stats.skipped);
+        if (!cache.save(cache_path))
+        {
+            GFX_WARN("Could not write the audio cache to %s, it will be rebuilt next time.", cache_path.c_str());
+        }
+    }
 
-    /* Generate a reasonable number of sources for multiple SFX playback and overlap */
-    constexpr int num_sources = 12;
-    m_inactive_sources.resize(num_sources);
-    alGenSources(num_sources, m_inactive_sources.data());
+    /* The samples go straight from the cache to the backend, they are already in the format it mixes at */
+    for (std::size_t clip = 0u; clip < cache.get_clip_count(); ++clip)
+    {
+        if (cache.get_format(clip).channels == 0u)
+        {
+            continue;
+        }
 
-    /* Set all positions and velocities to 0 */
-    for (auto source : m_inactive_sources)
+        add_sound(cache.get_name(clip), cache.get_format(clip), cache.get_samples(clip), cache.get_bytes(clip));
+        resident_bytes += cache.get_bytes(clip);
+    }
+
+    const auto load_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+    GFX_INFO("Loaded %zu sound effects and opened %zu streamed music tracks in %.2fms (%.1fKiB of resident audio).",
+             m_sounds.size(), m_streams.size(), load_ms, resident_bytes / 1024.f);
+
+    create_sources();
+
+    if (!m_streams.empty())
     {
-        alSource3f(source, AL_POSITION, 0.f, 0.f, 0.f);
-        alSource3f(source, AL_VELOCITY, 0.f, 0.f, 0.f);
-        alSourcei(source, AL_LOOPING, 0);
+        m_stream_thread_running = true;
+        m_stream_thread = std::thread(&SoundManager::stream_thread_main, this);
     }
+}
 
-    /* Set listener position and velocity to 0 */
-    alListener3f(AL_POSITION, 0.f, 0.f, 0.f);
-    alListener3f(AL_VELOCITY, 0.f, 0.f, 0.f);
+SoundManager::SoundManager(std::unique_ptr<AudioBackend> backend, EAudioBackend backend_type)
+    : m_backend(std::move(backend)), m_backend_type(backend_type)
+{
+    create_sources();
+}
+
+void SoundManager::add_sound(const std::string& sound_name, const AudioFormat& format, const void* data, std::size_t size)
+{
+    const auto buffer = m_backend->create_buffer();
+    m_backend->set_buffer_data(buffer, format, data, size);
+    m_sounds[sound_name].buffer = buffer;
 }
 
 unsigned SoundManager::play(const std::string& sound_name, bool looped)
 {
-    /* Before we play anything, move finished active sources back to the inactive pool. We only need to do this whenever a new
-     * sound is requested playing, since otherwise no state will have changed since last time */
-    auto itrs = std::partition_copy(m_active_sources.begin(), m_active_sources.end(), std::back_inserter(m_inactive_sources),
-                                    m_active_sources.begin(), [](unsigned n) {
-                                        int state;
-                                        alGetSourcei(n, AL_SOURCE_STATE, &state);
-                                        return AL_STOPPED == state;
-                                    });
+    std::lock_guard lock(m_stream_mutex);
+    ++m_voice_stats.plays;
 
-    m_active_sources.erase(itrs.second, m_active_sources.end());
+    /* Streamed tracks are fed by the stream thread, and their sources are not voices */
+    if (auto stream = m_streams.find(sound_name); stream != m_streams.end())
+    {
+        if (const auto previous = stream->second->get_source(); previous != 0u)
+        {
+            stream->second->stop();
+            m_inactive_sources.push_back(previous);
+        }
+
+        const auto source = acquire_source(UINT8_MAX);
+        GFX_ASSERT(source != 0u, "No available sound sources to stream %s!", sound_name.c_str());
+        stream->second->start(source, looped);
+        return source;
+    }
+
+    const auto& sound = m_sounds.at(sound_name);
+
+    /* If the sound already plays on as many voices as it may, restart the oldest of them */
+    if (sound.max_voices > 0u)
+    {
+        Voice* oldest = nullptr;
+        unsigned voice_count = 0u;
+        for (auto& voice : m_voices)
+        {
+            if (voice.buffer == sound.buffer)
+            {
+                ++voice_count;
+                oldest = (oldest == nullptr || voice.started < oldest->started) ? &voice : oldest;
+            }
+        }
 
-    GFX_ASSERT(!m_inactive_sources.empty(), "No available sound sources to play audio!");
+        if (voice_count >= sound.max_voices)
+        {
+            ++m_voice_stats.retriggers;
+            oldest->started = ++m_play_counter;
+            m_backend->restart(oldest->source, looped);
+            return oldest->source;
+        }
+    }
 
-    /* Get an available source */
-    const auto source = m_inactive_sources.back();
-    m_inactive_sources.pop_back();
+    const auto source = acquire_source(sound.priority);
+    if (source == 0u)
+    {
+        ++m_voice_stats.dropped;
+        return 0u;
+    }
 
     /* Queue it up */
-    alSourcei(source, AL_LOOPING, static_cast<int>(looped));
-    alSourcei(source, AL_BUFFER, m_sound_buffers.at(sound_name));
-    alSourcePlay(source);
+    m_backend->play(source, sound.buffer, looped);
 
-    /* Add it to the active sources */
-    m_active_sources.push_back(source);
-    GFX_DEBUG("USED %u  AVIAIL: %u - audio sources", m_active_sources.size(), m_inactive_sources.size());
+    /* Add it to the voices */
+    m_voices.push_back({source, sound.buffer, sound.priority, ++m_play_counter});
+    m_voice_stats.active = static_cast<unsigned>(m_voices.size());
+    m_voice_stats.peak_active = std::max(m_voice_stats.peak_active, m_voice_stats.active);
 
     return source;
 }
 
-void SoundManager::stop(unsigned sound_id_from_play) { alSourceStop(sound_id_from_play); }
+void SoundManager::stop(unsigned sound_id_from_play)
+{
+    std::lock_guard lock(m_stream_mutex);
+    for (auto& [name, stream] : m_streams)
+    {
+        if (stream->get_source() == sound_id_from_play)
+        {
+            stream->stop();
+            m_inactive_sources.push_back(sound_id_from_play);
+            return;
+        }
+    }
+
+    m_backend->stop(sound_id_from_play);
+}
+
+void SoundManager::update(float dt)
+{
+    PAC_PROFILE_SCOPE("Audio Voices");
+    m_backend->advance(dt);
+
+    /* Move voices that have stopped back to the inactive pool. This is the only place source states are polled */
+    const auto stopped = std::partition(m_voices.begin(), m_voices.end(),
+                                        [this](const Voice& voice) { return m_backend->is_playing(voice.source); });
+
+    for (auto voice = stopped; voice != m_voices.end(); ++voice)
+    {
+        m_inactive_sources.push_back(voice->source);
+    }
+
+    m_voices.erase(stopped, m_voices.end());
+    m_voice_stats.active = static_cast<unsigned>(m_voices.size());
+
+    std::lock_guard lock(m_stream_mutex);
+    reclaim_finished_streams();
+}
+
+void SoundManager::configure(const std::string& sound_name, uint8_t priority, uint8_t max_voices)
+{
+    /* Streams are not voices, so they are not configured */
+    if (auto sound = m_sounds.find(sound_name); sound != m_sounds.end())
+    {
+        sound->second.priority = priority;
+        sound->second.max_voices = max_voices;
+    }
+    else if (m_streams.count(sound_name) == 0u)
+    {
+        GFX_WARN("Can not configure the sound %s, it does not exist.", sound_name.c_str());
+    }
+}
+
+void SoundManager::set_steal_policy(EVoiceStealPolicy policy) { m_steal_policy = policy; }
+
+const VoiceStats& SoundManager::get_voice_stats() const { return m_voice_stats; }
+
+EAudioBackend SoundManager::get_backend_type() const { return m_backend_type; }
+
+AudioMixStats SoundManager::get_mix_stats() const { return m_backend->get_mix_stats(); }
+
+unsigned SoundManager::acquire_source(uint8_t priority)
+{
+    if (!m_inactive_sources.empty())
+    {
+        const auto source = m_inactive_sources.back();
+        m_inactive_sources.pop_back();
+        return source;
+    }
+
+    /* Every source is busy, so pick a voice that is not more important than the new sound */
+    auto victim = m_voices.end();
+    for (auto voice = m_voices.begin(); voice != m_voices.end(); ++voice)
+    {
+        if (voice->priority > priority)
+        {
+            continue;
+        }
+
+        if (victim == m_voices.end())
+        {
+            victim = voice;
+        }
+        else if (m_steal_policy == EVoiceStealPolicy::LowestPriority && voice->priority != victim->priority)
+        {
+            victim = voice->priority < victim->priority ? voice : victim;
+        }
+        else if (voice->started < victim->started)
+        {
+            victim = voice;
+        }
+    }
+
+    if (victim == m_voices.end())
+    {
+        return 0u;
+    }
+
+    ++m_voice_stats.steals;
+    const auto source = victim->source;
+    m_backend->stop(source);
+    m_voices.erase(victim);
+    return source;
+}
+
+void SoundManager::create_sources()
+{
+    /* Generate a reasonable number of sources for multiple SFX playback and overlap */
+    m_voices.reserve(AUDIO_SOURCES);
+    for (auto i = 0u; i < AUDIO_SOURCES; ++i)
+    {
+        m_inactive_sources.push_back(m_backend->create_source());
+    }
+}
+
+void SoundManager::stream_thread_main()
+{
+    while (m_stream_thread_running)
+    {
+        {
+            std::lock_guard lock(m_stream_mutex);
+            for (auto& [name, stream] : m_streams)
+            {
+                stream->update();
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_STREAM_POLL_MS));
+    }
+}
+
+void SoundManager::reclaim_finished_streams()
+{
+    for (auto& [name, stream] : m_streams)
+    {
+        if (stream->is_finished())
+        {
+            m_inactive_sources.push_back(stream->get_source());
+            stream->stop();
+        }
+    }
+}
 
 SoundManager::~SoundManager()
 {
-    /* Stop all playing sounds */
-    for (auto source : m_active_sources)
+    /* Stop feeding the streams, then stop them and take their sources back */
+    m_stream_thread_running = false;
+    if (m_stream_thread.joinable())
     {
-        int state;
-        alGetSourcei(source, AL_SOURCE_STATE, &state);
-        if (state != AL_STOPPED)
+        m_stream_thread.join();
+    }
+
+    for (auto& [name, stream] : m_streams)
+    {
+        if (const auto source = stream->get_source(); source != 0u)
         {
-            alSourceStop(source);
+            stream->stop();
+            m_inactive_sources.push_back(source);
         }
+    }
 
-        m_inactive_sources.push_back(source);
+    /* Streams delete their buffers, which must happen while the backend exists */
+    m_streams.clear();
+
+    /* Stop all playing sounds */
+    for (const auto& voice : m_voices)
+    {
+        m_backend->stop(voice.source);
+        m_inactive_sources.push_back(voice.source);
     }
 
-    m_active_sources.clear();
+    m_voices.clear();
 
     /* Delete Buffers */
-    for (auto buffer : m_sound_buffers)
+    for (const auto& sound : m_sounds)
     {
-        alDeleteBuffers(1, &buffer.second);
+        m_backend->delete_buffer(sound.second.buffer);
     }
 
-    /* Delete sources and close device / context */
-    alDeleteSources(m_inactive_sources.size(), m_inactive_sources.data());
-    alcDestroyContext(m_audio_context);
-    alcCloseDevice(m_audio_device);
+    /* Delete sources, the backend closes the device when it is destroyed */
+    for (auto source : m_inactive_sources)
+    {
+        m_backend->delete_source(source);
+    }
+}
+
+void set_audio_backend(EAudioBackend backend, const std::string& capture_path, bool paced_by_simulation)
+{
+    GFX_ASSERT(!g_sound_created, "The audio backend must be selected before the sound manager is created.");
+    g_requested_backend = backend;
+    g_capture_path = capture_path;
+    g_paced_by_simulation = paced_by_simulation;
 }
 
 SoundManager& get_sound()
 {
-    static SoundManager sm;
+    static SoundManager sm{g_requested_backend.value_or(audio_backend_from_environment()), g_capture_path,
+                           g_paced_by_simulation};
+    g_sound_created = true;
     return sm;
 }
 
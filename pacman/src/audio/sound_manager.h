@@ -1,44 +1,145 @@
 #pragma once
 
+#include "config.h"
+#include "music_stream.h"
+#include "audio_backend.h"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <vector>
 #include <string>
+#include <cstdint>
 
 #include "robinhood/robinhood.h"
 
-/* Forward Declarations */
-typedef struct ALCcontext_struct ALCcontext;
-typedef struct ALCdevice_struct ALCdevice;
-
 namespace pac
 {
+/*!
+ * \brief The EVoiceStealPolicy enum decides which playing voice gives up its source when a sound is played and every source
+ * is busy. Only voices with the same or a lower priority than the new sound are ever stolen.
+ */
+enum class EVoiceStealPolicy
+{
+    /* Steal the voice that started playing first */
+    Oldest,
+
+    /* Steal the voice with the lowest priority, and the oldest one of those */
+    LowestPriority
+};
+
+/*!
+ * \brief The VoiceStats struct counts how the sources are used
+ */
+struct VoiceStats
+{
+    /* Sources that are playing (or were at the last update), and the most there have been at once */
+    unsigned active = 0u;
+    unsigned peak_active = 0u;
+
+    /* Sounds that were played, played by restarting a voice of the same sound, played by stealing another sound's voice,
+     * and not played at all because every voice had a higher priority */
+    uint64_t plays = 0u;
+    uint64_t retriggers = 0u;
+    uint64_t steals = 0u;
+    uint64_t dropped = 0u;
+};
+
 /*!
  * \brief The SoundManager class is a singleton responsible for playing audio and internally managing the audio buffers,
- * sources and listeners. It can also load music, although it is not streamed, but loaded up front.
+ * sources and listeners. Files larger than AUDIO_STREAM_MIN_BYTES (the music tracks) are not loaded up front, but streamed
+ * from disk by a background thread.
+ *
+ * Every other sound plays on a voice (one of the AUDIO_SOURCES sources). Sounds have a priority and can be limited to a number
+ * of voices, in which case playing them again restarts their oldest voice. When all sources are busy a voice is stolen
+ * according to the steal policy. Streams always get a source, and their sources are never stolen.
  */
 class SoundManager
 {
 private:
-    /* Map of sound names to buffers (the name is the filename without an extension) */
-    robin_hood::unordered_map<std::string, unsigned> m_sound_buffers{};
+    /* What the audio is played through */
+    std::unique_ptr<AudioBackend> m_backend = nullptr;
+    EAudioBackend m_backend_type = EAudioBackend::OpenAL;
+
+    /*!
+     * \brief The Sound struct is a loaded sound and how it may use the voices
+     */
+    struct Sound
+    {
+        unsigned buffer = 0u;
+        uint8_t priority = SOUND_DEFAULT_PRIORITY;
 
-    /* All actively playing sound sources */
-    std::vector<unsigned> m_active_sources = {};
+        /* The most voices this sound can play on at once (0 for no limit) */
+        uint8_t max_voices = 0u;
+    };
+
+    /*!
+     * \brief The Voice struct is a source that is playing a sound
+     */
+    struct Voice
+    {
+        unsigned source = 0u;
+        unsigned buffer = 0u;
+        uint8_t priority = 0u;
+
+        /* Increases with every play, so lower values started playing earlier */
+        uint64_t started = 0u;
+    };
+
+    /* Map of sound names to sounds (the name is the filename without an extension) */
+    robin_hood::unordered_map<std::string, Sound> m_sounds{};
+
+    /* Map of sound names to streamed tracks */
+    robin_hood::unordered_map<std::string, std::unique_ptr<MusicStream>> m_streams{};
+
+    /* Guards the streams, which are refilled by the stream thread and started / stopped by the main thread */
+    std::mutex m_stream_mutex{};
+
+    /* Thread that keeps the streams fed, and the flag that tells it to exit */
+    std::thread m_stream_thread{};
+    std::atomic<bool> m_stream_thread_running{false};
+
+    /* All voices that were playing at the last update, or have been started since */
+    std::vector<Voice> m_voices = {};
 
     /* All inactive (pending) sound sources */
     std::vector<unsigned> m_inactive_sources = {};
 
-    /* Audio Device */
-    ALCdevice* m_audio_device = nullptr;
+    EVoiceStealPolicy m_steal_policy = EVoiceStealPolicy::LowestPriority;
 
-    /* OpenAL Context */
-    ALCcontext* m_audio_context = nullptr;
+    /* Counter used to order the voices by age */
+    uint64_t m_play_counter = 0u;
+
+    VoiceStats m_voice_stats = {};
 
 public:
+    /*!
+     * \brief SoundManager creates a sound manager with AUDIO_SOURCES voices on the given backend, and no sounds (add them with
+     * add_sound). The game uses the one get_sound creates, which has every sound in res/audio.
+     * \param backend is the backend to play through
+     * \param backend_type is the type of the backend
+     */
+    SoundManager(std::unique_ptr<AudioBackend> backend, EAudioBackend backend_type);
+
+    SoundManager(const SoundManager&) = delete;
+    SoundManager& operator=(const SoundManager&) = delete;
+
+    /*!
+     * \brief add_sound adds a sound effect that can be played by name, with the default priority and no voice limit
+     * \param sound_name is the name to play the sound by
+     * \param format is the format of the sample data
+     * \param data is the sample data, it is not used after the call
+     * \param size is the size of the data in bytes
+     */
+    void add_sound(const std::string& sound_name, const AudioFormat& format, const void* data, std::size_t size);
+
     /*!
      * \brief play the sound with the given name
      * \param sound_name is the name of the sound to play
      * \param looped true if you want the sound to loop forever (like a music track maybe?)
-     * \return id of sound that started  playing. Use this to later stop the sound.
+     * \return id of sound that started  playing. Use this to later stop the sound. It is 0 if the sound was dropped because
+     * every source is playing something more important.
      */
     unsigned play(const std::string& sound_name, bool looped = false);
 
@@ -48,14 +149,81 @@ public:
      */
     void stop(unsigned sound_id_from_play);
 
+    /*!
+     * \brief update advances a backend that is paced by the simulation, and moves the sources that have stopped playing back
+     * to the pool. Call once per frame.
+     * \param dt is the simulated time since the last update in seconds
+     */
+    void update(float dt);
+
+    /*!
+     * \brief configure sets how a sound may use the voices
+     * \param sound_name is the name of the sound
+     * \param priority decides which sounds can steal the voice of which (higher is more important)
+     * \param max_voices is the most voices the sound can play on at once, or 0 for no limit
+     */
+    void configure(const std::string& sound_name, uint8_t priority, uint8_t max_voices);
+
+    /*!
+     * \brief set_steal_policy sets which voice is stolen when all sources are busy
+     */
+    void set_steal_policy(EVoiceStealPolicy policy);
+
+    /*!
+     * \brief get_voice_stats returns the voice counters since the game started
+     */
+    const VoiceStats& get_voice_stats() const;
+
+    /*!
+     * \brief get_backend_type returns the backend audio is played through (OpenAL falls back to Null without a device)
+     */
+    EAudioBackend get_backend_type() const;
+
+    /*!
+     * \brief get_mix_stats returns the cost of mixing on the CPU, all zero unless the software backend is used
+     */
+    AudioMixStats get_mix_stats() const;
+
     ~SoundManager();
 
 private:
-    SoundManager();
+    SoundManager(EAudioBackend backend, const std::string& capture_path, bool paced_by_simulation);
+
+    /*!
+     * \brief create_sources creates the AUDIO_SOURCES sources the voices play on
+     */
+    void create_sources();
+
+    /*!
+     * \brief stream_thread_main refills the buffers of the playing streams until the sound manager is destroyed
+     */
+    void stream_thread_main();
+
+    /*!
+     * \brief reclaim_finished_streams moves the sources of streams that have played to the end back to the inactive pool. The
+     * stream mutex must be held.
+     */
+    void reclaim_finished_streams();
+
+    /*!
+     * \brief acquire_source returns a free source, stealing a voice with at most the given priority if there is none
+     * \return the source, or 0 if every voice has a higher priority
+     */
+    unsigned acquire_source(uint8_t priority);
 
     friend SoundManager& get_sound();
 };
 
+/*!
+ * \brief set_audio_backend selects the backend the sound manager is created with. Must be called before the first call to
+ * get_sound. If it is never called, the backend is taken from the PAC_AUDIO_BACKEND environment variable ("openal", "null" or
+ * "software"), defaulting to OpenAL.
+ * \param backend is the backend to use
+ * \param capture_path is a WAV file the software backend writes everything it mixes to (empty to not write it)
+ * \param paced_by_simulation is true for the software backend to mix as simulated time passes rather than in real time
+ */
+void set_audio_backend(EAudioBackend backend, const std::string& capture_path = {}, bool paced_by_simulation = false);
+
 /*!
  * \brief get_sound returns access to the SoundManager singleton
  * \return the sound manager for playing sounds
@@ -3,16 +3,19 @@
  * 13. Oct 2018: Initial File
  * 13. Oct 2018: Add basic OpenAL support
  * 18. Oct 2018: Make Exceptions Optional
+ * 18. Oct 2026: Memory map files and check chunk bounds, support LIST / fact chunks and WAVE_FORMAT_EXTENSIBLE
+ * 18. Oct 2026: Share sample decoding with the audio backends
  */
 
 #ifndef WAVELOADER_H
 #define WAVELOADER_H
 
+#include "mapped_file.h"
+#include "audio_backend.h"
+
 #include <string>
-#include <vector>
-#include <cstdio>
+#include <cstring>
 #include <cstdint>
-#include <iostream>
 #include <stdexcept>
 
 #include <AL/al.h>
@@ -21,26 +24,10 @@ namespace loadio
 {
 namespace detail
 {
-/*!
- * \brief The HeaderRiff struct is the special case of a header. This is always the first in a wave file and
- * denotes the total size of the file.
- */
-struct HeaderRiff
-{
-    uint8_t chunk_ID[4]{};
-    uint32_t chunk_size{};
-    uint8_t format[4]{};
-};
-
-/*!
- * \brief The Header struct is a generic header for all wav chunks. Used to get the ID and size of the next
- * chunk that should be read.
- */
-struct Header
-{
-    uint8_t ID[4];
-    uint32_t size;
-};
+/* Format tags of the fmt chunk */
+constexpr uint16_t WAVE_FORMAT_PCM = 0x0001u;
+constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003u;
+constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFEu;
 
 /*!
  * \brief The HeaderFmt struct contains all format specific information in this wave file
@@ -55,85 +42,180 @@ struct HeaderFmt
     uint16_t bits_per_sample{};
 };
 
-using HeaderData = std::vector<uint8_t>;
+/*!
+ * \brief read_le reads a little endian value from a byte pointer that may not be aligned
+ */
+template <typename T>
+T read_le(const uint8_t* bytes)
+{
+    T value = 0;
+    for (unsigned i = 0u; i < sizeof(T); ++i)
+    {
+        value |= static_cast<T>(static_cast<T>(bytes[i]) << (8u * i));
+    }
+    return value;
+}
+
+/*!
+ * \brief is_id returns true if the four bytes are the given chunk ID
+ */
+inline bool is_id(const uint8_t* bytes, const char* id) { return std::memcmp(bytes, id, 4u) == 0; }
+
+/*!
+ * \brief decode_sample reads one sample of any supported integer or float format as a float in [-1, 1]
+ * \param bits is 8 (unsigned), 16, 24 or 32 (signed, or a float if is_float is true), anything else decodes to 0
+ */
+inline float decode_sample(const uint8_t* sample, uint16_t bits, bool is_float)
+{
+    switch (bits)
+    {
+    case 8u: return (sample[0] - 128) / 128.f;
+    case 16u: return read_le<int16_t>(sample) / 32768.f;
+    case 24u:
+        return static_cast<int32_t>((uint32_t{sample[0]} << 8u) | (uint32_t{sample[1]} << 16u) | (uint32_t{sample[2]} << 24u)) /
+               2147483648.f;
+    case 32u:
+    {
+        if (!is_float)
+        {
+            return read_le<int32_t>(sample) / 2147483648.f;
+        }
+
+        float value = 0.f;
+        std::memcpy(&value, sample, sizeof(value));
+        return value;
+    }
+    default: return 0.f;
+    }
+}
 }  // namespace detail
 
 /*!
- * \brief The WaveFile class can read wavefiles
+ * \brief The WaveFile class can read wavefiles. The file is memory mapped and the waveform data is never copied, data()
+ * points into the mapping, so the WaveFile must outlive any use of it.
  */
 class WaveFile
 {
 private:
     detail::HeaderFmt m_fmt;
 
-    detail::HeaderData m_data;
+    pac::MappedFile m_file;
+
+    const uint8_t* m_data = nullptr;
+
+    size_t m_size = 0u;
 
 public:
+    WaveFile() = default;
+
     WaveFile(const std::string& filepath) { loadFromFile(filepath.c_str()); }
 
     /*!
      * \brief loadFromFile loads a new wave file from file.
      * \param fp is the filepath to load from. If this is invalid, throws an invalid_argument exception
-     * \throws invalid_argument if the filepath does not exist
+     * \throws invalid_argument if the filepath does not exist or can not be mapped
+     * \throws runtime_error if the file is not uncompressed (integer or float samples), or a chunk does not fit in the file
      */
     void loadFromFile(const char* fp)
     {
-        detail::HeaderRiff riff;
+        m_fmt = {};
+        m_data = nullptr;
+        m_size = 0u;
 
-        /* Open File */
-        FILE* f = fopen(fp, "rb");
-
-        if (!f)
+        if (!m_file.open(fp))
         {
             throw std::invalid_argument(std::string("Filepath (fp) ") + fp + " does not exist!");
         }
 
-        /* Read RIFF Header */
-        fread(&riff, sizeof riff, 1, f);
+        const uint8_t* bytes = m_file.data();
+        const size_t file_size = m_file.size();
 
-        /* Local storage to check for completion, and reading next header */
-        detail::Header next_header;
-        bool b_fmt{false}, b_data{false};
+        /* Check the RIFF Header */
+        if (file_size < 12u || !detail::is_id(bytes, "RIFF") || !detail::is_id(bytes + 8, "WAVE"))
+        {
+            throw std::runtime_error(std::string(fp) + " is not a wave file!");
+        }
 
-        do
+        /* Walk the chunks, every chunk must fit in the file except for a truncated data chunk which is cut short */
+        bool b_fmt{false}, b_data{false};
+        size_t offset = 12u;
+        while (!(b_fmt && b_data) && offset + 8u <= file_size)
         {
-            fread(&next_header, sizeof next_header, 1, f);
+            const uint8_t* header = bytes + offset;
+            const size_t chunk_size = detail::read_le<uint32_t>(header + 4);
+            const size_t body = offset + 8u;
+            const size_t remaining = file_size - body;
 
-            /* Read FMT */
-            if (next_header.ID[0] == 102 && next_header.ID[1] == 109 && next_header.ID[2] == 116 && next_header.ID[3] == 32)
+            /* Read FMT (the extensible format keeps the real format tag at the start of its sub format GUID) */
+            if (detail::is_id(header, "fmt "))
             {
-                fread(&m_fmt, next_header.size, 1, f);
+                if (chunk_size < 16u || chunk_size > remaining)
+                {
+                    throw std::runtime_error(std::string(fp) + " has a broken fmt chunk!");
+                }
+
+                const uint8_t* fmt = bytes + body;
+                m_fmt.audio_format = detail::read_le<uint16_t>(fmt);
+                m_fmt.num_channels = detail::read_le<uint16_t>(fmt + 2);
+                m_fmt.sample_rate = detail::read_le<uint32_t>(fmt + 4);
+                m_fmt.byte_rate = detail::read_le<uint32_t>(fmt + 8);
+                m_fmt.block_align = detail::read_le<uint16_t>(fmt + 12);
+                m_fmt.bits_per_sample = detail::read_le<uint16_t>(fmt + 14);
+
+                if (m_fmt.audio_format == detail::WAVE_FORMAT_EXTENSIBLE)
+                {
+                    if (chunk_size < 40u)
+                    {
+                        throw std::runtime_error(std::string(fp) + " has a broken extensible fmt chunk!");
+                    }
+                    m_fmt.audio_format = detail::read_le<uint16_t>(fmt + 24);
+                }
+
+                if ((m_fmt.audio_format != detail::WAVE_FORMAT_PCM && m_fmt.audio_format != detail::WAVE_FORMAT_IEEE_FLOAT) ||
+                    m_fmt.block_align == 0u || m_fmt.num_channels == 0u ||
+                    m_fmt.block_align != m_fmt.num_channels * ((m_fmt.bits_per_sample + 7u) / 8u))
+                {
+                    throw std::runtime_error(std::string(fp) + " is not uncompressed PCM!");
+                }
                 b_fmt = true;
             }
             /* Read DATA */
-            else if (next_header.ID[0] == 100 && next_header.ID[1] == 97 && next_header.ID[2] == 116 && next_header.ID[3] == 97)
+            else if (detail::is_id(header, "data"))
             {
-                m_data.resize(next_header.size);
-                fread(m_data.data(), next_header.size, 1, f);
+                m_data = bytes + body;
+                m_size = chunk_size < remaining ? chunk_size : remaining;
                 b_data = true;
             }
-            /* Just move on otherwise (MUST SUPPORT COMPRESSED WAV IN FUTURE) */
-            else
+            /* LIST (metadata), fact (sample count, only needed for compressed formats) and anything else is skipped */
+            else if (chunk_size > remaining)
             {
-                detail::HeaderData junk(next_header.size);
-                fread(junk.data(), next_header.size, 1, f);
+                throw std::runtime_error(std::string(fp) + " has a chunk that does not fit in the file!");
             }
-        } while (!(b_fmt && b_data));
 
-        fclose(f);
+            /* Chunks are padded to an even size */
+            offset = body + chunk_size + (chunk_size & 1u);
+        }
+
+        if (!b_fmt || !b_data)
+        {
+            throw std::runtime_error(std::string(fp) + " is missing a fmt or data chunk!");
+        }
+
+        /* Whole sample frames only */
+        m_size -= m_size % m_fmt.block_align;
     }
 
     /*!
      * \brief data returns the raw waveform data
-     * \return the waveform data
+     * \return the waveform data (a pointer into the mapped file)
      */
-    const uint8_t* data() const { return m_data.data(); }
+    const uint8_t* data() const { return m_data; }
 
     /*!
      * \brief size retuns the data size in bytes
      * \return the size of the wave data in bytes
      */
-    size_t size() const { return m_data.size(); }
+    size_t size() const { return m_size; }
 
     /*!
      * \brief frequency gets the frequency of the wave file
@@ -141,6 +223,36 @@ public:
      */
     uint32_t frequency() const { return m_fmt.sample_rate; }
 
+    /*!
+     * \brief blockAlign gets the size of one sample frame (a sample for every channel)
+     * \return the size of a sample frame in bytes
+     */
+    uint16_t blockAlign() const { return m_fmt.block_align; }
+
+    /*!
+     * \brief channels gets the number of interleaved channels
+     */
+    uint16_t channels() const { return m_fmt.num_channels; }
+
+    /*!
+     * \brief bitsPerSample gets the size of one sample of one channel in bits
+     */
+    uint16_t bitsPerSample() const { return m_fmt.bits_per_sample; }
+
+    /*!
+     * \brief isFloat returns true if the samples are IEEE floats rather than integers
+     */
+    bool isFloat() const { return m_fmt.audio_format == detail::WAVE_FORMAT_IEEE_FLOAT; }
+
+    /*!
+     * \brief getFormat gets the sample format, for playing the data through an audio backend
+     * \return the channels, bits per sample and frequency
+     */
+    pac::AudioFormat getFormat() const
+    {
+        return {m_fmt.num_channels, m_fmt.bits_per_sample, m_fmt.sample_rate, isFloat()};
+    }
+
     /*!
      * \brief getALformat gets one of the four supported OpenAL formats. STEREO16, MONO16, STEREO8 and MONO8
      * If another format has been loaded this function will thrown a runtime_error
@@ -150,6 +262,10 @@ public:
      */
     ALenum getALformat() const
     {
+        if (isFloat())
+        {
+            return 0;
+        }
         if (m_fmt.num_channels == 2 && m_fmt.bits_per_sample == 16)
         {
             return AL_FORMAT_STEREO16;
@@ -179,7 +295,7 @@ public:
     {
         uint32_t buf;
         alGenBuffers(1, &buf);
-        alBufferData(buf, getALformat(), data(), size(), frequency());
+        alBufferData(buf, getALformat(), data(), static_cast<ALsizei>(size()), static_cast<ALsizei>(frequency()));
         return buf;
     }
 };
@@ -2,8 +2,11 @@
 #include "config.h"
 #include "encrypt/vignere_encryptor.h"
 
+#include <array>
+#include <deque>
+#include <mutex>
+#include <algorithm>
 #include <sstream>
-#include <fstream>
 
 #include <cglutil.h>
 
@@ -11,7 +14,7 @@ namespace pac
 {
 robin_hood::unordered_map<std::string, std::vector<ScoreEntry>> load_high_score_entries_from_file(const char* filepath)
 {
-    /* Decrypt the level file */
+    /* Decrypt the level file, the old format was encrypted with the VignereEncryption, which is kept only to read it */
     auto scorestring = cgl::read_entire_file(filepath);
     VignereEncryption decryptor(ENCRYPTION_STRING);
     decryptor.decrypt(scorestring);
@@ -46,30 +49,100 @@ robin_hood::unordered_map<std::string, std::vector<ScoreEntry>> load_high_score_
     return out;
 }
 
-void write_high_score_entries_to_file(const robin_hood::unordered_map<std::string, std::vector<ScoreEntry>>& entries,
-                                      const char* filepath)
+namespace
 {
-    /* First write to a string */
-    std::stringstream tmpstring;
-    for (const auto& [level, scores] : entries)
+/*!
+ * \brief make_crc_table builds the table used by crc32
+ */
+std::array<uint32_t, 256> make_crc_table()
+{
+    std::array<uint32_t, 256> table = {};
+    for (uint32_t n = 0u; n < 256u; ++n)
     {
-        tmpstring << level << ' ' << scores.size() << '\n';
-
-        for (const auto& entry : scores)
+        auto c = n;
+        for (auto k = 0; k < 8; ++k)
         {
-            tmpstring << entry.name << '\n' << entry.score << '\n';
+            c = (c & 1u) ? 0xEDB88320u ^ (c >> 1u) : c >> 1u;
         }
+        table[n] = c;
+    }
+    return table;
+}
+}  // namespace
+
+const char* intern_name(std::string_view name)
+{
+    /* The names are never removed, and deque elements do not move, so the views used as keys stay valid */
+    static std::mutex mutex{};
+    static std::deque<std::string> names{};
+    static robin_hood::unordered_map<std::string_view, const char*> interned{};
+
+    std::lock_guard lock(mutex);
+    if (const auto it = interned.find(name); it != interned.end())
+    {
+        return it->second;
+    }
+
+    const auto& stored = names.emplace_back(name);
+    interned.emplace(stored, stored.c_str());
+    return stored.c_str();
+}
+
+uint32_t crc32(const uint8_t* data, std::size_t size, uint32_t crc) noexcept
+{
+    static const auto table = make_crc_table();
+    for (std::size_t i = 0u; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8u);
+    }
+    return crc;
+}
+
+LuaCallStats& get_lua_call_stats()
+{
+    static LuaCallStats stats{};
+    return stats;
+}
+
+LuaCallTimer::LuaCallTimer() : m_start(std::chrono::steady_clock::now()) { ++get_lua_call_stats().calls; }
+
+LuaCallTimer::~LuaCallTimer() noexcept
+{
+    get_lua_call_stats().ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+LuaBatchConnection::LuaBatchConnection(ScopedConnection connection, std::weak_ptr<LuaEventBatchBase> batch)
+    : m_connection(std::move(connection)), m_batch(std::move(batch))
+{
+}
+
+LuaBatchConnection& LuaBatchConnection::operator=(LuaBatchConnection&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_connection = std::move(other.m_connection);
+        m_batch = std::move(other.m_batch);
     }
+    return *this;
+}
 
-    /* Encrypt the string we just created */
-    VignereEncryption encryptor(ENCRYPTION_STRING);
-    std::string levelstring = tmpstring.str();
-    encryptor.encrypt(levelstring);
+LuaBatchConnection::~LuaBatchConnection() noexcept { release(); }
 
-    /* Write it to file */
-    std::ofstream file(cgl::native_absolute_path(filepath));
-    file.sync_with_stdio(false);
-    file.write(levelstring.c_str(), levelstring.size());
+void LuaBatchConnection::release()
+{
+    m_connection.release();
+    if (auto batch = m_batch.lock())
+    {
+        batch->released = true;
+    }
+    m_batch.reset();
+}
+
+void remove_released_lua_batches(std::vector<std::shared_ptr<LuaEventBatchBase>>& batches)
+{
+    batches.erase(std::remove_if(batches.begin(), batches.end(), [](const auto& batch) { return batch->released; }),
+                  batches.end());
 }
 
 int manhattan_distance(glm::ivec2 from, glm::ivec2 to) noexcept { return std::abs(from.x - to.x) + std::abs(from.y - to.y); }
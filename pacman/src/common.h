@@ -1,14 +1,19 @@
 #pragma once
 
+#include "profiler.h"
+#include "event_bus.h"
+
+#include <chrono>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <string_view>
 
 #include <glm/vec2.hpp>
 #include <sol/state.hpp>
 #include <entt/entity/registry.hpp>
-#include <entt/signal/dispatcher.hpp>
 #include <robinhood/robinhood.h>
 
 namespace pac
@@ -62,39 +67,228 @@ enum class EAIState
 };
 
 /*!
- * \brief wraps a sol function call for use with EnTT
+ * \brief The LuaCallStats struct counts the calls the game makes into lua, and the time spent in them
+ */
+struct LuaCallStats
+{
+    uint64_t calls = 0u;
+    double ms = 0.0;
+};
+
+/*!
+ * \brief get_lua_call_stats returns the lua call counters of the current frame (the game loop resets them every frame)
+ */
+LuaCallStats& get_lua_call_stats();
+
+/*!
+ * \brief The LuaCallTimer class counts a call into lua, and adds the time until it is destroyed to the lua call stats
+ */
+class LuaCallTimer
+{
+private:
+    std::chrono::steady_clock::time_point m_start = {};
+
+public:
+    LuaCallTimer();
+
+    LuaCallTimer(const LuaCallTimer&) = delete;
+    LuaCallTimer(LuaCallTimer&&) = delete;
+    LuaCallTimer& operator=(const LuaCallTimer&) = delete;
+    LuaCallTimer& operator=(LuaCallTimer&&) = delete;
+    ~LuaCallTimer() noexcept;
+};
+
+/*!
+ * \brief wraps a sol function call for use with the EventBus
  * \note Thanks @skypjack for the implementation and help
  */
 template<typename Ev>
 void sol_function_wrapper(sol::function& func, const Ev& event)
 {
+    PAC_PROFILE_SCOPE("Lua Event");
+    LuaCallTimer timer{};
     func(event);
 }
 
 /*!
- * \brief function used to bind lua and entt event connections
+ * \brief function used to bind lua functions to events
  * \note Again, thanks to @skypjack for the tip
  */
 template<typename Ev>
-entt::scoped_connection lua_binder(entt::dispatcher& disp, sol::function& func)
+ScopedConnection lua_binder(EventBus& bus, sol::function& func)
+{
+    return bus.sink<Ev>().template connect<&sol_function_wrapper<Ev>>(func);
+}
+
+/*!
+ * \brief The LuaEventBatchBase class lets batches of different event types be owned by the same container
+ */
+class LuaEventBatchBase
+{
+public:
+    /* Set when the connection of the batch is released, the owner removes it once nothing can be delivering to it */
+    bool released = false;
+
+    virtual ~LuaEventBatchBase() = default;
+};
+
+/*!
+ * \brief The LuaEventBatch class hands every event of a type from one bus update to a lua function in a single call, as
+ * (events, count). The events table and the userdata in it are created once and overwritten every update, so lua must copy
+ * anything it wants to keep after the call.
+ */
+template<typename Ev>
+class LuaEventBatch : public LuaEventBatchBase
+{
+private:
+    /* The lua function to call */
+    sol::function m_func{};
+
+    /* The table passed to lua, entry i refers to the userdata in slot i of the pool (and is nil past the event count) */
+    sol::table m_events{};
+
+    /* One userdata per event slot that has ever been used, they are copied into instead of recreated */
+    sol::table m_pool{};
+    std::size_t m_pool_size = 0u;
+
+    /* Number of events in the previous batch */
+    std::size_t m_count = 0u;
+
+public:
+    explicit LuaEventBatch(const sol::function& func) : m_func(func)
+    {
+        sol::state_view lua(func.lua_state());
+        m_events = lua.create_table();
+        m_pool = lua.create_table();
+    }
+
+    /*!
+     * \brief deliver copies the events into the pooled userdata and calls the lua function once (not at all without events)
+     */
+    void deliver(const Ev* events, std::size_t count)
+    {
+        if (count == 0u)
+        {
+            return;
+        }
+
+        PAC_PROFILE_SCOPE("Lua Event Batch");
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+            const auto slot = i + 1u;
+            if (slot > m_pool_size)
+            {
+                m_pool[slot] = events[i];
+                m_pool_size = slot;
+            }
+            else
+            {
+                m_pool.get<Ev&>(slot) = events[i];
+            }
+
+            /* Slots below the previous count already refer to the right userdata */
+            if (slot > m_count)
+            {
+                m_events[slot] = m_pool.get<sol::object>(slot);
+            }
+        }
+
+        for (auto slot = count + 1u; slot <= m_count; ++slot)
+        {
+            m_events[slot] = sol::lua_nil;
+        }
+        m_count = count;
+
+        LuaCallTimer timer{};
+        m_func(m_events, count);
+    }
+};
+
+/*!
+ * \brief The LuaBatchConnection class is the connection handed to lua for a batch. Releasing it (or lua collecting it)
+ * disconnects the batch and marks it as released, so its owner can remove it at a point where it is not being delivered to. It
+ * only holds a weak reference to the batch, so it is fine for the batches to be destroyed before the lua state.
+ */
+class LuaBatchConnection
+{
+private:
+    ScopedConnection m_connection = {};
+    std::weak_ptr<LuaEventBatchBase> m_batch = {};
+
+public:
+    LuaBatchConnection(ScopedConnection connection, std::weak_ptr<LuaEventBatchBase> batch);
+
+    LuaBatchConnection(const LuaBatchConnection&) = delete;
+    LuaBatchConnection(LuaBatchConnection&& other) noexcept = default;
+    LuaBatchConnection& operator=(const LuaBatchConnection&) = delete;
+    LuaBatchConnection& operator=(LuaBatchConnection&& other) noexcept;
+    ~LuaBatchConnection() noexcept;
+
+    /*!
+     * \brief release disconnects the batch now and marks it as released (does nothing if it is not connected)
+     */
+    void release();
+};
+
+/*!
+ * \brief function used to bind lua functions to batches of events, the batch is kept alive by adding it to batches until
+ * the returned connection is released
+ */
+template<typename Ev>
+LuaBatchConnection lua_batch_binder(EventBus& bus, std::vector<std::shared_ptr<LuaEventBatchBase>>& batches,
+                                    const sol::function& func)
+{
+    auto batch = std::make_shared<LuaEventBatch<Ev>>(func);
+    ScopedConnection connection = bus.sink<Ev>().template connect_batch<&LuaEventBatch<Ev>::deliver>(*batch);
+    batches.push_back(batch);
+    return {std::move(connection), batch};
+}
+
+/*!
+ * \brief remove_released_lua_batches removes the batches whose connection was released, call it when the bus is not updating
+ */
+void remove_released_lua_batches(std::vector<std::shared_ptr<LuaEventBatchBase>>& batches);
+
+/*!
+ * \brief The LuaEventBinder struct contains the functions that connect lua functions to an event type, one call per event or
+ * one call per batch
+ */
+struct LuaEventBinder
+{
+    ScopedConnection (*connect)(EventBus&, sol::function&) = nullptr;
+    LuaBatchConnection (*connect_batched)(EventBus&, std::vector<std::shared_ptr<LuaEventBatchBase>>&,
+                                          const sol::function&) = nullptr;
+};
+
+/*!
+ * \brief lua_event_binder returns the binder for event type Ev
+ */
+template<typename Ev>
+LuaEventBinder lua_event_binder()
 {
-    return disp.sink<Ev>().template connect<&sol_function_wrapper<Ev>>(func);
+    return {&lua_binder<Ev>, &lua_batch_binder<Ev>};
 }
 
 /*!
- * \brief load_entries_from_file loads high score entries from highscores.txt in order to display them in the menu
+ * \brief load_entries_from_file loads high score entries from the old highscores.txt format, which is only read to migrate it
+ * to the score journal
  * \return a vector of entries
  */
 robin_hood::unordered_map<std::string, std::vector<ScoreEntry>>
 load_high_score_entries_from_file(const char* filepath = "res/highscores.txt");
 
 /*!
- * \brief write_high_score_entries_to_file writes all high scores in the vector to the given file
- * \param entries are the entries to write
- * \param filepath is the file to write to
+ * \brief intern_name returns a copy of a name that lives as long as the program, the same one for equal names, so events can
+ * carry names of any length and stay trivially copyable. It takes a lock, so it is meant for names of things like pickups
+ * rather than for every event.
+ */
+const char* intern_name(std::string_view name);
+
+/*!
+ * \brief crc32 updates a CRC32 (polynomial 0xEDB88320) with the given bytes, the final CRC is the returned value xor 0xFFFFFFFF
+ * \param crc is the value returned for the previous bytes, or the initial value to start a new CRC
  */
-void write_high_score_entries_to_file(const robin_hood::unordered_map<std::string, std::vector<ScoreEntry>>& entries,
-                                      const char* filepath = "res/highscores.txt");
+uint32_t crc32(const uint8_t* data, std::size_t size, uint32_t crc = 0xFFFFFFFFu) noexcept;
 
 /*!
  * \brief manhattan_distance compute manhattan distance between two points, used in astar as a heuristic for example
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 template<typename T>
 class BaseCrypt
 {
@@ -17,3 +20,24 @@ public:
      */
     virtual void decrypt(T& val) = 0;
 };
+
+/*!
+ * \brief The BaseStreamCrypt class encrypts byte ranges of a longer stream, such as a file. The transform of every byte depends
+ * on its position in the stream, so any range can be encrypted or decrypted on its own, in chunks of any size.
+ */
+class BaseStreamCrypt
+{
+public:
+    virtual ~BaseStreamCrypt() noexcept = default;
+
+    /*!
+     * \brief encrypt encrypts size bytes in place
+     * \param position is the position of the first byte in the stream
+     */
+    virtual void encrypt(uint8_t* data, std::size_t size, uint64_t position) = 0;
+
+    /*!
+     * \brief decrypt decrypts size bytes in place that were encrypted at the same position with the same encryptor
+     */
+    virtual void decrypt(uint8_t* data, std::size_t size, uint64_t position) = 0;
+};
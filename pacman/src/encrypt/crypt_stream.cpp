@@ -0,0 +1,44 @@
+#include "crypt_stream.h"
+#include "config.h"
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+namespace pac
+{
+bool write_encrypted(std::ostream& out, BaseStreamCrypt& crypt, const void* data, std::size_t size, uint64_t position)
+{
+    /* Encrypt into a small buffer that stays in cache, instead of a copy of all the data */
+    std::array<uint8_t, CRYPT_STREAM_CHUNK_BYTES> chunk = {};
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (std::size_t done = 0u; done < size && out;)
+    {
+        const auto count = std::min<std::size_t>(size - done, chunk.size());
+        std::memcpy(chunk.data(), bytes + done, count);
+        crypt.encrypt(chunk.data(), count, position + done);
+        out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(count));
+        done += count;
+    }
+    return static_cast<bool>(out);
+}
+
+bool read_encrypted(std::istream& in, BaseStreamCrypt& crypt, void* data, std::size_t size, uint64_t position)
+{
+    /* Decrypt every chunk right after it is read, while it is still in cache */
+    auto* bytes = static_cast<uint8_t*>(data);
+    for (std::size_t done = 0u; done < size;)
+    {
+        const auto count = std::min<std::size_t>(size - done, CRYPT_STREAM_CHUNK_BYTES);
+        in.read(reinterpret_cast<char*>(bytes + done), static_cast<std::streamsize>(count));
+        const auto read = static_cast<std::size_t>(in.gcount());
+        crypt.decrypt(bytes + done, read, position + done);
+        done += read;
+        if (read < count)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace pac
@@ -0,0 +1,30 @@
+/*!
+ * \file crypt_stream.h contains functions that encrypt or decrypt data while it is written to or read from a stream, a chunk of
+ * CRYPT_STREAM_CHUNK_BYTES at a time, so the data is never copied or encrypted whole
+ */
+
+#pragma once
+
+#include "base_encryptor.h"
+
+#include <istream>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief write_encrypted encrypts data and writes it to a stream
+ * \param position is the position of the data in the encrypted stream, usually where it ends up in the file
+ * \return true if everything was written
+ */
+bool write_encrypted(std::ostream& out, BaseStreamCrypt& crypt, const void* data, std::size_t size, uint64_t position);
+
+/*!
+ * \brief read_encrypted reads size bytes from a stream and decrypts them
+ * \param position is the position of the data in the encrypted stream
+ * \return true if all size bytes were read
+ */
+bool read_encrypted(std::istream& in, BaseStreamCrypt& crypt, void* data, std::size_t size, uint64_t position);
+}  // namespace pac
@@ -0,0 +1,179 @@
+#include "keystream_encryptor.h"
+#include "config.h"
+
+#include <algorithm>
+
+#include <gfx.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PAC_KEYSTREAM_SSE2
+#include <emmintrin.h>
+#endif
+
+/* GCC and Clang can build the AVX2 path for any x86 target and pick it at run time, MSVC only when AVX2 is enabled */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PAC_KEYSTREAM_AVX2
+#define PAC_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define PAC_KEYSTREAM_AVX2
+#define PAC_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+namespace pac
+{
+namespace
+{
+/* Bytes after the pad that repeat its start */
+constexpr std::size_t PAD_TAIL = 32u;
+
+static_assert(KEYSTREAM_PAD_SIZE >= PAD_TAIL, "The keystream pad must be at least as large as an AVX2 block.");
+
+uint64_t splitmix64(uint64_t& state)
+{
+    auto z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31u);
+}
+
+void apply_scalar(uint8_t* data, std::size_t size, const uint8_t* pad, std::size_t offset)
+{
+    for (std::size_t i = 0u; i < size; ++i)
+    {
+        data[i] ^= pad[offset];
+        if (++offset == KEYSTREAM_PAD_SIZE)
+        {
+            offset = 0u;
+        }
+    }
+}
+
+#ifdef PAC_KEYSTREAM_SSE2
+void apply_sse2(uint8_t* data, std::size_t size, const uint8_t* pad, std::size_t offset)
+{
+    std::size_t i = 0u;
+    for (; i + 16u <= size; i += 16u)
+    {
+        const auto key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pad + offset));
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(block, key));
+
+        /* The pad tail makes the bytes past the end equal to the ones at the start */
+        offset += 16u;
+        if (offset >= KEYSTREAM_PAD_SIZE)
+        {
+            offset -= KEYSTREAM_PAD_SIZE;
+        }
+    }
+    apply_scalar(data + i, size - i, pad, offset);
+}
+#endif
+
+#ifdef PAC_KEYSTREAM_AVX2
+PAC_TARGET_AVX2 void apply_avx2(uint8_t* data, std::size_t size, const uint8_t* pad, std::size_t offset)
+{
+    std::size_t i = 0u;
+    for (; i + 32u <= size; i += 32u)
+    {
+        const auto key = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pad + offset));
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(block, key));
+
+        offset += 32u;
+        if (offset >= KEYSTREAM_PAD_SIZE)
+        {
+            offset -= KEYSTREAM_PAD_SIZE;
+        }
+    }
+    apply_scalar(data + i, size - i, pad, offset);
+}
+
+bool cpu_has_avx2()
+{
+#if defined(__AVX2__)
+    return true;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+}  // namespace
+
+KeystreamEncryption::KeystreamEncryption(const char* key) : m_pad(KEYSTREAM_PAD_SIZE + PAD_TAIL), m_path(best_path())
+{
+    GFX_ASSERT(key, "Keystream Encryption key must not be nullptr.");
+
+    /* Seed the pad generator with the FNV-1a hash of the key */
+    uint64_t state = 0xCBF29CE484222325ull;
+    for (const auto* c = key; *c; ++c)
+    {
+        state = (state ^ static_cast<uint8_t>(*c)) * 0x100000001B3ull;
+    }
+
+    for (std::size_t i = 0u; i < KEYSTREAM_PAD_SIZE; i += 8u)
+    {
+        const auto bits = splitmix64(state);
+        for (std::size_t b = 0u; b < 8u && i + b < KEYSTREAM_PAD_SIZE; ++b)
+        {
+            m_pad[i + b] = static_cast<uint8_t>(bits >> (8u * b));
+        }
+    }
+
+    for (std::size_t i = 0u; i < PAD_TAIL; ++i)
+    {
+        m_pad[KEYSTREAM_PAD_SIZE + i] = m_pad[i];
+    }
+}
+
+void KeystreamEncryption::encrypt(uint8_t* data, std::size_t size, uint64_t position) { apply(data, size, position); }
+
+void KeystreamEncryption::decrypt(uint8_t* data, std::size_t size, uint64_t position) { apply(data, size, position); }
+
+void KeystreamEncryption::set_path(EKeystreamPath path) { m_path = std::min(path, best_path()); }
+
+EKeystreamPath KeystreamEncryption::get_path() const { return m_path; }
+
+EKeystreamPath KeystreamEncryption::best_path()
+{
+#ifdef PAC_KEYSTREAM_AVX2
+    static const bool has_avx2 = cpu_has_avx2();
+    if (has_avx2)
+    {
+        return EKeystreamPath::AVX2;
+    }
+#endif
+
+#ifdef PAC_KEYSTREAM_SSE2
+    return EKeystreamPath::SSE2;
+#else
+    return EKeystreamPath::Scalar;
+#endif
+}
+
+void KeystreamEncryption::apply(uint8_t* data, std::size_t size, uint64_t position) const
+{
+    const auto offset = static_cast<std::size_t>(position % KEYSTREAM_PAD_SIZE);
+    switch (m_path)
+    {
+#ifdef PAC_KEYSTREAM_AVX2
+    case EKeystreamPath::AVX2: apply_avx2(data, size, m_pad.data(), offset); break;
+#endif
+#ifdef PAC_KEYSTREAM_SSE2
+    case EKeystreamPath::SSE2: apply_sse2(data, size, m_pad.data(), offset); break;
+#endif
+    default: apply_scalar(data, size, m_pad.data(), offset); break;
+    }
+}
+
+const char* keystream_path_name(EKeystreamPath path)
+{
+    switch (path)
+    {
+    case EKeystreamPath::AVX2: return "AVX2";
+    case EKeystreamPath::SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
+}  // namespace pac
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "base_encryptor.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief The EKeystreamPath enum lists the ways the keystream can be applied, fastest last
+ */
+enum class EKeystreamPath
+{
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+/*!
+ * \brief The Keystream Encryptor XORs every byte with a pad of KEYSTREAM_PAD_SIZE bytes derived from the key, starting at the
+ * byte's position in the stream modulo the pad size. Encrypting and decrypting are the same operation. It is applied 16 or 32
+ * bytes at a time with SSE2 or AVX2 when the CPU has them, and a byte at a time otherwise.
+ */
+class KeystreamEncryption : public BaseStreamCrypt
+{
+private:
+    /* The pad, followed by a copy of its first 32 bytes so a block never has to wrap around the end */
+    std::vector<uint8_t> m_pad = {};
+
+    EKeystreamPath m_path = EKeystreamPath::Scalar;
+
+public:
+    /*!
+     * \brief Construct a Keystream Encryptor using this as the "pass-key", it uses the fastest path the CPU supports
+     */
+    explicit KeystreamEncryption(const char* key);
+
+    void encrypt(uint8_t* data, std::size_t size, uint64_t position) override;
+
+    void decrypt(uint8_t* data, std::size_t size, uint64_t position) override;
+
+    /*!
+     * \brief set_path selects how the keystream is applied, a path the CPU does not support falls back to the best one it does
+     */
+    void set_path(EKeystreamPath path);
+
+    /*!
+     * \brief get_path returns how the keystream is applied
+     */
+    EKeystreamPath get_path() const;
+
+    /*!
+     * \brief best_path returns the fastest path the CPU supports
+     */
+    static EKeystreamPath best_path();
+
+private:
+    /*!
+     * \brief apply XORs the keystream at position onto the data
+     */
+    void apply(uint8_t* data, std::size_t size, uint64_t position) const;
+};
+
+/*!
+ * \brief keystream_path_name returns the name of a keystream path, for logging
+ */
+const char* keystream_path_name(EKeystreamPath path);
+}  // namespace pac
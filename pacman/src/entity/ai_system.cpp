@@ -1,11 +1,13 @@
 #include "ai_system.h"
 #include "pathfinding.h"
 #include "level.h"
+#include "event_bus.h"
+#include "job_system.h"
 #include "config.h"
 
 namespace pac
 {
-extern entt::dispatcher g_event_queue;
+extern EventBus g_event_queue;
 
 AISystem::AISystem(entt::registry& reg, Level& level) : System(reg), m_level(level)
 {
@@ -21,7 +23,10 @@ AISystem::~AISystem() noexcept
 
 void AISystem::update(float dt)
 {
-    /* Update paths when required */
+    /* Solve the requests of the last tick first, with the states they were made with */
+    solve_repaths();
+
+    /* Update AI states */
     m_reg.view<CAI>().each([this, dt](entt::entity e, CAI& ai) {
         /* Get position of AI */
         const auto& ai_pos = m_reg.get<CPosition>(e);
@@ -66,7 +71,7 @@ void AISystem::update(float dt)
             if (ai_pos.position == ai_pos.spawn)
             {
                 GFX_DEBUG("Ghost is Respawning from the Dead.");
-                m_reg.get<CAnimationSprite>(e).tint = glm::vec3{1.f, 1.f, 1.f};
+                m_reg.get<CTint>(e).tint = glm::vec3{1.f, 1.f, 1.f};
                 ai.state = EAIState::Searching;
                 ai.state_timer = 0.f;
                 g_event_queue.enqueue(EvGhostStateChanged{e, ai.state});
@@ -85,10 +90,23 @@ void AISystem::recieve(const EvEntityMoved& move)
         return;
     }
 
-    /* Create a new path and then ask movement system to move in the direction of the path */
-    pathfind(m_reg.get<CPosition>(move.entity), move.direction, get_player_pos(), m_reg.get<CAI>(move.entity));
-    const auto new_direction = m_reg.get<CAI>(move.entity).path->get();
-    m_reg.get<CMovement>(move.entity).desired_direction = new_direction;
+    /* Queue a new path, it is found together with the others in the next update. A ghost that already asked this tick
+     * only keeps its last request. */
+    const auto [it, added] = m_repath_index.emplace(move.entity, m_repaths.size());
+    if (added)
+    {
+        m_repaths.emplace_back();
+    }
+
+    /* Copy what the search needs now, so it uses the same state as if it was searched right away */
+    const auto& pos = m_reg.get<CPosition>(move.entity);
+    auto& request = m_repaths[it->second];
+    request.entity = move.entity;
+    request.direction = move.direction;
+    request.state = m_reg.get<CAI>(move.entity).state;
+    request.position = pos.position;
+    request.spawn = pos.spawn;
+    request.player_position = get_player_pos();
 }
 
 void AISystem::recieve_pacmanstate(const EvPacInvulnreableChange& pac)
@@ -107,6 +125,8 @@ void AISystem::recieve_pacmanstate(const EvPacInvulnreableChange& pac)
     }
 }
 
+void AISystem::set_parallel_repath(bool parallel) { m_parallel_repath = parallel; }
+
 glm::ivec2 AISystem::get_player_pos() const
 {
     glm::ivec2 out_pos{};
@@ -114,26 +134,92 @@ glm::ivec2 AISystem::get_player_pos() const
     return out_pos;
 }
 
-void AISystem::pathfind(const CPosition& pos, const glm::ivec2& ai_dir, const glm::ivec2& plr_pos, CAI& ai)
+void AISystem::solve_repaths()
 {
+    if (m_repaths.empty())
+    {
+        return;
+    }
+
+    /* Ghosts that were removed since they asked get no path */
+    for (auto& request : m_repaths)
+    {
+        if (!m_reg.valid(request.entity) || !m_reg.has<CAI>(request.entity))
+        {
+            request.entity = entt::null;
+        }
+    }
+
+    const auto solve = [this](std::size_t first, std::size_t last) {
+        for (auto i = first; i < last; ++i)
+        {
+            if (m_repaths[i].entity != entt::null)
+            {
+                pathfind(m_repaths[i]);
+            }
+        }
+    };
+
+    if (m_parallel_repath && m_repaths.size() >= AI_REPATH_PARALLEL_MIN)
+    {
+        get_job_system().parallel_for("Ghost Repath", 0u, m_repaths.size(), AI_REPATH_GRAIN, solve);
+    }
+    else
+    {
+        solve(0u, m_repaths.size());
+    }
+
+    /* Apply the paths in the order the ghosts first asked */
+    for (auto& request : m_repaths)
+    {
+        if (!request.path)
+        {
+            continue;
+        }
+
+        auto& ai = m_reg.get<CAI>(request.entity);
+        ai.target = request.target;
+        ai.path = std::move(request.path);
+        m_reg.get<CMovement>(request.entity).desired_direction = ai.path->get();
+    }
+    m_repaths.clear();
+    m_repath_index.clear();
+}
+
+void AISystem::pathfind(RepathRequest& request) const
+{
+    const auto& plr_pos = request.player_position;
+
     /* Based on state, we will have different targets for the AI */
-    switch (ai.state)
+    switch (request.state)
     {
     /* Chasing goes directly to the player */
-    case EAIState::Chasing: ai.target = plr_pos; break;
+    case EAIState::Chasing: request.target = plr_pos; break;
     /* ChasingAhead goes ahead of the player, anticipating their moves (TODO : Add this state) */
-    case EAIState::ChasingAhead: ai.target = plr_pos; break;
+    case EAIState::ChasingAhead: request.target = plr_pos; break;
     /* Scattering means going to random areas nearby */
-    case EAIState::Scattering: ai.target = m_level.find_closest_intersection(pos.position, ai_dir); break;
+    case EAIState::Scattering:
+        request.target = m_level.find_closest_intersection(request.position, request.direction);
+        break;
     /* Searching doesn't know where the player is, and will wander to the next intersection */
-    case EAIState::Searching: ai.target = m_level.find_closest_intersection(plr_pos, -ai_dir); break;
+    case EAIState::Searching: request.target = m_level.find_closest_intersection(plr_pos, -request.direction); break;
     /* Fleeing means -> Get away from Pacman ASAP! */
-    case EAIState::Scared: ai.target = m_level.find_sensible_escape_point(pos.position, ai_dir, plr_pos); break;
+    case EAIState::Scared:
+        request.target = m_level.find_sensible_escape_point(request.position, request.direction, plr_pos);
+        break;
     /* When Dead -> Go to Death Point */
-    case EAIState::Dead: ai.target = pos.spawn; break;
+    case EAIState::Dead: request.target = request.spawn; break;
     }
 
     /* Create path to the requested location */
-    ai.path = std::make_unique<Path>(m_level, pos.position, ai.target);
+    request.path = std::make_unique<Path>(m_level, request.position, request.target);
 }
+
+const char* AISystem::name() const { return "AI System"; }
+
+SystemAccess AISystem::access() const
+{
+    return {component_mask<CPosition, CPlayer>(), component_mask<CAI, CMovement, CTint>(), false, false};
+}
+
 }  // namespace pac
@@ -4,20 +4,53 @@
 #include "events.h"
 #include "components.h"
 
+#include <memory>
+#include <vector>
+
 #include <glm/vec2.hpp>
+#include <robinhood/robinhood.h>
 
 namespace pac
 {
 class Level;
 
 /*!
- * \brief The AISystem handles Ghost AI
+ * \brief The AISystem handles Ghost AI. Ghosts that reach a new tile ask for a new path, and the requests of a tick are solved
+ * together at the start of the next update (split over the job system when there are many of them). A ghost that asks again
+ * before its request is solved replaces it, so every ghost gets one path per batch, searched with what it knew when it last
+ * asked. The new paths are applied in the order the ghosts first asked, so the outcome never depends on how the searches
+ * were scheduled.
  */
 class AISystem : public System
 {
 private:
+    /*!
+     * \brief The RepathRequest struct is a ghost that needs a new path, what the search needs to know, and its result
+     */
+    struct RepathRequest
+    {
+        entt::entity entity = entt::null;
+        glm::ivec2 direction{};
+
+        /* Copied from the ghost and the player when the request is made */
+        EAIState state = EAIState::Scattering;
+        glm::ivec2 position{};
+        glm::ivec2 spawn{};
+        glm::ivec2 player_position{};
+
+        /* The result of the search (no path means the ghost is gone) */
+        glm::ivec2 target{};
+        std::unique_ptr<Path> path = nullptr;
+    };
+
     Level& m_level;
 
+    /* Requests made since the last update, one per ghost in the order they first asked, and where each ghost's request is */
+    std::vector<RepathRequest> m_repaths = {};
+    robin_hood::unordered_map<entt::entity, std::size_t> m_repath_index{};
+
+    bool m_parallel_repath = true;
+
 public:
     AISystem(entt::registry& reg, Level& level);
 
@@ -25,10 +58,23 @@ public:
 
     void update(float dt) override;
 
+    const char* name() const override;
+
+    SystemAccess access() const override;
+
+    /*!
+     * \brief recieve queues a new path for a ghost that has moved onto a new tile, replacing one it already queued
+     */
     void recieve(const EvEntityMoved& move);
 
     void recieve_pacmanstate(const EvPacInvulnreableChange& pac);
 
+    /*!
+     * \brief set_parallel_repath selects whether large batches of path searches are split over the job system, or solved on
+     * the thread running the system
+     */
+    void set_parallel_repath(bool parallel);
+
 private:
     /*!
      * \brief get_player_pos gets the position of the player
@@ -37,6 +83,14 @@ private:
      */
     glm::ivec2 get_player_pos() const;
 
-    void pathfind(const CPosition& pos, const glm::ivec2& ai_dir, const glm::ivec2& plr_pos, CAI& ai);
+    /*!
+     * \brief solve_repaths finds a path for every queued request, and sets the desired direction of the ghosts that made them
+     */
+    void solve_repaths();
+
+    /*!
+     * \brief pathfind picks the target of a request based on the ghost's state and searches for a path to it
+     */
+    void pathfind(RepathRequest& request) const;
 };
 }  // namespace pac
@@ -6,16 +6,20 @@ namespace pac
 void pac::AnimationSystem::update(float dt)
 {
     /* Update animation frame */
-    m_reg.view<CAnimationSprite>().each([dt](auto e, CAnimationSprite& spr) {
-        spr.animation_timer += dt;
+    m_reg.view<CAnimationFrame>().each([dt](auto e, CAnimationFrame& anim) {
+        anim.animation_timer += dt;
 
         /* If we hit a new frame, then update frame number */
-        if (spr.animation_timer > 1.f / spr.fps)
+        if (anim.animation_timer > 1.f / anim.fps)
         {
-            spr.animation_timer = 0.f;
-            spr.active_animation.frame_number = (spr.active_animation.frame_number + 1) % spr.active_animation.frame_count;
+            anim.animation_timer = 0.f;
+            ++anim.frame;
         }
     });
 }
 
+const char* AnimationSystem::name() const { return "Animation System"; }
+
+SystemAccess AnimationSystem::access() const { return {0u, component_mask<CAnimationFrame>(), false, false}; }
+
 }  // namespace pac
@@ -46,17 +46,22 @@ struct CMovement
     float progress = 0.f;
 };
 
-/* Animated sprite component */
+/* Animated sprite component, which animation is shown (the frame shown is in CAnimationFrame) */
 struct CAnimationSprite
 {
     /* Available animations (accessible by hash of their name */
     robin_hood::unordered_map<std::string, TextureID> available_animations{};
 
-    /* Color tint */
-    glm::vec3 tint = glm::vec3(1.f);
-
     /* The active animation sprite (from the map) */
     TextureID active_animation{};
+};
+
+/* Animation frame component, advanced by the AnimationSystem alone. It counts frames without wrapping them, so it does not
+ * depend on which animation is active and the systems that change that can run at the same time as it. */
+struct CAnimationFrame
+{
+    /* Frames since the entity was spawned, the one shown is this modulo the frame count of the active animation */
+    uint32_t frame = 0u;
 
     /* Current animation time */
     float animation_timer = 0.f;
@@ -65,6 +70,12 @@ struct CAnimationSprite
     float fps = 24.f;
 };
 
+/* Color tint component of animated sprites, kept apart from them so the systems that change it do not touch the animation */
+struct CTint
+{
+    glm::vec3 tint = glm::vec3(1.f);
+};
+
 struct CSprite
 {
     /* Sprite ID */
@@ -109,7 +120,9 @@ struct CAI
     float state_timer = 0.f;
 };
 
-/* Input Component */
+/* Input Component. Entities spawned together from one entity file share the same lua functions (and anything they capture
+ * from the file), since the file only runs once. Each action is called with the entity it runs for, so state that belongs to
+ * one entity should be kept on that entity and not in the functions' upvalues. */
 struct CInput
 {
     robin_hood::unordered_map<Action, sol::function> actions{};
@@ -3,6 +3,8 @@
 #include "common.h"
 #include "input/input.h"
 
+#include <string_view>
+
 #include <entt/entity/registry.hpp>
 
 namespace pac
@@ -32,8 +34,14 @@ struct EvPacInvulnreableChange
 
 struct EvPacPickup
 {
-    std::string pickup_name{};
-    int score_delta;
+    /* Name of the pickup, interned so the event stays trivially copyable whatever the length of the name */
+    const char* pickup_name = "";
+    int score_delta = 0;
+
+    EvPacPickup() = default;
+    EvPacPickup(std::string_view name, int score) : pickup_name(intern_name(name)), score_delta(score) {}
+
+    std::string_view get_pickup_name() const { return pickup_name; }
 };
 
 struct EvGhostStateChanged
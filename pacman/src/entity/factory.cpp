@@ -1,5 +1,6 @@
 #include "factory.h"
 #include "rendering/renderer.h"
+#include "profiler.h"
 
 #include <entt/meta/factory.hpp>
 
@@ -9,7 +10,18 @@ EntityFactory::EntityFactory(entt::registry& registry) : m_registry(registry) {}
 
 entt::entity EntityFactory::spawn(sol::state_view& state, const std::string& name)
 {
-    auto e = m_registry.create();
+    entt::entity e = entt::null;
+    spawn(state, name, &e, &e + 1);
+    return e;
+}
+
+bool EntityFactory::spawn(sol::state_view& state, const std::string& name, entt::entity* first, entt::entity* last)
+{
+    PAC_PROFILE_SCOPE("EntityFactory::spawn");
+    if (first == last)
+    {
+        return true;
+    }
 
     /* Map entity names to filepaths */
     if (m_entity_path_map.find(name) == m_entity_path_map.end())
@@ -21,15 +33,16 @@ entt::entity EntityFactory::spawn(sol::state_view& state, const std::string& nam
         }
         else
         {
-            return entt::null;
+            return false;
         }
     }
 
     /* Get the filepath assosciated with the entity name */
     const auto& filepath = m_entity_path_map.at(name);
-    GFX_DEBUG("Making entity from file: %s", filepath.filename().c_str());
+    GFX_DEBUG("Making %td entities from file: %s", last - first, filepath.filename().c_str());
 
-    /* Load script, and iterate all keys in table */
+    /* Create every entity at once, then load the script (only once) and iterate all keys in table */
+    m_registry.create(first, last);
     state.script_file(filepath.string());
     sol::table table = state[filepath.filename().stem().string()];
     for (const auto& k : table)
@@ -39,18 +52,18 @@ entt::entity EntityFactory::spawn(sol::state_view& state, const std::string& nam
         /* Hash key for faster compares, and then get the component */
         sol::table component = table[k.first.as<const char*>()];
 
-        /* Check all known components, and attach it to the entity */
+        /* Check all known components, and attach it to the entities */
         const auto& key = k.first.as<std::string>();
         if (auto fn = m_component_map.find(key); fn != m_component_map.end())
         {
-            fn->getSecond()(state, component, e);
+            (this->*fn->getSecond())(state, component, first, last);
         }
     }
 
-    /* Finally add a meta data component since it was created by a factory */
-    m_registry.assign<CMeta>(e, filepath.filename().stem().string());
+    /* Finally add a meta data component since they were created by a factory */
+    m_registry.assign<CMeta>(first, last, CMeta{filepath.filename().stem().string()});
 
-    return e;
+    return true;
 }
 
 std::optional<std::filesystem::path> EntityFactory::find_entity_path(const std::string& name)
@@ -85,14 +98,15 @@ std::optional<std::filesystem::path> EntityFactory::find_entity_path(const std::
     return std::nullopt;
 }
 
-void EntityFactory::make_sprite_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_sprite_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
     GFX_DEBUG("Adding Sprite Component");
-    m_registry.assign<CSprite>(e, CSprite{get_renderer().get_tileset_texture(comp["index"]),
-                                          glm::vec3{comp["tint"][1], comp["tint"][2], comp["tint"][3]}});
+    m_registry.assign<CSprite>(first, last,
+                               CSprite{get_renderer().get_tileset_texture(comp["index"]),
+                                       glm::vec3{comp["tint"][1], comp["tint"][2], comp["tint"][3]}});
 }
 
-void EntityFactory::make_animsprite_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_animsprite_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
     /* Prepare data */
     robin_hood::unordered_map<std::string, TextureID> anims{};
@@ -112,52 +126,62 @@ void EntityFactory::make_animsprite_component(sol::state_view& state, const sol:
         anims.emplace(k.as<std::string>(), tex);
     });
 
-    /* Finally create animation sprite based on loaded data */
-    m_registry.assign<CAnimationSprite>(e, anims, glm::vec3{comp["tint"][1], comp["tint"][2], comp["tint"][3]},
-                                        anims[comp["starting"]], 0.f, comp["fps"]);
+    /* Finally create animation sprite based on loaded data (the textures are shared by every entity) */
+    const auto starting = anims[comp["starting"]];
+    const glm::vec3 tint{comp["tint"][1], comp["tint"][2], comp["tint"][3]};
+    m_registry.assign<CAnimationSprite>(first, last, CAnimationSprite{std::move(anims), starting});
+    m_registry.assign<CAnimationFrame>(first, last, CAnimationFrame{0u, 0.f, comp["fps"]});
+    m_registry.assign<CTint>(first, last, CTint{tint});
 }
 
-void EntityFactory::make_ai_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_ai_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
-    m_registry.assign<CAI>(e);
+    /* The AI component owns its path, so it can not be copied to every entity and is assigned one at a time instead */
+    m_registry.reserve<CAI>(m_registry.size<CAI>() + static_cast<std::size_t>(last - first));
+    for (; first != last; ++first)
+    {
+        m_registry.assign<CAI>(*first);
+    }
 }
 
-void EntityFactory::make_position_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_position_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
     GFX_DEBUG("Position Component at (%d, %d)", comp["x"].get<int>(), comp["y"].get<int>());
-    m_registry.assign<CPosition>(e, CPosition{glm::ivec2{comp["x"], comp["y"]}, glm::ivec2{comp["x"], comp["y"]}});
+    m_registry.assign<CPosition>(first, last, CPosition{glm::ivec2{comp["x"], comp["y"]}, glm::ivec2{comp["x"], comp["y"]}});
 }
 
-void EntityFactory::make_movement_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_movement_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
-    m_registry.assign<CMovement>(e, glm::ivec2{0}, glm::ivec2{0}, comp["speed"], 0.f);
+    m_registry.assign<CMovement>(first, last, CMovement{glm::ivec2{0}, glm::ivec2{0}, comp["speed"], 0.f});
 }
 
-void EntityFactory::make_player_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_player_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
-    m_registry.assign<CPlayer>(e, get_renderer().get_tileset_texture(comp["icon"]), comp["lives"].get<int>(), 0, 0.f, 0);
+    m_registry.assign<CPlayer>(first, last,
+                               CPlayer{get_renderer().get_tileset_texture(comp["icon"]), comp["lives"].get<int>(), 0, 0.f, 0});
 }
 
-void EntityFactory::make_input_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_input_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
+    /* The functions are references to the ones in the entity table, so every entity calls the same closures */
     robin_hood::unordered_map<Action, sol::function> actions{};
     for (auto& [k, v] : comp)
     {
         actions.emplace(k.as<Action>(), v.as<sol::function>());
     }
 
-    m_registry.assign<CInput>(e, std::move(actions));
+    m_registry.assign<CInput>(first, last, CInput{std::move(actions)});
 }
 
-void EntityFactory::make_pickup_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_pickup_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
     GFX_DEBUG("Adding Pikcup Component");
-    m_registry.assign<CPickup>(e, comp["score"].get<int>());
+    m_registry.assign<CPickup>(first, last, CPickup{comp["score"].get<int>()});
 }
 
-void EntityFactory::make_collision_component(sol::state_view& state, const sol::table& comp, entt::entity e)
+void EntityFactory::make_collision_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last)
 {
-    m_registry.assign<CCollision>(e);
+    m_registry.assign<CCollision>(first, last);
 }
 
 }  // namespace pac
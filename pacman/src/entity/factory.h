@@ -20,7 +20,9 @@ namespace pac
 class EntityFactory
 {
 private:
-    using ComponentFn = std::function<void(sol::state_view&, const sol::table&, entt::entity)>;
+    /* The entities [first, last) a component is assigned to */
+    using EntityIt = const entt::entity*;
+    using ComponentFn = void (EntityFactory::*)(sol::state_view&, const sol::table&, EntityIt, EntityIt);
 
     /* Factory registry */
     entt::registry& m_registry;
@@ -30,16 +32,15 @@ private:
 
     /* Map component names to their respective creation functions */
     robin_hood::unordered_map<std::string, ComponentFn> m_component_map{
-        {"Sprite", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_sprite_component(s, t, e); }},
-        {"Position", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_position_component(s, t, e); }},
-        {"Pickup", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_pickup_component(s, t, e); }},
-        {"Collision", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_collision_component(s, t, e); }},
-        {"Movement", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_movement_component(s, t, e); }},
-        {"Player", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_player_component(s, t, e); }},
-        {"AnimationSprite",
-         [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_animsprite_component(s, t, e); }},
-        {"AI", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_ai_component(s, t, e); }},
-        {"Input", [this](sol::state_view& s, const sol::table& t, entt::entity e) { make_input_component(s, t, e); }}};
+        {"Sprite", &EntityFactory::make_sprite_component},
+        {"Position", &EntityFactory::make_position_component},
+        {"Pickup", &EntityFactory::make_pickup_component},
+        {"Collision", &EntityFactory::make_collision_component},
+        {"Movement", &EntityFactory::make_movement_component},
+        {"Player", &EntityFactory::make_player_component},
+        {"AnimationSprite", &EntityFactory::make_animsprite_component},
+        {"AI", &EntityFactory::make_ai_component},
+        {"Input", &EntityFactory::make_input_component}};
 
 public:
     EntityFactory(entt::registry& registry);
@@ -52,6 +53,18 @@ public:
      */
     entt::entity spawn(sol::state_view& state, const std::string& name);
 
+    /*!
+     * \brief spawn spawns one entity for every element of [first, last) from a resource file. The file is only read once, and
+     * every component is built once and then assigned to all the entities in one go. This means the lua functions of an Input
+     * component are shared by all of them, see CInput
+     * \param state is the lua state where the entity is defined
+     * \param name is the name of the entity
+     * \param first is where the first new entity is written
+     * \param last is one past where the last new entity is written
+     * \return true if the entities were spawned, nothing is created if the entity does not exist
+     */
+    bool spawn(sol::state_view& state, const std::string& name, entt::entity* first, entt::entity* last);
+
 private:
     /*!
      * \brief find_entity_path finds the path of the .lua file where the entity data is stored
@@ -60,16 +73,16 @@ private:
      */
     std::optional<std::filesystem::path> find_entity_path(const std::string& name);
 
-    /* Factory functions for each component type */
-    void make_sprite_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_animsprite_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_ai_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_position_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_movement_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_player_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_input_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_pickup_component(sol::state_view& state, const sol::table& comp, entt::entity e);
-    void make_collision_component(sol::state_view& state, const sol::table& comp, entt::entity e);
+    /* Factory functions for each component type, they assign the component to every entity in [first, last) */
+    void make_sprite_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_animsprite_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_ai_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_position_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_movement_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_player_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_input_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_pickup_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
+    void make_collision_component(sol::state_view& state, const sol::table& comp, EntityIt first, EntityIt last);
 };
 
 }  // namespace pac
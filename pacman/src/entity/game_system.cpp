@@ -3,11 +3,12 @@
 #include "states/respawn_state.h"
 #include "states/game_over_state.h"
 #include "entity/components.h"
+#include "event_bus.h"
 #include "config.h"
 
 namespace pac
 {
-extern entt::dispatcher g_event_queue;
+extern EventBus g_event_queue;
 
 GameSystem::GameSystem(entt::registry& reg, GameContext context) : System(reg), m_context(context)
 {
@@ -58,7 +59,7 @@ void GameSystem::update(float dt)
         }
 
         /* Do similar check for ghosts */
-        auto enemies = m_reg.group<CAI>(entt::get<const CPosition, CAnimationSprite>);
+        auto enemies = m_reg.group<CAI>(entt::get<const CPosition, CTint>);
         for (auto ghost : enemies)
         {
             if (enemies.get<const CPosition>(ghost).position == pos.position)
@@ -77,7 +78,7 @@ void GameSystem::update(float dt)
 
                     /* Mark ghost as dead and set it's tint to someting sensible */
                     enemies.get<CAI>(ghost).state = EAIState::Dead;
-                    enemies.get<CAnimationSprite>(ghost).tint = glm::vec3{0.05f, 0.05f, 1.f};
+                    enemies.get<CTint>(ghost).tint = glm::vec3{0.05f, 0.05f, 1.f};
                 }
                 else
                 {
@@ -114,4 +115,13 @@ void GameSystem::recieve(const EvPacLifeChanged& life_update)
     }
 }
 
+const char* GameSystem::name() const { return "Game System"; }
+
+SystemAccess GameSystem::access() const
+{
+    /* Pickups are destroyed, events are triggered and states are pushed, so it runs alone on the main thread */
+    return {component_mask<CPlayer, CPosition, CPickup, CMeta, CAI, CTint>(), component_mask<CPlayer, CAI, CTint>(), true,
+            true};
+}
+
 }  // namespace pac
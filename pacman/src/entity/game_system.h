@@ -24,6 +24,10 @@ public:
 
     void update(float dt) override;
 
+    const char* name() const override;
+
+    SystemAccess access() const override;
+
     void recieve(const EvPacLifeChanged& life_update);
 };
 }  // namespace pac
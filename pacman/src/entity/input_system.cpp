@@ -1,11 +1,12 @@
 #include "input_system.h"
 #include "components.h"
-
-#include <entt/signal/dispatcher.hpp>
+#include "profiler.h"
+#include "event_bus.h"
+#include "common.h"
 
 namespace pac
 {
-extern entt::dispatcher g_event_queue;
+extern EventBus g_event_queue;
 
 InputSystem::InputSystem(entt::registry& reg) : System(reg)
 {
@@ -24,6 +25,8 @@ void InputSystem::update(float dt)
         {
             if (auto found = input.actions.find(action); found != input.actions.end())
             {
+                PAC_PROFILE_SCOPE("Lua Input Action");
+                LuaCallTimer timer{};
                 found->second.call(e);
             }
         }
@@ -35,4 +38,13 @@ void InputSystem::update(float dt)
 
 void InputSystem::recieve(const EvInput& input) { m_unprocessed_actions.push_back(input.action); }
 
+const char* InputSystem::name() const { return "Input System"; }
+
+SystemAccess InputSystem::access() const
+{
+    /* The actions are lua functions, which may move and animate the entity (see move and set_animation) but can also play
+     * sounds or connect to events, so it runs alone on the main thread */
+    return {component_mask<CInput>(), component_mask<CMovement, CAnimationSprite>(), true, true};
+}
+
 }  // namespace pac
@@ -21,6 +21,10 @@ public:
 
     void update(float dt) override;
 
+    const char* name() const override;
+
+    SystemAccess access() const override;
+
     /*!
      * \brief recieve
      * \param input
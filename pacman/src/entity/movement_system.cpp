@@ -2,15 +2,20 @@
 #include "components.h"
 #include "events.h"
 #include "level.h"
+#include "alloc_tracker.h"
+#include "event_bus.h"
 
 #include <gfx.h>
 
 namespace pac
 {
-extern entt::dispatcher g_event_queue;
+extern EventBus g_event_queue;
 
 void MovementSystem::update(float dt)
 {
+    /* Movement only touches components and the (already grown) event queue, so it should never allocate once warmed up */
+    PAC_ALLOC_BUDGET("MovementSystem::update", 0u);
+
     auto movement_group = m_reg.group<CPosition, CMovement>(entt::get<CCollision>);
     movement_group.each([dt, this](entt::entity e, CPosition& pos, CMovement& mov, const CCollision& _) {
         /* Check if we can move towards desired direction and switch it if possible */
@@ -88,4 +93,11 @@ void MovementSystem::update_animation(glm::ivec2 new_direction, CAnimationSprite
     }
 }
 
+const char* MovementSystem::name() const { return "Movement System"; }
+
+SystemAccess MovementSystem::access() const
+{
+    return {component_mask<CCollision, CPlayer>(), component_mask<CPosition, CMovement, CAnimationSprite>(), false, false};
+}
+
 }  // namespace pac
@@ -20,6 +20,10 @@ public:
 
     void update(float dt) override;
 
+    const char* name() const override;
+
+    SystemAccess access() const override;
+
 private:
     void update_animation(glm::ivec2 new_direction, CAnimationSprite& anim);
 };
@@ -23,14 +23,16 @@ void RenderingSystem::update(float dt)
             interp_pos += move.progress * glm::vec2(move.current_direction);
         }
 
-        /* Submit the draw request */
+        /* Submit the draw request (below animated sprites, so pickups never cover ghosts or the player) */
         get_renderer().draw({HALF_TILE + interp_pos * TILE_SIZE<float>, glm::vec2(TILE_SIZE<float>, TILE_SIZE<float>),
-                             sprite.tint, sprite.sprite});
+                             sprite.tint, sprite.sprite},
+                            ELayer::Entities, 0u);
     });
 
     /* Draw Animated Sprites */
-    auto regular_moving_anim = m_reg.view<CAnimationSprite, CPosition>();
-    regular_moving_anim.each([this](auto e, const CAnimationSprite& sprite, const CPosition& pos) {
+    auto regular_moving_anim = m_reg.view<CAnimationSprite, CAnimationFrame, CTint, CPosition>();
+    regular_moving_anim.each([this](auto e, const CAnimationSprite& sprite, const CAnimationFrame& anim, const CTint& tint,
+                                    const CPosition& pos) {
         auto interp_pos = glm::vec2(pos.position);
 
         /* If we also have a movement comp, take that into consideration */
@@ -40,9 +42,12 @@ void RenderingSystem::update(float dt)
             interp_pos += move.progress * glm::vec2(move.current_direction);
         }
 
-        /* Draw */
+        /* Draw the current frame of the active animation */
+        auto texture = sprite.active_animation;
+        texture.frame_number = static_cast<uint8_t>(anim.frame % texture.frame_count);
         get_renderer().draw({HALF_TILE + interp_pos * TILE_SIZE<float>, glm::vec2(TILE_SIZE<float>, TILE_SIZE<float>),
-                             sprite.tint, sprite.active_animation});
+                             tint.tint, texture},
+                            ELayer::Entities, 1u);
     });
 
     /* Draw Player Icon as Lives */
@@ -61,8 +66,19 @@ void RenderingSystem::update(float dt)
             get_renderer().draw({HALF_TILE + glm::vec2(i + 1, SCREEN_H / TILE_SIZE<int> - 2) * TILE_SIZE<float>,
                                  {TILE_SIZE<float>, TILE_SIZE<float>},
                                  {1.f, 1.f, 1.f},
-                                 plr.icon});
+                                 plr.icon},
+                                ELayer::Interface);
         }
     });
 }
+
+const char* RenderingSystem::name() const { return "Rendering System"; }
+
+SystemAccess RenderingSystem::access() const
+{
+    /* Drawing goes through the renderer and ImGui, so it stays on the main thread */
+    return {component_mask<CSprite, CPosition, CMovement, CAnimationSprite, CAnimationFrame, CTint, CPlayer>(), 0u, true,
+            false};
+}
+
 }  // namespace pac
@@ -14,5 +14,9 @@ public:
     using System::System;
 
     void update(float dt) override;
+
+    const char* name() const override;
+
+    SystemAccess access() const override;
 };
 }  // namespace pac
@@ -1,9 +1,56 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
+#include <gfx.h>
 #include <entt/entity/registry.hpp>
 
 namespace pac
 {
+/* One bit per component type, see component_mask */
+using ComponentMask = uint64_t;
+
+namespace detail
+{
+/* Source of component bits, they are handed out the first time each component type is used */
+inline std::atomic<unsigned> g_next_component_bit = 0u;
+
+template<typename Component>
+ComponentMask component_bit()
+{
+    static const unsigned bit = g_next_component_bit++;
+    GFX_ASSERT(bit < 64u, "There are more component types than bits in a ComponentMask.");
+    return ComponentMask{1u} << bit;
+}
+}  // namespace detail
+
+/*!
+ * \brief component_mask returns the mask with the bits of the given component types set
+ */
+template<typename... Components>
+ComponentMask component_mask()
+{
+    return (ComponentMask{0u} | ... | detail::component_bit<Components>());
+}
+
+/*!
+ * \brief The SystemAccess struct describes what a system touches while it updates, so the SystemScheduler knows which systems
+ * can run at the same time. Two systems conflict if either writes a component the other reads or writes.
+ */
+struct SystemAccess
+{
+    /* Components read and written */
+    ComponentMask reads = ~ComponentMask{0u};
+    ComponentMask writes = ~ComponentMask{0u};
+
+    /* The system calls into lua, the renderer, ImGui or the state manager, which only work on the main thread */
+    bool main_thread = true;
+
+    /* The system creates or destroys entities or triggers events, so it runs alone (on the main thread) */
+    bool exclusive = true;
+};
+
 /*!
  * \brief The System class represents a separate part of logic that should be updated in the game world. For example a movement
  * system should handle all movement updates.
@@ -28,6 +75,17 @@ public:
      * \param reg is the current entity registry to work with
      */
     virtual void update(float dt) = 0;
+
+    /*!
+     * \brief name returns the name of the system, used to label it in the profiler
+     */
+    virtual const char* name() const = 0;
+
+    /*!
+     * \brief access returns what the system touches while it updates. The default is everything, on the main thread and with
+     * nothing else running, which is always safe.
+     */
+    virtual SystemAccess access() const { return {}; }
 };
 
 }  // namespace pac
@@ -0,0 +1,167 @@
+#include "system_scheduler.h"
+#include "profiler.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+SystemScheduler::SystemScheduler(JobSystem& jobs) : m_jobs(jobs) {}
+
+void SystemScheduler::set_systems(const std::vector<std::unique_ptr<System>>& systems)
+{
+    m_nodes = std::vector<Node>(systems.size());
+    for (std::size_t i = 0u; i < systems.size(); ++i)
+    {
+        m_nodes[i].system = systems[i].get();
+        m_nodes[i].access = systems[i]->access();
+
+        /* A system waits for every earlier system it conflicts with */
+        for (std::size_t earlier = 0u; earlier < i; ++earlier)
+        {
+            if (systems_conflict(m_nodes[earlier].access, m_nodes[i].access))
+            {
+                m_nodes[earlier].successors.push_back(i);
+                ++m_nodes[i].predecessors;
+            }
+        }
+    }
+
+    m_main_ready.reserve(m_nodes.size());
+    m_finished.reserve(m_nodes.size());
+    m_finished_swap.reserve(m_nodes.size());
+    m_warm_up = true;
+}
+
+void SystemScheduler::run(float dt, EventBus& bus)
+{
+    PAC_PROFILE_SCOPE("SystemScheduler::run");
+    const auto start = std::chrono::steady_clock::now();
+    m_stats.worker_systems = 0u;
+
+    if (!m_parallel || m_warm_up)
+    {
+        for (std::size_t i = 0u; i < m_nodes.size(); ++i)
+        {
+            run_node(i, dt);
+        }
+        m_warm_up = false;
+    }
+    else
+    {
+        for (std::size_t i = 0u; i < m_nodes.size(); ++i)
+        {
+            m_nodes[i].waiting_for = m_nodes[i].predecessors;
+        }
+
+        for (std::size_t i = 0u; i < m_nodes.size(); ++i)
+        {
+            if (m_nodes[i].predecessors == 0u)
+            {
+                dispatch(i, dt);
+            }
+        }
+
+        /* Run main thread systems as they become ready, and otherwise help the workers until they finish one */
+        auto remaining = m_nodes.size();
+        while (remaining > 0u)
+        {
+            if (!m_main_ready.empty())
+            {
+                const auto index = m_main_ready.front();
+                m_main_ready.erase(m_main_ready.begin());
+                run_node(index, dt);
+                finish(index, dt);
+                --remaining;
+                continue;
+            }
+
+            {
+                std::unique_lock lock(m_mutex);
+                if (m_finished.empty())
+                {
+                    lock.unlock();
+                    if (m_jobs.run_one())
+                    {
+                        continue;
+                    }
+
+                    lock.lock();
+                    m_finished_changed.wait(lock, [this] { return !m_finished.empty(); });
+                }
+                std::swap(m_finished, m_finished_swap);
+            }
+
+            for (const auto index : m_finished_swap)
+            {
+                finish(index, dt);
+                --remaining;
+            }
+            m_finished_swap.clear();
+        }
+    }
+
+    /* Every system is done, so the events can go to the bus in the order the systems are listed */
+    for (auto& node : m_nodes)
+    {
+        node.events.flush(bus);
+    }
+
+    m_stats.frame_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SystemScheduler::set_parallel(bool parallel) { m_parallel = parallel; }
+
+const SystemScheduler::Stats& SystemScheduler::get_stats() const { return m_stats; }
+
+void SystemScheduler::run_node(std::size_t index, float dt)
+{
+    auto& node = m_nodes[index];
+    DeferredEvents::Scope deferred(node.events);
+    PAC_PROFILE_SCOPE(node.system->name());
+    node.system->update(dt);
+}
+
+void SystemScheduler::dispatch(std::size_t index, float dt)
+{
+    if (m_nodes[index].access.main_thread || m_nodes[index].access.exclusive)
+    {
+        m_main_ready.insert(std::upper_bound(m_main_ready.begin(), m_main_ready.end(), index), index);
+        return;
+    }
+
+    ++m_stats.worker_systems;
+    m_jobs.run("Scheduled System", [this, index, dt] {
+        run_node(index, dt);
+
+        /* Notify while holding the lock, once it is released the scheduler may be gone */
+        std::lock_guard lock(m_mutex);
+        m_finished.push_back(index);
+        m_finished_changed.notify_one();
+    });
+}
+
+void SystemScheduler::finish(std::size_t index, float dt)
+{
+    for (const auto successor : m_nodes[index].successors)
+    {
+        GFX_ASSERT(m_nodes[successor].waiting_for > 0u, "System %s finished twice.", m_nodes[index].system->name());
+        if (--m_nodes[successor].waiting_for == 0u)
+        {
+            dispatch(successor, dt);
+        }
+    }
+}
+
+bool systems_conflict(const SystemAccess& a, const SystemAccess& b)
+{
+    if (a.exclusive || b.exclusive)
+    {
+        return true;
+    }
+
+    return (a.writes & (b.reads | b.writes)) != 0u || (b.writes & a.reads) != 0u;
+}
+}  // namespace pac
@@ -0,0 +1,134 @@
+/*!
+ * \file system_scheduler.h contains the scheduler that updates the systems of a state, running systems that do not touch the
+ * same components at the same time on the worker pool.
+ */
+
+#pragma once
+
+#include "system.h"
+#include "event_bus.h"
+#include "job_system.h"
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <condition_variable>
+
+namespace pac
+{
+/*!
+ * \brief The SystemScheduler class updates a list of systems once per frame. A system waits for every earlier system it
+ * conflicts with (see SystemAccess), which makes the order of the list a dependency graph, and systems whose dependencies
+ * are done run at once: main thread systems on the calling thread, lowest first, and the rest as jobs. Events that
+ * systems enqueue are held back and moved to the bus once every system is done, in the order of the list, so listeners see the
+ * same events in the same order as if the systems had run one after another.
+ */
+class SystemScheduler
+{
+public:
+    /*!
+     * \brief The Stats struct contains timings of the last frame
+     */
+    struct Stats
+    {
+        /* Time from the first system starting to the last one finishing */
+        float frame_ms = 0.f;
+
+        /* Systems that ran on a worker thread */
+        unsigned worker_systems = 0u;
+    };
+
+private:
+    /*!
+     * \brief The Node struct is a system in the dependency graph
+     */
+    struct Node
+    {
+        System* system = nullptr;
+        SystemAccess access = {};
+
+        /* Later systems that wait for this one, and the number of earlier systems this one waits for */
+        std::vector<std::size_t> successors = {};
+        unsigned predecessors = 0u;
+
+        /* Predecessors that have not finished in the current frame */
+        unsigned waiting_for = 0u;
+
+        /* Events the system enqueued in the current frame */
+        DeferredEvents events = {};
+    };
+
+    std::vector<Node> m_nodes = {};
+
+    JobSystem& m_jobs;
+
+    /* When false, systems run one after another on the calling thread */
+    bool m_parallel = true;
+
+    /* The first frame runs every system in order on the calling thread, since views and groups are created in the registry
+     * the first time they are used */
+    bool m_warm_up = true;
+
+    /* Main thread systems that can run, and systems workers have finished (guarded by m_mutex) */
+    std::vector<std::size_t> m_main_ready = {};
+    std::vector<std::size_t> m_finished = {};
+    std::vector<std::size_t> m_finished_swap = {};
+    std::mutex m_mutex = {};
+    std::condition_variable m_finished_changed = {};
+
+    Stats m_stats = {};
+
+public:
+    explicit SystemScheduler(JobSystem& jobs = get_job_system());
+
+    SystemScheduler(const SystemScheduler&) = delete;
+    SystemScheduler(SystemScheduler&&) = delete;
+    SystemScheduler& operator=(const SystemScheduler&) = delete;
+    SystemScheduler& operator=(SystemScheduler&&) = delete;
+    ~SystemScheduler() noexcept = default;
+
+    /*!
+     * \brief set_systems builds the dependency graph of the systems (which must outlive the scheduler, or the next call)
+     */
+    void set_systems(const std::vector<std::unique_ptr<System>>& systems);
+
+    /*!
+     * \brief run updates every system once and waits for them to finish
+     * \param dt is the delta time
+     * \param bus is where the events the systems enqueued go once they are done
+     */
+    void run(float dt, EventBus& bus);
+
+    /*!
+     * \brief set_parallel selects whether systems may run at the same time, or one after another on the calling thread
+     */
+    void set_parallel(bool parallel);
+
+    /*!
+     * \brief get_stats returns the timings of the last frame
+     */
+    const Stats& get_stats() const;
+
+private:
+    /*!
+     * \brief run_node updates a system, holding back the events it enqueues
+     */
+    void run_node(std::size_t index, float dt);
+
+    /*!
+     * \brief dispatch starts a system whose dependencies are done, or queues it for the main thread
+     */
+    void dispatch(std::size_t index, float dt);
+
+    /*!
+     * \brief finish marks a system as done, and dispatches the systems that were only waiting for it
+     */
+    void finish(std::size_t index, float dt);
+};
+
+/*!
+ * \brief systems_conflict returns true if two systems may not run at the same time
+ */
+bool systems_conflict(const SystemAccess& a, const SystemAccess& b);
+}  // namespace pac
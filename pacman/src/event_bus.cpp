@@ -0,0 +1,129 @@
+#include "event_bus.h"
+
+namespace pac
+{
+ScopedConnection::ScopedConnection(const EventConnection& connection) : m_connection(connection) {}
+
+ScopedConnection::ScopedConnection(ScopedConnection&& other) noexcept : m_connection(other.m_connection)
+{
+    other.m_connection = {};
+}
+
+ScopedConnection& ScopedConnection::operator=(ScopedConnection&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_connection = other.m_connection;
+        other.m_connection = {};
+    }
+    return *this;
+}
+
+ScopedConnection::~ScopedConnection() noexcept { release(); }
+
+void ScopedConnection::release()
+{
+    if (m_connection.bus)
+    {
+        m_connection.bus->remove_listener(m_connection.type, m_connection.listener);
+        m_connection = {};
+    }
+}
+
+void EventBus::PoolBase::publish(const void* events, std::size_t count)
+{
+    /* Listeners may connect (which can grow the vector) or disconnect while being called, so index and copy each one */
+    ++delivering;
+    const auto listener_count = listeners.size();
+    for (std::size_t i = 0u; i < listener_count; ++i)
+    {
+        const auto listener = listeners[i];
+        if (listener.thunk)
+        {
+            listener.thunk(listener.instance, events, count);
+        }
+    }
+    --delivering;
+
+    if (delivering == 0u && has_removed_listeners)
+    {
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [](const auto& l) { return !l.thunk; }),
+                        listeners.end());
+        has_removed_listeners = false;
+    }
+}
+
+void EventBus::PoolBase::remove_listener(const detail::EventListener& listener)
+{
+    auto it = std::find(listeners.begin(), listeners.end(), listener);
+    if (it == listeners.end())
+    {
+        return;
+    }
+
+    if (delivering > 0u)
+    {
+        *it = {};
+        has_removed_listeners = true;
+    }
+    else
+    {
+        listeners.erase(it);
+    }
+}
+
+DeferredEvents::Scope::Scope(DeferredEvents& events) : m_previous(detail::t_deferred_events)
+{
+    detail::t_deferred_events = &events;
+}
+
+DeferredEvents::Scope::~Scope() noexcept { detail::t_deferred_events = m_previous; }
+
+void DeferredEvents::flush(EventBus& bus)
+{
+    GFX_ASSERT(detail::t_deferred_events != this, "Deferred events can not be flushed while they are collecting events.");
+    for (const auto& record : m_records)
+    {
+        record.enqueue(bus, m_storage.data() + record.offset);
+    }
+    clear();
+}
+
+void DeferredEvents::clear()
+{
+    m_storage.clear();
+    m_records.clear();
+}
+
+std::size_t DeferredEvents::size() const { return m_records.size(); }
+
+EventBus::EventBus(std::size_t queue_capacity) : m_queue_capacity(queue_capacity) {}
+
+void EventBus::update()
+{
+    /* Index the pools, since a listener may use a new event type and add a pool while we are delivering */
+    for (std::size_t i = 0u; i < m_pools.size(); ++i)
+    {
+        if (m_pools[i])
+        {
+            m_pools[i]->deliver(m_stats);
+        }
+    }
+}
+
+EventBus::Stats EventBus::take_stats()
+{
+    const auto out = m_stats;
+    m_stats = {};
+    return out;
+}
+
+void EventBus::remove_listener(std::size_t type, const detail::EventListener& listener)
+{
+    if (type < m_pools.size() && m_pools[type])
+    {
+        m_pools[type]->remove_listener(listener);
+    }
+}
+}  // namespace pac
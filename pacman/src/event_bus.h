@@ -0,0 +1,487 @@
+/*!
+ * \file event_bus.h contains the game event bus. Events are queued into arrays (one pair per event type) that double in size
+ * when they fill up, and delivered in batches to their listeners when the bus is updated, so there are no allocations once every
+ * event type has seen its busiest update. The connect and disconnect interface follows entt::dispatcher, which it replaces.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <typeinfo>
+#include <type_traits>
+
+#include <gfx.h>
+
+namespace pac
+{
+class EventBus;
+
+namespace detail
+{
+/* Source of event type ids, they are handed out the first time each event type is used (which may be on any thread) */
+inline std::atomic<std::size_t> g_next_event_type_id = 0u;
+
+template<typename Ev>
+std::size_t event_type_id()
+{
+    static const std::size_t id = g_next_event_type_id.fetch_add(1u, std::memory_order_relaxed);
+    return id;
+}
+
+/*!
+ * \brief The EventListener struct is a type-erased listener. The thunk receives a batch of events of the type it was connected
+ * to, and the thunk and instance pair identifies the listener when disconnecting.
+ */
+struct EventListener
+{
+    using Thunk = void (*)(void* instance, const void* events, std::size_t count);
+
+    Thunk thunk = nullptr;
+    void* instance = nullptr;
+
+    bool operator==(const EventListener& other) const { return thunk == other.thunk && instance == other.instance; }
+};
+
+/*!
+ * \brief Calls Candidate once per event, either as a member function of Instance or as a free function taking the instance as
+ * its first argument (like entt, this lets a listener carry a payload)
+ */
+template<auto Candidate, typename Ev, typename Instance>
+void event_thunk(void* instance, const void* events, std::size_t count)
+{
+    auto& target = *static_cast<Instance*>(instance);
+    const auto* typed_events = static_cast<const Ev*>(events);
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+        if constexpr (std::is_member_function_pointer_v<decltype(Candidate)>)
+        {
+            (target.*Candidate)(typed_events[i]);
+        }
+        else
+        {
+            Candidate(target, typed_events[i]);
+        }
+    }
+}
+
+/*!
+ * \brief Calls Candidate once with every event of the batch, as (events, count)
+ */
+template<auto Candidate, typename Ev, typename Instance>
+void event_batch_thunk(void* instance, const void* events, std::size_t count)
+{
+    auto& target = *static_cast<Instance*>(instance);
+    if constexpr (std::is_member_function_pointer_v<decltype(Candidate)>)
+    {
+        (target.*Candidate)(static_cast<const Ev*>(events), count);
+    }
+    else
+    {
+        Candidate(target, static_cast<const Ev*>(events), count);
+    }
+}
+
+template<typename Instance>
+void* erase_instance(Instance& instance)
+{
+    return const_cast<void*>(static_cast<const void*>(std::addressof(instance)));
+}
+
+/*!
+ * \brief Enqueues an event that was held back by a DeferredEvents
+ */
+template<typename Ev>
+void enqueue_deferred(EventBus& bus, const std::byte* data);
+}  // namespace detail
+
+/*!
+ * \brief The DeferredEvents class holds the events enqueued on a thread while one of its Scopes is alive, instead of them
+ * going to the bus. This lets systems running on worker threads enqueue events, and flush moves them to the bus later in the
+ * order they were enqueued. The buffers keep their capacity, so it stops allocating once it has seen its busiest frame.
+ */
+class DeferredEvents
+{
+private:
+    /* How to enqueue a held back event, and where its bytes are */
+    struct Record
+    {
+        void (*enqueue)(EventBus&, const std::byte*) = nullptr;
+        std::size_t offset = 0u;
+    };
+
+    std::vector<std::byte> m_storage = {};
+    std::vector<Record> m_records = {};
+
+public:
+    /*!
+     * \brief The Scope class makes events enqueued on the calling thread go to a DeferredEvents until it is destroyed
+     */
+    class Scope
+    {
+    private:
+        DeferredEvents* m_previous = nullptr;
+
+    public:
+        explicit Scope(DeferredEvents& events);
+
+        Scope(const Scope&) = delete;
+        Scope(Scope&&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        Scope& operator=(Scope&&) = delete;
+        ~Scope() noexcept;
+    };
+
+    /*!
+     * \brief push holds back an event
+     */
+    template<typename Ev>
+    void push(const Ev& event)
+    {
+        const auto offset = m_storage.size();
+        m_storage.resize(offset + sizeof(Ev));
+        std::memcpy(m_storage.data() + offset, &event, sizeof(Ev));
+        m_records.push_back({&detail::enqueue_deferred<Ev>, offset});
+    }
+
+    /*!
+     * \brief flush enqueues the held back events on the bus, and forgets them
+     */
+    void flush(EventBus& bus);
+
+    /*!
+     * \brief clear forgets the held back events without enqueueing them
+     */
+    void clear();
+
+    /*!
+     * \brief size returns the number of held back events
+     */
+    std::size_t size() const;
+};
+
+namespace detail
+{
+/* The DeferredEvents events enqueued on this thread go to, if any */
+inline thread_local DeferredEvents* t_deferred_events = nullptr;
+}  // namespace detail
+
+/*!
+ * \brief The EventConnection struct is a handle to a connected listener. It does nothing on its own, but can be turned into a
+ * ScopedConnection to disconnect the listener automatically.
+ */
+struct EventConnection
+{
+    EventBus* bus = nullptr;
+    std::size_t type = 0u;
+    detail::EventListener listener = {};
+};
+
+/*!
+ * \brief The ScopedConnection class disconnects a listener when it is destroyed
+ */
+class ScopedConnection
+{
+private:
+    EventConnection m_connection = {};
+
+public:
+    ScopedConnection() = default;
+    ScopedConnection(const EventConnection& connection);
+
+    ScopedConnection(const ScopedConnection&) = delete;
+    ScopedConnection(ScopedConnection&& other) noexcept;
+    ScopedConnection& operator=(const ScopedConnection&) = delete;
+    ScopedConnection& operator=(ScopedConnection&& other) noexcept;
+    ~ScopedConnection() noexcept;
+
+    /*!
+     * \brief release disconnects the listener now (does nothing if it is not connected)
+     */
+    void release();
+};
+
+/*!
+ * \brief The EventBus class queues events per type and delivers them to listeners when it is updated. Listeners of a type are
+ * called in the order they connected, and each gets every queued event of that type before the next listener is called. Events
+ * queued while the bus is delivering are delivered on the next update. Events must be trivially copyable (no strings or
+ * containers) so the queues never allocate, and the bus is not thread safe (see DeferredEvents for enqueueing from workers).
+ */
+class EventBus
+{
+public:
+    /*!
+     * \brief The Stats struct contains counters of the bus, reset when read with take_stats
+     */
+    struct Stats
+    {
+        /* Events queued, delivered (counted once per event, not per listener), and times a queue was full and had to grow */
+        uint64_t enqueued = 0u;
+        uint64_t delivered = 0u;
+        uint64_t grown = 0u;
+
+        /* Most events of one type waiting in a single update */
+        std::size_t peak_queued = 0u;
+    };
+
+private:
+    /*!
+     * \brief The PoolBase struct contains everything about an event type that does not depend on the type
+     */
+    struct PoolBase
+    {
+        /* Listeners in connection order, a null thunk marks a listener that was disconnected while delivering */
+        std::vector<detail::EventListener> listeners = {};
+
+        /* Delivery depth, listeners are only removed from the vector when nothing is iterating it */
+        unsigned delivering = 0u;
+        bool has_removed_listeners = false;
+
+        virtual ~PoolBase() = default;
+
+        /*!
+         * \brief deliver swaps the queues and hands the queued events to every listener
+         */
+        virtual void deliver(Stats& stats) = 0;
+
+        /*!
+         * \brief publish hands a batch of events to every listener
+         */
+        void publish(const void* events, std::size_t count);
+
+        /*!
+         * \brief remove_listener removes (or, while delivering, marks) a listener
+         */
+        void remove_listener(const detail::EventListener& listener);
+    };
+
+    /*!
+     * \brief The Pool struct holds two queues for an event type. Events are written to the back queue, and update swaps them so
+     * listeners read a queue nothing is writing to. A full back queue doubles in size, and keeps that size from then on.
+     */
+    template<typename Ev>
+    struct Pool : PoolBase
+    {
+        static_assert(std::is_trivially_copyable_v<Ev>, "Events must be trivially copyable, so they can be queued without allocating");
+
+        std::unique_ptr<Ev[]> queues[2] = {};
+        std::size_t sizes[2] = {0u, 0u};
+        std::size_t capacities[2] = {0u, 0u};
+        unsigned back = 0u;
+
+        explicit Pool(std::size_t queue_capacity)
+            : queues{std::make_unique<Ev[]>(queue_capacity), std::make_unique<Ev[]>(queue_capacity)},
+              capacities{queue_capacity, queue_capacity}
+        {
+        }
+
+        /*!
+         * \brief grow_back doubles the capacity of the back queue, keeping the events in it. The front queue may be in the middle
+         * of being delivered, but it is never the back queue, so this is safe to do from a listener.
+         */
+        void grow_back()
+        {
+            const auto capacity = std::max<std::size_t>(capacities[back] * 2u, 1u);
+            auto grown = std::make_unique<Ev[]>(capacity);
+            std::memcpy(grown.get(), queues[back].get(), sizes[back] * sizeof(Ev));
+            queues[back] = std::move(grown);
+            capacities[back] = capacity;
+        }
+
+        void deliver(Stats& stats) override
+        {
+            const auto front = back;
+            back ^= 1u;
+
+            const auto count = sizes[front];
+            stats.delivered += count;
+            stats.peak_queued = std::max(stats.peak_queued, count);
+            publish(queues[front].get(), count);
+            sizes[front] = 0u;
+        }
+    };
+
+public:
+    /*!
+     * \brief The Sink class connects and disconnects listeners of a single event type
+     */
+    template<typename Ev>
+    class Sink
+    {
+    private:
+        EventBus& m_bus;
+
+    public:
+        explicit Sink(EventBus& bus) : m_bus(bus) {}
+
+        /*!
+         * \brief connect calls Candidate for every event of type Ev. Candidate is either a member function of Instance taking
+         * const Ev&, or a free function taking (Instance&, const Ev&).
+         * \param instance is the object to call Candidate on (or the payload to pass to it)
+         */
+        template<auto Candidate, typename Instance>
+        EventConnection connect(Instance& instance)
+        {
+            return m_bus.add_listener<Ev>({&detail::event_thunk<Candidate, Ev, Instance>, detail::erase_instance(instance)});
+        }
+
+        /*!
+         * \brief connect_batch calls Candidate once per update with all events of type Ev, as (const Ev* events, size_t count).
+         * Candidate is called even when there are no events, since that is cheap and lets listeners reset per-frame state.
+         */
+        template<auto Candidate, typename Instance>
+        EventConnection connect_batch(Instance& instance)
+        {
+            return m_bus.add_listener<Ev>({&detail::event_batch_thunk<Candidate, Ev, Instance>, detail::erase_instance(instance)});
+        }
+
+        /*!
+         * \brief disconnect removes a listener that was connected with connect
+         */
+        template<auto Candidate, typename Instance>
+        void disconnect(Instance& instance)
+        {
+            m_bus.remove_listener(detail::event_type_id<Ev>(),
+                                  {&detail::event_thunk<Candidate, Ev, Instance>, detail::erase_instance(instance)});
+        }
+
+        /*!
+         * \brief disconnect_batch removes a listener that was connected with connect_batch
+         */
+        template<auto Candidate, typename Instance>
+        void disconnect_batch(Instance& instance)
+        {
+            m_bus.remove_listener(detail::event_type_id<Ev>(),
+                                  {&detail::event_batch_thunk<Candidate, Ev, Instance>, detail::erase_instance(instance)});
+        }
+    };
+
+private:
+    /* Pools indexed by event type id, created the first time a type is used */
+    std::vector<std::unique_ptr<PoolBase>> m_pools = {};
+
+    /* Number of events each queue can hold */
+    std::size_t m_queue_capacity = 0u;
+
+    /* Counters since the last call to take_stats */
+    Stats m_stats = {};
+
+public:
+    /*!
+     * \brief EventBus creates an event bus
+     * \param queue_capacity is the number of events of each type that can be queued between updates before a queue grows
+     */
+    explicit EventBus(std::size_t queue_capacity = EVENT_QUEUE_CAPACITY);
+
+    EventBus(const EventBus&) = delete;
+    EventBus(EventBus&&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+    EventBus& operator=(EventBus&&) = delete;
+    ~EventBus() noexcept = default;
+
+    /*!
+     * \brief sink returns the sink used to connect listeners to events of type Ev
+     */
+    template<typename Ev>
+    Sink<Ev> sink()
+    {
+        return Sink<Ev>(*this);
+    }
+
+    /*!
+     * \brief enqueue queues an event to be delivered on the next update. Events are never dropped, if the queue is full it grows
+     * (which allocates, so raise EVENT_QUEUE_CAPACITY if it keeps happening).
+     */
+    template<typename Ev>
+    void enqueue(const Ev& event)
+    {
+        /* Events enqueued under a DeferredEvents::Scope are held back (they may come from a worker thread) */
+        if (auto* deferred = detail::t_deferred_events; deferred)
+        {
+            deferred->push(event);
+            return;
+        }
+
+        auto& pool = get_pool<Ev>();
+        auto& size = pool.sizes[pool.back];
+        if (size == pool.capacities[pool.back])
+        {
+            pool.grow_back();
+            ++m_stats.grown;
+            GFX_DEBUG("The %s queue is full, it can hold %zu events now.", typeid(Ev).name(), pool.capacities[pool.back]);
+        }
+
+        pool.queues[pool.back][size++] = event;
+        ++m_stats.enqueued;
+    }
+
+    /*!
+     * \brief trigger delivers an event to the listeners of its type immediately
+     * \param args are used to construct the event
+     */
+    template<typename Ev, typename... Args>
+    void trigger(Args&&... args)
+    {
+        const Ev event{std::forward<Args>(args)...};
+        get_pool<Ev>().publish(&event, 1u);
+    }
+
+    /*!
+     * \brief update delivers every queued event, one event type at a time
+     */
+    void update();
+
+    /*!
+     * \brief take_stats returns the counters since the previous call, and resets them
+     */
+    Stats take_stats();
+
+private:
+    friend class ScopedConnection;
+
+    template<typename Ev>
+    Pool<Ev>& get_pool()
+    {
+        const auto id = detail::event_type_id<Ev>();
+        if (id >= m_pools.size())
+        {
+            m_pools.resize(id + 1u);
+        }
+
+        if (!m_pools[id])
+        {
+            m_pools[id] = std::make_unique<Pool<Ev>>(m_queue_capacity);
+        }
+
+        return static_cast<Pool<Ev>&>(*m_pools[id]);
+    }
+
+    template<typename Ev>
+    EventConnection add_listener(const detail::EventListener& listener)
+    {
+        get_pool<Ev>().listeners.push_back(listener);
+        return {this, detail::event_type_id<Ev>(), listener};
+    }
+
+    void remove_listener(std::size_t type, const detail::EventListener& listener);
+};
+
+namespace detail
+{
+template<typename Ev>
+void enqueue_deferred(EventBus& bus, const std::byte* data)
+{
+    Ev event;
+    std::memcpy(&event, data, sizeof(Ev));
+    bus.enqueue(event);
+}
+}  // namespace detail
+}  // namespace pac
@@ -0,0 +1,68 @@
+#include "frame_arena.h"
+#include "config.h"
+
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+FrameArena::FrameArena(std::size_t capacity, std::pmr::memory_resource* upstream)
+    : m_buffer(std::make_unique<std::byte[]>(capacity)), m_capacity(capacity), m_upstream(upstream)
+{
+}
+
+void FrameArena::reset()
+{
+    m_high_water_mark = std::max(m_high_water_mark, m_frame.used + m_frame.overflow_bytes);
+    m_last_frame = m_frame;
+    m_frame = {};
+    m_offset = 0u;
+}
+
+const FrameArena::Stats& FrameArena::get_last_frame() const { return m_last_frame; }
+
+std::size_t FrameArena::get_high_water_mark() const { return m_high_water_mark; }
+
+std::size_t FrameArena::get_capacity() const { return m_capacity; }
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    /* Align the offset of the buffer start (which is aligned for any fundamental type) */
+    const auto begin = (m_offset + alignment - 1u) & ~(alignment - 1u);
+    if (begin + bytes <= m_capacity)
+    {
+        m_offset = begin + bytes;
+        m_frame.used = std::max(m_frame.used, m_offset);
+        return m_buffer.get() + begin;
+    }
+
+    ++m_frame.overflow_allocations;
+    m_frame.overflow_bytes += bytes;
+    return m_upstream->allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+{
+    auto* p = static_cast<std::byte*>(ptr);
+    if (p < m_buffer.get() || p >= m_buffer.get() + m_capacity)
+    {
+        m_upstream->deallocate(ptr, bytes, alignment);
+        return;
+    }
+
+    /* Roll back the most recent allocation, everything else is freed on reset */
+    if (p + bytes == m_buffer.get() + m_offset)
+    {
+        m_offset = static_cast<std::size_t>(p - m_buffer.get());
+    }
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept { return this == &other; }
+
+FrameArena& get_frame_arena()
+{
+    thread_local FrameArena arena{FRAME_ARENA_CAPACITY};
+    return arena;
+}
+}  // namespace pac
@@ -0,0 +1,104 @@
+/*!
+ * \file frame_arena.h contains a linear (bump) allocator for data that only lives for a single frame, exposed as a std::pmr
+ * memory resource so standard containers can opt into it.
+ */
+
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <memory_resource>
+
+namespace pac
+{
+/*!
+ * \brief The FrameArena class hands out memory by bumping an offset into a fixed buffer, and frees everything at once when it is
+ * reset at the end of the frame. Deallocation is a no-op (except for the most recent allocation, which is rolled back so growing
+ * containers reuse their space). When the buffer is full, allocations fall back to the upstream resource and are counted as
+ * overflow, so FRAME_ARENA_CAPACITY can be tuned from the reported high-water mark.
+ * \note Anything allocated from the arena must be destroyed before the arena is reset. Each thread has its own arena, and only
+ * the main thread arena is reset by the game loop.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    /*!
+     * \brief The Stats struct contains the usage of the arena in a frame
+     */
+    struct Stats
+    {
+        /* Bytes used from the buffer */
+        std::size_t used = 0u;
+
+        /* Allocations and bytes that did not fit in the buffer */
+        std::size_t overflow_allocations = 0u;
+        std::size_t overflow_bytes = 0u;
+    };
+
+private:
+    /* The buffer allocations are made from */
+    std::unique_ptr<std::byte[]> m_buffer = nullptr;
+
+    /* Size of the buffer */
+    std::size_t m_capacity = 0u;
+
+    /* Start of the free part of the buffer */
+    std::size_t m_offset = 0u;
+
+    /* Resource used when the buffer is full */
+    std::pmr::memory_resource* m_upstream = nullptr;
+
+    /* Usage of the current and the previous frame */
+    Stats m_frame = {};
+    Stats m_last_frame = {};
+
+    /* Most bytes used (including overflow) in any frame so far */
+    std::size_t m_high_water_mark = 0u;
+
+public:
+    /*!
+     * \brief FrameArena creates an arena
+     * \param capacity is the size of the buffer in bytes
+     * \param upstream is the resource used when the buffer is full
+     */
+    explicit FrameArena(std::size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena(FrameArena&&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    FrameArena& operator=(FrameArena&&) = delete;
+    ~FrameArena() noexcept override = default;
+
+    /*!
+     * \brief reset frees everything allocated from the buffer, and moves the usage of this frame into the previous frame stats
+     */
+    void reset();
+
+    /*!
+     * \brief get_last_frame returns the usage of the previous frame
+     */
+    const Stats& get_last_frame() const;
+
+    /*!
+     * \brief get_high_water_mark returns the most bytes used in any frame so far (including overflow)
+     */
+    std::size_t get_high_water_mark() const;
+
+    /*!
+     * \brief get_capacity returns the size of the buffer in bytes
+     */
+    std::size_t get_capacity() const;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+/*!
+ * \brief get_frame_arena returns the frame arena of the calling thread
+ */
+FrameArena& get_frame_arena();
+}  // namespace pac
@@ -3,58 +3,119 @@
 #include "input/input.h"
 #include "states/game_state.h"
 #include "states/main_menu_state.h"
+#include "states/respawn_state.h"
+#include "states/render_stress_state.h"
 #include "rendering/shader_program.h"
 #include "rendering/renderer.h"
 #include "audio/sound_manager.h"
+#include "profiler.h"
+#include "lua_profiler.h"
+#include "alloc_tracker.h"
+#include "frame_arena.h"
+#include "event_bus.h"
+#include "job_system.h"
+#include "replay.h"
+#include "config.h"
 
 #include <chrono>
+#include <utility>
 
 #include <gfx.h>
 #include <cglutil.h>
+#include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
-#include <entt/signal/dispatcher.hpp>
 
 namespace pac
 {
 /* The game event queue */
-entt::dispatcher g_event_queue{};
-
-Game::Game(std::string_view title, glm::uvec2 window_size)
-    : m_lua_events{{"Input", &lua_binder<EvInput>},
-                   {"MouseMove", &lua_binder<EvMouseMove>},
-                   {"EntityMoved", &lua_binder<EvEntityMoved>},
-                   {"PacInvulnerableChange", &lua_binder<EvPacInvulnreableChange>},
-                   {"Pickup", &lua_binder<EvPacPickup>},
-                   {"GhostStateChanged", &lua_binder<EvGhostStateChanged>},
-                   {"PacLifeChanged", &lua_binder<EvPacLifeChanged>},
-                   {"LevelFinished", &lua_binder<EvLevelFinished>}}
+EventBus g_event_queue{};
+
+Game::Game(std::string_view title, glm::uvec2 window_size, const LaunchOptions& options)
+    : m_lua_events{{"Input", lua_event_binder<EvInput>()},
+                   {"MouseMove", lua_event_binder<EvMouseMove>()},
+                   {"EntityMoved", lua_event_binder<EvEntityMoved>()},
+                   {"PacInvulnerableChange", lua_event_binder<EvPacInvulnreableChange>()},
+                   {"Pickup", lua_event_binder<EvPacPickup>()},
+                   {"GhostStateChanged", lua_event_binder<EvGhostStateChanged>()},
+                   {"PacLifeChanged", lua_event_binder<EvPacLifeChanged>()},
+                   {"LevelFinished", lua_event_binder<EvLevelFinished>()}},
+      m_options(options)
 {
+    /* Must happen before anything starts a job */
+    set_job_thread_count(m_options.workers);
+
+    /* Headless runs have no window, so draw with the CPU instead (must happen before the renderer is created). They run as fast
+     * as they can, so audio is mixed as simulated time passes to keep a capture in step with the game */
+    if (m_options.headless)
+    {
+        set_render_backend(ERenderBackend::Software);
+        set_audio_backend(EAudioBackend::Software, m_options.audio_capture_path, true);
+    }
+
+    /* Capturing audio needs the software mixer */
+    if (!m_options.headless && !m_options.audio_capture_path.empty())
+    {
+        set_audio_backend(EAudioBackend::Software, m_options.audio_capture_path);
+    }
+
     /* Please never use more than 100 functions in LUA while this is a thing (limitation of using a vector here) */
     m_registered_event_functions.reserve(100);
 
-    /* Perform initialization in correct order */
-    init_glfw_window(title.data(), window_size);
+    /* Perform initialization in correct order, headless runs need neither a window nor an OpenGL context */
+    if (!m_options.headless)
+    {
+        init_glfw_window(title.data(), window_size);
+    }
     init_imgui();
     reflect_all();
     set_up_lua();
+
+    g_event_queue.sink<EvInput>().connect<&Game::recieve_input>(*this);
 }
 
 Game::~Game() noexcept
 {
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    g_event_queue.sink<EvInput>().disconnect<&Game::recieve_input>(*this);
+
+#ifdef PAC_ENABLE_PROFILER
+    get_lua_profiler().attach(nullptr);
+#endif
+
+    if (m_window)
+    {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+    }
     ImGui::DestroyContext();
 
-    glfwDestroyWindow(m_window);
+    if (m_window)
+    {
+        glfwDestroyWindow(m_window);
+    }
 }
 
-void Game::run()
+bool Game::run()
 {
-    /* Add initial state to the stack */
-    m_state_manager.push<MainMenuState>({&m_state_manager, &m_lua, &m_registry});
+    /* Add initial state to the stack, or go straight to the level of the replay being played back */
+    const GameContext context = {&m_state_manager, &m_lua, &m_registry};
+    if (!m_options.replay_path.empty() && get_replay().load(m_options.replay_path))
+    {
+        m_state_manager.push<MainMenuState>(context);
+        m_state_manager.push<GameState>(context, get_replay().get_level_name());
+        m_state_manager.push<RespawnState>(context);
+    }
+    else
+    {
+        m_flags.running = !m_options.headless;
+        m_state_manager.push<MainMenuState>(context);
+        if (!m_options.record_path.empty())
+        {
+            get_replay().request_recording(m_options.record_path);
+        }
+    }
 
     /* Create variables for tracking frame-times */
     std::chrono::steady_clock delta_clock = {};
@@ -62,27 +123,147 @@ void Game::run()
 
     do
     {
-        /* Set ImGui up for a new frame */
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        PAC_PROFILE_FRAME();
+#ifdef PAC_ENABLE_PROFILER
+        get_lua_profiler().new_frame();
+#endif
+        PAC_ALLOC_FRAME();
+        PAC_PROFILE_SCOPE("Frame");
 
         /* Compute delta time in floating point seconds */
         const float dt = std::chrono::duration<float>(delta_clock.now() - last_frame).count();
         last_frame = delta_clock.now();
 
+        /* Set ImGui up for a new frame, without a window nothing but the time step has to be fed to it */
+        if (m_window)
+        {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+        }
+        else
+        {
+            ImGui::GetIO().DeltaTime = dt;
+        }
+        ImGui::NewFrame();
+
         /* Let ImGui show the FPS in Debug mode only */
 #ifndef NDEBUG
         ImGui::Text("FPS: %5.1f", ImGui::GetIO().Framerate);
         ImGui::SameLine(0.f, 25.f);
         ImGui::Text("Frame Time: %6.4fms", dt * 1000.f);
+
+        const auto& render_stats = get_renderer().get_frame_stats();
+        ImGui::Text("Submit: %6.4fms  Upload: %6.2fKiB  Sprites: %u (+%u static)", render_stats.submit_ms,
+                    render_stats.bytes_uploaded / 1024.f, render_stats.dynamic_instances, render_stats.static_instances);
+        ImGui::Text("Fence Wait: %6.4fms  Stalled Frames: %lu", render_stats.fence_wait_ms,
+                    get_renderer().get_total_fence_stalls());
+        ImGui::Text("Batches: %u  Segment Capacity: %u  Sort: %6.4fms", render_stats.batches, render_stats.segment_capacity,
+                    render_stats.sort_ms);
+        ImGui::Text("%s Backend: %6.4fms",
+                    get_renderer().get_backend_type() == ERenderBackend::Software ? "Software" : "OpenGL",
+                    render_stats.backend_ms);
+        const auto& arena = get_frame_arena();
+        ImGui::Text("Frame Arena: %6.2f/%.0fKiB  High-water: %6.2fKiB  Overflow: %zu", arena.get_last_frame().used / 1024.f,
+                    arena.get_capacity() / 1024.f, arena.get_high_water_mark() / 1024.f,
+                    arena.get_last_frame().overflow_allocations);
+        ImGui::Text("Events: %llu queued  Peak: %zu  Grown: %llu", static_cast<unsigned long long>(m_event_stats.enqueued),
+                    m_event_stats.peak_queued, static_cast<unsigned long long>(m_event_stats.grown));
+        ImGui::SameLine();
+        ImGui::Text("Lua: %llu calls  %6.4fms", static_cast<unsigned long long>(m_lua_stats.calls), m_lua_stats.ms);
+        const auto job_stats = get_job_system().take_stats();
+        uint64_t jobs_executed = job_stats.helped, jobs_stolen = 0u;
+        for (std::size_t i = 0u; i < job_stats.executed.size(); ++i)
+        {
+            jobs_executed += job_stats.executed[i];
+            jobs_stolen += job_stats.stolen[i];
+        }
+        ImGui::SameLine();
+        ImGui::Text("Jobs: %llu run  %llu stolen  %llu helped  Workers: %u", static_cast<unsigned long long>(jobs_executed),
+                    static_cast<unsigned long long>(jobs_stolen), static_cast<unsigned long long>(job_stats.helped),
+                    get_job_system().get_thread_count());
+        const auto& voice_stats = get_sound().get_voice_stats();
+        ImGui::Text("Voices: %u/%u  Peak: %u  Retriggers: %llu  Steals: %llu  Dropped: %llu", voice_stats.active, AUDIO_SOURCES,
+                    voice_stats.peak_active, static_cast<unsigned long long>(voice_stats.retriggers),
+                    static_cast<unsigned long long>(voice_stats.steals), static_cast<unsigned long long>(voice_stats.dropped));
+        if (get_sound().get_backend_type() == EAudioBackend::Software)
+        {
+            const auto mix_stats = get_sound().get_mix_stats();
+            ImGui::SameLine();
+            ImGui::Text("Mixer: %6.4fms per %ums block  Peak: %6.4fms  Voices: %u (%u resampled)", mix_stats.block_ms,
+                        AUDIO_MIX_BLOCK_MS, mix_stats.peak_block_ms, mix_stats.voices, mix_stats.resampled_voices);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Render Stress Test"))
+        {
+            m_state_manager.push<RenderStressState>(GameContext{&m_state_manager, &m_lua, &m_registry}, 100'000u, 120u);
+        }
+        ImGui::SliderInt("Stress Sprites", &m_stress_sprites, 0, 1000000);
+        ImGui::SameLine();
+        m_capture_requested |= ImGui::Button("Capture Frame");
+        get_replay().draw_overlay();
+#ifdef PAC_ENABLE_ALLOC_TRACKER
+        get_alloc_tracker().draw_overlay();
+#endif
+#endif
+
+#ifdef PAC_ENABLE_PROFILER
+        get_profiler().draw_overlay();
+        get_lua_profiler().draw_overlay();
 #endif
 
-        glfwPollEvents();
-        g_event_queue.update();
-        update(dt);
+        /* While a replay is playing back, the game is simulated with the recorded delta time */
+        const float sim_dt = get_replay().begin_tick(dt);
+
+        if (m_window)
+        {
+            glfwPollEvents();
+        }
+        {
+            PAC_PROFILE_SCOPE("Event Queue");
+            g_event_queue.update();
+            remove_released_lua_batches(m_lua_event_batches);
+        }
+        update(sim_dt);
         draw();
-    } while (m_flags.running && !glfwWindowShouldClose(m_window) && !m_state_manager.empty());
+        get_sound().update(sim_dt);
+
+        if (get_replay().end_tick(m_registry) && m_options.headless)
+        {
+            m_flags.running = false;
+        }
+
+        /* Everything transient from this frame is gone now, so the arena can be reused */
+        get_frame_arena().reset();
+        m_event_stats = g_event_queue.take_stats();
+        m_lua_stats = std::exchange(get_lua_call_stats(), {});
+    } while (m_flags.running && !(m_window && glfwWindowShouldClose(m_window)) && !m_state_manager.empty());
+
+    /* Write the recording (or report the playback) if the game was closed in the middle of a level */
+    get_replay().finish(m_registry);
+
+    /* The last frame of a headless replay is always the same, so it can be checked against a known good one */
+    bool passed = true;
+    if (!m_options.golden_path.empty())
+    {
+        passed = get_renderer().compare_frame(m_options.golden_path);
+    }
+
+    get_renderer().log_summary();
+
+    GFX_INFO("Frame arena high-water mark: %.2fKiB of %.0fKiB.", get_frame_arena().get_high_water_mark() / 1024.f,
+             get_frame_arena().get_capacity() / 1024.f);
+
+#ifdef PAC_ENABLE_ALLOC_TRACKER
+    get_alloc_tracker().log_summary();
+#endif
+
+#ifdef PAC_ENABLE_PROFILER
+    if (get_lua_profiler().get_mode() != LuaProfiler::EMode::Off)
+    {
+        get_lua_profiler().dump("lua_profile.txt");
+    }
+#endif
+    return passed;
 }
 
 void Game::init_glfw_window(const char* title, glm::uvec2 window_size)
@@ -149,6 +330,17 @@ void Game::init_imgui()
     const auto abs_path = cgl::native_absolute_path("res/ATI_9x16.ttf");
     io.Fonts->AddFontFromFileTTF(abs_path.c_str(), 16.f);
 
+    /* Without a window there is no input or OpenGL to hook up, ImGui still builds its windows but they are never drawn */
+    if (!m_window)
+    {
+        unsigned char* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+        io.DisplaySize = {static_cast<float>(SCREEN_W), static_cast<float>(SCREEN_H)};
+        return;
+    }
+
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 
     ImGui_ImplGlfw_InitForOpenGL(m_window, true);
@@ -157,30 +349,77 @@ void Game::init_imgui()
 
 void Game::update(float dt)
 {
+    PAC_PROFILE_SCOPE("Game::update");
     get_input().update(dt, m_window);
     m_state_manager.update(dt);
 }
 
 void Game::draw()
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    PAC_PROFILE_SCOPE("Game::draw");
+    if (m_window)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
 
     m_state_manager.draw();
+
+    /* Cover the screen in small extra sprites when stress testing the renderer. They are spread over every layer and many
+     * depths so all passes of the sort are exercised */
+    for (int i = 0; i < m_stress_sprites; ++i)
+    {
+        const auto x = static_cast<float>((i * 4) % SCREEN_W);
+        const auto y = static_cast<float>(((i * 4) / SCREEN_W * 4) % SCREEN_H);
+        get_renderer().draw({{x, y}, {4.f, 4.f}, {1.f, 1.f, 0.f}, {}}, static_cast<ELayer>(i % 5),
+                            static_cast<uint16_t>((i * 7919) & 0xFFFF));
+    }
+
     get_renderer().submit_work();
 
-    glfwSwapBuffers(m_window);
+    if (m_capture_requested)
+    {
+        get_renderer().capture_frame("capture.png");
+        m_capture_requested = false;
+    }
+
+    /* Frames of the software backend only exist in memory until they are presented */
+    if (m_window)
+    {
+        get_renderer().present();
+
+        PAC_PROFILE_SCOPE("Swap Buffers");
+        glfwSwapBuffers(m_window);
+    }
 }
 
+void Game::recieve_input([[maybe_unused]] const EvInput& input)
+{
+#ifdef PAC_ENABLE_PROFILER
+    if (input.action == ACTION_TOGGLE_DEBUG)
+    {
+        get_profiler().toggle_overlay();
+        get_lua_profiler().toggle_overlay();
+    }
+#endif
+}
+
+sol::state& Game::get_lua() { return m_lua; }
+
 void Game::set_up_lua()
 {
     m_lua.open_libraries(sol::lib::base, sol::lib::package);
 
+#ifdef PAC_ENABLE_PROFILER
+    /* Hook the state before any script runs, so the lua profiler sees every function */
+    get_lua_profiler().attach(m_lua.lua_state());
+#endif
+
     /* Register Data Types in LUA */
     m_lua.new_usertype<glm::ivec2>("ivec2", sol::constructors<glm::ivec2(), glm::ivec2(int, int)>(), "x", &glm::ivec2::x, "y",
                                    &glm::ivec2::y);
 
-    m_lua.new_usertype<EvPacPickup>("EvPacPickup", "pickup_name", &EvPacPickup::pickup_name, "score_delta",
-                                    &EvPacPickup::score_delta);
+    m_lua.new_usertype<EvPacPickup>("EvPacPickup", "pickup_name", sol::readonly_property(&EvPacPickup::get_pickup_name),
+                                    "score_delta", &EvPacPickup::score_delta);
 
     m_lua.new_usertype<EvGhostStateChanged>("EvGhostStateChanged", "new_state", &EvGhostStateChanged::new_state, "ghost",
                                             &EvGhostStateChanged::ghost);
@@ -209,12 +448,27 @@ void Game::set_up_lua()
     /* Function to allow lua to connect to events */
     m_lua.set_function("connect", [this](const std::string& event_name, sol::function func) {
         m_registered_event_functions.push_back(func);
-        return m_lua_events.at(event_name)(g_event_queue, m_registered_event_functions.back());
+        return m_lua_events.at(event_name).connect(g_event_queue, m_registered_event_functions.back());
+    });
+
+    /* Same as connect, but the function is called once per frame with all events of the type, as (events, count) */
+    m_lua.set_function("connect_batched", [this](const std::string& event_name, sol::function func) {
+        return m_lua_events.at(event_name).connect_batched(g_event_queue, m_lua_event_batches, func);
     });
 
     /* Play audio from lua */
     m_lua.set_function("play_sound", [](const std::string& sound) { get_sound().play(sound); });
 
+    /* Set the priority of a sound, and how many voices it can play on at once (0 for no limit) */
+    m_lua.set_function("configure_sound", [](const std::string& sound, uint8_t priority, uint8_t max_voices) {
+        get_sound().configure(sound, priority, max_voices);
+    });
+
+    /* Pick which voice is stolen when every source is busy */
+    m_lua.new_enum<EVoiceStealPolicy>("VoiceStealPolicy", {{"OLDEST", EVoiceStealPolicy::Oldest},
+                                                           {"LOWEST_PRIORITY", EVoiceStealPolicy::LowestPriority}});
+    m_lua.set_function("set_voice_steal_policy", [](EVoiceStealPolicy policy) { get_sound().set_steal_policy(policy); });
+
     /* Create action functions (each of these requires a certain component to work. It is the callers responsibility that the
      * given entity has this component. This makes for a flexible way to tell something what you want to do */
     m_lua.set_function("move", [this](entt::entity e, int x, int y) { m_registry.get<CMovement>(e).desired_direction = {x, y}; });
@@ -5,7 +5,10 @@
 
 #include "states/state_manager.h"
 #include "reflect.h"
+#include "common.h"
+#include "event_bus.h"
 
+#include <string>
 #include <vector>
 #include <memory>
 #include <string_view>
@@ -17,6 +20,32 @@
 
 namespace pac
 {
+struct EvInput;
+
+/*!
+ * \brief The LaunchOptions struct contains the options given on the command line
+ */
+struct LaunchOptions
+{
+    /* Record the first level that is played to this replay file (empty to not record) */
+    std::string record_path{};
+
+    /* Play this replay file back instead of showing the main menu (empty to start normally) */
+    std::string replay_path{};
+
+    /* Write the audio mixed by the software audio backend to this WAV file (empty to not write it) */
+    std::string audio_capture_path{};
+
+    /* Draw and mix audio with the software backends without opening a window, the game quits when the replay has been played */
+    bool headless = false;
+
+    /* Compare the last frame of a headless replay with this PNG file, it is written instead if it does not exist yet */
+    std::string golden_path{};
+
+    /* Job system worker threads (0 means one per core besides the main thread) */
+    unsigned workers = WORKER_THREADS;
+};
+
 /*!
  * \brief The Game class is the highest level wrapper around the game state. It keeps track of the active
  * state, and delegates work to the various systems that need to work together.
@@ -33,23 +62,41 @@ private:
     /* Entity Registry */
     entt::registry m_registry{};
 
-    /* The Game Window */
+    /* The Game Window (there is none in headless runs) */
     struct GLFWwindow* m_window = nullptr;
 
     /* Event Binder to allow lua to bind events */
-    robin_hood::unordered_map<std::string, entt::scoped_connection (*)(entt::dispatcher&, sol::function&)> m_lua_events{};
+    robin_hood::unordered_map<std::string, LuaEventBinder> m_lua_events{};
 
     /* To keep objects alive (hacky solution until I find a better way to hook up lua with entt events) */
     std::vector<sol::function> m_registered_event_functions{};
 
+    /* Batches of functions connected with connect_batched, kept alive here until lua releases their connection */
+    std::vector<std::shared_ptr<LuaEventBatchBase>> m_lua_event_batches{};
+
     /* This struct will contain flags that can be flipped on / off to toggle features */
     struct Flags
     {
         uint8_t running = true;
     } m_flags = {true};
 
+    /* Number of extra sprites drawn every frame to stress test the renderer (set from the debug overlay) */
+    int m_stress_sprites = 0;
+
+    /* Set from the debug overlay to write the next frame to a PNG file */
+    bool m_capture_requested = false;
+
+    /* Event bus counters of the previous frame */
+    EventBus::Stats m_event_stats = {};
+
+    /* Calls into lua during the previous frame */
+    LuaCallStats m_lua_stats = {};
+
+    /* Options from the command line */
+    LaunchOptions m_options = {};
+
 public:
-    Game(std::string_view title, glm::uvec2 window_size);
+    Game(std::string_view title, glm::uvec2 window_size, const LaunchOptions& options = {});
 
     Game(const Game&) = delete;
 
@@ -60,7 +107,16 @@ public:
 
     ~Game() noexcept;
 
-    void run();
+    /*!
+     * \brief run runs the game loop until the game is closed, or the replay of a headless run has been played
+     * \return false if the last frame of a headless run did not match its golden image
+     */
+    bool run();
+
+    /*!
+     * \brief get_lua returns the lua state, with the game's bindings set up and the sound script run
+     */
+    sol::state& get_lua();
 
 private:
     /*!
@@ -71,7 +127,7 @@ private:
     void init_glfw_window(const char* title, glm::uvec2 window_size);
 
     /*!
-     * \brief init_imgui initializes ImGui
+     * \brief init_imgui initializes ImGui, with the GLFW and OpenGL backends if there is a window
      */
     void init_imgui();
 
@@ -86,6 +142,12 @@ private:
      */
     void draw();
 
+    /*!
+     * \brief recieve_input handles input that is global to the game, like toggling the profiler overlay
+     * \param input is the input event
+     */
+    void recieve_input(const EvInput& input);
+
 private:
     /*!
      * \brief set_up_lua adds lua bindings and functions to the lua state
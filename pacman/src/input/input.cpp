@@ -1,5 +1,6 @@
 #include "input.h"
 #include "entity/events.h"
+#include "event_bus.h"
 
 #include <gfx.h>
 #include <glm/vec2.hpp>
@@ -8,7 +9,7 @@
 
 namespace pac
 {
-extern entt::dispatcher g_event_queue;
+extern EventBus g_event_queue;
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
@@ -73,6 +74,11 @@ void InputManager::pop() { m_waiting_commands.emplace_back(ECommandType::Pop); }
 
 void InputManager::invoke(int key)
 {
+    if (!m_enabled)
+    {
+        return;
+    }
+
     for (auto it = m_active_domains.rbegin(); it != m_active_domains.rend(); ++it)
     {
         it->try_invoke(key);
@@ -99,7 +105,12 @@ void InputManager::update(float dt, GLFWwindow* win)
 
     m_waiting_commands.clear();
 
-    /* Invoke keys */
+    /* Invoke keys (headless runs have no window to read them from) */
+    if (!m_enabled || !win)
+    {
+        return;
+    }
+
     for (auto it = m_active_domains.rbegin(); it != m_active_domains.rend(); ++it)
     {
         it->invoke_live_keys(dt, win);
@@ -110,12 +121,20 @@ void InputManager::update(float dt, GLFWwindow* win)
     }
 }
 
-void InputManager::invoke_axis(float x, float y) { g_event_queue.enqueue(EvMouseMove{{x, y}, m_mouse_pos}); }
+void InputManager::invoke_axis(float x, float y)
+{
+    if (m_enabled)
+    {
+        g_event_queue.enqueue(EvMouseMove{{x, y}, m_mouse_pos});
+    }
+}
 
 void InputManager::set_cursor_pos(const glm::dvec2& new_pos) { m_mouse_pos = new_pos; }
 
 const glm::dvec2& InputManager::get_cursor_position() const { return m_mouse_pos; }
 
+void InputManager::set_enabled(bool enabled) { m_enabled = enabled; }
+
 InputManager& get_input()
 {
     static InputManager im{};
@@ -9,7 +9,6 @@
 #include <vector>
 #include <functional>
 
-#include <entt/signal/dispatcher.hpp>
 #include <robinhood/robinhood.h>
 #include <glm/vec2.hpp>
 
@@ -160,6 +159,9 @@ private:
     /* Last recorded mouse position */
     glm::dvec2 m_mouse_pos = {};
 
+    /* When disabled, keys, buttons and mouse movement are ignored (while a replay is playing back for example) */
+    bool m_enabled = true;
+
 public:
     /*!
      * \brief push an input state to the stack
@@ -203,6 +205,12 @@ public:
      */
     const glm::dvec2& get_cursor_position() const;
 
+    /*!
+     * \brief set_enabled enables or disables input from the keyboard and mouse, the input domains are still updated
+     * \param enabled is true to enable input
+     */
+    void set_enabled(bool enabled);
+
 private:
     /* Private CTOR since we only want one InputManager */
     InputManager() = default;
@@ -0,0 +1,317 @@
+#include "job_system.h"
+#include "frame_arena.h"
+#include "config.h"
+
+#include <chrono>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+/* How long a thread waiting for a counter sleeps before it looks for jobs to run again */
+constexpr auto WAIT_POLL_INTERVAL = std::chrono::microseconds(100);
+
+/*!
+ * \brief The WorkerIdentity struct tells a thread which worker it is, and of which job system
+ */
+struct WorkerIdentity
+{
+    const JobSystem* system = nullptr;
+    int index = -1;
+};
+
+thread_local WorkerIdentity t_worker = {};
+
+unsigned g_job_thread_count = WORKER_THREADS;
+}  // namespace
+
+bool JobCounter::is_done() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_pending == 0u;
+}
+
+JobSystem::JobSystem(unsigned thread_count)
+{
+    if (thread_count == 0u)
+    {
+        thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+    }
+
+    /* Every deque exists before any worker starts, since workers steal from each other */
+    m_workers.reserve(thread_count);
+    for (auto i = 0u; i < thread_count; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    for (auto i = 0u; i < thread_count; ++i)
+    {
+        m_workers[i]->thread = std::thread(&JobSystem::worker_main, this, static_cast<int>(i));
+    }
+    GFX_INFO("Started %u job system workers.", thread_count);
+}
+
+JobSystem::~JobSystem() noexcept
+{
+    {
+        std::lock_guard lock(m_sleep_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker->thread.join();
+    }
+}
+
+void JobSystem::run(const char* name, std::function<void()> fn, JobCounter* counter, EJobPriority priority)
+{
+    if (counter)
+    {
+        std::lock_guard lock(counter->m_mutex);
+        ++counter->m_pending;
+    }
+
+    push({name, std::move(fn), counter}, priority);
+}
+
+void JobSystem::run_after(JobCounter& dependency, const char* name, std::function<void()> fn, JobCounter* counter)
+{
+    if (counter)
+    {
+        std::lock_guard lock(counter->m_mutex);
+        ++counter->m_pending;
+    }
+
+    {
+        std::lock_guard lock(dependency.m_mutex);
+        if (dependency.m_pending > 0u)
+        {
+            dependency.m_continuations.push_back({name, std::move(fn), counter});
+            return;
+        }
+    }
+
+    push({name, std::move(fn), counter}, EJobPriority::Normal);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    while (!counter.is_done())
+    {
+        if (run_one())
+        {
+            continue;
+        }
+
+        /* Nothing to run, so sleep until the counter is done (or for a moment, in case other jobs are started) */
+        std::unique_lock lock(counter.m_mutex);
+        counter.m_done.wait_for(lock, WAIT_POLL_INTERVAL, [&counter] { return counter.m_pending == 0u; });
+    }
+}
+
+bool JobSystem::run_one()
+{
+    Job job{};
+    if (!take(worker_index(), false, job))
+    {
+        return false;
+    }
+
+    execute(job);
+    return true;
+}
+
+unsigned JobSystem::get_thread_count() const { return static_cast<unsigned>(m_workers.size()); }
+
+JobSystem::Stats JobSystem::take_stats()
+{
+    Stats stats{};
+    for (auto& worker : m_workers)
+    {
+        stats.executed.push_back(worker->executed.exchange(0u));
+        stats.stolen.push_back(worker->stolen.exchange(0u));
+    }
+    stats.helped = m_helped.exchange(0u);
+    return stats;
+}
+
+int JobSystem::worker_index() const { return t_worker.system == this ? t_worker.index : -1; }
+
+void JobSystem::push(Job job, EJobPriority priority)
+{
+    const auto index = worker_index();
+    if (priority == EJobPriority::Background)
+    {
+        std::lock_guard lock(m_queue_mutex);
+        m_background.push_back(std::move(job));
+        ++m_background_queued;
+    }
+    else if (index >= 0)
+    {
+        auto& worker = *m_workers[index];
+        std::lock_guard lock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+        ++m_queued;
+    }
+    else
+    {
+        std::lock_guard lock(m_queue_mutex);
+        m_injected.push_back(std::move(job));
+        ++m_queued;
+    }
+
+    /* Taking the lock orders this with a worker that is about to sleep, so it either sees the job or gets the notification */
+    {
+        std::lock_guard lock(m_sleep_mutex);
+    }
+    m_wake.notify_one();
+}
+
+bool JobSystem::take(int worker, bool background, Job& out_job)
+{
+    if (m_queued > 0u)
+    {
+        /* The newest job of our own deque is the one most likely to still be in the cache */
+        if (worker >= 0)
+        {
+            auto& own = *m_workers[worker];
+            std::lock_guard lock(own.mutex);
+            if (!own.jobs.empty())
+            {
+                out_job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                --m_queued;
+                return true;
+            }
+        }
+
+        {
+            std::lock_guard lock(m_queue_mutex);
+            if (!m_injected.empty())
+            {
+                out_job = std::move(m_injected.front());
+                m_injected.pop_front();
+                --m_queued;
+                return true;
+            }
+        }
+
+        /* Steal the oldest job of another worker, starting with the next one so thieves spread out */
+        const auto count = static_cast<int>(m_workers.size());
+        for (int i = 1; i <= count; ++i)
+        {
+            const auto victim = (std::max(worker, 0) + i) % count;
+            if (victim == worker)
+            {
+                continue;
+            }
+
+            auto& other = *m_workers[victim];
+            std::lock_guard lock(other.mutex);
+            if (!other.jobs.empty())
+            {
+                out_job = std::move(other.jobs.front());
+                other.jobs.pop_front();
+                --m_queued;
+                if (worker >= 0)
+                {
+                    ++m_workers[worker]->stolen;
+                }
+                return true;
+            }
+        }
+    }
+
+    if (background && m_background_queued > 0u)
+    {
+        std::lock_guard lock(m_queue_mutex);
+        if (!m_background.empty())
+        {
+            out_job = std::move(m_background.front());
+            m_background.pop_front();
+            --m_background_queued;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::execute(Job& job)
+{
+    {
+        PAC_PROFILE_SCOPE(job.name);
+        job.fn();
+    }
+
+    if (const auto index = worker_index(); index >= 0)
+    {
+        ++m_workers[index]->executed;
+    }
+    else
+    {
+        ++m_helped;
+    }
+
+    /* The job may refer to the stack of a thread waiting for the counter, so it is gone before the counter is counted down */
+    job.fn = nullptr;
+    if (job.counter)
+    {
+        finish(*job.counter);
+    }
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+    std::vector<JobCounter::Continuation> continuations{};
+    {
+        std::lock_guard lock(counter.m_mutex);
+        GFX_ASSERT(counter.m_pending > 0u, "A job counter was counted down more often than it was counted up.");
+        if (--counter.m_pending == 0u)
+        {
+            continuations.swap(counter.m_continuations);
+            counter.m_done.notify_all();
+        }
+    }
+
+    for (auto& continuation : continuations)
+    {
+        push({continuation.name, std::move(continuation.fn), continuation.counter}, EJobPriority::Normal);
+    }
+}
+
+void JobSystem::worker_main(int index)
+{
+    t_worker = {this, index};
+    while (true)
+    {
+        Job job{};
+        if (take(index, true, job))
+        {
+            execute(job);
+            get_frame_arena().reset();
+            continue;
+        }
+
+        std::unique_lock lock(m_sleep_mutex);
+        m_wake.wait(lock, [this] { return m_stopping || m_queued > 0u || m_background_queued > 0u; });
+        if (m_stopping && m_queued == 0u && m_background_queued == 0u)
+        {
+            return;
+        }
+    }
+}
+
+void set_job_thread_count(unsigned thread_count) { g_job_thread_count = thread_count; }
+
+JobSystem& get_job_system()
+{
+    static JobSystem jobs{g_job_thread_count};
+    return jobs;
+}
+}  // namespace pac
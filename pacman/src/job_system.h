@@ -0,0 +1,263 @@
+/*!
+ * \file job_system.h contains the job system every part of the game hands work to, such as the systems that can run alongside
+ * each other (see entity/system_scheduler.h), path searches, loaders and the software renderer.
+ */
+
+#pragma once
+
+#include "profiler.h"
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+namespace pac
+{
+class JobSystem;
+
+/*!
+ * \brief The EJobPriority enum tells the job system how soon a job has to run
+ */
+enum class EJobPriority
+{
+    /* Work someone is waiting for, such as the pieces of a parallel_for. Threads waiting for jobs run these too */
+    Normal,
+
+    /* Long work nobody waits for right away (like parsing a level), it is only run by workers with nothing else to do */
+    Background
+};
+
+/*!
+ * \brief The JobCounter class counts the unfinished jobs that were given it when they were started. It is used to wait for
+ * jobs, and to start jobs once others are done. A counter must outlive its jobs (waiting for it guarantees that).
+ */
+class JobCounter
+{
+private:
+    friend class JobSystem;
+
+    /*!
+     * \brief The Continuation struct is a job that is started once the counter reaches zero
+     */
+    struct Continuation
+    {
+        const char* name = nullptr;
+        std::function<void()> fn = {};
+        JobCounter* counter = nullptr;
+    };
+
+    unsigned m_pending = 0u;
+    std::vector<Continuation> m_continuations = {};
+    mutable std::mutex m_mutex = {};
+    std::condition_variable m_done = {};
+
+public:
+    JobCounter() = default;
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter(JobCounter&&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+    JobCounter& operator=(JobCounter&&) = delete;
+    ~JobCounter() noexcept = default;
+
+    /*!
+     * \brief is_done returns true when every job given this counter has finished
+     */
+    bool is_done() const;
+};
+
+/*!
+ * \brief The JobSystem class runs jobs on a fixed set of worker threads. Each worker has a deque of jobs: a worker takes the
+ * newest job from its own deque, and when that is empty it takes the oldest job of the jobs started from other threads, or
+ * steals the oldest job of another worker. Threads waiting for a counter run jobs while they wait, so jobs may start and
+ * wait for other jobs. Every job is recorded as a profiler zone, and workers reset their frame arena after every job, so arena
+ * memory never outlives the job that took it.
+ */
+class JobSystem
+{
+public:
+    /*!
+     * \brief The Stats struct contains the jobs every worker ran, reset when read with take_stats
+     */
+    struct Stats
+    {
+        /* Jobs run and jobs stolen from other workers, per worker */
+        std::vector<uint64_t> executed = {};
+        std::vector<uint64_t> stolen = {};
+
+        /* Jobs run by threads that are not workers while they waited */
+        uint64_t helped = 0u;
+    };
+
+private:
+    /*!
+     * \brief The Job struct is a job that is queued
+     */
+    struct Job
+    {
+        const char* name = nullptr;
+        std::function<void()> fn = {};
+        JobCounter* counter = nullptr;
+    };
+
+    /*!
+     * \brief The Worker struct is a worker thread and its deque of jobs
+     */
+    struct Worker
+    {
+        std::deque<Job> jobs = {};
+        std::mutex mutex = {};
+        std::atomic<uint64_t> executed = 0u;
+        std::atomic<uint64_t> stolen = 0u;
+        std::thread thread = {};
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers = {};
+
+    /* Jobs started by threads that are not workers, and background jobs */
+    std::deque<Job> m_injected = {};
+    std::deque<Job> m_background = {};
+    std::mutex m_queue_mutex = {};
+
+    /* Normal and background jobs waiting in any queue, workers sleep while both are zero */
+    std::atomic<std::size_t> m_queued = 0u;
+    std::atomic<std::size_t> m_background_queued = 0u;
+    std::mutex m_sleep_mutex = {};
+    std::condition_variable m_wake = {};
+    bool m_stopping = false;
+
+    std::atomic<uint64_t> m_helped = 0u;
+
+public:
+    /*!
+     * \brief JobSystem starts the worker threads
+     * \param thread_count is the number of threads, 0 means one per core besides the calling thread
+     */
+    explicit JobSystem(unsigned thread_count);
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem(JobSystem&&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    JobSystem& operator=(JobSystem&&) = delete;
+
+    /*!
+     * \brief ~JobSystem runs the jobs that were started and joins the threads
+     */
+    ~JobSystem() noexcept;
+
+    /*!
+     * \brief run starts a job
+     * \param name is the name of the job in the profiler, it must have static storage
+     * \param fn is the job
+     * \param counter is counted up until the job has finished (optional)
+     * \param priority is how soon the job has to run
+     */
+    void run(const char* name, std::function<void()> fn, JobCounter* counter = nullptr,
+             EJobPriority priority = EJobPriority::Normal);
+
+    /*!
+     * \brief run_after starts a job once every job given the dependency counter has finished (right away if they have)
+     */
+    void run_after(JobCounter& dependency, const char* name, std::function<void()> fn, JobCounter* counter = nullptr);
+
+    /*!
+     * \brief wait returns once every job given the counter has finished, running other jobs in the meantime
+     */
+    void wait(JobCounter& counter);
+
+    /*!
+     * \brief run_one runs a normal priority job if one is queued
+     * \return true if a job was run
+     */
+    bool run_one();
+
+    /*!
+     * \brief parallel_for calls fn(first, last) for consecutive pieces of [begin, end) of at most grain elements, on the
+     * workers and the calling thread, and returns once every piece is done
+     * \param name is the name of the pieces in the profiler, it must have static storage
+     */
+    template<typename Fn>
+    void parallel_for(const char* name, std::size_t begin, std::size_t end, std::size_t grain, const Fn& fn)
+    {
+        grain = std::max<std::size_t>(grain, 1u);
+        if (end <= begin)
+        {
+            return;
+        }
+
+        /* The calling thread takes the first piece, so a range of one piece never leaves it */
+        JobCounter counter{};
+        for (auto first = begin + grain; first < end; first += grain)
+        {
+            const auto last = std::min(first + grain, end);
+            run(name, [&fn, first, last] { fn(first, last); }, &counter);
+        }
+
+        {
+            PAC_PROFILE_SCOPE(name);
+            fn(begin, std::min(begin + grain, end));
+        }
+        wait(counter);
+    }
+
+    /*!
+     * \brief get_thread_count returns the number of worker threads
+     */
+    unsigned get_thread_count() const;
+
+    /*!
+     * \brief take_stats returns the jobs run since the previous call, and resets the counts
+     */
+    Stats take_stats();
+
+private:
+    /*!
+     * \brief worker_index returns the index of the calling thread if it is a worker of this job system, and -1 otherwise
+     */
+    int worker_index() const;
+
+    /*!
+     * \brief push queues a job, on the deque of the calling worker if it is one
+     */
+    void push(Job job, EJobPriority priority);
+
+    /*!
+     * \brief take removes the next job the calling thread should run
+     * \param worker is the index of the calling worker, or -1
+     * \param background is true if background jobs may be taken
+     */
+    bool take(int worker, bool background, Job& out_job);
+
+    /*!
+     * \brief execute runs a job and counts down its counter
+     */
+    void execute(Job& job);
+
+    /*!
+     * \brief finish counts down a counter, and starts its continuations if it reached zero
+     */
+    void finish(JobCounter& counter);
+
+    void worker_main(int index);
+};
+
+/*!
+ * \brief set_job_thread_count sets the number of worker threads, it only has an effect before get_job_system is first called
+ * \param thread_count is the number of threads, 0 means one per core besides the main thread
+ */
+void set_job_thread_count(unsigned thread_count);
+
+/*!
+ * \brief get_job_system returns the job system of the game, started on first use with the number of threads given to
+ * set_job_thread_count (WORKER_THREADS by default)
+ */
+JobSystem& get_job_system();
+}  // namespace pac
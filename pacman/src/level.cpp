@@ -1,13 +1,16 @@
 #include "level.h"
 #include "pathfinding.h"
+#include "frame_arena.h"
 #include "entity/factory.h"
 #include "audio/sound_manager.h"
 #include "states/state_manager.h"
 #include "states/respawn_state.h"
 #include "states/game_over_state.h"
+#include "profiler.h"
 #include "config.h"
 
 #include <regex>
+#include <chrono>
 #include <fstream>
 #include <iterator>
 #include <algorithm>
@@ -25,68 +28,110 @@ Level::Level() { m_tileset_texture = get_renderer().load_animation_texture("res/
 
 void Level::update(float dt) {}
 
+Level::~Level() noexcept { get_renderer().release_static_layer(this); }
+
 void Level::draw()
 {
+    PAC_PROFILE_SCOPE("Level::draw");
     auto& r = get_renderer();
-    for (auto y = 0ul; y < m_tiles.size(); ++y)
-    {
-        for (auto x = 0ul; x < m_tiles[y].size(); ++x)
-        {
-            const Tile& t = m_tiles[y][x];
 
-            /* Only draw non-blank tiles. Most tiles are non-blank so the if is likely to happen. */
-            if (t.type != ETileType::Blank)
-            {
-                /* Draw tile */
-                r.draw({{HALF_TILE + x * TILE_SIZE<float>, HALF_TILE + y * TILE_SIZE<float>},
-                        {TILE_SIZE<float>, TILE_SIZE<float>},
-                        {1.f, 1.f, 1.f},
-                        t.texture});
-            }
-        }
+    /* Tiles only need to be re-submitted if some other level has taken over the static layer */
+    if (!r.owns_static_layer(this))
+    {
+        rebuild_static_layer();
     }
+
+    r.draw_static_layer();
 }
 
 const std::string& Level::get_name() const { return m_name; }
 
-void Level::load(sol::state_view& state_view, entt::registry& reg, std::string_view level_name)
+bool Level::load(sol::state_view& state_view, entt::registry& reg, std::string_view level_name)
 {
-    GFX_INFO("Loading level %s", level_name.data());
+    PAC_PROFILE_SCOPE("Level::load");
+    return instantiate(state_view, reg, parse(state_view, level_name));
+}
+
+Level::Data Level::parse(sol::state_view& state_view, std::string_view level_name)
+{
+    PAC_PROFILE_SCOPE("Level::parse");
+    const auto start = std::chrono::steady_clock::now();
+    Data data{};
+    data.name = level_name;
 
     /* Read level file data */
-    state_view.script_file(cgl::native_absolute_path("res/levels.lua"));
+    const auto path = cgl::native_absolute_path("res/levels.lua");
+    data.file_time = std::filesystem::last_write_time(path);
+    state_view.script_file(path);
     sol::table level_data = state_view["levels"][level_name];
-
-    /* Reisze level to level size */
-    resize({level_data["w"], level_data["h"]});
+    data.size = {level_data["w"], level_data["h"]};
 
     /* Load Teleporter Information */
-    m_teleporters.clear();
     sol::table tp_tbl = level_data["teleporters"];
     for (const auto& [_, tpelem] : tp_tbl)
     {
         sol::table tp = tpelem.as<sol::table>();
-        m_teleporters.emplace_back(TeleportDestination{glm::ivec2{tp["from"][1], tp["from"][2]},
-                                                       glm::ivec2{tp["position"][1], tp["position"][2]},
-                                                       glm::ivec2{tp["direction"][1], tp["direction"][2]}});
+        data.teleporters.emplace_back(TeleportDestination{glm::ivec2{tp["from"][1], tp["from"][2]},
+                                                          glm::ivec2{tp["position"][1], tp["position"][2]},
+                                                          glm::ivec2{tp["direction"][1], tp["direction"][2]}});
     }
 
     /* Load the tile information */
-    const auto& tiles = level_data["tiles"].get<std::vector<int>>();
+    data.tiles = level_data["tiles"].get<std::vector<int>>();
+
+    /* And the positions of every entity */
+    sol::table entities = level_data["entities"];
+    for (const auto& [_, entity] : entities)
+    {
+        sol::table entity_data = entity.as<sol::table>();
+        data.spawns.push_back({entity_data["name"].get<std::string>(), entity_data["x"].get<std::vector<int>>(),
+                               entity_data["y"].get<std::vector<int>>()});
+    }
+
+    data.parse_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return data;
+}
+
+bool Level::instantiate(sol::state_view& state_view, entt::registry& reg, const Data& data)
+{
+    PAC_PROFILE_SCOPE("Level::instantiate");
+
+    /* Reject broken level data before anything is replaced, since it is read by index below */
+    if (data.size.x < 0 || data.size.y < 0 || data.tiles.size() != static_cast<std::size_t>(data.size.x) * data.size.y)
+    {
+        GFX_WARN("Level %s has %zu tiles, but is %dx%d. Not loading it.", data.name.c_str(), data.tiles.size(), data.size.x,
+                 data.size.y);
+        return false;
+    }
+    for (const auto& spawns : data.spawns)
+    {
+        if (spawns.x.size() != spawns.y.size())
+        {
+            GFX_WARN("Entity %s of level %s has %zu x and %zu y positions. Not loading the level.", spawns.entity.c_str(),
+                     data.name.c_str(), spawns.x.size(), spawns.y.size());
+            return false;
+        }
+    }
+
+    GFX_INFO("Loading level %s", data.name.c_str());
 
-    /* Then use this tile data to generate the level tile format */
+    /* Reisze level to level size */
+    resize(data.size);
+    m_teleporters = data.teleporters;
+
+    /* Then use the tile data to generate the level tile format */
     for (auto y = 0ul; y < m_tiles.size(); ++y)
     {
         for (auto x = 0ul; x < m_tiles[y].size(); ++x)
         {
             auto& level_tile = m_tiles[y][x];
-            auto tile_type = tiles[y * level_data["w"].get<int>() + x];
+            auto tile_type = data.tiles[y * data.size.x + x];
 
             /* It's either a blank tile or it is some kind of wall */
             if (tile_type != -1)
             {
                 level_tile.type = ETileType::Wall;
-                level_tile.texture = get_renderer().get_tileset_texture(tiles[y * m_tiles[y].size() + x]);
+                level_tile.texture = get_renderer().get_tileset_texture(tile_type);
             }
             else
             {
@@ -95,30 +140,39 @@ void Level::load(sol::state_view& state_view, entt::registry& reg, std::string_v
         }
     }
 
-    /* Process entities by key / value */
-    reg.reset();
-    EntityFactory factory(reg);
-    sol::table entities = level_data["entities"];
+    /* Tiles are final now, so upload them once */
+    rebuild_static_layer();
 
-    for (const auto& [_, entity] : entities)
+    /* Make room for every entity up front */
+    reg.reset();
+    std::size_t entity_count = 0u;
+    for (const auto& spawns : data.spawns)
     {
-        sol::table entity_data = entity.as<sol::table>();
+        entity_count += spawns.x.size();
+    }
+    reg.reserve(entity_count);
 
-        /* Spawn based on name, and then move to position if entity has a position component */
-        const auto& x_positions = entity_data["x"].get<std::vector<int>>();
-        const auto& y_positions = entity_data["y"].get<std::vector<int>>();
+    /* Spawn all instances of an entity in one go, then move each of them to its position */
+    EntityFactory factory(reg);
+    std::vector<entt::entity> entities{};
+    for (const auto& spawns : data.spawns)
+    {
+        entities.resize(spawns.x.size());
+        if (!factory.spawn(state_view, spawns.entity, entities.data(), entities.data() + entities.size()))
+        {
+            continue;
+        }
 
-        /* For each position, spawn an entity */
-        for (auto i = 0u; i < x_positions.size(); ++i)
+        for (std::size_t i = 0u; i < entities.size(); ++i)
         {
-            auto e = factory.spawn(state_view, entity_data["name"]);
-            reg.get<CPosition>(e).position = {x_positions[i], y_positions[i]};
-            reg.get<CPosition>(e).spawn = {x_positions[i], y_positions[i]};
+            auto& position = reg.get<CPosition>(entities[i]);
+            position.position = position.spawn = {spawns.x[i], spawns.y[i]};
         }
     }
 
     /* Set level name */
-    m_name = level_name;
+    m_name = data.name;
+    return true;
 }
 
 void Level::save(sol::state_view& state_view, const entt::registry& reg, std::string_view level_name,
@@ -194,9 +248,11 @@ void Level::save(sol::state_view& state_view, const entt::registry& reg, std::st
     save_to_file(levels);
 }
 
-std::vector<glm::ivec2> Level::get_neighbours(glm::ivec2 pos) const
+std::pmr::vector<glm::ivec2> Level::get_neighbours(glm::ivec2 pos) const
 {
-    std::vector<glm::ivec2> out{};
+    /* Called for every node of every path search, so keep it off the heap */
+    std::pmr::vector<glm::ivec2> out(&get_frame_arena());
+    out.reserve(4u);
 
     /* Check all directions and make sure they are not walls. If they are not, add them to out vector and return it. */
     if (pos.x > 0 && get_tile(pos + glm::ivec2{-1, 0}).type != ETileType::Wall)
@@ -222,6 +278,11 @@ std::vector<glm::ivec2> Level::get_neighbours(glm::ivec2 pos) const
     return out;
 }
 
+glm::ivec2 Level::get_size() const
+{
+    return {m_tiles.empty() ? 0 : static_cast<int>(m_tiles[0].size()), static_cast<int>(m_tiles.size())};
+}
+
 Level::Tile& Level::get_tile(glm::ivec2 coordinate)
 {
     GFX_ASSERT(coordinate.y >= 0 && coordinate.y < static_cast<int>(m_tiles.size()), "Y Coordinate out of bounds!");
@@ -236,6 +297,12 @@ const Level::Tile& Level::get_tile(glm::ivec2 coordinate) const
     return m_tiles[coordinate.y][coordinate.x];
 }
 
+void Level::set_tile(glm::ivec2 coordinate, const Level::Tile& tile)
+{
+    get_tile(coordinate) = tile;
+    update_static_tile(coordinate);
+}
+
 std::optional<Level::TeleportDestination> Level::get_teleport_dest(glm::ivec2 from) const
 {
     /* If a destination exists, teleport! */
@@ -262,7 +329,7 @@ glm::ivec2 Level::find_closest_intersection(glm::ivec2 start, glm::ivec2 dir) co
     directions.erase(e_itr, directions.end());
 
     /* Now choose a direction to move in and go as far as possible in that way */
-    std::vector<glm::ivec2> possible_targets = {};
+    std::pmr::vector<glm::ivec2> possible_targets(&get_frame_arena());
     for (const auto& dir : directions)
     {
         glm::ivec2 movement_vector = dir - start;
@@ -327,6 +394,40 @@ void Level::resize(glm::ivec2 new_size)
     {
         xvec.resize(new_size.x);
     }
+
+    rebuild_static_layer();
+}
+
+void Level::rebuild_static_layer()
+{
+    const auto width = m_tiles.empty() ? 0u : static_cast<unsigned>(m_tiles[0].size());
+    get_renderer().set_static_layer(this, width * static_cast<unsigned>(m_tiles.size()));
+
+    for (auto y = 0; y < static_cast<int>(m_tiles.size()); ++y)
+    {
+        for (auto x = 0; x < static_cast<int>(m_tiles[y].size()); ++x)
+        {
+            update_static_tile({x, y});
+        }
+    }
+}
+
+void Level::update_static_tile(glm::ivec2 coordinate)
+{
+    auto& r = get_renderer();
+    if (!r.owns_static_layer(this))
+    {
+        return;
+    }
+
+    /* Blank tiles keep their slot (so a tile's index is always y * w + x) but get a zero size so nothing is rasterized */
+    const Tile& t = get_tile(coordinate);
+    const auto size = t.type != ETileType::Blank ? TILE_SIZE<float> : 0.f;
+    r.set_static_instance(coordinate.y * static_cast<unsigned>(m_tiles[0].size()) + coordinate.x,
+                          {{HALF_TILE + coordinate.x * TILE_SIZE<float>, HALF_TILE + coordinate.y * TILE_SIZE<float>},
+                           {size, size},
+                           {1.f, 1.f, 1.f},
+                           t.texture});
 }
 
 glm::ivec2 Level::direction(glm::ivec2 from, glm::ivec2 to) const
@@ -396,7 +497,7 @@ void Level::save_to_file(sol::table levels_table)
     ofile << "}\n";
 }
 
-glm::ivec2 Level::find_sensible_escape_point(glm::ivec2 ghost_pos, glm::ivec2 ghost_dir, glm::ivec2 escape_from_pos)
+glm::ivec2 Level::find_sensible_escape_point(glm::ivec2 ghost_pos, glm::ivec2 ghost_dir, glm::ivec2 escape_from_pos) const
 {
     /* Compute direction to pacman so we can prefer some directions to others */
     const auto pacman_delta = escape_from_pos - ghost_pos;
@@ -415,7 +516,7 @@ glm::ivec2 Level::find_sensible_escape_point(glm::ivec2 ghost_pos, glm::ivec2 gh
     });
 
     /* Now choose a direction to move in and go as far as possible in that way */
-    std::vector<glm::ivec2> possible_targets = {};
+    std::pmr::vector<glm::ivec2> possible_targets(&get_frame_arena());
     for (const auto& dir : directions)
     {
         glm::ivec2 movement_vector = dir - ghost_pos;
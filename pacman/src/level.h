@@ -5,7 +5,9 @@
 #include <chrono>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <cstdint>
+#include <filesystem>
 #include <string_view>
 
 #include <robinhood/robinhood.h>
@@ -65,6 +67,36 @@ public:
         TextureID texture = {};
     };
 
+    /*!
+     * \brief The Data struct is what the level file says about a level. It is plain data, so it can be parsed on a worker
+     * thread and then instantiated on the main thread.
+     */
+    struct Data
+    {
+        /*!
+         * \brief The Spawns struct is an entity and the positions to spawn it at
+         */
+        struct Spawns
+        {
+            std::string entity{};
+            std::vector<int> x{};
+            std::vector<int> y{};
+        };
+
+        std::string name{};
+        glm::ivec2 size{};
+
+        /* Tileset frame of every tile (row by row), or -1 for blank tiles */
+        std::vector<int> tiles{};
+
+        std::vector<TeleportDestination> teleporters{};
+        std::vector<Spawns> spawns{};
+
+        /* Modification time of the level file when it was parsed, and how long parsing took */
+        std::filesystem::file_time_type file_time{};
+        float parse_ms = 0.f;
+    };
+
 private:
     using seconds = std::chrono::duration<float>;
 
@@ -86,6 +118,8 @@ private:
 public:
     Level();
 
+    ~Level() noexcept;
+
     /* Level editor can freely change the level */
     friend class EditorState;
 
@@ -97,7 +131,8 @@ public:
     void update(float dt);
 
     /*!
-     * \brief draw draws the level (food, tiles and blank tiles
+     * \brief draw draws the level tiles. The tiles are retained in the renderer's static layer, so this only uploads them
+     * again if another level has used the layer since
      */
     void draw();
 
@@ -110,8 +145,23 @@ public:
     /*!
      * \brief load a level at the given relative file path
      * \param fp is the relative (to the executable dir) file path of the level file
+     * \return true if the level was loaded, see instantiate
      */
-    void load(sol::state_view& state_view, entt::registry& reg, std::string_view level_name);
+    bool load(sol::state_view& state_view, entt::registry& reg, std::string_view level_name);
+
+    /*!
+     * \brief parse reads a level from the level file without touching the renderer, registry or any level
+     * \param state_view is the lua state to run the level file in, it does not have to be the game's state
+     * \param level_name is the level to read
+     */
+    static Data parse(sol::state_view& state_view, std::string_view level_name);
+
+    /*!
+     * \brief instantiate replaces the current level with parsed level data, and spawns its entities
+     * \return true if the level was instantiated, false if the data is inconsistent (the tiles do not match the size, or an
+     * entity does not have as many y positions as x positions), in which case the current level and registry are untouched
+     */
+    bool instantiate(sol::state_view& state_view, entt::registry& reg, const Data& data);
 
     /*!
      * \brief save saves the level to a file
@@ -128,6 +178,13 @@ public:
     Tile& get_tile(glm::ivec2 coordinate);
     const Tile& get_tile(glm::ivec2 coordinate) const;
 
+    /*!
+     * \brief set_tile changes the tile at the given coordinate and updates it in the renderer's static layer
+     * \param coordinate is the coordinate of the tile to change
+     * \param tile is the new tile
+     */
+    void set_tile(glm::ivec2 coordinate, const Tile& tile);
+
     /*!
      * \brief get_teleport_dest returns the destination
      * \param from is where you want to find a destination
@@ -161,7 +218,12 @@ public:
      * \param pos the position of the tile to get the neighbours (NESW) of
      * \return A vector of tile coordinates
      */
-    std::vector<glm::ivec2> get_neighbours(glm::ivec2 pos) const;
+    std::pmr::vector<glm::ivec2> get_neighbours(glm::ivec2 pos) const;
+
+    /*!
+     * \brief get_size returns the width and height of the level in tiles
+     */
+    glm::ivec2 get_size() const;
 
     /*!
      * \brief score returns current score
@@ -174,7 +236,7 @@ public:
      * \param escape_from_pos
      * \return
      */
-    glm::ivec2 find_sensible_escape_point(glm::ivec2 ghost_pos, glm::ivec2 ghost_dir, glm::ivec2 escape_from_pos);
+    glm::ivec2 find_sensible_escape_point(glm::ivec2 ghost_pos, glm::ivec2 ghost_dir, glm::ivec2 escape_from_pos) const;
 
 private:
     /*!
@@ -191,6 +253,17 @@ private:
      */
     void resize(glm::ivec2 new_size);
 
+    /*!
+     * \brief rebuild_static_layer takes ownership of the renderer's static layer and fills it with all tiles in the level
+     */
+    void rebuild_static_layer();
+
+    /*!
+     * \brief update_static_tile updates a single tile in the renderer's static layer (if this level owns it)
+     * \param coordinate is the coordinate of the tile to update
+     */
+    void update_static_tile(glm::ivec2 coordinate);
+
     /*!
      * \brief direction gets the direction (-1, 0, 1) you need to go to get from a to b
      * \param from
@@ -0,0 +1,90 @@
+#include "level_preloader.h"
+#include "job_system.h"
+#include "config.h"
+
+#include <chrono>
+#include <memory>
+#include <algorithm>
+
+#include <gfx.h>
+#include <cglutil.h>
+#include <sol/state.hpp>
+
+namespace pac
+{
+namespace
+{
+bool is_done(const std::future<Level::Data>& data)
+{
+    return data.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+/*!
+ * \brief parse_on_worker parses a level in a lua state of its own
+ */
+Level::Data parse_on_worker(std::string level_name)
+{
+    sol::state lua{};
+    lua.open_libraries(sol::lib::base);
+    return Level::parse(lua, level_name);
+}
+}  // namespace
+
+void LevelPreloader::request(std::string_view level_name)
+{
+    if (find(level_name) != m_jobs.end())
+    {
+        return;
+    }
+
+    /* Make room by dropping the oldest parsed level, levels still being parsed are kept so their work is not wasted */
+    if (m_jobs.size() >= LEVEL_PRELOAD_MAX)
+    {
+        const auto done = std::find_if(m_jobs.begin(), m_jobs.end(), [](const Job& job) { return is_done(job.data); });
+        if (done == m_jobs.end())
+        {
+            return;
+        }
+        m_jobs.erase(done);
+    }
+
+    /* Parsing is a background job, so it never holds up the work of a frame */
+    GFX_DEBUG("Preloading level %s", std::string(level_name).c_str());
+    auto task = std::make_shared<std::packaged_task<Level::Data()>>(
+        [name = std::string(level_name)] { return parse_on_worker(name); });
+    m_jobs.push_back({std::string(level_name), task->get_future()});
+    get_job_system().run("Level Preload", [task] { (*task)(); }, nullptr, EJobPriority::Background);
+}
+
+bool LevelPreloader::is_ready(std::string_view level_name) const
+{
+    const auto job = find(level_name);
+    return job == m_jobs.end() || is_done(job->data);
+}
+
+std::optional<Level::Data> LevelPreloader::take(std::string_view level_name)
+{
+    const auto job = find(level_name);
+    if (job == m_jobs.end())
+    {
+        return std::nullopt;
+    }
+
+    auto future = std::move(m_jobs[job - m_jobs.cbegin()].data);
+    m_jobs.erase(job);
+    auto data = future.get();
+
+    /* The level may have been saved in the editor since it was parsed */
+    if (data.file_time != std::filesystem::last_write_time(cgl::native_absolute_path("res/levels.lua")))
+    {
+        GFX_INFO("Not using the preloaded level %s, the level file has changed.", data.name.c_str());
+        return std::nullopt;
+    }
+    return data;
+}
+
+std::vector<LevelPreloader::Job>::const_iterator LevelPreloader::find(std::string_view level_name) const
+{
+    return std::find_if(m_jobs.begin(), m_jobs.end(), [level_name](const Job& job) { return job.level_name == level_name; });
+}
+}  // namespace pac
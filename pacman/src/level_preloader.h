@@ -0,0 +1,62 @@
+/*!
+ * \file level_preloader.h contains the level preloader, which parses levels as background jobs so they can be instantiated
+ * later without running the level file on the main thread
+ */
+
+#pragma once
+
+#include "level.h"
+
+#include <future>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+
+namespace pac
+{
+/*!
+ * \brief The LevelPreloader class parses levels as background jobs of the job system. Every job runs the level file in its own
+ * lua state, so the game's lua state is never touched off the main thread. At most LEVEL_PRELOAD_MAX levels are kept at a time.
+ */
+class LevelPreloader
+{
+private:
+    /*!
+     * \brief The Job struct is a level that is being, or has been, parsed
+     */
+    struct Job
+    {
+        std::string level_name{};
+        std::future<Level::Data> data{};
+    };
+
+    std::vector<Job> m_jobs{};
+
+public:
+    LevelPreloader() = default;
+
+    LevelPreloader(const LevelPreloader&) = delete;
+    LevelPreloader& operator=(const LevelPreloader&) = delete;
+
+    /*!
+     * \brief request starts parsing a level in a background job, unless it is already parsed or being parsed
+     */
+    void request(std::string_view level_name);
+
+    /*!
+     * \brief is_ready returns false while a requested level is still being parsed
+     */
+    bool is_ready(std::string_view level_name) const;
+
+    /*!
+     * \brief take hands over a parsed level, waiting for the job if it is not done yet
+     * \return the level, or nothing if it was not requested or the level file has changed since it was parsed (parse errors
+     * are rethrown)
+     */
+    std::optional<Level::Data> take(std::string_view level_name);
+
+private:
+    std::vector<Job>::const_iterator find(std::string_view level_name) const;
+};
+}  // namespace pac
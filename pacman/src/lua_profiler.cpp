@@ -0,0 +1,308 @@
+#include "lua_profiler.h"
+
+#ifdef PAC_ENABLE_PROFILER
+
+#include "profiler.h"
+#include "config.h"
+
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include <gfx.h>
+#include <lua.hpp>
+#include <imgui/imgui.h>
+
+namespace pac
+{
+namespace
+{
+/* Number of functions listed in the overlay */
+constexpr std::size_t OVERLAY_FUNCTIONS = 24u;
+
+/*!
+ * \brief function_key hashes (FNV-1a) the source and line a function was defined at, which stays the same for as long as the
+ * script is loaded
+ */
+uint64_t function_key(const char* source, int line)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (; *source; ++source)
+    {
+        hash = (hash ^ static_cast<uint8_t>(*source)) * 0x100000001B3ull;
+    }
+    return (hash ^ static_cast<uint32_t>(line)) * 0x100000001B3ull;
+}
+}  // namespace
+
+void LuaProfiler::attach(lua_State* lua)
+{
+    const auto mode = m_mode;
+    set_mode(EMode::Off);
+    m_lua = lua;
+    m_stack.clear();
+    set_mode(mode);
+}
+
+void LuaProfiler::set_mode(EMode mode)
+{
+    m_mode = mode;
+    m_stack.clear();
+    if (!m_lua)
+    {
+        return;
+    }
+
+    switch (mode)
+    {
+    case EMode::Off: lua_sethook(m_lua, nullptr, 0, 0); break;
+    case EMode::Sampling: lua_sethook(m_lua, &LuaProfiler::hook, LUA_MASKCOUNT, LUA_PROFILER_SAMPLE_INSTRUCTIONS); break;
+    case EMode::Instrumenting: lua_sethook(m_lua, &LuaProfiler::hook, LUA_MASKCALL | LUA_MASKRET, 0); break;
+    }
+}
+
+LuaProfiler::EMode LuaProfiler::get_mode() const { return m_mode; }
+
+void LuaProfiler::new_frame()
+{
+    /* Nothing runs lua between frames, anything left on the stack was unwound by an error and never returned */
+    m_stack.clear();
+
+    m_last_frame_ns = m_frame_ns;
+    m_frame_ns = 0;
+    ++m_frames;
+}
+
+void LuaProfiler::reset()
+{
+    m_functions.clear();
+    m_stack.clear();
+    m_frame_ns = 0;
+    m_last_frame_ns = 0;
+    m_frames = 0u;
+    m_samples = 0u;
+}
+
+void LuaProfiler::toggle_overlay() { m_overlay_visible = !m_overlay_visible; }
+
+void LuaProfiler::draw_overlay()
+{
+    if (!m_overlay_visible)
+    {
+        return;
+    }
+
+    ImGui::SetNextWindowSize({600.f, 360.f}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Lua Profiler", &m_overlay_visible);
+
+    auto mode = static_cast<int>(m_mode);
+    ImGui::RadioButton("Off", &mode, static_cast<int>(EMode::Off));
+    ImGui::SameLine();
+    ImGui::RadioButton("Sampling", &mode, static_cast<int>(EMode::Sampling));
+    ImGui::SameLine();
+    ImGui::RadioButton("Instrumenting", &mode, static_cast<int>(EMode::Instrumenting));
+    if (mode != static_cast<int>(m_mode))
+    {
+        set_mode(static_cast<EMode>(mode));
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        reset();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Dump"))
+    {
+        dump("lua_profile.txt");
+    }
+
+    const auto frames = std::max<uint64_t>(m_frames, 1u);
+    ImGui::Text("Frames: %llu  Lua: %6.4fms last frame  Samples: %llu", static_cast<unsigned long long>(m_frames),
+                m_last_frame_ns / 1e6, static_cast<unsigned long long>(m_samples));
+
+    ImGui::Columns(5, "lua_functions");
+    ImGui::Text("Function");
+    ImGui::NextColumn();
+    ImGui::Text("Calls/frame");
+    ImGui::NextColumn();
+    ImGui::Text("Self ms/frame");
+    ImGui::NextColumn();
+    ImGui::Text("Incl. ms/frame");
+    ImGui::NextColumn();
+    ImGui::Text("Samples");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    const auto functions = sorted_functions();
+    for (std::size_t i = 0u; i < std::min(functions.size(), OVERLAY_FUNCTIONS); ++i)
+    {
+        const auto& stats = *functions[i];
+        ImGui::Text("%s", stats.name.c_str());
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", stats.source.c_str());
+        }
+        ImGui::NextColumn();
+        ImGui::Text("%.1f", static_cast<double>(stats.calls) / frames);
+        ImGui::NextColumn();
+        ImGui::Text("%.4f", stats.self_ns / 1e6 / frames);
+        ImGui::NextColumn();
+        ImGui::Text("%.4f", stats.inclusive_ns / 1e6 / frames);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f%%", m_samples > 0u ? 100.0 * stats.samples / m_samples : 0.0);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    ImGui::End();
+}
+
+bool LuaProfiler::dump(std::string_view fp) const
+{
+    std::ofstream file(std::string(fp), std::ios::trunc);
+    if (!file)
+    {
+        GFX_WARN("Could not open %s to write the lua profile.", fp.data());
+        return false;
+    }
+
+    const auto frames = std::max<uint64_t>(m_frames, 1u);
+    file << "Lua profile over " << m_frames << " frames, " << m_samples << " samples\n";
+    file << "function\tsource\tcalls\tcalls/frame\tself ms\tinclusive ms\tself ms/frame\tsamples\n";
+    for (const auto* stats : sorted_functions())
+    {
+        file << stats->name << '\t' << stats->source << '\t' << stats->calls << '\t' << static_cast<double>(stats->calls) / frames
+             << '\t' << stats->self_ns / 1e6 << '\t' << stats->inclusive_ns / 1e6 << '\t' << stats->self_ns / 1e6 / frames
+             << '\t' << stats->samples << '\n';
+    }
+
+    GFX_INFO("Wrote the profile of %zu lua functions to %s.", m_functions.size(), fp.data());
+    return static_cast<bool>(file);
+}
+
+void LuaProfiler::hook(lua_State* lua, lua_Debug* ar)
+{
+    auto& profiler = get_lua_profiler();
+    switch (ar->event)
+    {
+    case LUA_HOOKCALL: profiler.on_call(lua, ar); break;
+#ifdef LUA_HOOKTAILCALL
+    case LUA_HOOKTAILCALL:
+        /* The caller is replaced by the callee and will not return, so end it here */
+        profiler.on_return();
+        profiler.on_call(lua, ar);
+        break;
+#endif
+#ifdef LUA_HOOKTAILRET
+    /* Lua 5.1 reports functions left through a tail call as they return */
+    case LUA_HOOKTAILRET:
+#endif
+    case LUA_HOOKRET: profiler.on_return(); break;
+    case LUA_HOOKCOUNT: profiler.on_sample(lua, ar); break;
+    default: break;
+    }
+}
+
+LuaProfiler::FunctionStats& LuaProfiler::get_stats(lua_State* lua, lua_Debug* ar)
+{
+    /* Lua functions are identified by where they were defined. C functions (the C++ bindings) are all defined in the same
+     * place as far as lua can tell, so they are identified by the name they were called by instead */
+    lua_getinfo(lua, "S", ar);
+    const bool native = ar->what[0] == 'C';
+    if (native)
+    {
+        lua_getinfo(lua, "n", ar);
+    }
+
+    const auto key = native ? function_key(ar->name ? ar->name : "", -1) : function_key(ar->short_src, ar->linedefined);
+    if (auto found = m_functions.find(key); found != m_functions.end())
+    {
+        return found->second;
+    }
+
+    /* First time the function is seen, look up its name (which is slower, so it is only done once for lua functions) */
+    auto& stats = m_functions[key];
+    if (!native)
+    {
+        lua_getinfo(lua, "n", ar);
+    }
+    stats.native = native;
+    stats.name = ar->name ? ar->name : (ar->what[0] == 'm' ? "(main chunk)" : "(anonymous)");
+
+    char source[LUA_IDSIZE + 32] = {};
+    if (stats.native)
+    {
+        std::snprintf(source, sizeof(source), "[C++ binding]");
+    }
+    else
+    {
+        std::snprintf(source, sizeof(source), "%s:%d", ar->short_src, ar->linedefined);
+    }
+    stats.source = source;
+
+    return stats;
+}
+
+void LuaProfiler::on_call(lua_State* lua, lua_Debug* ar)
+{
+    auto& stats = get_stats(lua, ar);
+    ++stats.calls;
+    m_stack.push_back({&stats, Profiler::now(), 0});
+}
+
+void LuaProfiler::on_return()
+{
+    /* Calls made before the hook was installed return without a matching call */
+    if (m_stack.empty())
+    {
+        return;
+    }
+
+    const auto activation = m_stack.back();
+    m_stack.pop_back();
+
+    const auto elapsed = Profiler::now() - activation.start;
+    activation.stats->inclusive_ns += elapsed;
+    activation.stats->self_ns += elapsed - activation.child_ns;
+
+    if (m_stack.empty())
+    {
+        m_frame_ns += elapsed;
+    }
+    else
+    {
+        m_stack.back().child_ns += elapsed;
+    }
+}
+
+void LuaProfiler::on_sample(lua_State* lua, lua_Debug* ar)
+{
+    ++get_stats(lua, ar).samples;
+    ++m_samples;
+}
+
+std::vector<const LuaProfiler::FunctionStats*> LuaProfiler::sorted_functions() const
+{
+    std::vector<const FunctionStats*> out = {};
+    out.reserve(m_functions.size());
+    for (const auto& [key, stats] : m_functions)
+    {
+        out.push_back(&stats);
+    }
+
+    const bool by_samples = m_mode == EMode::Sampling;
+    std::sort(out.begin(), out.end(), [by_samples](const FunctionStats* a, const FunctionStats* b) {
+        return by_samples ? a->samples > b->samples : a->self_ns > b->self_ns;
+    });
+    return out;
+}
+
+LuaProfiler& get_lua_profiler()
+{
+    static LuaProfiler profiler{};
+    return profiler;
+}
+}  // namespace pac
+
+#endif
@@ -0,0 +1,178 @@
+/*!
+ * \file lua_profiler.h contains a profiler for lua scripts built on lua_sethook. It either samples the running function every
+ * few thousand VM instructions, or instruments every call and return to measure call counts, inclusive and self time per lua
+ * function and per C++ binding called from lua. It is part of the PACMAN_PROFILER CMake option and is off until a mode is
+ * picked in its overlay, since the hooks slow lua down.
+ */
+
+#pragma once
+
+#ifdef PAC_ENABLE_PROFILER
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include <robinhood/robinhood.h>
+
+struct lua_State;
+struct lua_Debug;
+
+namespace pac
+{
+/*!
+ * \brief The LuaProfiler class attributes the time spent in lua to the functions that spent it
+ */
+class LuaProfiler
+{
+public:
+    /*!
+     * \brief The EMode enum is the kind of hook that is installed
+     */
+    enum class EMode
+    {
+        Off,
+        Sampling,
+        Instrumenting
+    };
+
+    /*!
+     * \brief The FunctionStats struct contains everything measured for a single function since the last reset
+     */
+    struct FunctionStats
+    {
+        /* Name at the first call site it was seen from, and where it was defined */
+        std::string name = {};
+        std::string source = {};
+
+        /* True for C functions, which is what the C++ bindings are */
+        bool native = false;
+
+        /* Instrumenting results. Inclusive time counts recursive calls more than once */
+        uint64_t calls = 0u;
+        int64_t inclusive_ns = 0;
+        int64_t self_ns = 0;
+
+        /* Sampling results (only lua functions can be sampled) */
+        uint64_t samples = 0u;
+    };
+
+private:
+    /*!
+     * \brief The Activation struct is a function that has been called and has not returned yet
+     */
+    struct Activation
+    {
+        FunctionStats* stats = nullptr;
+        int64_t start = 0;
+        int64_t child_ns = 0;
+    };
+
+    /* The hooked lua state */
+    lua_State* m_lua = nullptr;
+
+    /* Installed hook */
+    EMode m_mode = EMode::Off;
+
+    /* Stats per function, keyed by a hash of where it was defined, or of its name for C functions. Closures created from the
+     * same code share their stats, so scripts creating closures at runtime do not grow this, and a function object freed and
+     * another allocated at its address can not be mixed up. Node map so the stats do not move while activations point to them */
+    robin_hood::unordered_node_map<uint64_t, FunctionStats> m_functions{};
+
+    /* Functions that are currently running, innermost last */
+    std::vector<Activation> m_stack = {};
+
+    /* Time spent in lua (outside of any other lua function) in the current and the previous frame */
+    int64_t m_frame_ns = 0;
+    int64_t m_last_frame_ns = 0;
+
+    /* Totals since the last reset */
+    uint64_t m_frames = 0u;
+    uint64_t m_samples = 0u;
+
+    bool m_overlay_visible = false;
+
+public:
+    LuaProfiler() = default;
+
+    LuaProfiler(const LuaProfiler&) = delete;
+    LuaProfiler(LuaProfiler&&) = delete;
+    LuaProfiler& operator=(const LuaProfiler&) = delete;
+    LuaProfiler& operator=(LuaProfiler&&) = delete;
+    ~LuaProfiler() noexcept = default;
+
+    /*!
+     * \brief attach sets the lua state to profile, call before the state runs any scripts. Functions running in coroutines of
+     * the state are not seen, since lua hooks are per thread.
+     * \param lua is the state to profile, or nullptr to remove the hook from the current one
+     */
+    void attach(lua_State* lua);
+
+    /*!
+     * \brief set_mode installs the hook for the given mode (or removes it). Results of the previous mode are kept.
+     */
+    void set_mode(EMode mode);
+
+    /*!
+     * \brief get_mode returns the installed hook
+     */
+    EMode get_mode() const;
+
+    /*!
+     * \brief new_frame marks the start of a new frame (call once per frame, outside of lua)
+     */
+    void new_frame();
+
+    /*!
+     * \brief reset clears every measurement
+     */
+    void reset();
+
+    /*!
+     * \brief toggle_overlay shows or hides the ImGui window
+     */
+    void toggle_overlay();
+
+    /*!
+     * \brief draw_overlay draws the busiest functions if the overlay is visible. Call between ImGui::NewFrame and ImGui::Render.
+     */
+    void draw_overlay();
+
+    /*!
+     * \brief dump writes the stats of every function, busiest first, to a text file
+     * \param fp is the file path to write to
+     * \return true if the file was written
+     */
+    bool dump(std::string_view fp) const;
+
+private:
+    /*!
+     * \brief hook is the function installed with lua_sethook, it forwards to the profiler singleton
+     */
+    static void hook(lua_State* lua, lua_Debug* ar);
+
+    /*!
+     * \brief get_stats finds (or creates) the stats of the function running in the activation record
+     */
+    FunctionStats& get_stats(lua_State* lua, lua_Debug* ar);
+
+    void on_call(lua_State* lua, lua_Debug* ar);
+
+    void on_return();
+
+    void on_sample(lua_State* lua, lua_Debug* ar);
+
+    /*!
+     * \brief sorted_functions returns the stats sorted by self time (or samples when sampling)
+     */
+    std::vector<const FunctionStats*> sorted_functions() const;
+};
+
+/*!
+ * \brief get_lua_profiler returns the lua profiler singleton
+ */
+LuaProfiler& get_lua_profiler();
+}  // namespace pac
+
+#endif
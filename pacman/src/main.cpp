@@ -2,20 +2,77 @@
 #include "config.h"
 
 #include <string>
+#include <cstdlib>
+#include <cstring>
 
+#include <gfx.h>
 #include <GLFW/glfw3.h>
 
 using namespace std::string_literals;
 
 int main(int argc, char* argv[])
 {
-    if (glfwInit())
+    /* Parse command line options */
+    pac::LaunchOptions options = {};
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            options.record_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            options.replay_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--audio-capture") == 0 && i + 1 < argc)
+        {
+            options.audio_capture_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            options.headless = true;
+        }
+        else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+        {
+            options.golden_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            options.workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            GFX_WARN("Unknown option %s. Usage: %s [--record <file>] [--replay <file> [--headless [--golden <file>]]] "
+                     "[--audio-capture <file>] [--workers <threads>]",
+                     argv[i], argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.headless && options.replay_path.empty())
+    {
+        GFX_WARN("--headless only makes sense with --replay, ignoring it.");
+        options.headless = false;
+    }
+
+    if (!options.golden_path.empty() && !options.headless)
+    {
+        GFX_WARN("--golden only makes sense with --headless, ignoring it.");
+        options.golden_path.clear();
+    }
+
+    /* Headless runs never open a window, so they do not need GLFW (or a display) at all */
+    int exit_code = 0;
+    if (options.headless || glfwInit())
     {
         const auto title_string = "OpenGL Pacman "s + pac::VERSION_STRING;
-        pac::Game game(title_string, {pac::SCREEN_W, pac::SCREEN_H});
-        game.run();
+        pac::Game game(title_string, {pac::SCREEN_W, pac::SCREEN_H}, options);
+        exit_code = game.run() ? 0 : 1;
 
-        glfwTerminate();
+        if (!options.headless)
+        {
+            glfwTerminate();
+        }
     }
-    return 0;
+    return exit_code;
 }
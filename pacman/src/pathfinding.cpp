@@ -1,14 +1,44 @@
 #include "pathfinding.h"
 #include "level.h"
 #include "common.h"
-#include "robinhood/robinhood.h"
+#include "frame_arena.h"
 
 #include <queue>
+#include <limits>
 #include <vector>
 #include <type_traits>
 
 #include <gfx.h>
 
+namespace
+{
+/* Marks tiles that the search has not reached yet */
+const glm::ivec2 NO_TRACEBACK = {-1, -1};
+constexpr int NO_COST = std::numeric_limits<int>::max();
+
+/*!
+ * \brief trace_back walks the traceback from target to origin and pushes the directions taken onto out
+ * \param traceback contains the tile each tile was reached from, indexed by y * width + x
+ * \param size is the size of the level
+ */
+void trace_back(const std::pmr::vector<glm::ivec2>& traceback, glm::ivec2 origin, glm::ivec2 target, glm::ivec2 size,
+                std::stack<glm::ivec2>& out)
+{
+    const auto index = [width = size.x](glm::ivec2 pos) { return static_cast<std::size_t>(pos.y * width + pos.x); };
+
+    /* Leave the path empty if the target is outside of the level or could not be reached */
+    if (target.x < 0 || target.y < 0 || target.x >= size.x || target.y >= size.y || traceback[index(target)] == NO_TRACEBACK)
+    {
+        return;
+    }
+
+    for (auto it = target; it != origin; it = traceback[index(it)])
+    {
+        out.push(it - traceback[index(it)]);
+    }
+}
+}  // namespace
+
 pac::Path::Path(const pac::Level& graph, glm::ivec2 origin, glm::ivec2 target, ASTAR astartag)
     : m_creation_time(std::chrono::steady_clock::now())
 {
@@ -43,12 +73,17 @@ bool pac::Path::outdated() const
 
 void pac::Path::pathfind_bfs(const pac::Level& graph, glm::ivec2 origin, glm::ivec2 target) noexcept
 {
+    /* All scratch lives in the frame arena, indexed by tile (a level is only ever a few thousand tiles) */
+    auto& arena = get_frame_arena();
+    const auto size = graph.get_size();
+    const auto index = [width = size.x](glm::ivec2 pos) { return static_cast<std::size_t>(pos.y * width + pos.x); };
+
     /* Get neighbours and try all paths until we find target, or if we don't the Path will be empty */
-    std::queue<glm::ivec2> next_node = {};
+    std::queue<glm::ivec2, std::pmr::deque<glm::ivec2>> next_node{std::pmr::deque<glm::ivec2>(&arena)};
     next_node.push(origin);
 
-    robin_hood::unordered_map<glm::ivec2, glm::ivec2, detail::custom_ivec2_hash> traceback{};
-    traceback[origin] = origin;
+    std::pmr::vector<glm::ivec2> traceback(static_cast<std::size_t>(size.x * size.y), NO_TRACEBACK, &arena);
+    traceback[index(origin)] = origin;
 
     while (!next_node.empty())
     {
@@ -62,36 +97,41 @@ void pac::Path::pathfind_bfs(const pac::Level& graph, glm::ivec2 origin, glm::iv
 
         for (auto next : graph.get_neighbours(current))
         {
-            if (traceback.find(next) == traceback.end())
+            if (traceback[index(next)] == NO_TRACEBACK)
             {
                 next_node.push(next);
-                traceback[next] = current;
+                traceback[index(next)] = current;
             }
         }
     }
 
-    /* Do traceback into stack */
-    for (auto it = target; it != origin; it = traceback.at(it))
-    {
-        m_directions.push(it - traceback.at(it));
-    }
+    trace_back(traceback, origin, target, size, m_directions);
 }
 
 void pac::Path::pathfind_astar(const pac::Level& graph, glm::ivec2 origin, glm::ivec2 target) noexcept
 {
+    /* All scratch lives in the frame arena, indexed by tile (a level is only ever a few thousand tiles) */
+    auto& arena = get_frame_arena();
+    const auto size = graph.get_size();
+    const auto cells = static_cast<std::size_t>(size.x * size.y);
+    const auto index = [width = size.x](glm::ivec2 pos) { return static_cast<std::size_t>(pos.y * width + pos.x); };
+
     /* Get neighbours and try all paths until we find target, or if we don't the Path will be empty */
     using priority_pair = std::pair<int, glm::ivec2>;
     auto priority_func = [](const priority_pair& a, const priority_pair& b) { return a.first > b.first; };
 
-    /* Use a priority queue with heuristic */
-    std::priority_queue<priority_pair, std::vector<priority_pair>, decltype(priority_func)> next_node(priority_func);
-    next_node.push(priority_pair(0.0, origin));
+    /* Use a priority queue with heuristic (reserved up front, so it never reallocates inside the arena) */
+    std::pmr::vector<priority_pair> queue_storage(&arena);
+    queue_storage.reserve(cells);
+    std::priority_queue<priority_pair, std::pmr::vector<priority_pair>, decltype(priority_func)> next_node(
+        priority_func, std::move(queue_storage));
+    next_node.push(priority_pair(0, origin));
 
-    /* Keep a traceback map and a cost map (using robin hood hash map as it tested to be 2x the speed of std in this case) */
-    robin_hood::unordered_map<glm::ivec2, glm::ivec2, detail::custom_ivec2_hash> traceback{};
-    robin_hood::unordered_map<glm::ivec2, int, detail::custom_ivec2_hash> cost_so_far{};
-    traceback[origin] = origin;
-    cost_so_far[origin] = 0;
+    /* Keep a traceback map and a cost map (NO_COST marks tiles that have not been reached yet) */
+    std::pmr::vector<glm::ivec2> traceback(cells, NO_TRACEBACK, &arena);
+    std::pmr::vector<int> cost_so_far(cells, NO_COST, &arena);
+    traceback[index(origin)] = origin;
+    cost_so_far[index(origin)] = 0;
 
     while (!next_node.empty())
     {
@@ -106,19 +146,15 @@ void pac::Path::pathfind_astar(const pac::Level& graph, glm::ivec2 origin, glm::
         /* Apply heuristic while processing the map */
         for (auto next : graph.get_neighbours(current))
         {
-            int new_cost = cost_so_far[current] + 1;
-            if (cost_so_far.find(next) == cost_so_far.end() || new_cost < cost_so_far[next])
+            int new_cost = cost_so_far[index(current)] + 1;
+            if (new_cost < cost_so_far[index(next)])
             {
-                cost_so_far[next] = new_cost;
-                traceback[next] = current;
+                cost_so_far[index(next)] = new_cost;
+                traceback[index(next)] = current;
                 next_node.push(priority_pair(new_cost + manhattan_distance(next, target), next));
             }
         }
     }
 
-    /* Do traceback into stack */
-    for (auto it = target; it != origin; it = traceback.at(it))
-    {
-        m_directions.push(it - traceback.at(it));
-    }
+    trace_back(traceback, origin, target, size, m_directions);
 }
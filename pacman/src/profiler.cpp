@@ -0,0 +1,239 @@
+#include "profiler.h"
+
+#ifdef PAC_ENABLE_PROFILER
+
+#include "config.h"
+
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+#include <gfx.h>
+#include <imgui/imgui.h>
+
+namespace pac
+{
+namespace
+{
+/* Ring of the calling thread, looked up once per thread */
+thread_local Profiler::ThreadRing* t_thread_ring = nullptr;
+
+/* Innermost zone of the calling thread */
+thread_local const char* t_current_zone = nullptr;
+
+/* Height of one nesting level in the overlay timeline */
+constexpr float ZONE_HEIGHT = 18.f;
+
+/*!
+ * \brief zone_color picks a stable color for a zone name, so the same zone has the same color every frame
+ */
+ImU32 zone_color(const char* name)
+{
+    const auto hash = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(name) * 2654435761u);
+    return IM_COL32(80u + (hash & 0x7Fu), 80u + ((hash >> 8u) & 0x7Fu), 80u + ((hash >> 16u) & 0x7Fu), 255u);
+}
+}  // namespace
+
+ProfileZone::ProfileZone(const char* name) noexcept : m_name(name), m_start(Profiler::now()), m_parent(t_current_zone)
+{
+    ++get_profiler().thread_ring().depth;
+    t_current_zone = name;
+}
+
+ProfileZone::~ProfileZone() noexcept
+{
+    const auto end = Profiler::now();
+    auto& ring = get_profiler().thread_ring();
+    --ring.depth;
+    t_current_zone = m_parent;
+
+    /* Fill the record, then publish it by moving the head (the reader acquires the head before reading records) */
+    const auto head = ring.head.load(std::memory_order_relaxed);
+    auto& record = ring.records[head % PROFILER_RING_CAPACITY];
+    record.name.store(m_name, std::memory_order_relaxed);
+    record.start.store(m_start, std::memory_order_relaxed);
+    record.end.store(end, std::memory_order_relaxed);
+    record.depth.store(ring.depth, std::memory_order_relaxed);
+    ring.head.store(head + 1u, std::memory_order_release);
+}
+
+Profiler::Profiler() : m_frame_start(now()), m_previous_frame_start(m_frame_start), m_epoch(m_frame_start) {}
+
+int64_t Profiler::now() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* Profiler::current_zone() noexcept { return t_current_zone; }
+
+Profiler::ThreadRing& Profiler::thread_ring()
+{
+    if (!t_thread_ring)
+    {
+        auto ring = std::make_unique<ThreadRing>();
+        ring->records = std::make_unique<ThreadRing::Record[]>(PROFILER_RING_CAPACITY);
+
+        std::lock_guard lock(m_threads_mutex);
+        ring->index = static_cast<uint32_t>(m_threads.size());
+        t_thread_ring = m_threads.emplace_back(std::move(ring)).get();
+    }
+
+    return *t_thread_ring;
+}
+
+void Profiler::new_frame()
+{
+    m_previous_frame_start = m_frame_start;
+    m_frame_start = now();
+}
+
+void Profiler::toggle_overlay() { m_overlay_visible = !m_overlay_visible; }
+
+void Profiler::draw_overlay()
+{
+    if (!m_overlay_visible)
+    {
+        return;
+    }
+
+    /* Copy the previous (complete) frame, unless the view is paused so it can be inspected */
+    if (!m_overlay_paused)
+    {
+        m_overlay_frame_start = m_previous_frame_start;
+        m_overlay_frame_end = m_frame_start;
+        collect(m_overlay_frame_start, m_overlay_frame_end, m_overlay_zones);
+    }
+
+    ImGui::SetNextWindowSize({600.f, 240.f}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler", &m_overlay_visible);
+
+    const auto frame_ms = (m_overlay_frame_end - m_overlay_frame_start) / 1e6f;
+    ImGui::Text("Frame: %6.3fms  Zones: %zu", frame_ms, m_overlay_zones.size());
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &m_overlay_paused);
+    ImGui::SameLine();
+    if (ImGui::Button("Export Trace"))
+    {
+        export_chrome_trace("trace.json");
+    }
+
+    /* One row per thread, zones are laid out horizontally by time and vertically by depth */
+    auto* draw_list = ImGui::GetWindowDrawList();
+    const auto origin = ImGui::GetCursorScreenPos();
+    const auto width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+    const auto scale = width / std::max<float>(static_cast<float>(m_overlay_frame_end - m_overlay_frame_start), 1.f);
+
+    uint32_t max_depth = 0u;
+    uint32_t max_thread = 0u;
+    for (const auto& zone : m_overlay_zones)
+    {
+        max_depth = std::max(max_depth, zone.depth);
+        max_thread = std::max(max_thread, zone.thread);
+    }
+
+    const auto row_height = (max_depth + 1u) * ZONE_HEIGHT + 4.f;
+    const auto mouse = ImGui::GetMousePos();
+    for (const auto& zone : m_overlay_zones)
+    {
+        const auto x0 = origin.x + std::max<float>(static_cast<float>(zone.start - m_overlay_frame_start), 0.f) * scale;
+        const auto x1 = origin.x + std::min<float>(static_cast<float>(zone.end - m_overlay_frame_start), width / scale) * scale;
+        const auto y0 = origin.y + zone.thread * row_height + zone.depth * ZONE_HEIGHT;
+        const ImVec2 min = {x0, y0};
+        const ImVec2 max = {std::max(x1, x0 + 1.f), y0 + ZONE_HEIGHT - 1.f};
+
+        draw_list->AddRectFilled(min, max, zone_color(zone.name));
+        draw_list->PushClipRect(min, max, true);
+        draw_list->AddText({x0 + 2.f, y0 + 1.f}, IM_COL32_WHITE, zone.name);
+        draw_list->PopClipRect();
+
+        if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+        {
+            ImGui::SetTooltip("%s: %.4fms (thread %u)", zone.name, (zone.end - zone.start) / 1e6f, zone.thread);
+        }
+    }
+
+    ImGui::Dummy({width, (max_thread + 1u) * row_height});
+    ImGui::End();
+}
+
+void Profiler::collect(int64_t from, int64_t to, std::vector<Zone>& out) const
+{
+    out.clear();
+
+    /* Ring index of every zone copied from the current ring */
+    std::vector<uint64_t> indices = {};
+
+    std::lock_guard lock(m_threads_mutex);
+    for (const auto& ring : m_threads)
+    {
+        const auto head = ring->head.load(std::memory_order_acquire);
+        const auto first = head > PROFILER_RING_CAPACITY ? head - PROFILER_RING_CAPACITY : 0u;
+        const auto copied_from = out.size();
+        indices.clear();
+
+        for (auto i = first; i < head; ++i)
+        {
+            const auto& record = ring->records[i % PROFILER_RING_CAPACITY];
+            const Zone zone = {record.name.load(std::memory_order_relaxed), record.start.load(std::memory_order_relaxed),
+                               record.end.load(std::memory_order_relaxed), record.depth.load(std::memory_order_relaxed),
+                               ring->index};
+            if (zone.end > from && zone.start < to)
+            {
+                out.push_back(zone);
+                indices.push_back(i);
+            }
+        }
+
+        /* The owning thread kept writing while we copied. Every zone up to the head it has reached now, and the one it may be
+         * writing, overwrote the slot of the zone a ring earlier, so only the copies of those older zones are dropped. */
+        const auto head_now = ring->head.load(std::memory_order_acquire);
+        const auto valid_from = head_now + 1u > PROFILER_RING_CAPACITY ? head_now + 1u - PROFILER_RING_CAPACITY : 0u;
+        const auto lapped = static_cast<std::size_t>(
+            std::lower_bound(indices.begin(), indices.end(), valid_from) - indices.begin());
+        if (lapped > 0u)
+        {
+            GFX_DEBUG("Profiler thread %u overwrote %zu zones while they were collected, dropping them.", ring->index, lapped);
+            out.erase(out.begin() + static_cast<std::ptrdiff_t>(copied_from),
+                      out.begin() + static_cast<std::ptrdiff_t>(copied_from + lapped));
+        }
+    }
+}
+
+bool Profiler::export_chrome_trace(std::string_view fp) const
+{
+    std::vector<Zone> zones = {};
+    collect(m_epoch, now(), zones);
+
+    std::ofstream file(std::string(fp), std::ios::trunc);
+    if (!file)
+    {
+        GFX_WARN("Could not open %s to write the trace.", fp.data());
+        return false;
+    }
+
+    /* Complete ("X") events with timestamps in microseconds, see the Trace Event Format */
+    file << "{\"traceEvents\":[";
+    for (std::size_t i = 0u; i < zones.size(); ++i)
+    {
+        std::string name = zones[i].name;
+        name.erase(std::remove_if(name.begin(), name.end(), [](char c) { return c == '"' || c == '\\'; }), name.end());
+
+        file << (i > 0u ? ",\n" : "\n") << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << zones[i].thread
+             << ",\"ts\":" << (zones[i].start - m_epoch) / 1000.0 << ",\"dur\":" << (zones[i].end - zones[i].start) / 1000.0
+             << "}";
+    }
+    file << "\n]}\n";
+
+    GFX_INFO("Wrote %zu zones to %s.", zones.size(), fp.data());
+    return static_cast<bool>(file);
+}
+
+Profiler& get_profiler()
+{
+    static Profiler profiler{};
+    return profiler;
+}
+}  // namespace pac
+
+#endif
@@ -0,0 +1,187 @@
+/*!
+ * \file profiler.h contains a scoped CPU profiler. Zones are recorded with PAC_PROFILE_SCOPE into a lock-free ring buffer per
+ * thread, shown in an ImGui timeline (toggled with ACTION_TOGGLE_DEBUG) and can be exported to the Chrome trace format for
+ * chrome://tracing or about:tracing. When the PACMAN_PROFILER CMake option is off, the macros compile to nothing.
+ */
+
+#pragma once
+
+#ifdef PAC_ENABLE_PROFILER
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#define PAC_PROFILE_CONCAT_IMPL(a, b) a##b
+#define PAC_PROFILE_CONCAT(a, b) PAC_PROFILE_CONCAT_IMPL(a, b)
+
+/* Profile the rest of the current scope under the given name (must be a string with static storage, like a literal) */
+#define PAC_PROFILE_SCOPE(name) const ::pac::ProfileZone PAC_PROFILE_CONCAT(pac_profile_zone_, __LINE__)(name)
+
+/* Mark the start of a new frame (call once per frame, from the main thread) */
+#define PAC_PROFILE_FRAME() ::pac::get_profiler().new_frame()
+
+namespace pac
+{
+/*!
+ * \brief The ProfileZone class records the time between its construction and destruction as a zone on the current thread
+ */
+class ProfileZone
+{
+private:
+    /* Name of the zone */
+    const char* m_name = nullptr;
+
+    /* When the zone started in nanoseconds (see Profiler::now) */
+    int64_t m_start = 0;
+
+    /* Zone that was active on this thread when this one started */
+    const char* m_parent = nullptr;
+
+public:
+    explicit ProfileZone(const char* name) noexcept;
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone(ProfileZone&&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+    ProfileZone& operator=(ProfileZone&&) = delete;
+    ~ProfileZone() noexcept;
+};
+
+/*!
+ * \brief The Profiler class owns the per-thread zone rings, and knows how to show and export them
+ */
+class Profiler
+{
+public:
+    /*!
+     * \brief The Zone struct is a finished zone, copied out of a ring
+     */
+    struct Zone
+    {
+        const char* name = nullptr;
+        int64_t start = 0;
+        int64_t end = 0;
+        uint32_t depth = 0u;
+        uint32_t thread = 0u;
+    };
+
+    /*!
+     * \brief The ThreadRing struct is a single producer ring buffer of zones. Only the owning thread writes to it, while any
+     * thread may read it. Records are atomics so a reader racing the writer sees stale or new values, never torn ones, and
+     * readers drop the zones the writer may have overwritten while they were copying.
+     */
+    struct ThreadRing
+    {
+        struct Record
+        {
+            std::atomic<const char*> name{nullptr};
+            std::atomic<int64_t> start{0};
+            std::atomic<int64_t> end{0};
+            std::atomic<uint32_t> depth{0u};
+        };
+
+        /* PROFILER_RING_CAPACITY records */
+        std::unique_ptr<Record[]> records = nullptr;
+
+        /* Total number of zones ever written, the next write goes to head % capacity */
+        std::atomic<uint64_t> head{0u};
+
+        /* Current zone nesting depth (only touched by the owning thread) */
+        uint32_t depth = 0u;
+
+        /* Index of the thread in the registry, used as the thread id in traces */
+        uint32_t index = 0u;
+    };
+
+private:
+    /* Rings of every thread that has recorded a zone, rings are never removed so zones outlive their threads */
+    std::vector<std::unique_ptr<ThreadRing>> m_threads = {};
+
+    /* Guards m_threads (only taken when a thread records its first zone, or when reading) */
+    mutable std::mutex m_threads_mutex = {};
+
+    /* Start of the current and the previous frame */
+    int64_t m_frame_start = 0;
+    int64_t m_previous_frame_start = 0;
+
+    /* When the profiler was created, traces are relative to this */
+    int64_t m_epoch = 0;
+
+    /* Zones of the frame shown in the overlay (reused every frame) */
+    std::vector<Zone> m_overlay_zones = {};
+
+    /* Frame shown in the overlay */
+    int64_t m_overlay_frame_start = 0;
+    int64_t m_overlay_frame_end = 0;
+
+    /* Overlay state */
+    bool m_overlay_visible = false;
+    bool m_overlay_paused = false;
+
+public:
+    Profiler();
+
+    /*!
+     * \brief now returns the current time in nanoseconds on the clock used for all zones
+     */
+    static int64_t now() noexcept;
+
+    /*!
+     * \brief current_zone returns the name of the innermost zone on the calling thread, or nullptr outside of any zone. It does
+     * not allocate, so it is safe to call from the allocation tracker.
+     */
+    static const char* current_zone() noexcept;
+
+    /*!
+     * \brief thread_ring returns the ring of the calling thread, registering it if this is the first zone on the thread
+     */
+    ThreadRing& thread_ring();
+
+    /*!
+     * \brief new_frame marks the start of a new frame
+     */
+    void new_frame();
+
+    /*!
+     * \brief toggle_overlay shows or hides the ImGui timeline
+     */
+    void toggle_overlay();
+
+    /*!
+     * \brief draw_overlay draws the ImGui timeline of the previous frame if the overlay is visible. Call between ImGui::NewFrame
+     * and ImGui::Render.
+     */
+    void draw_overlay();
+
+    /*!
+     * \brief collect copies every zone that overlaps [from, to) out of all rings
+     * \param from is the start of the time range
+     * \param to is the end of the time range
+     * \param out receives the zones (it is cleared first)
+     */
+    void collect(int64_t from, int64_t to, std::vector<Zone>& out) const;
+
+    /*!
+     * \brief export_chrome_trace writes all zones still in the rings to a Chrome trace JSON file
+     * \param fp is the file path to write to
+     * \return true if the file was written
+     */
+    bool export_chrome_trace(std::string_view fp) const;
+};
+
+/*!
+ * \brief get_profiler returns the profiler singleton
+ */
+Profiler& get_profiler();
+}  // namespace pac
+
+#else
+
+#define PAC_PROFILE_SCOPE(name)
+#define PAC_PROFILE_FRAME()
+
+#endif
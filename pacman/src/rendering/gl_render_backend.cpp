@@ -0,0 +1,297 @@
+#include "gl_render_backend.h"
+#include "config.h"
+
+#include <array>
+#include <chrono>
+#include <numeric>
+#include <cstring>
+#include <algorithm>
+
+#include <gfx.h>
+#include <cglutil.h>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <imgui/imgui.h>
+#include <imgui/imgui_impl_opengl3.h>
+
+namespace pac
+{
+GLRenderBackend::GLRenderBackend(unsigned max_sprites)
+    : m_vao(std::vector<VertexArray::Attribute>{{{0u, 0u, 2, GL_FLOAT, offsetof(Vertex, pos), 0u},
+                                                 {1u, 0u, 2, GL_FLOAT, offsetof(Vertex, uv), 0u},
+                                                 {2u, 1u, 2, GL_SHORT, offsetof(InstanceVertex, pos), 1u},
+                                                 {3u, 1u, 2, GL_UNSIGNED_SHORT, offsetof(InstanceVertex, size), 1u},
+                                                 {4u, 1u, 4, GL_UNSIGNED_BYTE, offsetof(InstanceVertex, col), 1u},
+                                                 {5u, 1u, 1, GL_UNSIGNED_INT, offsetof(InstanceVertex, texture_id), 1u}}})
+{
+    /* Enable required OpenGL State (texture alpha blending) */
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    /* Create Shader Program */
+    prog = std::make_unique<ShaderProgram>(std::vector<cgl::ShaderStage>{{GL_VERTEX_SHADER, "res/shaders/sprite.vert"},
+                                                                         {GL_FRAGMENT_SHADER, "res/shaders/sprite.frag"}});
+
+    /* Use program and set sampler values to texture bind points right away, this state is stored in the program so we never
+     * need to update this ever again since the texture bind points will be fixed. */
+    prog->use();
+    std::vector<int> tmp(MAX_TEXTURES);
+    std::iota(tmp.begin(), tmp.end(), 0u);
+    glUniform1iv(0, tmp.size(), tmp.data());
+
+    /* Init sprite buffer */
+    glCreateBuffers(1, &m_sprite_buffer);
+
+    /* Quad is centered, so origin is at {0, 0}, will be scaled in instance data to reach proper size */
+    std::array<Vertex, 4> sprite_quad = {Vertex{{-0.5f, -0.5f}, {0.f, 0.f}}, Vertex{{0.5f, -0.5f}, {1.f, 0.f}},
+                                         Vertex{{0.5f, 0.5f}, {1.f, 1.f}}, Vertex{{-0.5f, 0.5f}, {0.f, 1.f}}};
+    std::array<GLuint, 6> sprite_indices = {0, 1, 2, 2, 3, 0};
+
+    /* Combine vertex and index data into one array and store everything in a single buffer (for locality) */
+    std::array<GLubyte, cgl::size_bytes(sprite_indices) + cgl::size_bytes(sprite_quad)> data = {};
+    memcpy(data.data(), sprite_indices.data(), cgl::size_bytes(sprite_indices));
+    memcpy(data.data() + cgl::size_bytes(sprite_indices), sprite_quad.data(), cgl::size_bytes(sprite_quad));
+
+    /* Combined Data for Initial Contents, not mappable, so Introspection will fail on this VAO */
+    glNamedBufferStorage(m_sprite_buffer, cgl::size_bytes(sprite_indices) + cgl::size_bytes(sprite_quad), data.data(), 0u);
+
+    /* Pre-Bind IBO and VBOs for the VAO */
+    glVertexArrayElementBuffer(m_vao, m_sprite_buffer);
+    glVertexArrayVertexBuffer(m_vao, 0u, m_sprite_buffer, cgl::size_bytes(sprite_indices), sizeof(Vertex));
+
+    /* Create the instance buffer ring with room for max_sprites number of sprites in each segment */
+    m_segment_fences.assign(INSTANCE_BUFFER_SEGMENTS, nullptr);
+    create_instance_buffer(max_sprites);
+
+    m_ubo.update(glm::ortho<float>(0.f, SCREEN_W, SCREEN_H, 0.f), glm::mat4(1.f));
+}
+
+GLRenderBackend::~GLRenderBackend()
+{
+    /* Make sure the GPU is done with every segment before the buffer goes away */
+    FrameStats discarded = {};
+    for (auto segment = 0u; segment < m_segment_fences.size(); ++segment)
+    {
+        wait_for_segment(segment, discarded);
+    }
+
+    /* Unmap the buffer when the renderer is destroyed */
+    glUnmapNamedBuffer(m_instance_buffer);
+    glDeleteBuffers(1, &m_sprite_buffer);
+    glDeleteBuffers(1, &m_instance_buffer);
+    glDeleteBuffers(1, &m_static_buffer);
+    glDeleteTextures(m_textures.size(), m_textures.data());
+}
+
+unsigned GLRenderBackend::create_texture(const std::vector<cgl::LoadedTexture>& layers)
+{
+    GLuint tex_id = 0u;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &tex_id);
+    glTextureParameteri(tex_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(tex_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(tex_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTextureParameteri(tex_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+    /* Allocate and transfer data to Texture */
+    glTextureStorage3D(tex_id, 1, GL_RGBA8, layers[0].width, layers[0].height, layers.size());
+    for (int i = 0; i < static_cast<int>(layers.size()); ++i)
+    {
+        glTextureSubImage3D(tex_id, 0, 0, 0, i, layers[i].width, layers[i].height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                            layers[i].pixels.data());
+    }
+
+    m_textures.push_back(tex_id);
+    return tex_id;
+}
+
+void GLRenderBackend::update_static_layer(const std::vector<InstanceVertex>& instances, unsigned dirty_begin,
+                                          unsigned dirty_end, FrameStats& stats)
+{
+    /* Recreate the buffer if the layer has outgrown it (only happens when a bigger level is loaded) */
+    if (instances.size() > m_static_capacity)
+    {
+        glDeleteBuffers(1, &m_static_buffer);
+        m_static_capacity = static_cast<unsigned>(instances.size());
+        glCreateBuffers(1, &m_static_buffer);
+        glNamedBufferStorage(m_static_buffer, m_static_capacity * sizeof(InstanceVertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        dirty_begin = 0u;
+        dirty_end = m_static_capacity;
+    }
+
+    /* Upload the dirty range only */
+    const auto byte_count = (dirty_end - dirty_begin) * sizeof(InstanceVertex);
+    glNamedBufferSubData(m_static_buffer, dirty_begin * sizeof(InstanceVertex), byte_count, instances.data() + dirty_begin);
+    stats.bytes_uploaded += byte_count;
+}
+
+void GLRenderBackend::draw_frame(const RenderFrame& frame, FrameStats& stats)
+{
+    /* Grow the ring if this frame does not fit in one segment. Past the max capacity we split the frame into batches instead */
+    if (frame.order.size() > m_segment_capacity && m_segment_capacity < INSTANCE_SEGMENT_MAX_CAPACITY)
+    {
+        grow_instance_buffer(frame.order.size(), stats);
+    }
+
+    /* Prepare state (only needs to bind VAO since it knows about it's resources already. Also bind all textures to their
+     *  respective texture units (from 0 an onward to N). */
+    prog->use();
+    m_ubo.bind(0);
+    glBindVertexArray(m_vao);
+    glBindTextures(0, m_textures.size(), m_textures.data());
+
+    /* Enable post processing */
+    if (m_post_enabled)
+    {
+        m_post_processor.capture();
+        draw_instances(frame, stats);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        m_post_processor.process();
+    }
+    /* Or don't */
+    else
+    {
+        draw_instances(frame, stats);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
+
+    stats.segment_capacity = m_segment_capacity;
+}
+
+void GLRenderBackend::read_pixels(std::vector<uint8_t>& out_pixels)
+{
+    constexpr auto row_size = SCREEN_W * 4u;
+    out_pixels.resize(row_size * SCREEN_H);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0u);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadnPixels(0, 0, SCREEN_W, SCREEN_H, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(out_pixels.size()),
+                  out_pixels.data());
+
+    /* OpenGL reads the bottom row first, so flip it */
+    for (auto y = 0u; y < SCREEN_H / 2u; ++y)
+    {
+        std::swap_ranges(out_pixels.begin() + y * row_size, out_pixels.begin() + (y + 1u) * row_size,
+                         out_pixels.begin() + (SCREEN_H - 1u - y) * row_size);
+    }
+}
+
+void GLRenderBackend::set_post_enabled(bool flag) { m_post_enabled = flag; }
+
+void GLRenderBackend::create_instance_buffer(unsigned segment_capacity)
+{
+    m_segment_capacity = segment_capacity;
+    m_current_segment = 0u;
+    const auto buffer_size = INSTANCE_BUFFER_SEGMENTS * segment_capacity * sizeof(InstanceVertex);
+
+    /* Create and allocate space for all segments */
+    glCreateBuffers(1, &m_instance_buffer);
+    glNamedBufferStorage(m_instance_buffer, buffer_size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+
+    /* Immediately map the buffer persistently */
+    m_mapped_instance_buffer = glMapNamedBufferRange(m_instance_buffer, 0, buffer_size,
+                                                     GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+
+    glVertexArrayVertexBuffer(m_vao, 1u, m_instance_buffer, 0u, sizeof(InstanceVertex));
+}
+
+void GLRenderBackend::grow_instance_buffer(std::size_t required, FrameStats& stats)
+{
+    /* The GPU may still be reading any of the segments, so wait for all of them before the buffer is replaced */
+    for (auto segment = 0u; segment < m_segment_fences.size(); ++segment)
+    {
+        wait_for_segment(segment, stats);
+    }
+
+    auto new_capacity = m_segment_capacity;
+    while (new_capacity < required && new_capacity < INSTANCE_SEGMENT_MAX_CAPACITY)
+    {
+        new_capacity *= 2u;
+    }
+    new_capacity = std::min(new_capacity, INSTANCE_SEGMENT_MAX_CAPACITY);
+
+    GFX_INFO("Growing instance buffer segments from %u to %u sprites.", m_segment_capacity, new_capacity);
+    glUnmapNamedBuffer(m_instance_buffer);
+    glDeleteBuffers(1, &m_instance_buffer);
+    create_instance_buffer(new_capacity);
+}
+
+void GLRenderBackend::wait_for_segment(unsigned segment, FrameStats& stats)
+{
+    auto& fence = m_segment_fences[segment];
+    if (!fence)
+    {
+        return;
+    }
+
+    /* Check without blocking first, this is the common case when the GPU keeps up */
+    auto result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0u);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        const auto wait_start = std::chrono::steady_clock::now();
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000u);
+        }
+
+        stats.fence_wait_ms += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - wait_start).count();
+        stats.fence_stalled = true;
+    }
+
+    if (result == GL_WAIT_FAILED)
+    {
+        GFX_ERROR("Waiting for instance buffer segment %u failed.", segment);
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void GLRenderBackend::draw_instances(const RenderFrame& frame, FrameStats& stats)
+{
+    draw_dynamic_range(frame, 0u, frame.split, stats);
+
+    /* Then the static layer, so the tiles are drawn in their place in the layer order */
+    if (!frame.static_instances.empty())
+    {
+        glVertexArrayVertexBuffer(m_vao, 1u, m_static_buffer, 0u, sizeof(InstanceVertex));
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(frame.static_instances.size()));
+        glVertexArrayVertexBuffer(m_vao, 1u, m_instance_buffer, 0u, sizeof(InstanceVertex));
+    }
+
+    draw_dynamic_range(frame, frame.split, frame.order.size(), stats);
+}
+
+void GLRenderBackend::draw_dynamic_range(const RenderFrame& frame, std::size_t first, std::size_t last, FrameStats& stats)
+{
+    /* Upload and draw the instances, each batch filling at most one segment of the ring */
+    for (auto batch_first = first; batch_first < last; batch_first += m_segment_capacity)
+    {
+        const auto count = std::min<std::size_t>(m_segment_capacity, last - batch_first);
+
+        /* The GPU may still be reading this segment from a previous batch, so wait for its fence before overwriting it */
+        wait_for_segment(m_current_segment, stats);
+
+        /* Write data to GPU in sorted order (The buffer is persistently mapped and explicitly flushed after profiling showed that
+         * mapping every frame was very expensive) */
+        const auto segment_offset = m_current_segment * m_segment_capacity * sizeof(InstanceVertex);
+        auto* segment_data = reinterpret_cast<InstanceVertex*>(static_cast<GLubyte*>(m_mapped_instance_buffer) + segment_offset);
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+            segment_data[i] = frame.instances[static_cast<uint32_t>(frame.order[batch_first + i])];
+        }
+        glFlushMappedNamedBufferRange(m_instance_buffer, segment_offset, count * sizeof(InstanceVertex));
+
+        /* The base instance selects the segment of the ring that was just written */
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(count),
+                                            m_current_segment * m_segment_capacity);
+
+        /* Fence the segment so we know when the GPU is done with it, then move on to the next one */
+        m_segment_fences[m_current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0u);
+        m_current_segment = (m_current_segment + 1u) % INSTANCE_BUFFER_SEGMENTS;
+
+        stats.bytes_uploaded += count * sizeof(InstanceVertex);
+        ++stats.batches;
+    }
+}
+}  // namespace pac
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "render_backend.h"
+#include "shader_program.h"
+#include "post_processing.h"
+#include "vertex_array_object.h"
+#include "uniform_buffer_object.h"
+
+#include <memory>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/mat4x4.hpp>
+
+/* Forward declare the GL sync object type to avoid including glad in this header */
+typedef struct __GLsync* GLsync;
+
+namespace pac
+{
+namespace detail
+{
+struct MatrixData
+{
+    glm::mat4 proj_matrix = glm::mat4(1.f);
+    glm::mat4 view_matrix = glm::mat4(1.f);
+};
+}  // namespace detail
+
+/*!
+ * \brief The GLRenderBackend class draws with OpenGL 4.5. It uses a single, large buffer starting with vertex and index data
+ * for the one instanced quad. Per-instance data for all the sprites in the game lives in a persistently mapped ring of
+ * segments, one per frame in flight, each guarded by a fence. Segments grow when a frame has more sprites than fit, and beyond
+ * INSTANCE_SEGMENT_MAX_CAPACITY a frame is split into several batches. The static layer lives in its own buffer that is only
+ * updated in the dirty range.
+ */
+class GLRenderBackend : public RenderBackend
+{
+private:
+    /*!
+     * \brief The Vertex struct is the vertex layout for the sprite quad
+     */
+    struct Vertex
+    {
+        glm::vec2 pos = {};
+        glm::vec2 uv = {};
+    };
+
+    void* m_mapped_instance_buffer = nullptr;
+
+    /* Buffer that contains sprite data, vertices and indices like [INDEX DATA ... VERTEX DATA] */
+    unsigned m_sprite_buffer = 0u;
+
+    /* Buffer that contains per-instance data, split into INSTANCE_BUFFER_SEGMENTS segments of m_segment_capacity instances */
+    unsigned m_instance_buffer = 0u;
+
+    /* Number of instances that fit in one segment of the instance buffer */
+    unsigned m_segment_capacity = 0u;
+
+    /* Segment of the instance buffer that the next frame writes to */
+    unsigned m_current_segment = 0u;
+
+    /* One fence per segment, signaled when the GPU is done reading from that segment */
+    std::vector<GLsync> m_segment_fences = {};
+
+    /* GPU buffer holding the retained static layer, and the number of instances it has room for */
+    unsigned m_static_buffer = 0u;
+    unsigned m_static_capacity = 0u;
+
+    /* Vector of all created textures, bound to texture units in order */
+    std::vector<unsigned> m_textures = {};
+
+    /* Post processor for applying post effects */
+    PostProcessor m_post_processor = {};
+
+    /* Vertex attribute layout */
+    VertexArray m_vao = {};
+
+    /* Shader program (unique_ptr) since it has no default Ctor */
+    std::unique_ptr<ShaderProgram> prog = nullptr;
+
+    /* Matrix UBO */
+    UniformBuffer<detail::MatrixData> m_ubo = {};
+
+    /* Post processing enabled or not */
+    bool m_post_enabled = true;
+
+public:
+    explicit GLRenderBackend(unsigned max_sprites);
+
+    GLRenderBackend(const GLRenderBackend&) = delete;
+    GLRenderBackend(GLRenderBackend&&) = delete;
+    GLRenderBackend& operator=(const GLRenderBackend&) = delete;
+    GLRenderBackend& operator=(GLRenderBackend&&) = delete;
+    ~GLRenderBackend() override;
+
+    unsigned create_texture(const std::vector<cgl::LoadedTexture>& layers) override;
+
+    void update_static_layer(const std::vector<InstanceVertex>& instances, unsigned dirty_begin, unsigned dirty_end,
+                             FrameStats& stats) override;
+
+    void draw_frame(const RenderFrame& frame, FrameStats& stats) override;
+
+    void read_pixels(std::vector<uint8_t>& out_pixels) override;
+
+    void set_post_enabled(bool flag) override;
+
+private:
+    /*!
+     * \brief create_instance_buffer creates and persistently maps the instance buffer ring with the given segment capacity
+     * \param segment_capacity is the number of instances per segment
+     */
+    void create_instance_buffer(unsigned segment_capacity);
+
+    /*!
+     * \brief grow_instance_buffer waits for the GPU to finish with the ring, then recreates it with room for at least required
+     * instances per segment (capped at INSTANCE_SEGMENT_MAX_CAPACITY)
+     * \param required is the number of instances that should fit in one segment
+     * \param stats are the statistics of the current frame
+     */
+    void grow_instance_buffer(std::size_t required, FrameStats& stats);
+
+    /*!
+     * \brief wait_for_segment blocks until the GPU has finished reading from the given instance buffer segment
+     * \param segment is the segment index to wait for
+     * \param stats are the statistics of the current frame
+     */
+    void wait_for_segment(unsigned segment, FrameStats& stats);
+
+    /*!
+     * \brief draw_instances draws the sorted dynamic instances below the static layer, then the static layer and then the rest
+     * of the dynamic instances
+     */
+    void draw_instances(const RenderFrame& frame, FrameStats& stats);
+
+    /*!
+     * \brief draw_dynamic_range uploads and draws a range of the sorted dynamic instances in batches of at most one ring
+     * segment each
+     * \param first is the first sorted instance to draw
+     * \param last is one past the last sorted instance to draw
+     */
+    void draw_dynamic_range(const RenderFrame& frame, std::size_t first, std::size_t last, FrameStats& stats);
+};
+}  // namespace pac
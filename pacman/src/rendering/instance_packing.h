@@ -0,0 +1,132 @@
+/*!
+ * \file instance_packing.h contains the packed per-instance sprite data (InstanceVertex) and its encoding, which is shared by
+ * the render backends and sprite.vert. Positions and sizes are 12.4 fixed point and colours are 8 bit unorm. Everything is
+ * constexpr so the round trip is verified by the static asserts at the bottom of this file every time it is compiled.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief The InstanceVertex struct is the packed vertex layout of per-instance sprite instantiations. Position and size
+ * are 12.4 fixed point, the colour is RGBA8 and the texture id is a packed TextureID
+ */
+struct InstanceVertex
+{
+    int16_t pos[2] = {};
+    uint16_t size[2] = {};
+    uint8_t col[4] = {};
+    uint32_t texture_id = {};
+};
+
+static_assert(sizeof(InstanceVertex) == 16u, "Packed instance data should be 16 bytes");
+
+namespace detail
+{
+/* Positions and sizes have 4 fractional bits, so 1/16th of a pixel precision, covering [-2048, 2048) and [0, 4096) pixels */
+constexpr float FIXED_POINT_SCALE = 16.f;
+
+constexpr int32_t round_to_int(float value) { return static_cast<int32_t>(value >= 0.f ? value + .5f : value - .5f); }
+
+constexpr int32_t clamp_int(int32_t value, int32_t lo, int32_t hi) { return value < lo ? lo : (value > hi ? hi : value); }
+
+constexpr float abs_float(float value) { return value < 0.f ? -value : value; }
+
+constexpr int16_t encode_position(float value)
+{
+    return static_cast<int16_t>(clamp_int(round_to_int(value * FIXED_POINT_SCALE), INT16_MIN, INT16_MAX));
+}
+
+constexpr float decode_position(int16_t value) { return value / FIXED_POINT_SCALE; }
+
+constexpr uint16_t encode_size(float value)
+{
+    return static_cast<uint16_t>(clamp_int(round_to_int(value * FIXED_POINT_SCALE), 0, UINT16_MAX));
+}
+
+constexpr float decode_size(uint16_t value) { return value / FIXED_POINT_SCALE; }
+
+constexpr uint8_t encode_unorm8(float value) { return static_cast<uint8_t>(clamp_int(round_to_int(value * 255.f), 0, 255)); }
+
+constexpr float decode_unorm8(uint8_t value) { return value / 255.f; }
+
+/*!
+ * \brief positions_round_trip checks every position from one tile outside the screen to one tile past it, in (non dyadic)
+ * steps of a tenth of a pixel, and makes sure the decoded value is within 1/32th of a pixel of the original. That is far
+ * below what the rasterizer can resolve at the game's resolution.
+ */
+constexpr bool positions_round_trip()
+{
+    constexpr auto extent = static_cast<int32_t>(SCREEN_W > SCREEN_H ? SCREEN_W : SCREEN_H) + TILE_SIZE<int32_t>;
+    for (auto i = -TILE_SIZE<int32_t> * 10; i <= extent * 10; ++i)
+    {
+        const auto value = i * .1f;
+        if (abs_float(decode_position(encode_position(value)) - value) > 1.f / 32.f)
+        {
+            return false;
+        }
+
+        if (value >= 0.f && abs_float(decode_size(encode_size(value)) - value) > 1.f / 32.f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief tile_positions_are_exact checks that the center of every tile on the screen (where most sprites are drawn) and the
+ * tile size survive the round trip without any error at all
+ */
+constexpr bool tile_positions_are_exact()
+{
+    for (auto i = 0; i <= static_cast<int>(SCREEN_H / TILE_SIZE<unsigned>); ++i)
+    {
+        const auto value = HALF_TILE + i * TILE_SIZE<float>;
+        if (decode_position(encode_position(value)) != value)
+        {
+            return false;
+        }
+    }
+
+    return decode_size(encode_size(TILE_SIZE<float>)) == TILE_SIZE<float> &&
+           decode_size(encode_size(static_cast<float>(SCREEN_H))) == static_cast<float>(SCREEN_H);
+}
+
+/*!
+ * \brief colours_round_trip checks that every 8 bit value survives the round trip, and that any tint in [0, 1] is within half
+ * a step of the original (so no visible banding compared to the 8 bit framebuffer)
+ */
+constexpr bool colours_round_trip()
+{
+    for (auto i = 0; i < 256; ++i)
+    {
+        if (encode_unorm8(decode_unorm8(static_cast<uint8_t>(i))) != i)
+        {
+            return false;
+        }
+    }
+
+    for (auto i = 0; i <= 1000; ++i)
+    {
+        const auto value = i / 1000.f;
+        if (abs_float(decode_unorm8(encode_unorm8(value)) - value) > .5f / 255.f + 1e-6f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(positions_round_trip(), "Packed positions and sizes lose visible precision at the game's resolution");
+static_assert(tile_positions_are_exact(), "Tile aligned positions and sizes must be exact in the packed format");
+static_assert(colours_round_trip(), "Packed colours must round trip to the same 8 bit value");
+}  // namespace detail
+}  // namespace pac
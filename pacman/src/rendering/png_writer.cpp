@@ -0,0 +1,105 @@
+#include "png_writer.h"
+#include "common.h"
+
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+#include <gfx.h>
+
+namespace pac
+{
+namespace
+{
+void push_u32(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24u));
+    out.push_back(static_cast<uint8_t>(value >> 16u));
+    out.push_back(static_cast<uint8_t>(value >> 8u));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+/*!
+ * \brief write_chunk writes a PNG chunk (length, type, data and the CRC of type and data)
+ */
+void write_chunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk = {};
+    chunk.reserve(data.size() + 12u);
+    push_u32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    push_u32(chunk, crc32(chunk.data() + 4u, data.size() + 4u) ^ 0xFFFFFFFFu);
+    file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+}  // namespace
+
+bool write_png(std::string_view fp, unsigned width, unsigned height, const std::vector<uint8_t>& rgba)
+{
+    const auto row_size = width * 4u;
+    if (rgba.size() < static_cast<std::size_t>(row_size) * height)
+    {
+        GFX_WARN("Not writing %s, expected %u bytes of pixels but got %zu.", fp.data(), row_size * height, rgba.size());
+        return false;
+    }
+
+    std::ofstream file(std::string(fp), std::ios::binary);
+    if (!file)
+    {
+        GFX_WARN("Could not open %s for writing.", fp.data());
+        return false;
+    }
+
+    /* Signature and header (8 bit RGBA, no interlacing) */
+    constexpr uint8_t signature[] = {0x89u, 'P', 'N', 'G', '\r', '\n', 0x1Au, '\n'};
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header = {};
+    push_u32(header, width);
+    push_u32(header, height);
+    header.insert(header.end(), {8u, 6u, 0u, 0u, 0u});
+    write_chunk(file, "IHDR", header);
+
+    /* Raw image data is every row prefixed with filter type 0 (None) */
+    std::vector<uint8_t> raw = {};
+    raw.reserve((row_size + 1u) * height);
+    for (auto y = 0u; y < height; ++y)
+    {
+        raw.push_back(0u);
+        raw.insert(raw.end(), rgba.begin() + y * row_size, rgba.begin() + (y + 1u) * row_size);
+    }
+
+    /* Wrap it in a zlib stream of stored deflate blocks (at most 65535 bytes each), followed by the adler32 checksum */
+    std::vector<uint8_t> zlib = {0x78u, 0x01u};
+    zlib.reserve(raw.size() + raw.size() / 65535u * 5u + 16u);
+    for (std::size_t offset = 0u; offset < raw.size() || offset == 0u;)
+    {
+        const auto block_size = static_cast<uint16_t>(std::min<std::size_t>(65535u, raw.size() - offset));
+        const auto last = offset + block_size >= raw.size();
+        zlib.push_back(last ? 1u : 0u);
+        zlib.push_back(static_cast<uint8_t>(block_size));
+        zlib.push_back(static_cast<uint8_t>(block_size >> 8u));
+        zlib.push_back(static_cast<uint8_t>(~block_size));
+        zlib.push_back(static_cast<uint8_t>(~block_size >> 8u));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + block_size);
+        offset += block_size;
+        if (last)
+        {
+            break;
+        }
+    }
+
+    uint32_t a = 1u;
+    uint32_t b = 0u;
+    for (const auto byte : raw)
+    {
+        a = (a + byte) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    push_u32(zlib, (b << 16u) | a);
+
+    write_chunk(file, "IDAT", zlib);
+    write_chunk(file, "IEND", {});
+    return static_cast<bool>(file);
+}
+}  // namespace pac
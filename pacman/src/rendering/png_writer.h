@@ -0,0 +1,23 @@
+/*!
+ * \file png_writer.h contains a minimal PNG encoder for dumping framebuffers. It writes uncompressed (stored) deflate blocks,
+ * which is plenty for captures and golden images, and keeps us from pulling in another dependency.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+namespace pac
+{
+/*!
+ * \brief write_png writes RGBA8 pixels to a PNG file
+ * \param fp is the file path to write to
+ * \param width is the width of the image in pixels
+ * \param height is the height of the image in pixels
+ * \param rgba is the tightly packed pixel data, top row first
+ * \return true if the file was written
+ */
+bool write_png(std::string_view fp, unsigned width, unsigned height, const std::vector<uint8_t>& rgba);
+}  // namespace pac
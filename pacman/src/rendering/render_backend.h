@@ -0,0 +1,122 @@
+#pragma once
+
+#include "instance_packing.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <cglutil.h>
+
+namespace pac
+{
+/*!
+ * \brief The ERenderBackend enum lists the available render backends
+ */
+enum class ERenderBackend
+{
+    OpenGL,
+    Software
+};
+
+/*!
+ * \brief The FrameStats struct contains statistics about the last submitted frame
+ */
+struct FrameStats
+{
+    /* Instances submitted with draw this frame */
+    unsigned dynamic_instances = 0u;
+
+    /* Instances drawn from the retained static layer (not re-uploaded unless dirty) */
+    unsigned static_instances = 0u;
+
+    /* Draw calls issued for the dynamic instances (one per instance buffer segment used) */
+    unsigned batches = 0u;
+
+    /* Number of instances each instance buffer segment currently has room for */
+    unsigned segment_capacity = 0u;
+
+    /* Bytes of instance data copied to the GPU this frame */
+    std::size_t bytes_uploaded = 0u;
+
+    /* CPU time spent in submit_work in milliseconds */
+    float submit_ms = 0.f;
+
+    /* CPU time spent sorting the sprites by layer and depth in milliseconds */
+    float sort_ms = 0.f;
+
+    /* CPU time spent by the backend drawing the frame in milliseconds (for the software backend, this is all rasterization) */
+    float backend_ms = 0.f;
+
+    /* CPU time spent waiting for the GPU to release the ring segment in milliseconds */
+    float fence_wait_ms = 0.f;
+
+    /* True if the segment fence had not signaled yet, so the CPU had to block */
+    bool fence_stalled = false;
+};
+
+/*!
+ * \brief The RenderFrame struct is everything a backend needs to draw one frame. Dynamic instances are drawn in the order
+ * given by the low 32 bits of order, those before split go beneath the static layer and the rest on top of it.
+ */
+struct RenderFrame
+{
+    /* Dynamic instances in submission order */
+    const std::vector<InstanceVertex>& instances;
+
+    /* Sorted sort keys with an index into instances in the low 32 bits */
+    const std::vector<uint64_t>& order;
+
+    /* Index into order of the first instance above the static layer */
+    std::size_t split = 0u;
+
+    /* Retained static layer instances, empty if the layer should not be drawn this frame */
+    const std::vector<InstanceVertex>& static_instances;
+};
+
+/*!
+ * \brief The RenderBackend class is the interface the Renderer draws through. The Renderer collects, packs and sorts sprites and
+ * owns the texture cache, while the backend owns whatever it needs to get pixels on the screen (or into memory).
+ */
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    /*!
+     * \brief create_texture creates a texture array from the given RGBA8 layers (all layers are the same size)
+     * \param layers is the pixel data for every layer of the array
+     * \return a backend handle for the texture (for the OpenGL backend this is the GL texture name, usable with ImGui)
+     */
+    virtual unsigned create_texture(const std::vector<cgl::LoadedTexture>& layers) = 0;
+
+    /*!
+     * \brief update_static_layer is called when instances [dirty_begin, dirty_end) of the static layer changed
+     * \param instances is the full static layer
+     * \param dirty_begin is the first changed instance
+     * \param dirty_end is one past the last changed instance
+     * \param stats are the statistics of the current frame
+     */
+    virtual void update_static_layer(const std::vector<InstanceVertex>& instances, unsigned dirty_begin, unsigned dirty_end,
+                                     FrameStats& stats) = 0;
+
+    /*!
+     * \brief draw_frame draws the given frame, including the ImGui draw data if the backend supports it
+     * \param frame is the frame to draw
+     * \param stats are the statistics of the current frame
+     */
+    virtual void draw_frame(const RenderFrame& frame, FrameStats& stats) = 0;
+
+    /*!
+     * \brief read_pixels reads back the last drawn frame as tightly packed RGBA8 rows, top row first
+     * \param out_pixels receives SCREEN_W * SCREEN_H * 4 bytes
+     */
+    virtual void read_pixels(std::vector<uint8_t>& out_pixels) = 0;
+
+    /*!
+     * \brief set_post_enabled allow you to enable or disable post processing, backends without post processing ignore it
+     * \param flag is the value to set
+     */
+    virtual void set_post_enabled(bool flag) = 0;
+};
+}  // namespace pac
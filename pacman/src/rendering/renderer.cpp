@@ -1,79 +1,62 @@
 #include "renderer.h"
 #include "config.h"
+#include "profiler.h"
+#include "png_writer.h"
+#include "sprite_sort.h"
+#include "stb_image.h"
+#include "gl_render_backend.h"
+#include "software_render_backend.h"
 
 #include <array>
-#include <numeric>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
 
 #include <gfx.h>
 #include <sstream>
-#include <cstring>
 #include <cglutil.h>
 #include <glad/glad.h>
-#include <glm/gtc/type_ptr.hpp>
-#include <glm/gtc/matrix_transform.hpp>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_opengl3.h>
 
 namespace pac
 {
-Renderer::Renderer(unsigned max_sprites)
-    : m_vao(std::vector<VertexArray::Attribute>{{{0u, 0u, 2, GL_FLOAT, offsetof(Vertex, pos), 0u},
-                                                 {1u, 0u, 2, GL_FLOAT, offsetof(Vertex, uv), 0u},
-                                                 {2u, 1u, 2, GL_FLOAT, offsetof(InstanceVertex, pos), 1u},
-                                                 {3u, 1u, 2, GL_FLOAT, offsetof(InstanceVertex, size), 1u},
-                                                 {4u, 1u, 3, GL_FLOAT, offsetof(InstanceVertex, col), 1u},
-                                                 {5u, 1u, 1, GL_UNSIGNED_INT, offsetof(InstanceVertex, texture_id), 1u}}})
+namespace
 {
-    init(max_sprites);
-    m_ubo.update(glm::ortho<float>(0.f, SCREEN_W, SCREEN_H, 0.f), glm::mat4(1.f));
-}
-
-void Renderer::init(unsigned max_sprites)
-{
-    /* Enable required OpenGL State (texture alpha blending) */
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    /* Create Shader Program */
-    prog = std::make_unique<ShaderProgram>(std::vector<cgl::ShaderStage>{{GL_VERTEX_SHADER, "res/shaders/sprite.vert"},
-                                                                         {GL_FRAGMENT_SHADER, "res/shaders/sprite.frag"}});
-
-    /* Use program and set sampler values to texture bind points right away, this state is stored in the program so we never
-     * need to update this ever again since the texture bind points will be fixed. */
-    prog->use();
-    std::vector<int> tmp(MAX_TEXTURES);
-    std::iota(tmp.begin(), tmp.end(), 0u);
-    glUniform1iv(0, tmp.size(), tmp.data());
-
-    /* Init sprite buffer */
-    glCreateBuffers(1, &m_sprite_buffer);
-
-    /* Quad is centered, so origin is at {0, 0}, will be scaled in instance data to reach proper size */
-    std::array<Vertex, 4> sprite_quad = {Vertex{{-0.5f, -0.5f}, {0.f, 0.f}}, Vertex{{0.5f, -0.5f}, {1.f, 0.f}},
-                                         Vertex{{0.5f, 0.5f}, {1.f, 1.f}}, Vertex{{-0.5f, 0.5f}, {0.f, 1.f}}};
-    std::array<GLuint, 6> sprite_indices = {0, 1, 2, 2, 3, 0};
+/* Backend requested with set_render_backend, if any */
+std::optional<ERenderBackend> g_requested_backend = std::nullopt;
 
-    /* Combine vertex and index data into one array and store everything in a single buffer (for locality) */
-    std::array<GLubyte, cgl::size_bytes(sprite_indices) + cgl::size_bytes(sprite_quad)> data = {};
-    memcpy(data.data(), sprite_indices.data(), cgl::size_bytes(sprite_indices));
-    memcpy(data.data() + cgl::size_bytes(sprite_indices), sprite_quad.data(), cgl::size_bytes(sprite_quad));
+/* Set once the renderer has been created, so late calls to set_render_backend can be caught */
+bool g_renderer_created = false;
 
-    /* Combined Data for Initial Contents, not mappable, so Introspection will fail on this VAO */
-    glNamedBufferStorage(m_sprite_buffer, cgl::size_bytes(sprite_indices) + cgl::size_bytes(sprite_quad), data.data(), 0u);
+ERenderBackend render_backend_from_environment()
+{
+    const auto* value = std::getenv("PAC_RENDER_BACKEND");
+    if (value && std::string_view(value) == "software")
+    {
+        return ERenderBackend::Software;
+    }
 
-    /* Create and allocate space for max_sprites number of sprites */
-    glCreateBuffers(1, &m_instance_buffer);
-    glNamedBufferStorage(m_instance_buffer, max_sprites * sizeof(InstanceVertex), nullptr,
-                         GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+    if (value && std::string_view(value) != "opengl")
+    {
+        GFX_WARN("Unknown render backend '%s' in PAC_RENDER_BACKEND, using OpenGL.", value);
+    }
 
-    /* Immediately map the buffer persistently */
-    m_mapped_instance_buffer = glMapNamedBufferRange(m_instance_buffer, 0, max_sprites * sizeof(InstanceVertex),
-                                                     GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+    return ERenderBackend::OpenGL;
+}
+}  // namespace
 
-    /* Pre-Bind IBO and VBOs for the VAO */
-    glVertexArrayElementBuffer(m_vao, m_sprite_buffer);
-    glVertexArrayVertexBuffer(m_vao, 0u, m_sprite_buffer, cgl::size_bytes(sprite_indices), sizeof(Vertex));
-    glVertexArrayVertexBuffer(m_vao, 1u, m_instance_buffer, 0u, sizeof(InstanceVertex));
+Renderer::Renderer(unsigned max_sprites, ERenderBackend backend) : m_backend_type(backend)
+{
+    if (backend == ERenderBackend::Software)
+    {
+        GFX_INFO("Using the software render backend.");
+        m_backend = std::make_unique<SoftwareRenderBackend>();
+    }
+    else
+    {
+        m_backend = std::make_unique<GLRenderBackend>(max_sprites);
+    }
 
     /* Load default texture ID 0 -> blank.png */
     load_texture("res/textures/blank.png");
@@ -81,86 +64,144 @@ void Renderer::init(unsigned max_sprites)
 
 Renderer::~Renderer()
 {
-    /* Unmap the buffer when the renderer is destroyed */
-    glUnmapNamedBuffer(m_instance_buffer);
-    glDeleteBuffers(1, &m_sprite_buffer);
-    glDeleteBuffers(1, &m_instance_buffer);
-    glDeleteTextures(m_textures.size(), m_textures.data());
+    if (m_present_texture != 0u)
+    {
+        glDeleteFramebuffers(1, &m_present_framebuffer);
+        glDeleteTextures(1, &m_present_texture);
+    }
 }
 
-void Renderer::draw(const Renderer::InstanceVertex& data) { m_instance_data.push_back(data); }
+InstanceVertex Renderer::pack_instance(const Renderer::Sprite& sprite)
+{
+    InstanceVertex out = {};
+    out.pos[0] = detail::encode_position(sprite.pos.x);
+    out.pos[1] = detail::encode_position(sprite.pos.y);
+    out.size[0] = detail::encode_size(sprite.size.x);
+    out.size[1] = detail::encode_size(sprite.size.y);
+    out.col[0] = detail::encode_unorm8(sprite.col.r);
+    out.col[1] = detail::encode_unorm8(sprite.col.g);
+    out.col[2] = detail::encode_unorm8(sprite.col.b);
+    out.col[3] = 255u;
+    out.texture_id = sprite.texture_id;
+    return out;
+}
 
-void Renderer::draw(InstanceVertex&& data) { m_instance_data.emplace_back(data); }
+void Renderer::draw(const Renderer::Sprite& data, ELayer layer, uint16_t depth)
+{
+    /* Sort by layer, then depth and finally by texture array so sprites sharing a texture end up next to each other */
+    const uint64_t key = (static_cast<uint32_t>(layer) << 24u) | (static_cast<uint32_t>(depth) << 8u) | (data.texture_id & 0xFFu);
+    m_sort_keys.push_back((key << 32u) | m_instance_data.size());
+    m_instance_data.push_back(pack_instance(data));
+}
 
 void Renderer::submit_work()
 {
-    /* Write data to GPU (The buffer is persistently mapped and explicitly flushed after profiling showed that mapping every frame
-     * was very expensive) */
-    memcpy(m_mapped_instance_buffer, m_instance_data.data(), cgl::size_bytes(m_instance_data));
-    glFlushMappedNamedBufferRange(m_instance_buffer, 0, cgl::size_bytes(m_instance_data));
-
-    /* Prepare state (only needs to bind VAO since it knows about it's resources already. Also bind all textures to their
-     *  respective texture units (from 0 an onward to N). */
-    prog->use();
-    m_ubo.bind(0);
-    glBindVertexArray(m_vao);
-    glBindTextures(0, m_textures.size(), m_textures.data());
+    PAC_PROFILE_SCOPE("Renderer::submit_work");
+    const auto submit_start = std::chrono::steady_clock::now();
+    m_frame_stats = {};
 
-    /* Enable post processing */
-    if (m_post_enabled)
+    /* Tiles are retained, so only upload what changed since last frame (usually nothing) */
+    auto& layer = m_static_layer;
+    if (layer.dirty_begin < layer.dirty_end)
     {
-        m_post_processor.capture();
-        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(m_instance_data.size()));
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        m_post_processor.process();
+        m_backend->update_static_layer(layer.instances, layer.dirty_begin, layer.dirty_end, m_frame_stats);
+        layer.dirty_begin = 0u;
+        layer.dirty_end = 0u;
     }
-    /* Or don't */
-    else
+
+    sort_instances();
+
+    /* Find the first sprite above the Tiles layer (the keys are sorted, and the layer is the top byte of the key) */
+    const auto above_tiles = static_cast<uint64_t>(static_cast<uint32_t>(ELayer::Tiles) + 1u) << 56u;
+    const auto split = static_cast<std::size_t>(std::lower_bound(m_sort_keys.cbegin(), m_sort_keys.cend(), above_tiles) -
+                                                m_sort_keys.cbegin());
+
+    /* ImGui is finalized here for every backend, but only drawn by those that support it */
+    ImGui::Render();
+
+    static const std::vector<InstanceVertex> no_static_instances = {};
+    const RenderFrame frame = {m_instance_data, m_sort_keys, split,
+                               layer.requested ? layer.instances : no_static_instances};
+
     {
-        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(m_instance_data.size()));
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        PAC_PROFILE_SCOPE("RenderBackend::draw_frame");
+        const auto backend_start = std::chrono::steady_clock::now();
+        m_backend->draw_frame(frame, m_frame_stats);
+        m_frame_stats.backend_ms =
+            std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - backend_start).count();
     }
 
+    m_frame_stats.dynamic_instances = static_cast<unsigned>(m_instance_data.size());
+    m_frame_stats.static_instances = static_cast<unsigned>(frame.static_instances.size());
+    m_total_fence_stalls += m_frame_stats.fence_stalled ? 1u : 0u;
     m_instance_data.clear();
+    m_sort_keys.clear();
+    layer.requested = false;
+
+    m_frame_stats.submit_ms =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - submit_start).count();
+
+    ++m_total_frames;
+    m_total_submit_ms += m_frame_stats.submit_ms;
+    m_total_sort_ms += m_frame_stats.sort_ms;
+    m_total_backend_ms += m_frame_stats.backend_ms;
+    m_peak_backend_ms = std::max(m_peak_backend_ms, m_frame_stats.backend_ms);
 }
 
-TextureID Renderer::load_texture(std::string_view relative_fp)
+void Renderer::set_static_layer(const void* owner, unsigned count)
 {
-    /* If texture is loaded already, return it */
-    if (auto out = check_texture_is_loaded(relative_fp))
+    m_static_layer.owner = owner;
+    m_static_layer.instances.assign(count, InstanceVertex{});
+    m_static_layer.dirty_begin = 0u;
+    m_static_layer.dirty_end = count;
+}
+
+void Renderer::set_static_instance(unsigned index, const Renderer::Sprite& data)
+{
+    GFX_ASSERT(index < m_static_layer.instances.size(), "Static instance %u is out of range.", index);
+    m_static_layer.instances[index] = pack_instance(data);
+
+    /* Grow the dirty range to include this instance */
+    if (m_static_layer.dirty_begin >= m_static_layer.dirty_end)
     {
-        GFX_DEBUG("Skip reload of texture [%s]", relative_fp.data());
-        return *out;
+        m_static_layer.dirty_begin = index;
+        m_static_layer.dirty_end = index + 1u;
+    }
+    else
+    {
+        m_static_layer.dirty_begin = std::min(m_static_layer.dirty_begin, index);
+        m_static_layer.dirty_end = std::max(m_static_layer.dirty_end, index + 1u);
     }
+}
 
-    auto tex_data = cgl::load_texture(relative_fp.data());
+bool Renderer::owns_static_layer(const void* owner) const { return m_static_layer.owner == owner; }
 
-    GLuint tex_id = 0u;
-    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &tex_id);
-    glTextureParameteri(tex_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTextureParameteri(tex_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTextureParameteri(tex_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTextureParameteri(tex_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+void Renderer::release_static_layer(const void* owner)
+{
+    if (m_static_layer.owner == owner)
+    {
+        set_static_layer(nullptr, 0u);
+    }
+}
 
-    /* Allocate and transfer data to Texture */
-    glTextureStorage3D(tex_id, 1, GL_RGBA8, tex_data.width, tex_data.height, 1);
-    glTextureSubImage3D(tex_id, 0, 0, 0, 0, tex_data.width, tex_data.height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
-                        tex_data.pixels.data());
+void Renderer::draw_static_layer() { m_static_layer.requested = true; }
 
-    /* Return texture ID and add to cache */
-    m_textures.push_back(tex_id);
-    GFX_DEBUG("You have loaded %u/15 textures now.", m_textures.size());
+const FrameStats& Renderer::get_frame_stats() const { return m_frame_stats; }
 
-    if (m_textures.size() > 15)
+unsigned long Renderer::get_total_fence_stalls() const { return m_total_fence_stalls; }
+
+TextureID Renderer::load_texture(std::string_view relative_fp)
+{
+    PAC_PROFILE_SCOPE("Renderer::load_texture");
+
+    /* If texture is loaded already, return it */
+    if (auto out = check_texture_is_loaded(relative_fp))
     {
-        GFX_ERROR("Too many textures.");
+        GFX_DEBUG("Skip reload of texture [%s]", relative_fp.data());
+        return *out;
     }
 
-    TextureID out{0u, 1u, 0u, static_cast<uint8_t>(m_textures.size() - 1)};
-    m_loaded_texture_cache.emplace(relative_fp.data(), out);
-    return out;
+    return add_texture({cgl::load_texture(relative_fp.data())}, relative_fp.data());
 }
 
 TextureID Renderer::get_tileset_texture(unsigned no)
@@ -180,6 +221,8 @@ unsigned long Renderer::get_texture_for_imgui(TextureID id) const
 TextureID Renderer::load_animation_texture(std::string_view relative_fp, int xoffset, int yoffset, int w, int h, int cols,
                                            int count)
 {
+    PAC_PROFILE_SCOPE("Renderer::load_animation_texture");
+
     /* Check if it is loaded already, by using all parameters as a string, and then hashing on that*/
     std::stringstream hash_str_stream{};
     hash_str_stream << relative_fp << xoffset << yoffset << w << h << cols << count;
@@ -193,25 +236,122 @@ TextureID Renderer::load_animation_texture(std::string_view relative_fp, int xof
     }
 
     /* Load the animation or spritesheet based on parameters */
-    auto tex_data = cgl::load_texture_partitioned(relative_fp.data(), xoffset, yoffset, w, h, cols, count);
+    return add_texture(cgl::load_texture_partitioned(relative_fp.data(), xoffset, yoffset, w, h, cols, count), hash_string);
+}
+
+void Renderer::set_post_enabled(bool flag) { m_backend->set_post_enabled(flag); }
+
+bool Renderer::capture_frame(std::string_view fp)
+{
+    PAC_PROFILE_SCOPE("Renderer::capture_frame");
+    const auto capture_start = std::chrono::steady_clock::now();
+    m_backend->read_pixels(m_capture_pixels);
+    const auto written = write_png(fp, SCREEN_W, SCREEN_H, m_capture_pixels);
+
+    GFX_INFO("Captured frame to %s in %.2fms.", fp.data(),
+             std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - capture_start).count());
+    return written;
+}
+
+bool Renderer::compare_frame(std::string_view fp)
+{
+    PAC_PROFILE_SCOPE("Renderer::compare_frame");
+    m_backend->read_pixels(m_capture_pixels);
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    auto* golden = stbi_load(fp.data(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!golden)
+    {
+        GFX_INFO("There is no golden image at %s yet, writing this frame as the golden image.", fp.data());
+        return write_png(fp, SCREEN_W, SCREEN_H, m_capture_pixels);
+    }
+
+    if (width != static_cast<int>(SCREEN_W) || height != static_cast<int>(SCREEN_H))
+    {
+        GFX_WARN("The golden image %s is %dx%d, but frames are %ux%u.", fp.data(), width, height, SCREEN_W, SCREEN_H);
+        stbi_image_free(golden);
+        return false;
+    }
+
+    /* The software backend is deterministic, so any difference at all is a failure */
+    std::size_t differing_pixels = 0u;
+    int max_difference = 0;
+    for (std::size_t i = 0u; i < m_capture_pixels.size(); i += 4u)
+    {
+        int difference = 0;
+        for (std::size_t c = 0u; c < 4u; ++c)
+        {
+            difference = std::max(difference, std::abs(static_cast<int>(m_capture_pixels[i + c]) - golden[i + c]));
+        }
+        differing_pixels += difference > 0 ? 1u : 0u;
+        max_difference = std::max(max_difference, difference);
+    }
+    stbi_image_free(golden);
+
+    if (differing_pixels == 0u)
+    {
+        GFX_INFO("The frame matches the golden image %s.", fp.data());
+        return true;
+    }
+
+    const auto actual_fp = std::string(fp) + ".actual.png";
+    write_png(actual_fp, SCREEN_W, SCREEN_H, m_capture_pixels);
+    GFX_WARN("%zu pixels of the frame differ from the golden image %s (by up to %d), the frame was written to %s.",
+             differing_pixels, fp.data(), max_difference, actual_fp.c_str());
+    return false;
+}
+
+void Renderer::present()
+{
+    /* The OpenGL backend has drawn into the window already */
+    if (m_backend_type != ERenderBackend::Software)
+    {
+        return;
+    }
+
+    PAC_PROFILE_SCOPE("Renderer::present");
+    if (m_present_texture == 0u)
+    {
+        glCreateTextures(GL_TEXTURE_2D, 1, &m_present_texture);
+        glTextureStorage2D(m_present_texture, 1, GL_RGBA8, SCREEN_W, SCREEN_H);
+        glCreateFramebuffers(1, &m_present_framebuffer);
+        glNamedFramebufferTexture(m_present_framebuffer, GL_COLOR_ATTACHMENT0, m_present_texture, 0);
+    }
 
-    GLuint tex_id = 0u;
-    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &tex_id);
-    glTextureParameteri(tex_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTextureParameteri(tex_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTextureParameteri(tex_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTextureParameteri(tex_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    m_backend->read_pixels(m_capture_pixels);
+    glTextureSubImage2D(m_present_texture, 0, 0, 0, SCREEN_W, SCREEN_H, GL_RGBA, GL_UNSIGNED_BYTE, m_capture_pixels.data());
 
-    /* Allocate and transfer data to Texture */
-    glTextureStorage3D(tex_id, 1, GL_RGBA8, tex_data[0].width, tex_data[0].height, tex_data.size());
-    for (int i = 0; i < static_cast<int>(tex_data.size()); ++i)
+    /* The pixels are top row first while OpenGL starts at the bottom, so flip them while blitting */
+    glBlitNamedFramebuffer(m_present_framebuffer, 0, 0, 0, SCREEN_W, SCREEN_H, 0, SCREEN_H, SCREEN_W, 0, GL_COLOR_BUFFER_BIT,
+                           GL_NEAREST);
+
+    /* The software backend does not draw ImGui, but with a window there is OpenGL to draw it with */
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
+
+void Renderer::log_summary() const
+{
+    if (m_total_frames == 0u)
     {
-        glTextureSubImage3D(tex_id, 0, 0, 0, i, tex_data[i].width, tex_data[i].height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
-                            tex_data[i].pixels.data());
+        return;
     }
 
+    const auto frames = static_cast<double>(m_total_frames);
+    const auto backend_ms = m_total_backend_ms / frames;
+    GFX_INFO("%s renderer: %lu frames, %.3fms submit, %.3fms sort and %.3fms backend on average (%.0f frames per second), "
+             "%.3fms peak backend.",
+             m_backend_type == ERenderBackend::Software ? "Software" : "OpenGL", m_total_frames, m_total_submit_ms / frames,
+             m_total_sort_ms / frames, backend_ms, backend_ms > 0.0 ? 1000.0 / backend_ms : 0.0, m_peak_backend_ms);
+}
+
+ERenderBackend Renderer::get_backend_type() const { return m_backend_type; }
+
+TextureID Renderer::add_texture(const std::vector<cgl::LoadedTexture>& layers, const std::string& cache_key)
+{
     /* Return ID and add to texture cache */
-    m_textures.push_back(tex_id);
+    m_textures.push_back(m_backend->create_texture(layers));
     GFX_DEBUG("You have loaded %u/15 textures now.", m_textures.size());
 
     if (m_textures.size() > 15)
@@ -219,12 +359,18 @@ TextureID Renderer::load_animation_texture(std::string_view relative_fp, int xof
         GFX_ERROR("Too many textures.");
     }
 
-    TextureID out{0u, static_cast<uint8_t>(tex_data.size()), 0u, static_cast<uint8_t>(m_textures.size() - 1)};
-    m_loaded_texture_cache.emplace(hash_string, out);
+    TextureID out{0u, static_cast<uint8_t>(layers.size()), 0u, static_cast<uint8_t>(m_textures.size() - 1)};
+    m_loaded_texture_cache.emplace(cache_key, out);
     return out;
 }
 
-void Renderer::set_post_enabled(bool flag) { m_post_enabled = flag; }
+void Renderer::sort_instances()
+{
+    PAC_PROFILE_SCOPE("Renderer::sort_instances");
+    const auto sort_start = std::chrono::steady_clock::now();
+    radix_sort_keys(m_sort_keys, m_sort_scratch);
+    m_frame_stats.sort_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - sort_start).count();
+}
 
 std::optional<TextureID> Renderer::check_texture_is_loaded(std::string_view fp)
 {
@@ -239,9 +385,16 @@ std::optional<TextureID> Renderer::check_texture_is_loaded(std::string_view fp)
     return std::nullopt;
 }
 
+void set_render_backend(ERenderBackend backend)
+{
+    GFX_ASSERT(!g_renderer_created, "The render backend must be selected before the renderer is created.");
+    g_requested_backend = backend;
+}
+
 Renderer& get_renderer()
 {
-    static Renderer r{2048};
+    static Renderer r{INSTANCE_SEGMENT_INITIAL_CAPACITY, g_requested_backend.value_or(render_backend_from_environment())};
+    g_renderer_created = true;
     return r;
 }
 
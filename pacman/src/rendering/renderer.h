@@ -1,12 +1,10 @@
 #pragma once
 
-#include "shader_program.h"
-#include "vertex_array_object.h"
-#include "uniform_buffer_object.h"
-#include "post_processing.h"
+#include "render_backend.h"
 
 #include <vector>
 #include <memory>
+#include <cstddef>
 #include <optional>
 #include <string_view>
 #include <unordered_map>
@@ -14,19 +12,9 @@
 #include <cglutil.h>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
-#include <glm/mat4x4.hpp>
 
 namespace pac
 {
-namespace detail
-{
-struct MatrixData
-{
-    glm::mat4 proj_matrix = glm::mat4(1.f);
-    glm::mat4 view_matrix = glm::mat4(1.f);
-};
-}  // namespace detail
-
 /*!
  * \brief The TextureID struct represents a texture ID. Supports up to 16 textures with up to 64 animation frames each.
  */
@@ -41,27 +29,54 @@ struct TextureID
 };
 
 /*!
- * \brief The Renderer class is a specialized "renderer" designed to render this pacman game efficiently. It
- * uses a single, large buffer starting with vertex and index data for the one instanced quad. Then the rest
- * of the buffer is per-instance data for all the sprites in the game.
+ * \brief The ELayer enum describes the layers sprites are drawn in, from back to front. The level's static layer (the tiles) is
+ * always drawn as the Tiles layer.
+ */
+enum class ELayer : uint8_t
+{
+    Background,
+    Tiles,
+    Entities,
+    Overlay,
+    Interface
+};
+
+/*!
+ * \brief The Renderer class is a specialized "renderer" designed to render this pacman game efficiently. It collects the
+ * sprites drawn during a frame, packs them and sorts them by layer, then depth, then texture (a radix sort on a 32-bit key),
+ * regardless of the order they were submitted in. Sprites with equal keys keep their submission order. Level tiles live in a
+ * separate, retained static layer that is only re-uploaded when tiles change. The actual drawing is done by a RenderBackend,
+ * either OpenGL or a CPU rasterizer for capturing frames on machines without a GPU.
  * \note This class should be instanced once, and act as a Singleton ish (taken care of with get_renderer function)
  */
 class Renderer
 {
 private:
     /*!
-     * \brief The Vertex struct is the vertex layout for the sprite quad
+     * \brief The StaticLayer struct holds instance data that is retained between frames (the level tiles). Only the dirty
+     * range [dirty_begin, dirty_end) is handed to the backend in submit_work.
      */
-    struct Vertex
+    struct StaticLayer
     {
-        glm::vec2 pos = {};
-        glm::vec2 uv = {};
+        /* Whoever filled the layer last (a Level), so a different owner knows to rebuild it */
+        const void* owner = nullptr;
+
+        /* CPU copy of the layer, so dirty ranges can be uploaded without the owner re-submitting everything */
+        std::vector<InstanceVertex> instances = {};
+
+        /* Range of instances that changed since the last upload */
+        unsigned dirty_begin = 0u;
+        unsigned dirty_end = 0u;
+
+        /* Set when the layer should be drawn this frame */
+        bool requested = false;
     };
 
+public:
     /*!
-     * \brief The InstanceVertex struct is the vertex layout of per-instance sprite instantiations
+     * \brief The Sprite struct is the unpacked per-instance data of a sprite, as passed to draw
      */
-    struct InstanceVertex
+    struct Sprite
     {
         glm::vec2 pos = {};
         glm::vec2 size = {};
@@ -69,15 +84,17 @@ private:
         uint32_t texture_id = {};
     };
 
-    void* m_mapped_instance_buffer = nullptr;
+private:
+    /* The backend that does the actual drawing */
+    std::unique_ptr<RenderBackend> m_backend = nullptr;
 
-    /* Buffer that contains sprite data, vertices and indices like [INDEX DATA ... VERTEX DATA] */
-    unsigned m_sprite_buffer = 0u;
+    /* Which backend m_backend is */
+    ERenderBackend m_backend_type = ERenderBackend::OpenGL;
 
-    /* Buffer that contains per-instance data */
-    unsigned m_instance_buffer = 0u;
+    /* Total number of frames where the CPU had to wait for the GPU to release an instance buffer segment */
+    unsigned long m_total_fence_stalls = 0u;
 
-    /* Vector of all currently available textures */
+    /* Backend handles of all currently available textures, indexed by TextureID::array_index */
     std::vector<unsigned> m_textures = {};
 
     /* A cache of mapping file paths to texture ID's so we don't have to load the same texture twice */
@@ -86,20 +103,31 @@ private:
     /* Instance data, added as you draw, and drawn once you submit the draw */
     std::vector<InstanceVertex> m_instance_data = {};
 
-    /* Post processor for applying post effects */
-    PostProcessor m_post_processor = {};
+    /* One entry per instance, the sort key in the upper 32 bits and the index into m_instance_data in the lower 32 bits */
+    std::vector<uint64_t> m_sort_keys = {};
+
+    /* Scratch space for the radix sort */
+    std::vector<uint64_t> m_sort_scratch = {};
 
-    /* Vertex attribute layout */
-    VertexArray m_vao = {};
+    /* Retained instances (level tiles) */
+    StaticLayer m_static_layer = {};
 
-    /* Shader program (unique_ptr) since it has no default Ctor */
-    std::unique_ptr<ShaderProgram> prog = nullptr;
+    /* Statistics from the previous call to submit_work */
+    FrameStats m_frame_stats = {};
 
-    /* Matrix UBO */
-    UniformBuffer<detail::MatrixData> m_ubo = {};
+    /* Pixels read back by capture_frame (kept around to avoid reallocating for every capture) */
+    std::vector<uint8_t> m_capture_pixels = {};
 
-    /* Post processing enabled or not */
-    bool m_post_enabled = true;
+    /* Timings summed over every submitted frame, for log_summary */
+    unsigned long m_total_frames = 0u;
+    double m_total_submit_ms = 0.0;
+    double m_total_sort_ms = 0.0;
+    double m_total_backend_ms = 0.0;
+    float m_peak_backend_ms = 0.f;
+
+    /* Texture and framebuffer the frames of the software backend are blitted to the window from (0 until first presented) */
+    unsigned m_present_texture = 0u;
+    unsigned m_present_framebuffer = 0u;
 
 public:
     Renderer(const Renderer&) = delete;
@@ -110,17 +138,61 @@ public:
 
     /*!
      * \brief draw adds a sprite to the draws that will appear the next time work is submitted
-     * \param data is the vertex data to add
-     * \param texture_id is the id of the texture that this sprite should use
+     * \param data is the sprite to add
+     * \param layer is the layer to draw the sprite in
+     * \param depth orders sprites within a layer, higher depths are drawn on top of lower ones
      */
-    void draw(const InstanceVertex& data);
-    void draw(InstanceVertex&& data);
+    void draw(const Sprite& data, ELayer layer = ELayer::Entities, uint16_t depth = 0u);
 
     /*!
      * \brief submit_work submits the collected draws for rendering and renders it
      */
     void submit_work();
 
+    /*!
+     * \brief set_static_layer resizes the retained static layer and hands ownership of it to owner. Every instance is marked
+     * dirty, so the owner should fill all of them with set_static_instance afterwards.
+     * \param owner is the object (usually a Level) that fills the layer
+     * \param count is the number of instances in the layer
+     */
+    void set_static_layer(const void* owner, unsigned count);
+
+    /*!
+     * \brief set_static_instance updates a single instance in the static layer and marks it for re-upload
+     * \param index is the index of the instance in the layer
+     * \param data is the new sprite data
+     */
+    void set_static_instance(unsigned index, const Sprite& data);
+
+    /*!
+     * \brief owns_static_layer checks if the static layer was last filled by owner
+     * \param owner is the object to check
+     * \return true if the layer currently holds the owner's data
+     */
+    bool owns_static_layer(const void* owner) const;
+
+    /*!
+     * \brief release_static_layer clears the static layer if it is owned by owner, call this when the owner is destroyed
+     * \param owner is the object releasing the layer
+     */
+    void release_static_layer(const void* owner);
+
+    /*!
+     * \brief draw_static_layer requests the static layer to be drawn this frame (beneath all other sprites)
+     */
+    void draw_static_layer();
+
+    /*!
+     * \brief get_frame_stats returns statistics about the previously submitted frame
+     */
+    const FrameStats& get_frame_stats() const;
+
+    /*!
+     * \brief get_total_fence_stalls returns the number of frames since startup where the CPU had to wait for the GPU to finish
+     * reading an instance buffer segment before it could be reused
+     */
+    unsigned long get_total_fence_stalls() const;
+
     /*!
      * \brief load_texture loads the texture at the given relative file path
      * \note if you call this multiple times with the same texture, it will not be loaded twice
@@ -157,9 +229,42 @@ public:
      */
     void set_post_enabled(bool flag);
 
+    /*!
+     * \brief capture_frame writes the last submitted frame to a PNG file
+     * \param fp is the file path to write to
+     * \return true if the capture was written
+     */
+    bool capture_frame(std::string_view fp);
+
+    /*!
+     * \brief compare_frame compares the last submitted frame with a golden image, pixel by pixel. If the golden image does not
+     * exist yet, the frame is written as the golden image instead. On a mismatch the frame is written next to the golden image
+     * with .actual.png appended to its name.
+     * \param fp is the file path of the golden image (a PNG of SCREEN_W x SCREEN_H)
+     * \return true if the frame matched, or was written as the new golden image
+     */
+    bool compare_frame(std::string_view fp);
+
+    /*!
+     * \brief present shows the last submitted frame in the window. The OpenGL backend draws straight into the window so it has
+     * nothing to do, frames of the software backend are uploaded to a texture and blitted into it, with ImGui drawn on top
+     * \note only call this when there is a window with an OpenGL context
+     */
+    void present();
+
+    /*!
+     * \brief log_summary logs the average and peak timings of every frame submitted since startup
+     */
+    void log_summary() const;
+
+    /*!
+     * \brief get_backend_type returns which backend the renderer draws with
+     */
+    ERenderBackend get_backend_type() const;
+
 private:
     /* Private because we want the singleton function to be the only one able to create a Renderer */
-    explicit Renderer(unsigned max_sprites = 2048u);
+    Renderer(unsigned max_sprites, ERenderBackend backend);
 
     /*!
      * \brief check_texture_is_loaded checks if the given filepath is loaded and cached
@@ -169,14 +274,36 @@ private:
     std::optional<TextureID> check_texture_is_loaded(std::string_view fp);
 
     /*!
-     * \brief init initializes the renderer's OpenGL state and objects
-     * \param max_sprites is the maximum amount of sprites to draw simultaneously for this renderer
+     * \brief pack_instance converts a sprite to the packed instance layout that is handed to the backend
+     * \param sprite is the sprite to pack
+     * \return the packed instance
      */
-    void init(unsigned max_sprites);
+    static InstanceVertex pack_instance(const Sprite& sprite);
+
+    /*!
+     * \brief add_texture hands texture layers to the backend and registers the result in the texture cache
+     * \param layers are the texture layers to add
+     * \param cache_key is the key to cache the texture under
+     * \return the TextureID of the new texture
+     */
+    TextureID add_texture(const std::vector<cgl::LoadedTexture>& layers, const std::string& cache_key);
+
+    /*!
+     * \brief sort_instances sorts m_sort_keys by their sort key with a stable radix sort
+     */
+    void sort_instances();
 
     friend Renderer& get_renderer();
 };
 
+/*!
+ * \brief set_render_backend selects the backend the renderer is created with. Must be called before the first call to
+ * get_renderer. If it is never called, the backend is taken from the PAC_RENDER_BACKEND environment variable ("software" or
+ * "opengl"), defaulting to OpenGL.
+ * \param backend is the backend to use
+ */
+void set_render_backend(ERenderBackend backend);
+
 /*!
  * \brief get_renderer returns a reference to the active renderer Singleton class
  * \note singleton is accessible through this function so we can control the lifetime and creation, unlike a global which
@@ -0,0 +1,227 @@
+#include "software_render_backend.h"
+#include "job_system.h"
+#include "config.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <gfx.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PAC_SOFTWARE_RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace pac
+{
+namespace
+{
+/* Opaque black, what the OpenGL backend clears to */
+constexpr uint32_t CLEAR_COLOR = 0xFF000000u;
+
+/* Divide by 255 with rounding, exact for v in [0, 255 * 255] */
+inline uint32_t div255(uint32_t v) { return (v + 128u + ((v + 128u) >> 8u)) >> 8u; }
+
+/*!
+ * \brief blend_pixel tints src and blends it onto dst with SRC_ALPHA, ONE_MINUS_SRC_ALPHA. The framebuffer stays opaque.
+ */
+inline uint32_t blend_pixel(uint32_t dst, uint32_t src, const uint8_t* tint)
+{
+    const auto src_alpha = div255(((src >> 24u) & 0xFFu) * tint[3]);
+    auto out = CLEAR_COLOR;
+    for (auto shift = 0u; shift < 24u; shift += 8u)
+    {
+        const auto s = div255(((src >> shift) & 0xFFu) * tint[shift / 8u]);
+        const auto d = (dst >> shift) & 0xFFu;
+        out |= div255(s * src_alpha + d * (255u - src_alpha)) << shift;
+    }
+    return out;
+}
+
+#ifdef PAC_SOFTWARE_RASTER_SSE2
+/* Same as div255, but for 8 unsigned 16-bit lanes */
+inline __m128i div255_epi16(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+/*!
+ * \brief blend_two does what blend_pixel does for two pixels that have been widened to 16 bits per channel
+ */
+inline __m128i blend_two(__m128i src, __m128i dst, __m128i tint)
+{
+    const auto tinted = div255_epi16(_mm_mullo_epi16(src, tint));
+    const auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(tinted, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    const auto inv_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return div255_epi16(_mm_add_epi16(_mm_mullo_epi16(tinted, alpha), _mm_mullo_epi16(dst, inv_alpha)));
+}
+#endif
+
+/*!
+ * \brief blend_span blends count texels from a texture row onto dst, texel i of the span being row[columns[i]]
+ * \param contiguous is true when columns[i] == columns[0] + i (the sprite is drawn at its texture size), so texels can be
+ * loaded directly instead of gathered
+ */
+void blend_span(uint32_t* dst, const uint32_t* row, const int* columns, int count, const uint8_t* tint, bool contiguous)
+{
+    auto i = 0;
+#ifdef PAC_SOFTWARE_RASTER_SSE2
+    const auto zero = _mm_setzero_si128();
+    const auto opaque = _mm_set1_epi32(static_cast<int>(CLEAR_COLOR));
+    const auto tint16 = _mm_setr_epi16(tint[0], tint[1], tint[2], tint[3], tint[0], tint[1], tint[2], tint[3]);
+    const auto untinted = (tint[0] & tint[1] & tint[2] & tint[3]) == 0xFFu;
+    for (; i + 4 <= count; i += 4)
+    {
+        const auto src =
+            contiguous ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + columns[i]))
+                       : _mm_set_epi32(static_cast<int>(row[columns[i + 3]]), static_cast<int>(row[columns[i + 2]]),
+                                       static_cast<int>(row[columns[i + 1]]), static_cast<int>(row[columns[i]]));
+
+        /* Skip fully transparent texels and copy fully opaque ones, most of the sprites in the game are one or the other */
+        const auto alpha = _mm_and_si128(src, opaque);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF)
+        {
+            continue;
+        }
+
+        if (untinted && _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, opaque)) == 0xFFFF)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), src);
+            continue;
+        }
+
+        const auto dest = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+
+        const auto lo = blend_two(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dest, zero), tint16);
+        const auto hi = blend_two(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dest, zero), tint16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+#endif
+
+    /* Scalar tail (or everything, without SSE2) */
+    for (; i < count; ++i)
+    {
+        dst[i] = blend_pixel(dst[i], row[columns[i]], tint);
+    }
+}
+}  // namespace
+
+SoftwareRenderBackend::SoftwareRenderBackend() : m_framebuffer(SCREEN_W * SCREEN_H, CLEAR_COLOR)
+{
+#ifdef PAC_SOFTWARE_RASTER_SSE2
+    GFX_INFO("Software rasterizer is using SSE2.");
+#else
+    GFX_INFO("Software rasterizer is using the scalar fallback.");
+#endif
+}
+
+unsigned SoftwareRenderBackend::create_texture(const std::vector<cgl::LoadedTexture>& layers)
+{
+    Texture texture = {layers[0].width, layers[0].height, static_cast<int>(layers.size()), {}};
+    const auto layer_size = static_cast<std::size_t>(texture.width * texture.height);
+    texture.texels.resize(layer_size * layers.size());
+
+    for (std::size_t i = 0u; i < layers.size(); ++i)
+    {
+        GFX_ASSERT(layers[i].pixels.size() >= layer_size * 4u, "Texture layer %zu is smaller than the first layer.", i);
+        memcpy(texture.texels.data() + i * layer_size, layers[i].pixels.data(), layer_size * 4u);
+    }
+
+    m_textures.push_back(std::move(texture));
+    return static_cast<unsigned>(m_textures.size() - 1u);
+}
+
+void SoftwareRenderBackend::update_static_layer(const std::vector<InstanceVertex>&, unsigned, unsigned, FrameStats&)
+{
+    /* Nothing to do, the static layer is read straight from the frame */
+}
+
+void SoftwareRenderBackend::draw_frame(const RenderFrame& frame, FrameStats& stats)
+{
+    /* Bands do not share any pixels, so they are drawn in parallel and every pixel still sees the sprites in order */
+    const auto bands = (SCREEN_H + SOFTWARE_RASTER_BAND_ROWS - 1u) / SOFTWARE_RASTER_BAND_ROWS;
+    get_job_system().parallel_for("Software Raster Band", 0u, bands, 1u, [this, &frame](std::size_t band, std::size_t) {
+        const auto row_begin = static_cast<int>(band * SOFTWARE_RASTER_BAND_ROWS);
+        const auto row_end = std::min(row_begin + static_cast<int>(SOFTWARE_RASTER_BAND_ROWS), static_cast<int>(SCREEN_H));
+        draw_band(frame, row_begin, row_end);
+    });
+
+    stats.batches = 1u;
+}
+
+void SoftwareRenderBackend::read_pixels(std::vector<uint8_t>& out_pixels)
+{
+    out_pixels.resize(m_framebuffer.size() * 4u);
+    memcpy(out_pixels.data(), m_framebuffer.data(), out_pixels.size());
+}
+
+void SoftwareRenderBackend::set_post_enabled(bool) {}
+
+void SoftwareRenderBackend::draw_band(const RenderFrame& frame, int row_begin, int row_end)
+{
+    std::fill(m_framebuffer.begin() + row_begin * SCREEN_W, m_framebuffer.begin() + row_end * SCREEN_W, CLEAR_COLOR);
+
+    std::vector<int> columns{};
+    for (std::size_t i = 0u; i < frame.split; ++i)
+    {
+        draw_instance(frame.instances[static_cast<uint32_t>(frame.order[i])], row_begin, row_end, columns);
+    }
+
+    for (const auto& instance : frame.static_instances)
+    {
+        draw_instance(instance, row_begin, row_end, columns);
+    }
+
+    for (auto i = frame.split; i < frame.order.size(); ++i)
+    {
+        draw_instance(frame.instances[static_cast<uint32_t>(frame.order[i])], row_begin, row_end, columns);
+    }
+}
+
+void SoftwareRenderBackend::draw_instance(const InstanceVertex& instance, int row_begin, int row_end, std::vector<int>& columns)
+{
+    const auto w = detail::decode_size(instance.size[0]);
+    const auto h = detail::decode_size(instance.size[1]);
+    const auto array_index = instance.texture_id & 0xFFu;
+    if (w <= 0.f || h <= 0.f || array_index >= m_textures.size())
+    {
+        return;
+    }
+
+    /* Pixels are covered when their center is inside the sprite, like the GPU rasterization rules */
+    const auto x0 = detail::decode_position(instance.pos[0]) - w / 2.f;
+    const auto y0 = detail::decode_position(instance.pos[1]) - h / 2.f;
+    const auto px_begin = std::max(0, static_cast<int>(std::ceil(x0 - .5f)));
+    const auto px_end = std::min(static_cast<int>(SCREEN_W), static_cast<int>(std::ceil(x0 + w - .5f)));
+    const auto py_begin = std::max(row_begin, static_cast<int>(std::ceil(y0 - .5f)));
+    const auto py_end = std::min(row_end, static_cast<int>(std::ceil(y0 + h - .5f)));
+    if (px_begin >= px_end || py_begin >= py_end)
+    {
+        return;
+    }
+
+    const auto& texture = m_textures[array_index];
+    const auto layer = std::min(static_cast<int>((instance.texture_id >> 8u) & 0xFFu), texture.layers - 1);
+    const auto* texels = texture.texels.data() + static_cast<std::size_t>(layer) * texture.width * texture.height;
+
+    /* Nearest texel column of every pixel in the span is the same for all rows */
+    columns.resize(px_end - px_begin);
+    for (auto px = px_begin; px < px_end; ++px)
+    {
+        const auto u = (px + .5f - x0) / w;
+        columns[px - px_begin] = std::clamp(static_cast<int>(u * texture.width), 0, texture.width - 1);
+    }
+
+    const auto contiguous = columns.back() - columns.front() == px_end - px_begin - 1;
+
+    for (auto py = py_begin; py < py_end; ++py)
+    {
+        const auto v = (py + .5f - y0) / h;
+        const auto row = std::clamp(static_cast<int>(v * texture.height), 0, texture.height - 1);
+        blend_span(m_framebuffer.data() + py * SCREEN_W + px_begin, texels + row * texture.width, columns.data(),
+                   px_end - px_begin, instance.col, contiguous);
+    }
+}
+}  // namespace pac
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "render_backend.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief The SoftwareRenderBackend class rasterizes sprites on the CPU into an RGBA8 framebuffer of SCREEN_W x SCREEN_H, so
+ * frames can be captured on machines without a GPU. It consumes the same packed instances and texture arrays as the OpenGL
+ * backend and blends with the same SRC_ALPHA, ONE_MINUS_SRC_ALPHA function (using SSE2 where available). Textures are sampled
+ * with nearest filtering, and neither post processing nor ImGui is drawn. The screen is split into bands of
+ * SOFTWARE_RASTER_BAND_ROWS rows that are drawn as jobs of the job system, each band drawing every sprite in order.
+ */
+class SoftwareRenderBackend : public RenderBackend
+{
+private:
+    /*!
+     * \brief The Texture struct is a CPU side texture array with every layer stored after each other
+     */
+    struct Texture
+    {
+        int width = 0;
+        int height = 0;
+        int layers = 0;
+        std::vector<uint32_t> texels = {};
+    };
+
+    /* Framebuffer pixels, packed RGBA8 (R in the lowest byte), top row first */
+    std::vector<uint32_t> m_framebuffer = {};
+
+    /* All created textures, the handle is the index */
+    std::vector<Texture> m_textures = {};
+
+public:
+    SoftwareRenderBackend();
+
+    unsigned create_texture(const std::vector<cgl::LoadedTexture>& layers) override;
+
+    void update_static_layer(const std::vector<InstanceVertex>& instances, unsigned dirty_begin, unsigned dirty_end,
+                             FrameStats& stats) override;
+
+    void draw_frame(const RenderFrame& frame, FrameStats& stats) override;
+
+    void read_pixels(std::vector<uint8_t>& out_pixels) override;
+
+    void set_post_enabled(bool flag) override;
+
+private:
+    /*!
+     * \brief draw_band clears a band of rows and rasterizes every sprite of the frame into it
+     * \param row_begin is the first row of the band
+     * \param row_end is the row after the last row of the band
+     */
+    void draw_band(const RenderFrame& frame, int row_begin, int row_end);
+
+    /*!
+     * \brief draw_instance rasterizes the part of a single sprite that is inside a band of rows into the framebuffer
+     * \param instance is the sprite to draw
+     * \param columns is scratch for the texel column of every pixel in a row of the sprite
+     */
+    void draw_instance(const InstanceVertex& instance, int row_begin, int row_end, std::vector<int>& columns);
+};
+}  // namespace pac
@@ -0,0 +1,44 @@
+#include "sprite_sort.h"
+
+#include <array>
+#include <cstddef>
+
+namespace pac
+{
+void radix_sort_keys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch)
+{
+    scratch.resize(keys.size());
+
+    /* LSD radix sort over the 4 bytes of the sort key (upper 32 bits). It is stable, so equal keys keep submission order */
+    for (auto shift = 32u; shift < 64u && !keys.empty(); shift += 8u)
+    {
+        std::array<std::size_t, 256> offsets = {};
+        for (const auto key : keys)
+        {
+            ++offsets[(key >> shift) & 0xFFu];
+        }
+
+        /* Skip the pass if every key has the same byte here (common, since most sprites share a layer and depth) */
+        if (offsets[(keys.front() >> shift) & 0xFFu] == keys.size())
+        {
+            continue;
+        }
+
+        /* Turn the histogram into start offsets, then scatter */
+        std::size_t sum = 0u;
+        for (auto& offset : offsets)
+        {
+            const auto count = offset;
+            offset = sum;
+            sum += count;
+        }
+
+        for (const auto key : keys)
+        {
+            scratch[offsets[(key >> shift) & 0xFFu]++] = key;
+        }
+
+        keys.swap(scratch);
+    }
+}
+}  // namespace pac
@@ -0,0 +1,19 @@
+/*!
+ * \file sprite_sort.h contains the radix sort the renderer orders its sprites with, kept apart so it can be benchmarked alone
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace pac
+{
+/*!
+ * \brief radix_sort_keys sorts keys by their upper 32 bits with a stable LSD radix sort, one pass per byte. Passes where every
+ * key has the same byte are skipped. The lower 32 bits are carried along, so keys that compare equal keep their order.
+ * \param keys are the keys to sort
+ * \param scratch is resized to fit the keys and used as the other buffer of each pass
+ */
+void radix_sort_keys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch);
+}  // namespace pac
@@ -0,0 +1,524 @@
+#include "replay.h"
+#include "entity/components.h"
+#include "entity/events.h"
+#include "event_bus.h"
+#include "config.h"
+
+#include <tuple>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <utility>
+#include <iterator>
+
+#include <gfx.h>
+#include <imgui/imgui.h>
+
+namespace pac
+{
+extern EventBus g_event_queue;
+
+namespace
+{
+/* Identifies replay files, and the version of the format below (2 changed how checksums are computed) */
+constexpr char REPLAY_MAGIC[4] = {'P', 'A', 'C', 'R'};
+constexpr uint16_t REPLAY_VERSION = 2u;
+
+/*
+ * Replay file layout, all values little endian:
+ *   magic[4] version:u16 checksum_interval:u16 name_length:u16 name[name_length]
+ *   ticks:u32 inputs:u32 checkpoints:u32 final_score:i32 final_checksum:u64
+ *   delta_times:f32[ticks]
+ *   inputs: (tick delta since the previous input:varint, action:u8)[inputs]
+ *   checkpoint checksums:u64[checkpoints], checkpoint i is taken at the end of tick (i + 1) * checksum_interval - 1
+ */
+
+/*!
+ * \brief The Writer struct appends little endian values to a byte buffer
+ */
+struct Writer
+{
+    std::string bytes = {};
+
+    template<typename T>
+    void put(T value)
+    {
+        uint8_t raw[sizeof(T)] = {};
+        std::memcpy(raw, &value, sizeof(T));
+        uint64_t bits = 0u;
+        for (std::size_t i = 0u; i < sizeof(T); ++i)
+        {
+            bits |= static_cast<uint64_t>(raw[i]) << (8u * i);
+        }
+        for (std::size_t i = 0u; i < sizeof(T); ++i)
+        {
+            bytes.push_back(static_cast<char>((bits >> (8u * i)) & 0xFFu));
+        }
+    }
+
+    void put_varint(uint32_t value)
+    {
+        do
+        {
+            const auto byte = static_cast<uint8_t>(value & 0x7Fu);
+            value >>= 7u;
+            bytes.push_back(static_cast<char>(value ? byte | 0x80u : byte));
+        } while (value);
+    }
+};
+
+/*!
+ * \brief The Reader struct reads little endian values from a byte buffer, and remembers if it ran out of bytes
+ */
+struct Reader
+{
+    const std::string& bytes;
+    std::size_t offset = 0u;
+    bool failed = false;
+
+    template<typename T>
+    T get()
+    {
+        if (bytes.size() - offset < sizeof(T))
+        {
+            failed = true;
+            offset = bytes.size();
+            return T{};
+        }
+
+        uint64_t bits = 0u;
+        for (std::size_t i = 0u; i < sizeof(T); ++i)
+        {
+            bits |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[offset + i])) << (8u * i);
+        }
+        offset += sizeof(T);
+
+        uint8_t raw[sizeof(T)] = {};
+        for (std::size_t i = 0u; i < sizeof(T); ++i)
+        {
+            raw[i] = static_cast<uint8_t>((bits >> (8u * i)) & 0xFFu);
+        }
+        T out{};
+        std::memcpy(&out, raw, sizeof(T));
+        return out;
+    }
+
+    uint32_t get_varint()
+    {
+        uint32_t value = 0u;
+        for (unsigned shift = 0u; shift < 35u; shift += 7u)
+        {
+            const auto byte = get<uint8_t>();
+            value |= static_cast<uint32_t>(byte & 0x7Fu) << shift;
+            if (failed || !(byte & 0x80u))
+            {
+                return value;
+            }
+        }
+
+        failed = true;
+        return value;
+    }
+
+    /*!
+     * \brief has returns true if count items of the given size can still be read (checked before resizing to count)
+     */
+    bool has(std::size_t count, std::size_t size) const { return count <= (bytes.size() - offset) / size; }
+};
+
+/*!
+ * \brief fnv1a mixes the bytes of value into the FNV-1a hash
+ */
+template<typename T>
+void fnv1a(uint64_t& hash, const T& value)
+{
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+}
+}  // namespace
+
+void Replay::request_recording(std::string_view fp)
+{
+    *this = {};
+    m_mode = EMode::Recording;
+    m_path = fp;
+}
+
+bool Replay::load(std::string_view fp)
+{
+    std::ifstream file(std::string(fp), std::ios::binary);
+    if (!file)
+    {
+        GFX_WARN("Could not open the replay %s.", fp.data());
+        return false;
+    }
+    const std::string bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    Reader reader{bytes};
+    char magic[4] = {};
+    for (auto& c : magic)
+    {
+        c = reader.get<char>();
+    }
+    const auto version = reader.get<uint16_t>();
+    const auto interval = reader.get<uint16_t>();
+    if (reader.failed || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 || version != REPLAY_VERSION)
+    {
+        GFX_WARN("%s is not a replay, or was recorded by another version of the game.", fp.data());
+        return false;
+    }
+
+    if (interval != REPLAY_CHECKSUM_INTERVAL)
+    {
+        GFX_WARN("%s has checksums every %u ticks, but this build takes them every %u ticks.", fp.data(), interval,
+                 REPLAY_CHECKSUM_INTERVAL);
+        return false;
+    }
+
+    Replay replay{};
+    const auto name_length = reader.get<uint16_t>();
+    if (reader.has(name_length, 1u))
+    {
+        replay.m_level_name = bytes.substr(reader.offset, name_length);
+        reader.offset += name_length;
+    }
+    else
+    {
+        reader.failed = true;
+    }
+
+    const auto ticks = reader.get<uint32_t>();
+    const auto inputs = reader.get<uint32_t>();
+    const auto checkpoints = reader.get<uint32_t>();
+    replay.m_final_score = reader.get<int32_t>();
+    replay.m_final_checksum = reader.get<uint64_t>();
+
+    /* Every count is checked against the bytes left, so a corrupt file can not make us allocate huge vectors */
+    if (!reader.failed && reader.has(ticks, sizeof(float)))
+    {
+        replay.m_delta_times.resize(ticks);
+        for (auto& dt : replay.m_delta_times)
+        {
+            dt = reader.get<float>();
+        }
+    }
+
+    if (!reader.failed && reader.has(inputs, 2u))
+    {
+        replay.m_inputs.resize(inputs);
+        uint32_t tick = 0u;
+        for (auto& input : replay.m_inputs)
+        {
+            tick += reader.get_varint();
+            input = {tick, static_cast<Action>(reader.get<uint8_t>())};
+            reader.failed |= tick >= ticks;
+        }
+    }
+
+    if (!reader.failed && reader.has(checkpoints, sizeof(uint64_t)))
+    {
+        replay.m_checkpoints.resize(checkpoints);
+        for (auto& checkpoint : replay.m_checkpoints)
+        {
+            checkpoint = reader.get<uint64_t>();
+        }
+    }
+
+    if (reader.failed || replay.m_delta_times.size() != ticks || replay.m_inputs.size() != inputs ||
+        replay.m_checkpoints.size() != checkpoints)
+    {
+        GFX_WARN("The replay %s is truncated or corrupt.", fp.data());
+        return false;
+    }
+
+    *this = std::move(replay);
+    m_mode = EMode::Playback;
+    m_path = fp;
+
+    GFX_INFO("Loaded replay %s of %s: %u ticks, %u inputs.", fp.data(), m_level_name.c_str(), ticks, inputs);
+    return true;
+}
+
+Replay::EMode Replay::get_mode() const { return m_mode; }
+
+const std::string& Replay::get_level_name() const { return m_level_name; }
+
+void Replay::on_level_loaded(std::string_view level_name)
+{
+    if (m_mode == EMode::Idle || m_armed || m_active)
+    {
+        return;
+    }
+
+    if (m_mode == EMode::Recording)
+    {
+        m_level_name = level_name;
+    }
+    else if (level_name != m_level_name)
+    {
+        GFX_WARN("Loaded level %s while playing back a replay of %s.", std::string(level_name).c_str(), m_level_name.c_str());
+    }
+    m_armed = true;
+}
+
+void Replay::on_level_exited() { m_level_ended |= m_active; }
+
+float Replay::begin_tick(float dt)
+{
+    /* The level was loaded during the previous iteration, so the first tick is this one */
+    if (m_armed)
+    {
+        m_armed = false;
+        m_active = true;
+        g_event_queue.sink<EvLevelFinished>().connect<&Replay::on_level_finished>(*this);
+        if (m_mode == EMode::Recording)
+        {
+            g_event_queue.sink<EvInput>().connect<&Replay::recieve_input>(*this);
+        }
+        else
+        {
+            /* Only the recorded input drives the game while playing back */
+            get_input().set_enabled(false);
+            m_playback_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    if (!m_active)
+    {
+        return dt;
+    }
+
+    if (m_mode == EMode::Recording)
+    {
+        m_delta_times.push_back(dt);
+        return dt;
+    }
+
+    /* The recorded input was delivered in this tick, so queue it before the event queue is updated */
+    for (; m_next_input < m_inputs.size() && m_inputs[m_next_input].tick == m_tick; ++m_next_input)
+    {
+        g_event_queue.enqueue(EvInput{m_inputs[m_next_input].action});
+    }
+    return m_delta_times[m_tick];
+}
+
+bool Replay::end_tick(entt::registry& reg)
+{
+    if (!m_active)
+    {
+        return false;
+    }
+
+    reg.view<CPlayer>().each([this](const CPlayer& player) { m_score = player.score; });
+
+    /* Checkpoints are taken at the end of every REPLAY_CHECKSUM_INTERVAL'th tick */
+    ++m_tick;
+    if (m_tick % REPLAY_CHECKSUM_INTERVAL == 0u)
+    {
+        const auto hash = checksum(reg);
+        if (m_mode == EMode::Recording)
+        {
+            m_checkpoints.push_back(hash);
+        }
+        else if (const auto index = m_tick / REPLAY_CHECKSUM_INTERVAL - 1u; index < m_checkpoints.size())
+        {
+            if (m_checkpoints[index] == hash)
+            {
+                ++m_checkpoints_matched;
+            }
+            else if (m_first_mismatch == UINT32_MAX)
+            {
+                m_first_mismatch = m_tick - 1u;
+                GFX_WARN("Replay diverged from the recording at tick %u.", m_first_mismatch);
+            }
+        }
+    }
+
+    const bool playback = m_mode == EMode::Playback;
+    const bool finished = playback ? m_tick >= m_delta_times.size() : m_level_ended;
+    if (finished)
+    {
+        finish(reg);
+    }
+    return finished && playback;
+}
+
+void Replay::finish(entt::registry& reg)
+{
+    if (!m_active)
+    {
+        *this = {};
+        return;
+    }
+
+    g_event_queue.sink<EvLevelFinished>().disconnect<&Replay::on_level_finished>(*this);
+    const auto final_checksum = checksum(reg);
+
+    if (m_mode == EMode::Recording)
+    {
+        g_event_queue.sink<EvInput>().disconnect<&Replay::recieve_input>(*this);
+        m_final_score = m_score;
+        m_final_checksum = final_checksum;
+        if (write())
+        {
+            GFX_INFO("Recorded %u ticks and %zu inputs of %s to %s (final score %d).", m_tick, m_inputs.size(),
+                     m_level_name.c_str(), m_path.c_str(), m_final_score);
+        }
+    }
+    else
+    {
+        get_input().set_enabled(true);
+
+        const auto seconds =
+            std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_playback_start).count(), 1e-9);
+        const auto expected_checkpoints = std::min<std::size_t>(m_checkpoints.size(), m_tick / REPLAY_CHECKSUM_INTERVAL);
+        const bool complete = m_tick >= m_delta_times.size();
+        const bool deterministic = complete && m_checkpoints_matched == expected_checkpoints && m_score == m_final_score &&
+                                   final_checksum == m_final_checksum;
+
+        GFX_INFO("Played back %u of %zu ticks of %s in %.3fs (%.0f ticks per second).", m_tick, m_delta_times.size(),
+                 m_level_name.c_str(), seconds, m_tick / seconds);
+        GFX_INFO("Checkpoints matched: %u of %zu (every %u ticks), final score %d (recorded %d), final checksum %s.",
+                 m_checkpoints_matched, expected_checkpoints, REPLAY_CHECKSUM_INTERVAL, m_score, m_final_score,
+                 final_checksum == m_final_checksum ? "matches" : "differs");
+        if (deterministic)
+        {
+            GFX_INFO("Replay %s is deterministic.", m_path.c_str());
+        }
+        else
+        {
+            GFX_WARN("Replay %s did not play back like it was recorded.", m_path.c_str());
+        }
+    }
+
+    *this = {};
+}
+
+void Replay::draw_overlay() const
+{
+    if (m_active && m_mode == EMode::Recording)
+    {
+        ImGui::Text("Recording replay: tick %u  inputs %zu", m_tick, m_inputs.size());
+    }
+    else if (m_active)
+    {
+        ImGui::Text("Playing replay: tick %u/%zu  checkpoints %u ok%s", m_tick, m_delta_times.size(), m_checkpoints_matched,
+                    m_first_mismatch == UINT32_MAX ? "" : " (diverged)");
+    }
+}
+
+void Replay::recieve_input(const EvInput& input) { m_inputs.push_back({m_tick, input.action}); }
+
+void Replay::on_level_finished([[maybe_unused]] const EvLevelFinished& data) { m_level_ended = true; }
+
+bool Replay::write() const
+{
+    Writer writer{};
+    for (auto c : REPLAY_MAGIC)
+    {
+        writer.put(c);
+    }
+    writer.put(REPLAY_VERSION);
+    writer.put(static_cast<uint16_t>(REPLAY_CHECKSUM_INTERVAL));
+    writer.put(static_cast<uint16_t>(m_level_name.size()));
+    writer.bytes += m_level_name;
+
+    writer.put(static_cast<uint32_t>(m_delta_times.size()));
+    writer.put(static_cast<uint32_t>(m_inputs.size()));
+    writer.put(static_cast<uint32_t>(m_checkpoints.size()));
+    writer.put(m_final_score);
+    writer.put(m_final_checksum);
+
+    for (auto dt : m_delta_times)
+    {
+        writer.put(dt);
+    }
+
+    uint32_t previous_tick = 0u;
+    for (const auto& input : m_inputs)
+    {
+        writer.put_varint(input.tick - previous_tick);
+        writer.put(static_cast<uint8_t>(input.action));
+        previous_tick = input.tick;
+    }
+
+    for (auto checkpoint : m_checkpoints)
+    {
+        writer.put(checkpoint);
+    }
+
+    std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        GFX_WARN("Could not open %s to write the replay.", m_path.c_str());
+        return false;
+    }
+    file.write(writer.bytes.data(), static_cast<std::streamsize>(writer.bytes.size()));
+    return static_cast<bool>(file);
+}
+
+uint64_t Replay::checksum(entt::registry& reg)
+{
+    /* Entity ids and the order of views depend on what was created and destroyed before, not only on the simulation. So every
+     * entity is hashed on its own, without its id, and the hashes are combined in the order of where the entities spawned
+     * (and their own hash, for entities that spawned at the same place) */
+    struct EntityHash
+    {
+        glm::ivec2 spawn = {};
+        uint64_t hash = 0u;
+    };
+
+    std::vector<EntityHash> entities{};
+    entities.reserve(reg.size<CPosition>());
+    reg.view<CPosition>().each([&reg, &entities](entt::entity e, const CPosition& pos) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        fnv1a(hash, pos.position.x);
+        fnv1a(hash, pos.position.y);
+
+        if (const auto* movement = reg.try_get<CMovement>(e))
+        {
+            fnv1a(hash, movement->current_direction.x);
+            fnv1a(hash, movement->current_direction.y);
+            fnv1a(hash, movement->progress);
+        }
+
+        if (const auto* player = reg.try_get<CPlayer>(e))
+        {
+            fnv1a(hash, player->lives);
+            fnv1a(hash, player->score);
+        }
+
+        if (const auto* ai = reg.try_get<CAI>(e))
+        {
+            fnv1a(hash, ai->state);
+            fnv1a(hash, ai->target.x);
+            fnv1a(hash, ai->target.y);
+        }
+
+        entities.push_back({pos.spawn, hash});
+    });
+
+    std::sort(entities.begin(), entities.end(), [](const EntityHash& a, const EntityHash& b) {
+        return std::tie(a.spawn.x, a.spawn.y, a.hash) < std::tie(b.spawn.x, b.spawn.y, b.hash);
+    });
+
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const auto& entity : entities)
+    {
+        fnv1a(hash, entity.spawn.x);
+        fnv1a(hash, entity.spawn.y);
+        fnv1a(hash, entity.hash);
+    }
+    return hash;
+}
+
+Replay& get_replay()
+{
+    static Replay replay{};
+    return replay;
+}
+}  // namespace pac
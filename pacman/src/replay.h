@@ -0,0 +1,175 @@
+/*!
+ * \file replay.h contains recording and playback of played levels. A replay is the level name, the delta time of every tick and
+ * the tick-stamped EvInput stream, plus checksums of the world every REPLAY_CHECKSUM_INTERVAL ticks. The game has no random
+ * number generator, so with the same delta times and inputs the simulation is deterministic and playback can verify that the
+ * world, final score and positions match what was recorded.
+ */
+
+#pragma once
+
+#include "input/input.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include <entt/entity/registry.hpp>
+
+namespace pac
+{
+struct EvInput;
+struct EvLevelFinished;
+
+/*!
+ * \brief The Replay class records the first level played after recording is requested, or plays a replay file back by
+ * overriding the delta time and feeding the recorded input to the event queue. Ticks are game loop iterations, counted from
+ * the iteration after the level was loaded.
+ */
+class Replay
+{
+public:
+    /*!
+     * \brief The EMode enum is what the replay is used for
+     */
+    enum class EMode
+    {
+        Idle,
+        Recording,
+        Playback
+    };
+
+private:
+    /*!
+     * \brief The InputRecord struct is an input action and the tick it was delivered in
+     */
+    struct InputRecord
+    {
+        uint32_t tick = 0u;
+        Action action = ACTION_NONE;
+    };
+
+    /* What the replay is used for, and whether the level has been loaded (armed) and the ticks have started (active) */
+    EMode m_mode = EMode::Idle;
+    bool m_armed = false;
+    bool m_active = false;
+
+    /* File recorded to, or played back from */
+    std::string m_path = {};
+
+    /* Contents of the replay */
+    std::string m_level_name = {};
+    std::vector<float> m_delta_times = {};
+    std::vector<InputRecord> m_inputs = {};
+    std::vector<uint64_t> m_checkpoints = {};
+    int32_t m_final_score = 0;
+    uint64_t m_final_checksum = 0u;
+
+    /* Current tick, and the next input to play back */
+    uint32_t m_tick = 0u;
+    std::size_t m_next_input = 0u;
+
+    /* Set when the level ended this tick, the replay then finishes at the end of the tick */
+    bool m_level_ended = false;
+
+    /* Score of the player at the end of the latest tick where there was one */
+    int32_t m_score = 0;
+
+    /* Playback results */
+    uint32_t m_checkpoints_matched = 0u;
+    uint32_t m_first_mismatch = UINT32_MAX;
+    std::chrono::steady_clock::time_point m_playback_start = {};
+
+public:
+    Replay() = default;
+
+    /* Moving is only used to reset or replace the replay while nothing is connected to it */
+    Replay(const Replay&) = delete;
+    Replay(Replay&&) = default;
+    Replay& operator=(const Replay&) = delete;
+    Replay& operator=(Replay&&) = default;
+    ~Replay() noexcept = default;
+
+    /*!
+     * \brief request_recording records the next level that is played to a replay file
+     * \param fp is the file to write when the level ends
+     */
+    void request_recording(std::string_view fp);
+
+    /*!
+     * \brief load reads a replay file to play back, the caller then loads the level returned by get_level_name
+     * \param fp is the file to read
+     * \return true if the file was read, false (with a warning) if it could not be read or is not a valid replay
+     */
+    bool load(std::string_view fp);
+
+    /*!
+     * \brief get_mode returns what the replay is used for
+     */
+    EMode get_mode() const;
+
+    /*!
+     * \brief get_level_name returns the name of the level in the replay
+     */
+    const std::string& get_level_name() const;
+
+    /*!
+     * \brief on_level_loaded is called by the GameState when it has loaded a level, which arms recording or playback
+     * \param level_name is the name of the level
+     */
+    void on_level_loaded(std::string_view level_name);
+
+    /*!
+     * \brief on_level_exited is called by the GameState when it is exited, which ends the replay after the current tick
+     */
+    void on_level_exited();
+
+    /*!
+     * \brief begin_tick starts a tick, call at the start of every game loop iteration before the event queue is updated
+     * \param dt is the measured delta time
+     * \return the delta time to simulate the tick with (the recorded one when playing back)
+     */
+    float begin_tick(float dt);
+
+    /*!
+     * \brief end_tick ends a tick, call at the end of every game loop iteration
+     * \param reg is the registry of the game world, used for the checksums
+     * \return true if a replay finished playing back during this tick
+     */
+    bool end_tick(entt::registry& reg);
+
+    /*!
+     * \brief finish writes the recording, or reports the result of the playback, if the replay is active
+     * \param reg is the registry of the game world, used for the final checksum
+     */
+    void finish(entt::registry& reg);
+
+    /*!
+     * \brief draw_overlay adds the replay progress to the current ImGui window while a replay is active
+     */
+    void draw_overlay() const;
+
+private:
+    void recieve_input(const EvInput& input);
+
+    void on_level_finished(const EvLevelFinished& data);
+
+    /*!
+     * \brief write writes the recorded replay to m_path
+     * \return true if the file was written
+     */
+    bool write() const;
+
+    /*!
+     * \brief checksum hashes the positions, movement, players and AI states of the world. It only depends on the state of the
+     * entities and where they spawned, not on their ids or the order they are stored in.
+     */
+    static uint64_t checksum(entt::registry& reg);
+};
+
+/*!
+ * \brief get_replay returns the replay singleton
+ */
+Replay& get_replay();
+}  // namespace pac
@@ -0,0 +1,809 @@
+#include "score_journal.h"
+#include "encrypt/crypt_stream.h"
+#include "config.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <gfx.h>
+#include <cglutil.h>
+
+namespace pac
+{
+namespace
+{
+/* Identifies score journals, and the version of the format below */
+constexpr char JOURNAL_MAGIC[4] = {'P', 'A', 'C', 'J'};
+constexpr uint16_t JOURNAL_VERSION = 3u;
+
+/* Journals of these versions are one file of scores with no checkpoint, they are read and then rewritten in the current
+ * version (version 1 is not encrypted) */
+constexpr uint16_t JOURNAL_VERSION_UNSEGMENTED = 2u;
+constexpr uint16_t JOURNAL_VERSION_UNENCRYPTED = 1u;
+
+/*
+ * Journal file layout, all values little endian:
+ *   magic[4] version:u16
+ *   records: length:u32 crc:u32 payload[length]
+ * where the CRC covers the length and the payload, and the payload is a type:u8 followed by a score
+ *   level_length:u16 level[level_length] name_length:u16 name[name_length] score:i32
+ * or by a checkpoint, which is the index as it was after the scores of every sealed segment
+ *   sealed_segments:u32 records:u64 level_count:u32
+ *   levels: level_length:u16 level[level_length] count:u64 top_count:u16
+ *           top: name_length:u16 name[name_length] score:i32
+ * Everything after the version is encrypted, each byte with its position in the file.
+ *
+ * The journal is the active segment (highscores.journal), which scores are appended to, and the sealed segments next to it
+ * (highscores.journal.000000 and up), which hold the older scores and are never written again. Every segment starts with a
+ * checkpoint, and a segment is sealed by renaming it after the new active segment has been written, so the last sealed
+ * segment always holds everything an active segment lost in a crash can be started from.
+ *
+ * No older score file is dropped when the format changes. The VignereEncryption text file (highscores.txt) becomes the
+ * journal when there is no journal yet, and version 1 and 2 journals have their scores rewritten in the current version.
+ */
+constexpr std::size_t HEADER_SIZE = sizeof(JOURNAL_MAGIC) + sizeof(uint16_t);
+constexpr std::size_t RECORD_HEADER_SIZE = 2u * sizeof(uint32_t);
+
+enum class ERecordType : uint8_t
+{
+    Score,
+    Checkpoint
+};
+
+template<typename T>
+void append_le(std::string& out, T value)
+{
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+    {
+        out.push_back(static_cast<char>(static_cast<uint64_t>(value) >> (8u * i)));
+    }
+}
+
+template<typename T>
+void store_le(char* bytes, T value)
+{
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+    {
+        bytes[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8u * i));
+    }
+}
+
+template<typename T>
+T read_le(const char* bytes)
+{
+    uint64_t value = 0u;
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+    {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8u * i);
+    }
+    return static_cast<T>(value);
+}
+
+/*!
+ * \brief append_string appends a string with its length in front, cut to the longest length that fits
+ */
+void append_string(std::string& out, const std::string& value)
+{
+    const auto length = static_cast<uint16_t>(std::min<std::size_t>(value.size(), UINT16_MAX));
+    append_le(out, length);
+    out.append(value, 0u, length);
+}
+
+/*!
+ * \brief record_crc returns the CRC of a record's length and payload
+ */
+uint32_t record_crc(const char* record, std::size_t payload_size)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(record);
+    return crc32(bytes + RECORD_HEADER_SIZE, payload_size, crc32(bytes, sizeof(uint32_t))) ^ 0xFFFFFFFFu;
+}
+
+/*!
+ * \brief begin_record appends the header of a record and its type, the payload is appended after it
+ * \return where the record starts, to pass to end_record
+ */
+std::size_t begin_record(std::string& out, ERecordType type)
+{
+    const auto start = out.size();
+    out.append(RECORD_HEADER_SIZE, '\0');
+    out.push_back(static_cast<char>(type));
+    return start;
+}
+
+/*!
+ * \brief end_record fills in the length and CRC of the record that starts at start, once its payload has been appended
+ */
+void end_record(std::string& out, std::size_t start)
+{
+    const auto payload_size = out.size() - start - RECORD_HEADER_SIZE;
+    store_le(out.data() + start, static_cast<uint32_t>(payload_size));
+    store_le(out.data() + start + sizeof(uint32_t), record_crc(out.data() + start, payload_size));
+}
+
+/*!
+ * \brief append_score appends a score as a journal record
+ */
+void append_score(std::string& out, const std::string& level, const ScoreEntry& entry)
+{
+    const auto start = begin_record(out, ERecordType::Score);
+    append_string(out, level);
+    append_string(out, entry.name);
+    append_le(out, static_cast<int32_t>(entry.score));
+    end_record(out, start);
+}
+
+/*!
+ * \brief append_checkpoint appends a checkpoint of an index as a journal record
+ * \param sealed_segments is the number of sealed segments the index holds the scores of
+ * \param records is the number of scores in those segments
+ */
+void append_checkpoint(std::string& out, const robin_hood::unordered_map<std::string, ScoreJournal::LevelScores>& levels,
+                       uint32_t sealed_segments, uint64_t records)
+{
+    const auto start = begin_record(out, ERecordType::Checkpoint);
+    append_le(out, sealed_segments);
+    append_le(out, records);
+    append_le(out, static_cast<uint32_t>(levels.size()));
+    for (const auto& [level, scores] : levels)
+    {
+        append_string(out, level);
+        append_le(out, scores.count);
+        append_le(out, static_cast<uint16_t>(scores.top.size()));
+        for (const auto& entry : scores.top)
+        {
+            append_string(out, entry.name);
+            append_le(out, static_cast<int32_t>(entry.score));
+        }
+    }
+    end_record(out, start);
+}
+
+/*!
+ * \brief The PayloadReader struct reads values from a record payload, and fails instead of reading past its end
+ */
+struct PayloadReader
+{
+    const char* data = nullptr;
+    std::size_t size = 0u;
+    std::size_t offset = 0u;
+
+    template<typename T>
+    bool read(T& value)
+    {
+        if (size - offset < sizeof(T))
+        {
+            return false;
+        }
+
+        value = read_le<T>(data + offset);
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& value)
+    {
+        uint16_t length = 0u;
+        if (!read(length) || size - offset < length)
+        {
+            return false;
+        }
+
+        value.assign(data + offset, length);
+        offset += length;
+        return true;
+    }
+
+    bool done() const { return offset == size; }
+};
+
+/*!
+ * \brief read_score decodes the payload of a score record
+ * \return false if the payload is not a score
+ */
+bool read_score(PayloadReader& reader, std::string& level, ScoreEntry& entry)
+{
+    int32_t score = 0;
+    if (!reader.read(level) || !reader.read(entry.name) || !reader.read(score) || !reader.done())
+    {
+        return false;
+    }
+
+    entry.score = score;
+    return true;
+}
+
+/*!
+ * \brief The Checkpoint struct is a decoded checkpoint record
+ */
+struct Checkpoint
+{
+    uint32_t sealed_segments = 0u;
+    uint64_t records = 0u;
+    robin_hood::unordered_map<std::string, ScoreJournal::LevelScores> levels{};
+};
+
+/*!
+ * \brief read_checkpoint decodes the payload of a checkpoint record
+ * \return false if the payload is not a checkpoint
+ */
+bool read_checkpoint(PayloadReader& reader, Checkpoint& checkpoint)
+{
+    uint32_t level_count = 0u;
+    if (!reader.read(checkpoint.sealed_segments) || !reader.read(checkpoint.records) || !reader.read(level_count))
+    {
+        return false;
+    }
+
+    std::string level = {};
+    for (uint32_t i = 0u; i < level_count; ++i)
+    {
+        ScoreJournal::LevelScores scores{};
+        uint16_t top_count = 0u;
+        if (!reader.read(level) || !reader.read(scores.count) || !reader.read(top_count))
+        {
+            return false;
+        }
+
+        scores.top.resize(top_count);
+        for (auto& entry : scores.top)
+        {
+            int32_t score = 0;
+            if (!reader.read(entry.name) || !reader.read(score))
+            {
+                return false;
+            }
+            entry.score = score;
+        }
+        checkpoint.levels[level] = std::move(scores);
+    }
+    return reader.done();
+}
+
+/*!
+ * \brief read_journal reads a journal file and decrypts everything after its header
+ * \param bytes is given the file, decrypted
+ * \param limit is the most bytes to read
+ * \return the version of the journal, or 0 if the file could not be read or is not a journal
+ */
+uint16_t read_journal(const std::string& fp, BaseStreamCrypt& crypt, std::string& bytes, uint64_t limit)
+{
+    std::ifstream file(fp, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return 0u;
+    }
+
+    bytes.assign(static_cast<std::size_t>(std::min<uint64_t>(static_cast<uint64_t>(file.tellg()), limit)), '\0');
+    file.seekg(0);
+    file.read(bytes.data(), static_cast<std::streamsize>(std::min(bytes.size(), HEADER_SIZE)));
+
+    const auto version = bytes.size() >= HEADER_SIZE ? read_le<uint16_t>(bytes.data() + sizeof(JOURNAL_MAGIC)) : 0u;
+    if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+        version < JOURNAL_VERSION_UNENCRYPTED || version > JOURNAL_VERSION)
+    {
+        return 0u;
+    }
+
+    auto* body = reinterpret_cast<uint8_t*>(bytes.data() + HEADER_SIZE);
+    if (version != JOURNAL_VERSION_UNENCRYPTED)
+    {
+        read_encrypted(file, crypt, body, bytes.size() - HEADER_SIZE, HEADER_SIZE);
+    }
+    else
+    {
+        file.read(reinterpret_cast<char*>(body), static_cast<std::streamsize>(bytes.size() - HEADER_SIZE));
+    }
+    return version;
+}
+
+/*!
+ * \brief for_each_record calls on_score(level, entry) for every score of a decrypted journal, and on_checkpoint(reader) with
+ * the payload of every checkpoint. It stops at the first record that is cut short, fails its CRC or can not be decoded, or
+ * that on_checkpoint returns false for.
+ * \param version is the version of the journal, scores of older versions have no type in front
+ * \return the offset just past the last good record, which is where the journal should end
+ */
+template<typename ScoreFn, typename CheckpointFn>
+std::size_t for_each_record(const std::string& bytes, uint16_t version, ScoreFn&& on_score, CheckpointFn&& on_checkpoint)
+{
+    std::size_t offset = HEADER_SIZE;
+    std::string level = {};
+    ScoreEntry entry = {};
+    while (bytes.size() - offset >= RECORD_HEADER_SIZE)
+    {
+        const auto* record = bytes.data() + offset;
+        const auto size = read_le<uint32_t>(record);
+        if (size > bytes.size() - offset - RECORD_HEADER_SIZE ||
+            read_le<uint32_t>(record + sizeof(uint32_t)) != record_crc(record, size))
+        {
+            break;
+        }
+
+        PayloadReader reader{record + RECORD_HEADER_SIZE, size};
+        uint8_t type = static_cast<uint8_t>(ERecordType::Score);
+        if (version == JOURNAL_VERSION && !reader.read(type))
+        {
+            break;
+        }
+
+        if (type == static_cast<uint8_t>(ERecordType::Score) && read_score(reader, level, entry))
+        {
+            on_score(level, entry);
+        }
+        else if (type != static_cast<uint8_t>(ERecordType::Checkpoint) || !on_checkpoint(reader))
+        {
+            break;
+        }
+        offset += RECORD_HEADER_SIZE + size;
+    }
+    return offset;
+}
+
+/*!
+ * \brief skip_checkpoint is the on_checkpoint of for_each_record for when only the scores are wanted
+ */
+bool skip_checkpoint(const PayloadReader&) { return true; }
+
+/*!
+ * \brief segment_path returns the path of a sealed segment of the journal with the given active segment
+ */
+std::string segment_path(const std::string& path, uint32_t segment)
+{
+    char number[16] = {};
+    std::snprintf(number, sizeof(number), ".%06u", segment);
+    return path + number;
+}
+
+/*!
+ * \brief count_sealed_segments returns the number of sealed segments of the journal with the given active segment, which
+ * are numbered from 0 with no gaps
+ */
+uint32_t count_sealed_segments(const std::string& path)
+{
+    uint32_t segments = 0u;
+    while (std::filesystem::exists(segment_path(path, segments)))
+    {
+        ++segments;
+    }
+    return segments;
+}
+
+/*!
+ * \brief sync_file makes the OS write a file that has been written and flushed to the disk
+ * \param data_only is true to skip metadata that is not needed to read the data back, like the modification time
+ * \return true if the file was synced
+ */
+bool sync_file(const std::string& fp, bool data_only)
+{
+#ifdef _WIN32
+    static_cast<void>(data_only);
+    const auto file = CreateFileA(fp.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    const bool synced = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return synced;
+#else
+    /* Syncing any descriptor of a file writes all of its data, not just what was written through that descriptor */
+    const int fd = ::open(fp.c_str(), O_WRONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+#ifdef __linux__
+    const bool synced = (data_only ? ::fdatasync(fd) : ::fsync(fd)) == 0;
+#else
+    static_cast<void>(data_only);
+    const bool synced = ::fsync(fd) == 0;
+#endif
+    ::close(fd);
+    return synced;
+#endif
+}
+
+/*!
+ * \brief sync_directory makes the OS write a directory to the disk, so a file that was renamed into it is still there after
+ * a crash (on Windows the rename itself is journaled, so there is nothing to do)
+ * \return true if the directory was synced
+ */
+bool sync_directory(const std::filesystem::path& dir)
+{
+#ifdef _WIN32
+    static_cast<void>(dir);
+    return true;
+#else
+    const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    const bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
+}  // namespace
+
+ScoreJournal::ScoreJournal() : m_crypt(ENCRYPTION_STRING) {}
+
+bool ScoreJournal::open(const std::string& fp, const std::string& legacy_fp)
+{
+    const auto start = std::chrono::steady_clock::now();
+    m_file.close();
+    m_path = fp;
+    m_sealed_scores.clear();
+    reset_index();
+
+    /* Read the whole active segment at once, decrypting it as it is read, and replay its scores onto its checkpoint */
+    std::string bytes = {};
+    std::size_t end = 0u;
+    const bool exists = std::filesystem::exists(fp);
+    const auto version = exists ? load_segment(fp, bytes, end) : uint16_t{0u};
+    if (version == 0u)
+    {
+        if (exists)
+        {
+            /* Keep the file around instead of overwriting it */
+            GFX_WARN("%s is not a score journal, or was written by another version of the game. Moving it to %s.bad.",
+                     fp.c_str(), fp.c_str());
+            std::error_code ec{};
+            std::filesystem::rename(fp, fp + ".bad", ec);
+            reset_index();
+        }
+
+        /* Without an active segment the journal goes on from its last sealed segment, which is also where a crash while a
+         * segment was being sealed leaves it */
+        if (const auto sealed_segments = count_sealed_segments(fp); sealed_segments > 0u)
+        {
+            return recover(sealed_segments);
+        }
+
+        /* Start the journal with the scores of the old high score file, if there is one. It is decrypted with the
+         * VignereEncryption it was written with, and left as it is so an older build of the game can still read it. */
+        std::string records = {};
+        append_checkpoint(records, m_levels, 0u, 0u);
+        if (!exists && !legacy_fp.empty() && std::filesystem::exists(legacy_fp))
+        {
+            auto legacy = load_high_score_entries_from_file(legacy_fp.c_str());
+            for (auto& [level, scores] : legacy)
+            {
+                std::stable_sort(scores.begin(), scores.end(),
+                                 [](const ScoreEntry& a, const ScoreEntry& b) { return a.score > b.score; });
+                for (const auto& entry : scores)
+                {
+                    append_score(records, level, entry);
+                    insert(level, entry);
+                    ++m_records;
+                }
+            }
+            GFX_INFO("Migrating %llu high scores of %zu levels from %s.", static_cast<unsigned long long>(m_records),
+                     legacy.size(), legacy_fp.c_str());
+        }
+
+        m_segment_records = m_records;
+        return rewrite(records) && (m_segment_records < SCORE_JOURNAL_SEGMENT_RECORDS || seal());
+    }
+
+    GFX_INFO("Replayed %llu scores (%llu in all) of %zu levels from %s in %.2fms.",
+             static_cast<unsigned long long>(m_segment_records), static_cast<unsigned long long>(m_records), m_levels.size(),
+             fp.c_str(), std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    /* Old journals have every score rewritten in the current version, after an empty checkpoint. If they hold too many
+     * scores for one segment, they are sealed right away. */
+    if (version <= JOURNAL_VERSION_UNSEGMENTED)
+    {
+        std::string records = {};
+        append_checkpoint(records, decltype(m_levels){}, 0u, 0u);
+        for_each_record(
+            bytes, version,
+            [&records](const std::string& level, const ScoreEntry& entry) { append_score(records, level, entry); },
+            skip_checkpoint);
+        return rewrite(records) && (m_segment_records < SCORE_JOURNAL_SEGMENT_RECORDS || seal());
+    }
+
+    /* Whatever follows the last good record was being written when the game stopped */
+    if (end < bytes.size())
+    {
+        GFX_WARN("Cutting %zu bytes of a torn or corrupt record off the end of %s.", bytes.size() - end, fp.c_str());
+        std::error_code ec{};
+        std::filesystem::resize_file(fp, end, ec);
+        if (ec)
+        {
+            GFX_WARN("Could not cut %s: %s", fp.c_str(), ec.message().c_str());
+            return rewrite(bytes.substr(HEADER_SIZE, end - HEADER_SIZE));
+        }
+        sync_file(fp, false);
+    }
+
+    m_size = end;
+    m_file.open(fp, std::ios::binary | std::ios::app);
+    return m_file.is_open() && (m_segment_records < SCORE_JOURNAL_SEGMENT_RECORDS || seal());
+}
+
+bool ScoreJournal::add(const std::string& level, const ScoreEntry& entry)
+{
+    if (m_file.is_open())
+    {
+        std::string record = {};
+        append_score(record, level, entry);
+        write_encrypted(m_file, m_crypt, record.data(), record.size(), m_size);
+        m_file.flush();
+
+        /* Stop appending after a failed write, so no good record ends up behind a torn one */
+        if (m_file)
+        {
+            ++m_records;
+            ++m_segment_records;
+            m_size += record.size();
+
+            /* The size of the file changes, so that has to be synced too, but nothing else does */
+            if (!sync_file(m_path, true))
+            {
+                GFX_WARN("Could not sync %s, the last score may be lost if the system crashes.", m_path.c_str());
+            }
+        }
+        else
+        {
+            GFX_WARN("Could not add a score to %s, scores are only kept until the game is closed.", m_path.c_str());
+            m_file.close();
+        }
+    }
+
+    /* The score is indexed before the segment is sealed, so the checkpoint of the next segment has it */
+    const bool top_score = insert(level, entry);
+    if (m_file.is_open() && m_segment_records >= SCORE_JOURNAL_SEGMENT_RECORDS)
+    {
+        seal();
+    }
+    return top_score;
+}
+
+const std::vector<ScoreEntry>& ScoreJournal::get_scores(const std::string& level) const
+{
+    static const std::vector<ScoreEntry> no_scores = {};
+    const auto it = m_levels.find(level);
+    return it != m_levels.end() ? it->second.top : no_scores;
+}
+
+std::vector<ScoreEntry> ScoreJournal::read_all_scores(const std::string& level)
+{
+    /* Sealed segments never change, so each of them is read once for a level and its scores are kept */
+    std::string bytes = {};
+    auto& sealed = m_sealed_scores[level];
+    for (; sealed.segments < m_sealed_segments; ++sealed.segments)
+    {
+        const auto fp = segment_path(m_path, sealed.segments);
+        const auto version = read_journal(fp, m_crypt, bytes, UINT64_MAX);
+        if (version == 0u)
+        {
+            GFX_WARN("Could not read the scores of %s from %s, they are left out.", level.c_str(), fp.c_str());
+            continue;
+        }
+
+        for_each_record(
+            bytes, version,
+            [&level, &sealed](const std::string& record_level, const ScoreEntry& entry) {
+                if (record_level == level)
+                {
+                    sealed.scores.push_back(entry);
+                }
+            },
+            skip_checkpoint);
+    }
+
+    /* Only read as far as the records that have been added to the active segment, in case a write failed part way */
+    const auto version = read_journal(m_path, m_crypt, bytes, m_size);
+    if (version == 0u)
+    {
+        GFX_WARN("Could not read the scores of %s from %s, showing the top scores only.", level.c_str(), m_path.c_str());
+        return get_scores(level);
+    }
+
+    auto scores = sealed.scores;
+    for_each_record(
+        bytes, version,
+        [&level, &scores](const std::string& record_level, const ScoreEntry& entry) {
+            if (record_level == level)
+            {
+                scores.push_back(entry);
+            }
+        },
+        skip_checkpoint);
+    std::stable_sort(scores.begin(), scores.end(), [](const ScoreEntry& a, const ScoreEntry& b) { return a.score > b.score; });
+    return scores;
+}
+
+const robin_hood::unordered_map<std::string, ScoreJournal::LevelScores>& ScoreJournal::get_levels() const { return m_levels; }
+
+uint64_t ScoreJournal::get_record_count() const { return m_records; }
+
+uint32_t ScoreJournal::get_sealed_segment_count() const { return m_sealed_segments; }
+
+bool ScoreJournal::rewrite(const std::string& records, bool seal)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    std::string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    append_le(header, JOURNAL_VERSION);
+
+    /* Write the new active segment next to the old one and sync it, then swap it in with a rename and sync the directory that
+     * holds it, so there always is a complete journal on the disk */
+    const auto tmp_path = m_path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        write_encrypted(file, m_crypt, records.data(), records.size(), HEADER_SIZE);
+        file.close();
+        if (!file || !sync_file(tmp_path, false))
+        {
+            GFX_WARN("Could not write %s to rewrite the score journal.", tmp_path.c_str());
+            std::error_code ec{};
+            std::filesystem::remove(tmp_path, ec);
+            return m_file.is_open();
+        }
+    }
+
+    m_file.close();
+    std::error_code ec{};
+
+    /* A segment is sealed by renaming it once the new active segment is on the disk, so if the game stops in between, the
+     * journal is recovered from the segment that was just sealed */
+    if (seal)
+    {
+        const auto sealed_path = segment_path(m_path, m_sealed_segments);
+        std::filesystem::rename(m_path, sealed_path, ec);
+        if (ec)
+        {
+            GFX_WARN("Could not seal %s as %s, scores are added to it until it can be: %s", m_path.c_str(), sealed_path.c_str(),
+                     ec.message().c_str());
+            std::filesystem::remove(tmp_path, ec);
+            m_file.open(m_path, std::ios::binary | std::ios::app);
+            return m_file.is_open();
+        }
+
+        ++m_sealed_segments;
+        m_segment_records = 0u;
+    }
+
+    std::filesystem::rename(tmp_path, m_path, ec);
+    if (ec)
+    {
+        GFX_WARN("Could not replace %s with the rewritten score journal: %s", m_path.c_str(), ec.message().c_str());
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    if (!sync_directory(std::filesystem::path(m_path).parent_path()))
+    {
+        GFX_WARN("Could not sync the directory of %s, it may be lost if the system crashes.", m_path.c_str());
+    }
+
+    GFX_INFO("Wrote a checkpoint and %llu scores (%zu bytes) to %s in %.2fms.",
+             static_cast<unsigned long long>(m_segment_records), HEADER_SIZE + records.size(), m_path.c_str(),
+             std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    m_size = HEADER_SIZE + records.size();
+    m_file.open(m_path, std::ios::binary | std::ios::app);
+    return m_file.is_open();
+}
+
+bool ScoreJournal::seal()
+{
+    std::string records = {};
+    append_checkpoint(records, m_levels, m_sealed_segments + 1u, m_records);
+    return rewrite(records, true);
+}
+
+uint16_t ScoreJournal::load_segment(const std::string& fp, std::string& bytes, std::size_t& end)
+{
+    const auto version = read_journal(fp, m_crypt, bytes, UINT64_MAX);
+    if (version == 0u)
+    {
+        return 0u;
+    }
+
+    /* Segments of the current version start with a checkpoint, older journals start with no scores */
+    bool checkpointed = version != JOURNAL_VERSION;
+    end = for_each_record(
+        bytes, version,
+        [this](const std::string& level, const ScoreEntry& entry) {
+            insert(level, entry);
+            ++m_records;
+            ++m_segment_records;
+        },
+        [this, &checkpointed](PayloadReader& reader) {
+            Checkpoint checkpoint{};
+            if (checkpointed || m_segment_records > 0u || !read_checkpoint(reader, checkpoint))
+            {
+                return false;
+            }
+
+            m_levels = std::move(checkpoint.levels);
+            m_records = checkpoint.records;
+            m_sealed_segments = checkpoint.sealed_segments;
+            checkpointed = true;
+            return true;
+        });
+    return checkpointed ? version : uint16_t{0u};
+}
+
+bool ScoreJournal::recover(uint32_t sealed_segments)
+{
+    /* The last sealed segment was the active segment before it was sealed, so the new one goes on from where it ends */
+    const auto last_path = segment_path(m_path, sealed_segments - 1u);
+    GFX_WARN("%s is missing, starting it again from %s.", m_path.c_str(), last_path.c_str());
+
+    std::string bytes = {};
+    std::size_t end = 0u;
+    if (load_segment(last_path, bytes, end) == 0u)
+    {
+        GFX_WARN("Could not read %s, the top scores start over (the sealed segments still hold every score).",
+                 last_path.c_str());
+        reset_index();
+    }
+
+    m_sealed_segments = sealed_segments;
+    m_segment_records = 0u;
+    std::string records = {};
+    append_checkpoint(records, m_levels, m_sealed_segments, m_records);
+    return rewrite(records);
+}
+
+void ScoreJournal::reset_index()
+{
+    m_levels.clear();
+    m_records = 0u;
+    m_segment_records = 0u;
+    m_sealed_segments = 0u;
+    m_size = 0u;
+}
+
+bool ScoreJournal::insert(const std::string& level, const ScoreEntry& entry)
+{
+    auto& scores = m_levels[level];
+    ++scores.count;
+
+    auto& top = scores.top;
+    const auto it = std::upper_bound(top.begin(), top.end(), entry.score,
+                                     [](int score, const ScoreEntry& e) { return score > e.score; });
+    if (static_cast<std::size_t>(it - top.begin()) >= HIGH_SCORE_TOP_K)
+    {
+        return false;
+    }
+
+    top.insert(it, entry);
+    if (top.size() > HIGH_SCORE_TOP_K)
+    {
+        top.pop_back();
+    }
+    return true;
+}
+
+ScoreJournal& get_score_journal()
+{
+    static ScoreJournal journal{};
+    [[maybe_unused]] static const bool opened = [] {
+        const auto res_path = std::filesystem::path(cgl::native_absolute_path("res"));
+        return journal.open((res_path / "highscores.journal").string(), (res_path / "highscores.txt").string());
+    }();
+
+    return journal;
+}
+}  // namespace pac
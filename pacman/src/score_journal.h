@@ -0,0 +1,176 @@
+/*!
+ * \file score_journal.h contains the high score journal. Every submitted score is appended to the journal as one record and
+ * kept there for good, and the best HIGH_SCORE_TOP_K scores of every level are kept in memory, so adding or looking up top
+ * scores never reads or rewrites the whole journal. The full history of a level is read from the journal when it is asked for.
+ */
+
+#pragma once
+
+#include "common.h"
+#include "encrypt/keystream_encryptor.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+
+#include <robinhood/robinhood.h>
+
+namespace pac
+{
+/*!
+ * \brief The ScoreJournal class is an append-only log of scores with the top scores of every level indexed in memory. A
+ * record is only accepted when its CRC matches, so a record torn by a crash is cut off the end of the file the next time it
+ * is opened. Every record is synced to the disk as it is added, and a file that has to be rewritten (when the journal is
+ * created, migrated, recovered or a segment is sealed) is written to a new file that is synced and then swapped in with a
+ * rename. Everything after the file header is encrypted with a KeystreamEncryption keyed by the position in the file, so
+ * records are encrypted as they are appended.
+ *
+ * Scores are appended to the active segment. Once it holds SCORE_JOURNAL_SEGMENT_RECORDS scores it is sealed (renamed and never
+ * written again), and a new active segment is started with a checkpoint of the index: the top scores and score count of every
+ * level. Opening the journal loads the checkpoint and replays only the scores after it, so it takes the same time however many
+ * scores the sealed segments hold.
+ */
+class ScoreJournal
+{
+public:
+    /*!
+     * \brief The LevelScores struct is what is kept in memory for a level
+     */
+    struct LevelScores
+    {
+        /* Best scores, highest first (scores that are equal keep the order they were added in) */
+        std::vector<ScoreEntry> top = {};
+
+        /* Scores of the level in the journal */
+        uint64_t count = 0u;
+    };
+
+private:
+    /*!
+     * \brief The SealedScores struct is the scores of a level that have been read from the sealed segments so far, in the order
+     * they were added
+     */
+    struct SealedScores
+    {
+        uint32_t segments = 0u;
+        std::vector<ScoreEntry> scores = {};
+    };
+
+    /* The active segment, and the stream appending to it (open while the journal is) */
+    std::string m_path = {};
+    std::ofstream m_file{};
+
+    /* Size of the active segment, which is where the next record is written */
+    uint64_t m_size = 0u;
+
+    KeystreamEncryption m_crypt;
+
+    robin_hood::unordered_map<std::string, LevelScores> m_levels{};
+
+    /* Scores in the journal, and in the active segment after its checkpoint */
+    uint64_t m_records = 0u;
+    uint64_t m_segment_records = 0u;
+
+    /* Sealed segments, which are m_path followed by their number (see segment_path) */
+    uint32_t m_sealed_segments = 0u;
+
+    /* Scores of the levels whose full history has been read, so no sealed segment is read twice for a level */
+    robin_hood::unordered_map<std::string, SealedScores> m_sealed_scores{};
+
+public:
+    ScoreJournal();
+
+    ScoreJournal(const ScoreJournal&) = delete;
+    ScoreJournal& operator=(const ScoreJournal&) = delete;
+
+    /*!
+     * \brief open reads the active segment of the journal, and creates it if it does not exist
+     * \param fp is the active segment, the sealed segments are next to it
+     * \param legacy_fp is a high score file in the old text format, its scores become the journal if it has to be created
+     * \return true if the journal can be appended to
+     */
+    bool open(const std::string& fp, const std::string& legacy_fp = {});
+
+    /*!
+     * \brief add appends a score to the journal and syncs it to the disk, then adds it to the top scores of its level. The
+     * active segment is sealed when it is full.
+     * \return true if the score is one of the top scores of the level
+     */
+    bool add(const std::string& level, const ScoreEntry& entry);
+
+    /*!
+     * \brief get_scores returns the top scores of a level, highest first
+     */
+    const std::vector<ScoreEntry>& get_scores(const std::string& level) const;
+
+    /*!
+     * \brief read_all_scores reads every score of a level from the journal, highest first. The sealed segments are only read
+     * the first time a level is asked for, after that only the active segment is, but it is still meant for showing the full
+     * history on request rather than every frame.
+     */
+    std::vector<ScoreEntry> read_all_scores(const std::string& level);
+
+    /*!
+     * \brief get_levels returns the top scores and score count of every level that has any
+     */
+    const robin_hood::unordered_map<std::string, LevelScores>& get_levels() const;
+
+    /*!
+     * \brief get_record_count returns the number of scores in the journal
+     */
+    uint64_t get_record_count() const;
+
+    /*!
+     * \brief get_sealed_segment_count returns the number of sealed segments in the journal
+     */
+    uint32_t get_sealed_segment_count() const;
+
+private:
+    /*!
+     * \brief rewrite replaces the active segment with one that holds the given records
+     * \param records is encoded records starting with a checkpoint, not encrypted
+     * \param seal is true to keep the active segment as the next sealed segment instead of replacing it
+     * \return true if the active segment was replaced and can be appended to
+     */
+    bool rewrite(const std::string& records, bool seal = false);
+
+    /*!
+     * \brief seal seals the active segment, and starts a new one with a checkpoint of the index
+     * \return true if the new active segment can be appended to
+     */
+    bool seal();
+
+    /*!
+     * \brief load_segment loads the checkpoint of a segment into the index and replays its scores
+     * \param bytes is given the segment, decrypted
+     * \param end is given the offset just past the last good record
+     * \return the version of the segment, or 0 if it is not a journal or does not start with a checkpoint
+     */
+    uint16_t load_segment(const std::string& fp, std::string& bytes, std::size_t& end);
+
+    /*!
+     * \brief recover starts a new active segment from the last sealed segment, when there is no active segment to open
+     * \param sealed_segments is the number of sealed segments
+     * \return true if the new active segment can be appended to
+     */
+    bool recover(uint32_t sealed_segments);
+
+    /*!
+     * \brief reset_index forgets every score, as if the journal was empty
+     */
+    void reset_index();
+
+    /*!
+     * \brief insert counts an entry for its level, and adds it to the top scores if it is good enough
+     * \return true if the entry is one of the top scores
+     */
+    bool insert(const std::string& level, const ScoreEntry& entry);
+};
+
+/*!
+ * \brief get_score_journal returns the score journal, which is opened on first use (res/highscores.journal, migrated from
+ * res/highscores.txt the first time)
+ */
+ScoreJournal& get_score_journal();
+}  // namespace pac
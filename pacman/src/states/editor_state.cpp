@@ -7,19 +7,19 @@
 #include "input/input.h"
 #include "config.h"
 #include "ui.h"
+#include "event_bus.h"
 
 #include <filesystem>
 
 #include <GLFW/glfw3.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui/imgui.h>
-#include <entt/signal/dispatcher.hpp>
 #include <entt/meta/factory.hpp>
 
 namespace pac
 {
 /* The game event queue */
-extern entt::dispatcher g_event_queue;
+extern EventBus g_event_queue;
 
 void EditorState::on_enter()
 {
@@ -121,13 +121,14 @@ bool EditorState::draw()
                              {}});
     }
 
-    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_overlay});
+    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_overlay},
+                        ELayer::Overlay);
     return false;
 }
 
 void EditorState::recieve_key(const EvInput& input)
 {
-    auto& tile = m_level.get_tile(m_hovered_tile);
+    const auto& tile = m_level.get_tile(m_hovered_tile);
 
     /* Handle editor input */
     switch (input.action)
@@ -136,8 +137,8 @@ void EditorState::recieve_key(const EvInput& input)
     case ACTION_PLACE:
         if (m_editor_mode == EMode::TilePlacement)
         {
-            tile.type = static_cast<Level::ETileType>(m_current_tex);
-            tile.texture = get_renderer().get_tileset_texture(m_current_tex);
+            m_level.set_tile(m_hovered_tile, {static_cast<Level::ETileType>(m_current_tex),
+                                              get_renderer().get_tileset_texture(m_current_tex)});
         }
         else
         {
@@ -147,8 +148,7 @@ void EditorState::recieve_key(const EvInput& input)
     case ACTION_UNDO:
         if (m_editor_mode == EMode::TilePlacement)
         {
-            tile.type = Level::ETileType::Blank;
-            tile.texture = {};
+            m_level.set_tile(m_hovered_tile, {Level::ETileType::Blank, {}});
         }
         else
         {
@@ -202,9 +202,11 @@ void EditorState::draw_ui(float dt)
     ImGui::InputText("Level Name", m_level_name.data(), cgl::size_bytes(m_level_name));
     if (ImGui::Button("Load"))
     {
-        m_entities.clear();
-        m_level.load(*m_context.lua, *m_context.registry, m_level_name.data());
-        load_get_entities();
+        if (m_level.load(*m_context.lua, *m_context.registry, m_level_name.data()))
+        {
+            m_entities.clear();
+            load_get_entities();
+        }
     }
     ImGui::SameLine();
     if (ImGui::Button("Save") && !m_level_name.empty())
@@ -1,11 +1,10 @@
 #include "game_over_state.h"
 #include "main_menu_state.h"
 #include "state_manager.h"
+#include "score_journal.h"
 #include "config.h"
 
-#include <vector>
 #include <cstring>
-#include <algorithm>
 
 #include <cglutil.h>
 #include <imgui/imgui.h>
@@ -23,15 +22,10 @@ void GameOverState::on_enter()
 
 void GameOverState::on_exit()
 {
-    /* Load and sort entries, then write back to file */
-    auto entries = load_high_score_entries_from_file();
-
+    /* Append the score to the journal */
     if (strlen(m_playername.data()) > 0)
     {
-        entries[m_level].emplace_back(ScoreEntry{m_playername.data(), m_score});
-        std::sort(entries.at(m_level).begin(), entries.at(m_level).end(),
-                  [](const ScoreEntry& a, const ScoreEntry& b) { return a.score > b.score; });
-        write_high_score_entries_to_file(entries);
+        get_score_journal().add(m_level, ScoreEntry{m_playername.data(), m_score});
     }
 
     get_input().pop();
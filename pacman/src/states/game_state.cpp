@@ -11,20 +11,41 @@
 #include "state_manager.h"
 #include "pause_state.h"
 #include "input/input.h"
+#include "event_bus.h"
+#include "replay.h"
 #include "config.h"
 
+#include <chrono>
+
 #include <gfx.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <entt/signal/dispatcher.hpp>
 
 namespace pac
 {
-extern entt::dispatcher g_event_queue;
+extern EventBus g_event_queue;
 
 GameState::GameState(GameContext owner, std::string_view level_name) : State(owner)
 {
-    m_level.load(*owner.lua, *m_context.registry, level_name);
+    /* Use the level if it was preloaded, otherwise parse it here */
+    auto data = m_context.state_manager->take_preloaded_level(level_name);
+    const auto preloaded = data.has_value();
+    if (!preloaded)
+    {
+        data = Level::parse(*owner.lua, level_name);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!m_level.instantiate(*owner.lua, *m_context.registry, *data))
+    {
+        /* A broken level is left again right after it is entered, back to where it was started from */
+        m_context.state_manager->pop();
+        return;
+    }
+    GFX_INFO("Level %s was parsed in %.2fms (%s) and instantiated in %.2fms.", data->name.c_str(), data->parse_ms,
+             preloaded ? "preloaded" : "on the main thread",
+             std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    get_replay().on_level_loaded(level_name);
 }
 
 void GameState::on_enter()
@@ -43,6 +64,7 @@ void GameState::on_enter()
     game_input.bind_key(GLFW_KEY_RIGHT, ACTION_MOVE_EAST);
     game_input.bind_key(GLFW_KEY_DOWN, ACTION_MOVE_SOUTH);
     game_input.bind_key(GLFW_KEY_LEFT, ACTION_MOVE_WEST);
+    game_input.bind_key(GLFW_KEY_F3, ACTION_TOGGLE_DEBUG);
     get_input().push(std::move(game_input));
 
     g_event_queue.sink<EvInput>().connect<&GameState::recieve>(*this);
@@ -51,6 +73,7 @@ void GameState::on_enter()
 
 void GameState::on_exit()
 {
+    get_replay().on_level_exited();
     g_event_queue.sink<EvInput>().disconnect<&GameState::recieve>(*this);
     g_event_queue.sink<EvLevelFinished>().disconnect<&GameState::on_win_or_lose>(*this);
 
@@ -62,17 +85,15 @@ void GameState::on_exit()
 bool GameState::update(float dt)
 {
     m_level.update(dt);
-    for (auto& system : m_systems)
-    {
-        system->update(dt);
-    }
+    m_scheduler.run(dt, g_event_queue);
     return false;
 }
 
 bool GameState::draw()
 {
     m_level.draw();
-    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_overlay});
+    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_overlay},
+                        ELayer::Overlay);
     return false;
 }
 
@@ -100,13 +121,18 @@ void GameState::on_win_or_lose(const EvLevelFinished& data)
 
 void GameState::add_systems()
 {
+    /* The order is the order systems see each other's changes in, the scheduler keeps it for systems that conflict. The
+     * animation system only advances CAnimationFrame, which nothing before the rendering system touches, so it goes ahead of
+     * the game system (which runs alone) to overlap the AI and movement systems. */
     m_systems.emplace_back(std::make_unique<InputSystem>(*m_context.registry));
     m_systems.emplace_back(std::make_unique<AISystem>(*m_context.registry, m_level));
     m_systems.emplace_back(std::make_unique<MovementSystem>(*m_context.registry, m_level));
-    m_systems.emplace_back(std::make_unique<GameSystem>(*m_context.registry, m_context));
     m_systems.emplace_back(std::make_unique<AnimationSystem>(*m_context.registry));
+    m_systems.emplace_back(std::make_unique<GameSystem>(*m_context.registry, m_context));
     m_systems.emplace_back(std::make_unique<RenderingSystem>(*m_context.registry));
     //    m_systems.emplace_back(std::make_unique<AudioSystem>(*m_context.registry));
+    m_scheduler.set_systems(m_systems);
+    m_scheduler.set_parallel(SYSTEM_SCHEDULER_PARALLEL);
 }
 
 }  // namespace pac
@@ -5,6 +5,7 @@
 #include <level.h>
 #include <entity/events.h>
 #include <entity/system.h>
+#include <entity/system_scheduler.h>
 #include <rendering/uniform_buffer_object.h>
 #include <states/state.h>
 
@@ -21,8 +22,9 @@ private:
     /* The level / world */
     Level m_level{};
 
-    /* Active Systems */
+    /* Active Systems, and the scheduler that updates them */
     std::vector<std::unique_ptr<System>> m_systems{};
+    SystemScheduler m_scheduler{};
 
     /* Game overlay */
     TextureID m_overlay{};
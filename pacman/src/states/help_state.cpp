@@ -99,7 +99,8 @@ bool pac::HelpState::update(float dt)
 
 bool pac::HelpState::draw()
 {
-    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_splash_texture});
+    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_splash_texture},
+                        ELayer::Background);
     return true;
 }
 }  // namespace pac
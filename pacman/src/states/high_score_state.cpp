@@ -1,9 +1,10 @@
 #include "high_score_state.h"
 #include "state_manager.h"
+#include "score_journal.h"
 #include "config.h"
 #include "input/input.h"
 
-#include <fstream>
+#include <cstdio>
 
 #include <imgui/imgui.h>
 #include <GLFW/glfw3.h>
@@ -17,11 +18,13 @@ void HighScoreState::on_enter()
     InputDomain hs_input_state(true);
     hs_input_state.bind_key(GLFW_KEY_ESCAPE, ACTION_BACK);
     get_input().push(std::move(hs_input_state));
-
-    m_entries = load_high_score_entries_from_file();
 }
 
-void HighScoreState::on_exit() { get_input().pop(); }
+void HighScoreState::on_exit()
+{
+    get_input().pop();
+    m_all_scores.clear();
+}
 
 bool HighScoreState::update(float dt)
 {
@@ -32,7 +35,7 @@ bool HighScoreState::update(float dt)
 
     if (ImGui::BeginTabBar("ScoreTabBar"))
     {
-        for (const auto& [k, v] : m_entries)
+        for (const auto& [k, v] : get_score_journal().get_levels())
         {
             if (ImGui::BeginTabItem(k.c_str()))
             {
@@ -55,30 +58,59 @@ bool HighScoreState::update(float dt)
 
 bool HighScoreState::draw()
 {
-    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_splash_texture});
+    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_splash_texture},
+                        ELayer::Background);
     return false;
 }
 
 void HighScoreState::scores_for(const std::string& level_name)
 {
-    /* Set up a 3 column high score table */
+    /* The top scores are kept in memory, every score is read from the journal the first time it is asked for */
+    const auto& levels = get_score_journal().get_levels();
+    const auto level = levels.find(level_name);
+    const auto count = level != levels.end() ? level->second.count : 0u;
+    if (count > HIGH_SCORE_TOP_K)
+    {
+        char label[64] = {};
+        std::snprintf(label, sizeof(label), "Show all %llu scores##ShowAll", static_cast<unsigned long long>(count));
+        ImGui::Checkbox(label, &m_show_all);
+    }
+
+    const auto* scores = &get_score_journal().get_scores(level_name);
+    if (m_show_all && count > HIGH_SCORE_TOP_K)
+    {
+        auto all = m_all_scores.find(level_name);
+        if (all == m_all_scores.end())
+        {
+            all = m_all_scores.emplace(level_name, get_score_journal().read_all_scores(level_name)).first;
+        }
+        scores = &all->second;
+    }
+
+    /* Set up a 3 column high score table, scrolling if there are more scores than fit */
+    ImGui::BeginChild("ScoreList", {0.f, 420.f});
     ImGui::Columns(3, "ScoreColumns", false);
     ImGui::SetColumnWidth(0, 25.f);
     ImGui::SetColumnWidth(1, 275.f);
 
-    /* Print score for each element */
-    int i = 1;
-    for (const auto& e : m_entries.at(level_name))
+    /* Print score for each element, only the rows that are scrolled into view are drawn */
+    ImGuiListClipper clipper(static_cast<int>(scores->size()));
+    while (clipper.Step())
     {
-        ImGui::Text("%d", i++);
-        ImGui::NextColumn();
-        ImGui::Text("%s", e.name.c_str());
-        ImGui::NextColumn();
-        ImGui::Text("%d", e.score);
-        ImGui::NextColumn();
-        ImGui::Separator();
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+        {
+            const auto& e = (*scores)[static_cast<std::size_t>(i)];
+            ImGui::Text("%d", i + 1);
+            ImGui::NextColumn();
+            ImGui::Text("%s", e.name.c_str());
+            ImGui::NextColumn();
+            ImGui::Text("%d", e.score);
+            ImGui::NextColumn();
+            ImGui::Separator();
+        }
     }
     ImGui::Columns();
+    ImGui::EndChild();
 }
 
 }  // namespace pac
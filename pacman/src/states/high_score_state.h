@@ -4,8 +4,8 @@
 #include "common.h"
 #include "rendering/renderer.h"
 
-#include <vector>
 #include <string>
+#include <vector>
 
 #include <robinhood/robinhood.h>
 
@@ -17,8 +17,9 @@ private:
     /* Splash screen texture */
     TextureID m_splash_texture = {};
 
-    /* All high score entries */
-    robin_hood::unordered_map<std::string, std::vector<ScoreEntry>> m_entries;
+    /* Show every score instead of the top scores, and the scores of the levels that have been read from the journal */
+    bool m_show_all = false;
+    robin_hood::unordered_map<std::string, std::vector<ScoreEntry>> m_all_scores{};
 
 public:
     using State::State;
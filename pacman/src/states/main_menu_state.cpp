@@ -16,6 +16,7 @@ namespace pac
 void pac::MainMenuState::on_enter()
 {
     m_splash_texture = get_renderer().load_texture("res/textures/splash_screen.png");
+    get_sound().configure("simple_theme", 255u, 1u);
     get_sound().play("pacman");
     m_music_id = get_sound().play("simple_theme");
 }
@@ -74,7 +75,8 @@ bool pac::MainMenuState::update(float dt)
 
 bool pac::MainMenuState::draw()
 {
-    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_splash_texture});
+    get_renderer().draw({{SCREEN_W / 2.f, SCREEN_H / 2.f}, glm::vec2(SCREEN_W, SCREEN_H), {1.f, 1.f, 1.f}, m_splash_texture},
+                        ELayer::Background);
     return true;
 }
 
@@ -0,0 +1,135 @@
+#include "render_stress_state.h"
+#include "state_manager.h"
+#include "rendering/renderer.h"
+#include "rendering/instance_packing.h"
+#include "config.h"
+
+#include <cstdint>
+#include <algorithm>
+
+#include <gfx.h>
+#include <imgui/imgui.h>
+
+namespace pac
+{
+namespace
+{
+/* Frames drawn before the counters are checked, so the instance ring has grown to fit the sprites */
+constexpr unsigned WARM_UP_FRAMES = 4u;
+
+/* Layers the sprites are spread over, and how many of those are drawn beneath the static layer */
+constexpr std::size_t LAYERS = 5u;
+constexpr std::size_t LAYERS_BELOW_STATIC = 2u;
+
+unsigned batches_for(std::size_t instances, unsigned capacity)
+{
+    return static_cast<unsigned>((instances + capacity - 1u) / capacity);
+}
+}  // namespace
+
+RenderStressState::RenderStressState(GameContext context, std::size_t sprites, unsigned frames)
+    : State(context), m_sprites(sprites), m_frames(frames + WARM_UP_FRAMES)
+{
+}
+
+void RenderStressState::on_enter()
+{
+    /* Add input state that is blocking so the game below does not react to input while it is hidden */
+    InputDomain stress_input(true);
+    get_input().push(std::move(stress_input));
+}
+
+void RenderStressState::on_exit() { get_input().pop(); }
+
+bool RenderStressState::update([[maybe_unused]] float dt)
+{
+    /* The counters are those of the previous frame, which was drawn by this state once the first frame is done */
+    if (m_frame > WARM_UP_FRAMES)
+    {
+        check_frame();
+    }
+
+    if (m_frame >= m_frames)
+    {
+        report();
+        m_context.state_manager->pop();
+        return false;
+    }
+
+    ImGui::SetNextWindowPos({SCREEN_W / 2.f, SCREEN_H / 2.f}, 0, {.5f, .5f});
+    ImGui::Begin("RenderStressWindow", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove);
+    ImGui::Text("RENDER STRESS TEST: %zu SPRITES, FRAME %u/%u", m_sprites, m_frame + 1u, m_frames);
+    ImGui::End();
+    return false;
+}
+
+bool RenderStressState::draw()
+{
+    /* Tile the screen with small sprites spread over every layer and many depths, so every pass of the sort is exercised
+     * and the sprites beneath and above the static layer both need several batches once there are enough of them */
+    for (std::size_t i = 0u; i < m_sprites; ++i)
+    {
+        const auto x = static_cast<float>((i * 4u) % SCREEN_W);
+        const auto y = static_cast<float>(((i * 4u) / SCREEN_W * 4u) % SCREEN_H);
+        get_renderer().draw({{x, y}, {4.f, 4.f}, {1.f, 1.f, 0.f}, {}}, static_cast<ELayer>(i % LAYERS),
+                            static_cast<uint16_t>((i * 7919u) & 0xFFFFu));
+    }
+
+    ++m_frame;
+    return false;
+}
+
+void RenderStressState::check_frame()
+{
+    const auto& stats = get_renderer().get_frame_stats();
+    ++m_checked_frames;
+    m_submit_ms += stats.submit_ms;
+    m_sort_ms += stats.sort_ms;
+    m_backend_ms += stats.backend_ms;
+    m_batches += stats.batches;
+    m_bytes_uploaded += stats.bytes_uploaded;
+
+    /* The OpenGL backend draws the sprites beneath and above the static layer in batches of at most a segment each, and
+     * uploads every sprite once. The software backend draws straight from the packed instances in one pass */
+    unsigned expected_batches = 1u;
+    std::size_t expected_bytes = 0u;
+    if (get_renderer().get_backend_type() == ERenderBackend::OpenGL)
+    {
+        const auto below = (m_sprites / LAYERS) * LAYERS_BELOW_STATIC + std::min(m_sprites % LAYERS, LAYERS_BELOW_STATIC);
+        expected_batches = stats.segment_capacity > 0u ? batches_for(below, stats.segment_capacity) +
+                                                             batches_for(m_sprites - below, stats.segment_capacity)
+                                                       : 0u;
+        expected_bytes = m_sprites * sizeof(InstanceVertex);
+    }
+
+    if (stats.dynamic_instances != m_sprites || stats.batches != expected_batches || stats.bytes_uploaded != expected_bytes)
+    {
+        GFX_WARN("Render stress frame %u: %u instances, %u batches and %zu bytes uploaded, expected %zu, %u and %zu.",
+                 m_frame, stats.dynamic_instances, stats.batches, stats.bytes_uploaded, m_sprites, expected_batches,
+                 expected_bytes);
+        ++m_failed_frames;
+    }
+}
+
+void RenderStressState::report() const
+{
+    if (m_checked_frames == 0u)
+    {
+        return;
+    }
+
+    const auto frames = static_cast<float>(m_checked_frames);
+    GFX_INFO("Render stress test of %zu sprites over %u frames: %.3fms submit, %.3fms sort, %.3fms backend, %.1f batches and "
+             "%.2fMiB uploaded per frame.",
+             m_sprites, m_checked_frames, m_submit_ms / frames, m_sort_ms / frames, m_backend_ms / frames,
+             m_batches / frames, m_bytes_uploaded / frames / (1024.f * 1024.f));
+    if (m_failed_frames == 0u)
+    {
+        GFX_INFO("Every frame of the render stress test had the expected instance, batch and byte counts.");
+    }
+    else
+    {
+        GFX_WARN("%u of %u frames of the render stress test had unexpected counts.", m_failed_frames, m_checked_frames);
+    }
+}
+}  // namespace pac
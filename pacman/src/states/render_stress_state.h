@@ -0,0 +1,54 @@
+#pragma once
+
+#include "state.h"
+
+#include <cstddef>
+
+namespace pac
+{
+/*!
+ * \brief The RenderStressState draws a large number of small sprites spread over every layer and many depths for a number of
+ * frames, instead of the states below it. Every frame it checks the renderer's counters of the previous frame against what
+ * was drawn (instances, and for the OpenGL backend the batches and bytes uploaded), logs a report and then pops itself.
+ */
+class RenderStressState : public State
+{
+private:
+    std::size_t m_sprites = 0u;
+
+    /* Frames to draw, and frames drawn so far */
+    unsigned m_frames = 0u;
+    unsigned m_frame = 0u;
+
+    /* Totals over the checked frames, for the report */
+    unsigned m_checked_frames = 0u;
+    unsigned m_failed_frames = 0u;
+    float m_submit_ms = 0.f;
+    float m_sort_ms = 0.f;
+    float m_backend_ms = 0.f;
+    unsigned m_batches = 0u;
+    std::size_t m_bytes_uploaded = 0u;
+
+public:
+    RenderStressState(GameContext context, std::size_t sprites, unsigned frames);
+
+    void on_enter() override;
+
+    void on_exit() override;
+
+    bool update(float dt) override;
+
+    bool draw() override;
+
+private:
+    /*!
+     * \brief check_frame compares the counters of the last submitted frame with what this state drew in it
+     */
+    void check_frame();
+
+    /*!
+     * \brief report logs the average timings and counters, and whether every frame matched
+     */
+    void report() const;
+};
+}  // namespace pac
@@ -1,5 +1,10 @@
 #include "state_manager.h"
 
+#include <chrono>
+#include <algorithm>
+
+#include <gfx.h>
+
 namespace pac
 {
 bool StateManager::empty() const { return m_statestack.empty(); }
@@ -10,16 +15,40 @@ void pac::StateManager::pop() { m_pending_commands.emplace_back(nullptr, EComman
 
 void StateManager::update(float dt)
 {
-    /* Process Commands */
-    for (auto& command : m_pending_commands)
+    /* Process Commands in order (by index, since entering a state may issue new ones), stopping at a level still loading */
+    std::size_t processed = 0u;
+    for (; processed < m_pending_commands.size(); ++processed)
     {
+        auto& command = m_pending_commands[processed];
+        if (command.command_type == ECommandType::PushPreloaded && !m_preloader.is_ready(command.level_name))
+        {
+            break;
+        }
+
         switch (command.command_type)
         {
         /* Enter and push state */
         case ECommandType::Push:
-            command.new_state->on_enter();
-            m_statestack.emplace_back(std::move(command.new_state));
+        {
+            auto state = std::move(command.new_state);
+            state->on_enter();
+            m_statestack.emplace_back(std::move(state));
+            break;
+        }
+        /* Create, enter and push a state once its level has been preloaded */
+        case ECommandType::PushPreloaded:
+        {
+            const auto start = std::chrono::steady_clock::now();
+            /* Creating the state may issue commands (and move this one), so take what is needed from it first */
+            const auto level_name = command.level_name;
+            const auto make_state = std::move(command.make_state);
+            auto state = make_state();
+            state->on_enter();
+            m_statestack.emplace_back(std::move(state));
+            GFX_INFO("Switched to the preloaded level %s in %.2fms.", level_name.c_str(),
+                     std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
             break;
+        }
         /* Exit and pop a state */
         case ECommandType::Pop:
             m_statestack.back()->on_exit();
@@ -37,7 +66,7 @@ void StateManager::update(float dt)
         }
     }
 
-    m_pending_commands.clear();
+    m_pending_commands.erase(m_pending_commands.begin(), m_pending_commands.begin() + processed);
 
     /* Update states from top to bottom */
     for (auto it = m_statestack.rbegin(); it != m_statestack.rend(); ++it)
@@ -61,5 +90,18 @@ void StateManager::draw()
     }
 }
 
+void StateManager::preload_level(std::string_view level_name) { m_preloader.request(level_name); }
+
+std::optional<Level::Data> StateManager::take_preloaded_level(std::string_view level_name)
+{
+    return m_preloader.take(level_name);
+}
+
+bool StateManager::is_waiting_for_level() const
+{
+    return std::any_of(m_pending_commands.begin(), m_pending_commands.end(),
+                       [](const Command& command) { return command.command_type == ECommandType::PushPreloaded; });
+}
+
 State* StateManager::get_active_state() const { return m_statestack.empty() ? nullptr : m_statestack.back().get(); }
 }  // namespace pac
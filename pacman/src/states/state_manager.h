@@ -2,9 +2,14 @@
 
 #include "state.h"
 #include "common.h"
+#include "level_preloader.h"
 
 #include <memory>
 #include <vector>
+#include <string>
+#include <optional>
+#include <functional>
+#include <string_view>
 
 namespace pac
 {
@@ -20,6 +25,7 @@ private:
     {
         Nothing,
         Push,
+        PushPreloaded,
         Pop,
         Clear
     };
@@ -32,8 +38,17 @@ private:
         /* The command to execute */
         ECommandType command_type = ECommandType::Nothing;
 
+        /* Used when Command is PushPreloaded, the state is created once its level has been preloaded */
+        std::function<std::unique_ptr<State>()> make_state{};
+        std::string level_name{};
+
         /* So we can emplace back */
         Command(std::unique_ptr<State> state, ECommandType type) : new_state(std::move(state)), command_type(type) {}
+
+        Command(std::function<std::unique_ptr<State>()> make, std::string_view level)
+            : command_type(ECommandType::PushPreloaded), make_state(std::move(make)), level_name(level)
+        {
+        }
     };
 
     /* Game State Stack */
@@ -42,6 +57,9 @@ private:
     /* Commands waiting */
     std::vector<Command> m_pending_commands = {};
 
+    /* Levels parsed ahead of the states that play them */
+    LevelPreloader m_preloader{};
+
 public:
     /*!
      * \brief push push a new state on the state stack
@@ -53,6 +71,35 @@ public:
         m_pending_commands.emplace_back(std::make_unique<State_>(context, std::forward<CtorArgs_>(args)...), ECommandType::Push);
     }
 
+    /*!
+     * \brief push_preloaded preloads a level on a worker thread and pushes a new state once it is ready. The states on the
+     * stack keep running meanwhile, and commands issued after this one wait for it.
+     * \param level_name is the level the state plays, it is handed to the state with take_preloaded_level
+     */
+    template<typename State_, typename... CtorArgs_>
+    void push_preloaded(std::string_view level_name, GameContext context, CtorArgs_... args)
+    {
+        preload_level(level_name);
+        m_pending_commands.emplace_back(
+            [context, args...]() -> std::unique_ptr<State> { return std::make_unique<State_>(context, args...); }, level_name);
+    }
+
+    /*!
+     * \brief preload_level starts parsing a level on a worker thread, for a state that may play it soon
+     */
+    void preload_level(std::string_view level_name);
+
+    /*!
+     * \brief take_preloaded_level hands over a preloaded level, waiting for it if it is still being parsed
+     * \return the level, or nothing if it was not preloaded (or is out of date)
+     */
+    std::optional<Level::Data> take_preloaded_level(std::string_view level_name);
+
+    /*!
+     * \brief is_waiting_for_level returns true while a state pushed with push_preloaded waits for its level
+     */
+    bool is_waiting_for_level() const;
+
     /*!
      * \brief empty checks if the state stack is empty
      * \return true if the state stack is empty
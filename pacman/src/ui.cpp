@@ -6,6 +6,7 @@
 #include <fstream>
 
 #include <cglutil.h>
+#include <glad/glad.h>
 #include <imgui/imgui.h>
 
 namespace pac
@@ -153,15 +154,28 @@ void LevelSelector::update(float dt)
 {
     using namespace ImGui;
 
+    /* The chosen level is still being loaded */
+    if (m_context.state_manager->is_waiting_for_level())
+    {
+        Text("Loading...");
+        return;
+    }
+
     for (const auto& level : m_levels)
     {
         char btn_txt[64];
         sprintf(btn_txt, "%s##BTN", level.c_str());
         if (Button(btn_txt))
         {
-            m_context.state_manager->push<GameState>(m_context, level);
+            m_context.state_manager->push_preloaded<GameState>(level, m_context, level);
             m_context.state_manager->push<RespawnState>(m_context);
         }
+
+        /* Start loading a level as soon as it is hovered, it is then usually ready by the time it is clicked */
+        if (IsItemHovered())
+        {
+            m_context.state_manager->preload_level(level);
+        }
     }
 }
 
@@ -0,0 +1,217 @@
+#include "test.h"
+#include "alloc_tracker.h"
+#include "event_bus.h"
+#include "frame_arena.h"
+#include "config.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory_resource>
+
+namespace
+{
+/* Frames run once a test has warmed up, every one of them must stay within its budget */
+constexpr unsigned STEADY_FRAMES = 200u;
+
+/* Events of each type enqueued in the busiest frame, and the capacity the bus starts with (so the warm-up has to grow it) */
+constexpr unsigned MAX_EVENTS = 300u;
+constexpr std::size_t QUEUE_CAPACITY = 16u;
+
+/* What the over budget handler saw */
+unsigned g_reported = 0u;
+const char* g_reported_name = nullptr;
+uint64_t g_reported_allocations = 0u;
+
+/* Allocations stored here can not be optimized away */
+int* volatile g_sink = nullptr;
+
+struct EvSmall
+{
+    int value = 0;
+};
+
+struct EvLarge
+{
+    uint64_t values[8] = {};
+};
+
+/*!
+ * \brief The Listener struct sums the events it is given, one by one or in batches
+ */
+struct Listener
+{
+    uint64_t sum = 0u;
+
+    void recieve_small(const EvSmall& event) { sum += static_cast<uint64_t>(event.value); }
+
+    void recieve_large(const EvLarge* events, std::size_t count)
+    {
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+            sum += events[i].values[7];
+        }
+    }
+};
+
+void record_over_budget(const char* name, uint64_t allocations, uint64_t)
+{
+    ++g_reported;
+    g_reported_name = name;
+    g_reported_allocations = allocations;
+}
+
+/*!
+ * \brief warm_up advances the tracker past ALLOC_BUDGET_WARMUP_FRAMES, so budgets are checked
+ */
+void warm_up()
+{
+    while (pac::get_alloc_tracker().get_frame_count() < pac::ALLOC_BUDGET_WARMUP_FRAMES)
+    {
+        PAC_ALLOC_FRAME();
+    }
+}
+
+/*!
+ * \brief run_bus_frame enqueues events of two types directly and through a DeferredEvents, and delivers them
+ */
+void run_bus_frame(pac::EventBus& bus, pac::DeferredEvents& deferred, unsigned events)
+{
+    for (auto i = 0u; i < events; ++i)
+    {
+        bus.enqueue(EvSmall{static_cast<int>(i)});
+    }
+
+    {
+        const pac::DeferredEvents::Scope scope(deferred);
+        for (auto i = 0u; i < events; ++i)
+        {
+            EvLarge event{};
+            event.values[7] = i;
+            bus.enqueue(event);
+        }
+    }
+    deferred.flush(bus);
+    bus.update();
+}
+}  // namespace
+
+PAC_TEST(alloc_budget, reports_exceeded_budgets)
+{
+    warm_up();
+    pac::get_alloc_tracker().set_over_budget_handler(&record_over_budget);
+    g_reported = 0u;
+    const auto count_before = pac::get_alloc_tracker().get_over_budget_count();
+
+    {
+        PAC_ALLOC_BUDGET("Within Budget", 1u);
+        g_sink = new int(1);
+        delete g_sink;
+    }
+    PAC_CHECK(g_reported == 0u);
+
+    /* Every time a budget is exceeded is reported, not only the first */
+    for (auto i = 0u; i < 2u; ++i)
+    {
+        PAC_ALLOC_BUDGET("Over Budget", 0u);
+        g_sink = new int(2);
+        delete g_sink;
+    }
+    PAC_CHECK(g_reported == 2u);
+    PAC_CHECK(g_reported_name && std::string(g_reported_name) == "Over Budget");
+    PAC_CHECK(g_reported_allocations == 1u);
+    PAC_CHECK(pac::get_alloc_tracker().get_over_budget_count() == count_before + 2u);
+
+    pac::get_alloc_tracker().set_over_budget_handler(nullptr);
+}
+
+PAC_TEST(alloc_budget, event_bus_steady_state)
+{
+    warm_up();
+    pac::get_alloc_tracker().set_over_budget_handler(&record_over_budget);
+    g_reported = 0u;
+
+    pac::EventBus bus{QUEUE_CAPACITY};
+    pac::DeferredEvents deferred{};
+    Listener listener{};
+    bus.sink<EvSmall>().connect<&Listener::recieve_small>(listener);
+    bus.sink<EvLarge>().connect_batch<&Listener::recieve_large>(listener);
+
+    /* The busiest frame grows the queues and the deferred buffers, which allocates. Each type has two queues that take turns
+     * being written to, and each grows on its own, so it takes two of them. */
+    pac::AllocCounter warm_up_counter{};
+    run_bus_frame(bus, deferred, MAX_EVENTS);
+    run_bus_frame(bus, deferred, MAX_EVENTS);
+    PAC_CHECK(warm_up_counter.allocations() > 0u);
+    PAC_CHECK(bus.take_stats().grown > 0u);
+
+    /* After that, no frame with as many events or fewer allocates */
+    uint64_t allocations = 0u;
+    uint64_t expected_sum = 0u;
+    listener.sum = 0u;
+    for (auto frame = 0u; frame < STEADY_FRAMES; ++frame)
+    {
+        /* Both types get the values 0 to events - 1 */
+        const auto events = frame * 7u % (MAX_EVENTS + 1u);
+        expected_sum += events > 0u ? uint64_t{events} * (events - 1u) : 0u;
+
+        pac::AllocCounter counter{};
+        {
+            PAC_ALLOC_BUDGET("Event Bus Frame", 0u);
+            run_bus_frame(bus, deferred, events);
+        }
+        allocations += counter.allocations();
+        PAC_ALLOC_FRAME();
+    }
+    PAC_CHECK(allocations == 0u);
+    PAC_CHECK(g_reported == 0u);
+    PAC_CHECK(bus.take_stats().grown == 0u);
+    PAC_CHECK(listener.sum == expected_sum);
+
+    bus.sink<EvSmall>().disconnect<&Listener::recieve_small>(listener);
+    bus.sink<EvLarge>().disconnect_batch<&Listener::recieve_large>(listener);
+    pac::get_alloc_tracker().set_over_budget_handler(nullptr);
+}
+
+PAC_TEST(alloc_budget, frame_arena_steady_state)
+{
+    warm_up();
+    pac::get_alloc_tracker().set_over_budget_handler(&record_over_budget);
+    g_reported = 0u;
+
+    pac::FrameArena arena{64u * 1024u};
+
+    /* Frame containers on the arena never allocate, however they grow */
+    uint64_t allocations = 0u;
+    for (auto frame = 0u; frame < STEADY_FRAMES; ++frame)
+    {
+        pac::AllocCounter counter{};
+        {
+            PAC_ALLOC_BUDGET("Frame Arena Frame", 0u);
+            std::pmr::vector<int> values(&arena);
+            for (auto i = 0u; i < 1000u + frame; ++i)
+            {
+                values.push_back(static_cast<int>(i));
+            }
+            std::pmr::string text("a frame arena string that is too long for the small string buffer", &arena);
+            text.append(frame % 16u, '!');
+        }
+        arena.reset();
+        allocations += counter.allocations();
+        PAC_ALLOC_FRAME();
+    }
+    PAC_CHECK(allocations == 0u);
+    PAC_CHECK(g_reported == 0u);
+    PAC_CHECK(arena.get_last_frame().overflow_allocations == 0u);
+
+    /* What does not fit goes to the upstream resource, which the budget catches */
+    {
+        PAC_ALLOC_BUDGET("Frame Arena Overflow", 0u);
+        std::pmr::vector<uint64_t> values(2u * arena.get_capacity() / sizeof(uint64_t), 0u, &arena);
+    }
+    arena.reset();
+    PAC_CHECK(arena.get_last_frame().overflow_allocations == 1u);
+    PAC_CHECK(g_reported == 1u);
+
+    pac::get_alloc_tracker().set_over_budget_handler(nullptr);
+}
@@ -0,0 +1,222 @@
+#include "test.h"
+#include "encrypt/keystream_encryptor.h"
+#include "encrypt/crypt_stream.h"
+#include "config.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+
+/* Every keystream path must give the same bytes as the scalar one, which is checked against the pad itself. The pad is
+ * what encrypting zeros from position 0 gives, so the byte at position p is encrypted by XORing it with
+ * pad[p % KEYSTREAM_PAD_SIZE]. */
+
+namespace
+{
+/* Positions the data is encrypted at, around the start and the end of the pad and far into a large file */
+constexpr uint64_t POSITIONS[] = {0u, 1u, 15u, 31u, 4093u, pac::KEYSTREAM_PAD_SIZE - 1u, pac::KEYSTREAM_PAD_SIZE + 7u,
+                                  (1ull << 33u) + 17u};
+
+/* Longest tail after the last whole AVX2 block */
+constexpr std::size_t MAX_TAIL = 31u;
+
+std::vector<uint8_t> make_data(std::size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (std::size_t i = 0u; i < size; ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 131u + (i >> 8u));
+    }
+    return data;
+}
+
+std::vector<uint8_t> make_pad()
+{
+    pac::KeystreamEncryption crypt(pac::ENCRYPTION_STRING);
+    crypt.set_path(pac::EKeystreamPath::Scalar);
+    std::vector<uint8_t> pad(pac::KEYSTREAM_PAD_SIZE, 0u);
+    crypt.encrypt(pad.data(), pad.size(), 0u);
+    return pad;
+}
+
+/*!
+ * \brief expected returns the data encrypted at position, byte by byte with the pad
+ */
+std::vector<uint8_t> expected(const std::vector<uint8_t>& pad, std::vector<uint8_t> data, uint64_t position)
+{
+    for (std::size_t i = 0u; i < data.size(); ++i)
+    {
+        data[i] ^= pad[(position + i) % pad.size()];
+    }
+    return data;
+}
+
+/*!
+ * \brief paths returns every path the CPU supports, the scalar one first
+ */
+std::vector<pac::EKeystreamPath> paths()
+{
+    std::vector<pac::EKeystreamPath> out{};
+    for (auto path = pac::EKeystreamPath::Scalar; path <= pac::KeystreamEncryption::best_path();
+         path = static_cast<pac::EKeystreamPath>(static_cast<int>(path) + 1))
+    {
+        out.push_back(path);
+    }
+    return out;
+}
+}  // namespace
+
+PAC_TEST(crypt, pad_is_keyed)
+{
+    const auto pad = make_pad();
+    PAC_CHECK(pad != std::vector<uint8_t>(pad.size(), 0u));
+
+    /* Another key gives another pad */
+    pac::KeystreamEncryption other("NAMCAP");
+    std::vector<uint8_t> other_pad(pad.size(), 0u);
+    other.encrypt(other_pad.data(), other_pad.size(), 0u);
+    PAC_CHECK(other_pad != pad);
+}
+
+PAC_TEST(crypt, paths_match_scalar)
+{
+    const auto pad = make_pad();
+    const auto original = make_data(3u * pac::KEYSTREAM_PAD_SIZE + 77u);
+    pac::KeystreamEncryption crypt(pac::ENCRYPTION_STRING);
+    for (auto path : paths())
+    {
+        crypt.set_path(path);
+        PAC_CHECK(crypt.get_path() == path);
+        for (auto position : POSITIONS)
+        {
+            auto data = original;
+            crypt.encrypt(data.data(), data.size(), position);
+            PAC_CHECK(data == expected(pad, original, position));
+
+            crypt.decrypt(data.data(), data.size(), position);
+            PAC_CHECK(data == original);
+        }
+    }
+}
+
+PAC_TEST(crypt, tails)
+{
+    /* Every length from no bytes to a tail of 31 after zero, one and two whole blocks, so the scalar tail of both SIMD paths
+     * runs after a block that did and did not wrap around the pad */
+    const auto pad = make_pad();
+    pac::KeystreamEncryption crypt(pac::ENCRYPTION_STRING);
+    for (auto path : paths())
+    {
+        crypt.set_path(path);
+        for (auto position : POSITIONS)
+        {
+            for (std::size_t blocks = 0u; blocks <= 2u; ++blocks)
+            {
+                for (std::size_t tail = 0u; tail <= MAX_TAIL; ++tail)
+                {
+                    const auto original = make_data(blocks * 32u + tail);
+                    auto data = original;
+                    crypt.encrypt(data.data(), data.size(), position);
+                    PAC_CHECK(data == expected(pad, original, position));
+                }
+            }
+        }
+    }
+}
+
+PAC_TEST(crypt, unaligned_buffers)
+{
+    /* The data starts at every offset into a block, and the bytes around it must not change */
+    constexpr std::size_t SIZE = 517u;
+    constexpr uint8_t GUARD = 0xA5u;
+
+    const auto pad = make_pad();
+    const auto original = make_data(SIZE);
+    pac::KeystreamEncryption crypt(pac::ENCRYPTION_STRING);
+    for (auto path : paths())
+    {
+        crypt.set_path(path);
+        for (std::size_t offset = 0u; offset < 32u; ++offset)
+        {
+            std::vector<uint8_t> buffer(offset + SIZE + 32u, GUARD);
+            std::copy(original.begin(), original.end(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+            crypt.encrypt(buffer.data() + offset, SIZE, 4093u);
+
+            const std::vector<uint8_t> data(buffer.begin() + static_cast<std::ptrdiff_t>(offset),
+                                            buffer.begin() + static_cast<std::ptrdiff_t>(offset + SIZE));
+            PAC_CHECK(data == expected(pad, original, 4093u));
+
+            bool guarded = true;
+            for (std::size_t i = 0u; i < offset; ++i)
+            {
+                guarded = guarded && buffer[i] == GUARD;
+            }
+            for (auto i = offset + SIZE; i < buffer.size(); ++i)
+            {
+                guarded = guarded && buffer[i] == GUARD;
+            }
+            PAC_CHECK(guarded);
+        }
+    }
+}
+
+PAC_TEST(crypt, position_keyed_seeks)
+{
+    const auto original = make_data(2u * pac::KEYSTREAM_PAD_SIZE + 999u);
+    pac::KeystreamEncryption crypt(pac::ENCRYPTION_STRING);
+    for (auto path : paths())
+    {
+        crypt.set_path(path);
+        auto whole = original;
+        crypt.encrypt(whole.data(), whole.size(), 0u);
+
+        /* Encrypting uneven pieces at their positions, last piece first, gives the same bytes as encrypting all at once */
+        std::vector<std::pair<std::size_t, std::size_t>> pieces{};
+        for (std::size_t done = 0u, size = 1u; done < original.size(); done += size, size = size * 7u % 997u + 1u)
+        {
+            size = std::min(size, original.size() - done);
+            pieces.emplace_back(done, size);
+        }
+        auto data = original;
+        for (auto it = pieces.rbegin(); it != pieces.rend(); ++it)
+        {
+            crypt.encrypt(data.data() + it->first, it->second, it->first);
+        }
+        PAC_CHECK(data == whole);
+
+        /* A slice from the middle decrypts on its own, without the bytes before it */
+        for (std::size_t start : {1u, 33u, 4000u, 4096u, 5001u})
+        {
+            std::vector<uint8_t> slice(whole.begin() + static_cast<std::ptrdiff_t>(start),
+                                       whole.begin() + static_cast<std::ptrdiff_t>(start + 300u));
+            crypt.decrypt(slice.data(), slice.size(), start);
+            PAC_CHECK(std::equal(slice.begin(), slice.end(), original.begin() + static_cast<std::ptrdiff_t>(start)));
+        }
+    }
+}
+
+PAC_TEST(crypt, stream_round_trip)
+{
+    /* More than one chunk and a partial one, at a position that is not a multiple of the chunk size */
+    const auto original = make_data(2u * pac::CRYPT_STREAM_CHUNK_BYTES + 123u);
+    const auto pad = make_pad();
+    pac::KeystreamEncryption crypt(pac::ENCRYPTION_STRING);
+
+    std::stringstream stream{};
+    PAC_CHECK(pac::write_encrypted(stream, crypt, original.data(), original.size(), 4093u));
+    const auto written = stream.str();
+    PAC_CHECK(std::vector<uint8_t>(written.begin(), written.end()) == expected(pad, original, 4093u));
+
+    std::vector<uint8_t> data(original.size(), 0u);
+    PAC_CHECK(pac::read_encrypted(stream, crypt, data.data(), data.size(), 4093u));
+    PAC_CHECK(data == original);
+
+    /* Reading more than was written fails, after decrypting what was there */
+    std::stringstream short_stream(written.substr(0u, 1000u));
+    std::fill(data.begin(), data.end(), uint8_t{0u});
+    PAC_CHECK(!pac::read_encrypted(short_stream, crypt, data.data(), data.size(), 4093u));
+    PAC_CHECK(std::equal(data.begin(), data.begin() + 1000, original.begin()));
+}
@@ -0,0 +1,218 @@
+#include "test.h"
+#include "job_system.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+
+namespace
+{
+/* Worker threads of the job systems the tests start */
+constexpr unsigned TEST_WORKERS = 3u;
+
+/* Jobs a worker starts on its own deque for the others to steal */
+constexpr unsigned STOLEN_JOBS = 600u;
+
+/* Children of every job in the nested wait test, and how deep the tree is */
+constexpr unsigned TREE_FANOUT = 4u;
+constexpr unsigned TREE_DEPTH = 5u;
+
+void spin_for(std::chrono::microseconds time)
+{
+    const auto end = std::chrono::steady_clock::now() + time;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        std::this_thread::yield();
+    }
+}
+
+/*!
+ * \brief run_tree starts a job for every child and waits for them, down to the given depth, and counts the leaves
+ */
+void run_tree(pac::JobSystem& jobs, unsigned depth, std::atomic<unsigned>& leaves)
+{
+    if (depth == 0u)
+    {
+        ++leaves;
+        return;
+    }
+
+    pac::JobCounter children{};
+    for (auto i = 0u; i < TREE_FANOUT; ++i)
+    {
+        jobs.run("Tree Node", [&jobs, depth, &leaves] { run_tree(jobs, depth - 1u, leaves); }, &children);
+    }
+    jobs.wait(children);
+}
+
+uint64_t sum(const std::vector<uint64_t>& values) { return std::accumulate(values.begin(), values.end(), uint64_t{0u}); }
+}  // namespace
+
+PAC_TEST(job_system, runs_every_job_once)
+{
+    constexpr unsigned JOBS = 10'000u;
+    pac::JobSystem jobs{TEST_WORKERS};
+    PAC_CHECK(jobs.get_thread_count() == TEST_WORKERS);
+    jobs.take_stats();
+
+    std::vector<std::atomic<unsigned>> runs(JOBS);
+    pac::JobCounter counter{};
+    for (auto i = 0u; i < JOBS; ++i)
+    {
+        jobs.run("Count", [&runs, i] { ++runs[i]; }, &counter);
+    }
+    jobs.wait(counter);
+
+    PAC_CHECK(counter.is_done());
+    PAC_CHECK(std::all_of(runs.begin(), runs.end(), [](const std::atomic<unsigned>& n) { return n == 1u; }));
+
+    /* Every job was run by a worker, or by this thread while it waited */
+    const auto stats = jobs.take_stats();
+    PAC_CHECK(sum(stats.executed) + stats.helped == JOBS);
+}
+
+PAC_TEST(job_system, nested_wait)
+{
+    /* Every job waits for its children, far more jobs wait at once than there are workers, which only finishes because
+     * waiting threads run jobs */
+    pac::JobSystem jobs{TEST_WORKERS};
+    std::atomic<unsigned> leaves = 0u;
+    pac::JobCounter root{};
+    jobs.run("Tree Root", [&jobs, &leaves] { run_tree(jobs, TREE_DEPTH, leaves); }, &root);
+    jobs.wait(root);
+
+    auto expected = 1u;
+    for (auto i = 0u; i < TREE_DEPTH; ++i)
+    {
+        expected *= TREE_FANOUT;
+    }
+    PAC_CHECK(leaves == expected);
+
+    /* With a single worker, most of the tree is run by threads that are waiting */
+    pac::JobSystem single{1u};
+    leaves = 0u;
+    run_tree(single, 3u, leaves);
+    PAC_CHECK(leaves == TREE_FANOUT * TREE_FANOUT * TREE_FANOUT);
+}
+
+PAC_TEST(job_system, runs_continuations_after_their_dependency)
+{
+    pac::JobSystem jobs{TEST_WORKERS};
+    std::atomic<unsigned> first_done = 0u;
+    std::atomic<bool> early = false;
+    std::atomic<unsigned> continued = 0u;
+
+    pac::JobCounter first{};
+    pac::JobCounter after{};
+    for (auto i = 0u; i < 16u; ++i)
+    {
+        jobs.run("First", [&first_done] {
+            spin_for(std::chrono::microseconds(200));
+            ++first_done;
+        }, &first);
+    }
+    for (auto i = 0u; i < 8u; ++i)
+    {
+        jobs.run_after(first, "After", [&] {
+            early = early || first_done != 16u;
+            ++continued;
+        }, &after);
+    }
+    jobs.wait(after);
+    PAC_CHECK(!early);
+    PAC_CHECK(continued == 8u);
+
+    /* A dependency that is already done starts the job right away */
+    pac::JobCounter again{};
+    jobs.run_after(first, "After Done", [&continued] { ++continued; }, &again);
+    jobs.wait(again);
+    PAC_CHECK(continued == 9u);
+}
+
+PAC_TEST(job_system, parallel_for_covers_the_range)
+{
+    pac::JobSystem jobs{TEST_WORKERS};
+    for (const std::size_t size : {0u, 1u, 7u, 64u, 1000u})
+    {
+        for (const std::size_t grain : {0u, 1u, 3u, 64u, 5000u})
+        {
+            std::vector<std::atomic<unsigned>> runs(size + 2u);
+            jobs.parallel_for("Cover", 1u, size + 1u, grain, [&runs](std::size_t first, std::size_t last) {
+                for (auto i = first; i < last; ++i)
+                {
+                    ++runs[i];
+                }
+            });
+
+            bool covered = runs.front() == 0u && runs.back() == 0u;
+            for (std::size_t i = 1u; i <= size; ++i)
+            {
+                covered = covered && runs[i] == 1u;
+            }
+            PAC_CHECK(covered);
+        }
+    }
+}
+
+PAC_TEST(job_system, idle_workers_steal)
+{
+    /* One worker starts every job on its own deque and then waits for them. The other workers have nothing else to do, so
+     * they must steal, and each of them must get a fair share instead of one thief taking everything. */
+    pac::JobSystem jobs{TEST_WORKERS};
+    jobs.take_stats();
+
+    pac::JobCounter producer{};
+    jobs.run("Producer", [&jobs] {
+        pac::JobCounter children{};
+        for (auto i = 0u; i < STOLEN_JOBS; ++i)
+        {
+            jobs.run("Stealable", [] { spin_for(std::chrono::microseconds(100)); }, &children);
+        }
+        jobs.wait(children);
+    }, &producer);
+
+    /* This thread does not help, so only workers run the jobs */
+    while (!producer.is_done())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const auto stats = jobs.take_stats();
+    PAC_CHECK(stats.helped == 0u);
+    PAC_CHECK(sum(stats.executed) == STOLEN_JOBS + 1u);
+
+    /* Every job the other workers ran was stolen, and every worker ran at least a tenth of an even share */
+    uint64_t thieves_executed = 0u;
+    uint64_t thieves_stolen = 0u;
+    for (std::size_t i = 0u; i < stats.executed.size(); ++i)
+    {
+        if (stats.stolen[i] > 0u)
+        {
+            thieves_executed += stats.executed[i];
+            thieves_stolen += stats.stolen[i];
+        }
+        PAC_CHECK(stats.executed[i] >= STOLEN_JOBS / TEST_WORKERS / 10u);
+    }
+    PAC_CHECK(thieves_stolen > 0u);
+    PAC_CHECK(thieves_executed == thieves_stolen);
+}
+
+PAC_TEST(job_system, background_jobs_only_run_on_workers)
+{
+    pac::JobSystem jobs{TEST_WORKERS};
+    std::atomic<bool> ran = false;
+    pac::JobCounter background{};
+    jobs.run("Background", [&ran] { ran = true; }, &background, pac::EJobPriority::Background);
+
+    /* Waiting threads only help with normal jobs */
+    while (jobs.run_one())
+    {
+    }
+    jobs.wait(background);
+    PAC_CHECK(ran);
+    PAC_CHECK(jobs.take_stats().helped == 0u);
+}
@@ -0,0 +1,72 @@
+#include "test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+namespace pac::test
+{
+namespace
+{
+/* Failed checks of the running test */
+unsigned g_failed_checks = 0u;
+}  // namespace
+
+std::vector<TestCase>& get_tests()
+{
+    static std::vector<TestCase> tests{};
+    return tests;
+}
+
+void check(bool ok, const char* expression, const char* file, int line)
+{
+    if (!ok)
+    {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        ++g_failed_checks;
+    }
+}
+}  // namespace pac::test
+
+/*!
+ * \brief main runs every test of the suite given as the first argument, or every test if there is no argument
+ * \return 0 if every test passed, 1 if one failed or threw, and 2 if the suite has no tests
+ */
+int main(int argc, char* argv[])
+{
+    const char* suite = argc > 1 ? argv[1] : nullptr;
+    unsigned ran = 0u, failed = 0u;
+
+    for (const auto& test : pac::test::get_tests())
+    {
+        if (suite && std::strcmp(suite, test.suite) != 0)
+        {
+            continue;
+        }
+
+        ++ran;
+        pac::test::g_failed_checks = 0u;
+        try
+        {
+            test.fn();
+        }
+        catch (const std::exception& e)
+        {
+            std::fprintf(stderr, "%s.%s threw: %s\n", test.suite, test.name, e.what());
+            ++pac::test::g_failed_checks;
+        }
+
+        const bool ok = pac::test::g_failed_checks == 0u;
+        failed += ok ? 0u : 1u;
+        std::printf("[%s] %s.%s\n", ok ? "  OK  " : " FAIL ", test.suite, test.name);
+    }
+
+    if (ran == 0u)
+    {
+        std::fprintf(stderr, "No tests in suite %s.\n", suite ? suite : "(all)");
+        return 2;
+    }
+
+    std::printf("%u of %u tests passed.\n", ran - failed, ran);
+    return failed == 0u ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#include "test.h"
+#include "audio/software_audio_backend.h"
+#include "config.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+namespace
+{
+namespace fs = std::filesystem;
+
+/* Sample frames in one mixed block, and the size of the capture header */
+constexpr std::size_t BLOCK_FRAMES = pac::AUDIO_MIX_FREQUENCY * pac::AUDIO_MIX_BLOCK_MS / 1000u;
+constexpr std::size_t WAV_HEADER_BYTES = 44u;
+
+/* Sample frames of the buffers that are played, more than is ever mixed so they play for the whole test */
+constexpr std::size_t TEST_FRAMES = BLOCK_FRAMES * 32u;
+
+void append_s24(std::vector<uint8_t>& out, int32_t value)
+{
+    for (auto i = 0u; i < 3u; ++i)
+    {
+        out.push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8u * i)));
+    }
+}
+
+void append_f32(std::vector<uint8_t>& out, float value)
+{
+    uint8_t bytes[4] = {};
+    std::memcpy(bytes, &value, sizeof(value));
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+/*!
+ * \brief read_capture returns the samples of a capture, or nothing if its header does not match its size
+ */
+std::vector<int16_t> read_capture(const fs::path& fp)
+{
+    std::ifstream file(fp, std::ios::binary);
+    const std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (bytes.size() < WAV_HEADER_BYTES)
+    {
+        return {};
+    }
+
+    uint32_t data_bytes = 0u;
+    std::memcpy(&data_bytes, bytes.data() + 40, sizeof(data_bytes));
+    if (data_bytes == 0u || data_bytes != bytes.size() - WAV_HEADER_BYTES)
+    {
+        return {};
+    }
+
+    std::vector<int16_t> samples(data_bytes / sizeof(int16_t));
+    std::memcpy(samples.data(), bytes.data() + WAV_HEADER_BYTES, data_bytes);
+    return samples;
+}
+
+/*!
+ * \brief near returns true if a mixed sample is within a quantization step or two of the expected [-1, 1] value
+ */
+bool near(int16_t sample, float expected) { return std::abs(sample / 32767.f - expected) < 2.f / 32767.f; }
+
+/*!
+ * \brief play_and_capture plays a buffer of the given data on a software backend paced by the simulation, advances it by the
+ * given times and returns the capture
+ */
+std::vector<int16_t> play_and_capture(const pac::AudioFormat& format, const std::vector<uint8_t>& data,
+                                      const std::vector<float>& advances)
+{
+    const auto fp = fs::temp_directory_path() / "pacman_software_audio_capture.wav";
+    {
+        pac::SoftwareAudioBackend backend{fp.string(), true};
+        const auto buffer = backend.create_buffer();
+        const auto source = backend.create_source();
+        backend.set_buffer_data(buffer, format, data.data(), data.size());
+        backend.play(source, buffer, false);
+        for (auto dt : advances)
+        {
+            backend.advance(dt);
+        }
+    }
+
+    auto samples = read_capture(fp);
+    fs::remove(fp);
+    return samples;
+}
+}  // namespace
+
+PAC_TEST(software_audio, capture_follows_simulated_time)
+{
+    std::vector<uint8_t> data(TEST_FRAMES * 2u, 0u);
+
+    /* 0.1 seconds is 10 whole blocks, then 12.5ms more adds one more and carries the rest, which 4ms does not complete */
+    const auto samples = play_and_capture({1u, 16u, pac::AUDIO_MIX_FREQUENCY}, data, {0.1f, 0.0125f, 0.004f});
+    PAC_CHECK(samples.size() == 11u * BLOCK_FRAMES * 2u);
+
+    /* Nothing is mixed without the simulation advancing, however long the backend lives */
+    PAC_CHECK(play_and_capture({1u, 16u, pac::AUDIO_MIX_FREQUENCY}, data, {}).empty());
+}
+
+PAC_TEST(software_audio, downmixes_surround_24_bit)
+{
+    /* Four channels, the even ones average into the left side and the odd ones into the right */
+    const float channels[4] = {0.5f, -0.25f, 0.25f, 0.75f};
+    std::vector<uint8_t> data{};
+    for (std::size_t frame = 0u; frame < TEST_FRAMES; ++frame)
+    {
+        for (auto value : channels)
+        {
+            append_s24(data, static_cast<int32_t>(value * 8388608.f));
+        }
+    }
+
+    const auto samples = play_and_capture({4u, 24u, pac::AUDIO_MIX_FREQUENCY}, data, {0.01f});
+    PAC_CHECK(samples.size() == BLOCK_FRAMES * 2u);
+    bool matches = !samples.empty();
+    for (std::size_t i = 0u; matches && i < samples.size(); i += 2u)
+    {
+        matches = near(samples[i], 0.375f) && near(samples[i + 1u], 0.25f);
+    }
+    PAC_CHECK(matches);
+}
+
+PAC_TEST(software_audio, converts_float_and_32_bit)
+{
+    std::vector<uint8_t> floats{};
+    std::vector<uint8_t> integers{};
+    for (std::size_t frame = 0u; frame < TEST_FRAMES; ++frame)
+    {
+        append_f32(floats, 0.5f);
+        append_f32(floats, -0.5f);
+        const auto quarter = static_cast<uint32_t>(1u << 29u);
+        for (auto i = 0u; i < 4u; ++i)
+        {
+            integers.push_back(static_cast<uint8_t>(quarter >> (8u * i)));
+        }
+    }
+
+    const auto float_samples = play_and_capture({2u, 32u, pac::AUDIO_MIX_FREQUENCY, true}, floats, {0.01f});
+    PAC_CHECK(float_samples.size() == BLOCK_FRAMES * 2u);
+    PAC_CHECK(!float_samples.empty() && near(float_samples[0], 0.5f) && near(float_samples[1], -0.5f));
+
+    /* Mono is played on both sides */
+    const auto integer_samples = play_and_capture({1u, 32u, pac::AUDIO_MIX_FREQUENCY}, integers, {0.01f});
+    PAC_CHECK(!integer_samples.empty() && near(integer_samples[0], 0.25f) && near(integer_samples[1], 0.25f));
+}
+
+PAC_TEST(software_audio, unsupported_formats_are_silent)
+{
+    /* 12-bit samples and 16-bit floats can not be decoded, so the source stops and the capture is silent */
+    std::vector<uint8_t> data(TEST_FRAMES * 4u, 0x55u);
+    for (const pac::AudioFormat format : {pac::AudioFormat{2u, 12u, pac::AUDIO_MIX_FREQUENCY},
+                                          pac::AudioFormat{2u, 16u, pac::AUDIO_MIX_FREQUENCY, true}})
+    {
+        const auto samples = play_and_capture(format, data, {0.01f});
+        PAC_CHECK(samples.size() == BLOCK_FRAMES * 2u);
+        bool silent = true;
+        for (auto sample : samples)
+        {
+            silent = silent && sample == 0;
+        }
+        PAC_CHECK(silent);
+    }
+}
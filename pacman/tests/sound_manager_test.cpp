@@ -0,0 +1,131 @@
+#include "test.h"
+#include "audio/sound_manager.h"
+#include "audio/software_audio_backend.h"
+#include "config.h"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace
+{
+/* Sample frames of the test sounds, long enough that nothing stops playing on its own during a test */
+constexpr std::size_t SOUND_FRAMES = pac::AUDIO_MIX_FREQUENCY;
+
+/* Priorities of the test sounds */
+constexpr uint8_t LOW_PRIORITY = 10u;
+constexpr uint8_t MEDIUM_PRIORITY = 100u;
+constexpr uint8_t HIGH_PRIORITY = 200u;
+
+/*!
+ * \brief make_sounds returns a sound manager on a software backend that is paced by the simulation (so voices only stop
+ * when they are stolen), with a low, a medium and a high priority sound, and a medium priority sound limited to one voice
+ */
+std::unique_ptr<pac::SoundManager> make_sounds(pac::EVoiceStealPolicy policy)
+{
+    auto sounds = std::make_unique<pac::SoundManager>(std::make_unique<pac::SoftwareAudioBackend>(std::string{}, true),
+                                                      pac::EAudioBackend::Software);
+    const std::vector<int16_t> silence(SOUND_FRAMES, 0);
+    for (const auto* name : {"low", "medium", "high", "limited"})
+    {
+        sounds->add_sound(name, {1u, 16u, pac::AUDIO_MIX_FREQUENCY}, silence.data(), silence.size() * sizeof(int16_t));
+    }
+
+    sounds->configure("low", LOW_PRIORITY, 0u);
+    sounds->configure("medium", MEDIUM_PRIORITY, 0u);
+    sounds->configure("high", HIGH_PRIORITY, 0u);
+    sounds->configure("limited", MEDIUM_PRIORITY, 1u);
+    sounds->set_steal_policy(policy);
+    return sounds;
+}
+
+/*!
+ * \brief The FullVoices struct is the source of the oldest voice and of the low priority voice once every source is busy
+ */
+struct FullVoices
+{
+    unsigned oldest = 0u;
+    unsigned low = 0u;
+};
+
+/*!
+ * \brief fill_voices plays the limited sound (twice, the second play restarts it), then the low priority sound, and then
+ * medium priority sounds until every source is busy
+ */
+FullVoices fill_voices(pac::SoundManager& sounds)
+{
+    FullVoices voices{};
+    voices.oldest = sounds.play("limited");
+    PAC_CHECK(sounds.play("limited") == voices.oldest);
+    voices.low = sounds.play("low");
+    for (auto i = 2u; i < pac::AUDIO_SOURCES; ++i)
+    {
+        PAC_CHECK(sounds.play("medium") != 0u);
+    }
+
+    sounds.update(0.f);
+    const auto& stats = sounds.get_voice_stats();
+    PAC_CHECK(stats.active == pac::AUDIO_SOURCES);
+    PAC_CHECK(stats.retriggers == 1u);
+    PAC_CHECK(stats.steals == 0u);
+    PAC_CHECK(stats.dropped == 0u);
+    return voices;
+}
+}  // namespace
+
+PAC_TEST(sound_voices, steal_oldest)
+{
+    auto sounds = make_sounds(pac::EVoiceStealPolicy::Oldest);
+    const auto voices = fill_voices(*sounds);
+
+    /* The limited sound started first, so the high priority sound takes its voice */
+    PAC_CHECK(sounds->play("high") == voices.oldest);
+
+    /* Then the low priority voice is the oldest one a low priority sound may take */
+    PAC_CHECK(sounds->play("low") == voices.low);
+
+    /* Only the high priority voice is left that a medium priority sound may not take, so it steals a medium one */
+    PAC_CHECK(sounds->play("medium") != 0u);
+
+    const auto& stats = sounds->get_voice_stats();
+    PAC_CHECK(stats.plays == pac::AUDIO_SOURCES + 4u);
+    PAC_CHECK(stats.retriggers == 1u);
+    PAC_CHECK(stats.steals == 3u);
+    PAC_CHECK(stats.dropped == 0u);
+    PAC_CHECK(stats.peak_active == pac::AUDIO_SOURCES);
+}
+
+PAC_TEST(sound_voices, steal_lowest_priority)
+{
+    auto sounds = make_sounds(pac::EVoiceStealPolicy::LowestPriority);
+    const auto voices = fill_voices(*sounds);
+
+    /* The high priority sound takes the low priority voice, even though the limited sound is older */
+    PAC_CHECK(sounds->play("high") == voices.low);
+
+    /* Now every voice has a higher priority than the low priority sound, so it is dropped */
+    PAC_CHECK(sounds->play("low") == 0u);
+
+    /* A medium priority sound takes the oldest medium priority voice, which is the limited sound */
+    PAC_CHECK(sounds->play("medium") == voices.oldest);
+
+    const auto& stats = sounds->get_voice_stats();
+    PAC_CHECK(stats.plays == pac::AUDIO_SOURCES + 4u);
+    PAC_CHECK(stats.retriggers == 1u);
+    PAC_CHECK(stats.steals == 2u);
+    PAC_CHECK(stats.dropped == 1u);
+    PAC_CHECK(stats.peak_active == pac::AUDIO_SOURCES);
+}
+
+PAC_TEST(sound_voices, stopped_voices_are_reused)
+{
+    auto sounds = make_sounds(pac::EVoiceStealPolicy::LowestPriority);
+    const auto voices = fill_voices(*sounds);
+
+    /* A voice that was stopped goes back to the pool at the next update, so the next sound steals nothing */
+    sounds->stop(voices.low);
+    sounds->update(0.f);
+    PAC_CHECK(sounds->get_voice_stats().active == pac::AUDIO_SOURCES - 1u);
+    PAC_CHECK(sounds->play("low") == voices.low);
+    PAC_CHECK(sounds->get_voice_stats().steals == 0u);
+}
@@ -0,0 +1,303 @@
+#include "test.h"
+#include "entity/system_scheduler.h"
+#include "event_bus.h"
+#include "job_system.h"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include <entt/entity/registry.hpp>
+
+namespace
+{
+/* Frames run in every test, the first one is the warm-up that runs every system in order */
+constexpr unsigned TEST_FRAMES = 50u;
+
+/* Worker threads of the job system the tests schedule on */
+constexpr unsigned TEST_WORKERS = 2u;
+
+/* Component types, only their bits in the access masks are used */
+struct CA
+{
+};
+struct CB
+{
+};
+struct CC
+{
+};
+
+struct EvSystemRan
+{
+    std::size_t system = 0u;
+    unsigned part = 0u;
+};
+
+/*!
+ * \brief The TraceSystem class records when it starts and finishes on a counter shared by every system of a test
+ */
+class TraceSystem : public pac::System
+{
+public:
+    pac::SystemAccess m_access{};
+    std::function<void()> m_body{};
+    std::atomic<unsigned>& m_clock;
+
+    /* Clock values of the last frame, and the thread the system last ran on */
+    unsigned m_started = 0u;
+    unsigned m_finished = 0u;
+    std::thread::id m_thread{};
+
+    TraceSystem(entt::registry& reg, std::atomic<unsigned>& clock, pac::SystemAccess access, std::function<void()> body = {})
+        : System(reg), m_access(access), m_body(std::move(body)), m_clock(clock)
+    {
+    }
+
+    void update(float) override
+    {
+        m_started = m_clock++;
+        m_thread = std::this_thread::get_id();
+        if (m_body)
+        {
+            m_body();
+        }
+        m_finished = m_clock++;
+    }
+
+    const char* name() const override { return "Trace System"; }
+
+    pac::SystemAccess access() const override { return m_access; }
+};
+
+/*!
+ * \brief must_wait returns true if a system has to wait for an earlier one, written out here rather than calling
+ * systems_conflict so the scheduler is checked against the rule and not against itself
+ */
+bool must_wait(const pac::SystemAccess& earlier, const pac::SystemAccess& later)
+{
+    return earlier.exclusive || later.exclusive || (earlier.writes & later.reads) || (earlier.writes & later.writes) ||
+           (earlier.reads & later.writes);
+}
+
+/*!
+ * \brief The Graph struct is a list of trace systems and a scheduler running them on a job system of its own
+ */
+struct Graph
+{
+    entt::registry reg{};
+    std::atomic<unsigned> clock = 0u;
+    std::vector<std::unique_ptr<pac::System>> systems{};
+    pac::JobSystem jobs{TEST_WORKERS};
+    pac::EventBus bus{};
+    std::unique_ptr<pac::SystemScheduler> scheduler = std::make_unique<pac::SystemScheduler>(jobs);
+
+    TraceSystem& add(pac::SystemAccess access, std::function<void()> body = {})
+    {
+        systems.emplace_back(std::make_unique<TraceSystem>(reg, clock, access, std::move(body)));
+        return static_cast<TraceSystem&>(*systems.back());
+    }
+
+    TraceSystem& at(std::size_t i) { return static_cast<TraceSystem&>(*systems[i]); }
+
+    /*!
+     * \brief kept_order returns true if every system started after every earlier system it conflicts with had finished
+     */
+    bool kept_order()
+    {
+        for (std::size_t later = 0u; later < systems.size(); ++later)
+        {
+            for (std::size_t earlier = 0u; earlier < later; ++earlier)
+            {
+                if (must_wait(at(earlier).m_access, at(later).m_access) && at(later).m_started < at(earlier).m_finished)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+/* A system working on a worker, it may run alongside others */
+pac::SystemAccess worker_access(pac::ComponentMask reads, pac::ComponentMask writes) { return {reads, writes, false, false}; }
+
+void spin_for(std::chrono::microseconds time)
+{
+    const auto end = std::chrono::steady_clock::now() + time;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        std::this_thread::yield();
+    }
+}
+}  // namespace
+
+PAC_TEST(system_scheduler, conflicts)
+{
+    using pac::component_mask;
+    PAC_CHECK(pac::systems_conflict(worker_access(0u, component_mask<CA>()), worker_access(component_mask<CA>(), 0u)));
+    PAC_CHECK(pac::systems_conflict(worker_access(component_mask<CA>(), 0u), worker_access(0u, component_mask<CA>())));
+    PAC_CHECK(pac::systems_conflict(worker_access(0u, component_mask<CA>()), worker_access(0u, component_mask<CA, CB>())));
+    PAC_CHECK(!pac::systems_conflict(worker_access(component_mask<CA>(), 0u), worker_access(component_mask<CA>(), 0u)));
+    PAC_CHECK(!pac::systems_conflict(worker_access(0u, component_mask<CA>()), worker_access(0u, component_mask<CB>())));
+
+    /* Main thread systems are only ordered by what they touch, exclusive ones by everything */
+    PAC_CHECK(!pac::systems_conflict({component_mask<CA>(), 0u, true, false}, worker_access(component_mask<CA>(), 0u)));
+    PAC_CHECK(pac::systems_conflict({0u, 0u, true, true}, worker_access(0u, 0u)));
+}
+
+PAC_TEST(system_scheduler, keeps_order_of_conflicting_systems)
+{
+    using pac::component_mask;
+    const auto work = [] { spin_for(std::chrono::microseconds(200)); };
+
+    Graph graph{};
+    graph.add(worker_access(0u, component_mask<CA>()), work);
+    graph.add(worker_access(component_mask<CA>(), component_mask<CB>()), work);
+    graph.add(worker_access(0u, component_mask<CC>()), work);
+    graph.add({component_mask<CB>(), 0u, true, false}, work);
+    graph.add({}, work);
+    graph.add(worker_access(component_mask<CA, CC>(), 0u), work);
+    graph.add(worker_access(0u, component_mask<CA>()), work);
+    graph.scheduler->set_systems(graph.systems);
+
+    for (unsigned frame = 0u; frame < TEST_FRAMES; ++frame)
+    {
+        graph.scheduler->run(0.f, graph.bus);
+        PAC_CHECK(graph.kept_order());
+    }
+}
+
+PAC_TEST(system_scheduler, main_thread_systems_stay_on_the_calling_thread)
+{
+    using pac::component_mask;
+    Graph graph{};
+    graph.add(worker_access(0u, component_mask<CA>()));
+    graph.add({component_mask<CB>(), 0u, true, false});
+    graph.add(worker_access(0u, component_mask<CC>()));
+    graph.add({});
+    graph.scheduler->set_systems(graph.systems);
+
+    for (unsigned frame = 0u; frame < TEST_FRAMES; ++frame)
+    {
+        graph.scheduler->run(0.f, graph.bus);
+        PAC_CHECK(graph.at(1u).m_thread == std::this_thread::get_id());
+        PAC_CHECK(graph.at(3u).m_thread == std::this_thread::get_id());
+
+        /* Every system runs on the calling thread in the warm-up frame, after that the two worker systems are jobs */
+        PAC_CHECK(graph.scheduler->get_stats().worker_systems == (frame == 0u ? 0u : 2u));
+    }
+}
+
+PAC_TEST(system_scheduler, runs_independent_systems_at_once)
+{
+    using pac::component_mask;
+
+    /* Each system waits for the other to start, which only ends before the timeout if they run at the same time */
+    std::mutex mutex{};
+    std::condition_variable changed{};
+    unsigned started = 0u;
+    bool overlapped = true;
+    const auto meet = [&] {
+        std::unique_lock lock(mutex);
+        const auto frame_start = started / 2u * 2u;
+        ++started;
+        changed.notify_all();
+        overlapped = changed.wait_for(lock, std::chrono::seconds(5), [&] { return started >= frame_start + 2u; }) &&
+                     overlapped;
+    };
+
+    Graph graph{};
+    graph.add(worker_access(component_mask<CC>(), component_mask<CA>()), meet);
+    graph.add(worker_access(component_mask<CC>(), component_mask<CB>()), meet);
+    graph.scheduler->set_systems(graph.systems);
+
+    /* The warm-up frame runs them one after another, so it is not one of the frames that meet */
+    graph.scheduler->set_parallel(false);
+    graph.at(0u).m_body = {};
+    graph.at(1u).m_body = {};
+    graph.scheduler->run(0.f, graph.bus);
+
+    graph.scheduler->set_parallel(true);
+    graph.at(0u).m_body = meet;
+    graph.at(1u).m_body = meet;
+    for (unsigned frame = 0u; frame < TEST_FRAMES; ++frame)
+    {
+        graph.scheduler->run(0.f, graph.bus);
+    }
+    PAC_CHECK(started == 2u * TEST_FRAMES);
+    PAC_CHECK(overlapped);
+}
+
+PAC_TEST(system_scheduler, delivers_events_in_system_order)
+{
+    using pac::component_mask;
+
+    /* The first system is the slowest, so the ones that do not wait for it enqueue their events first */
+    struct Listener
+    {
+        std::vector<EvSystemRan> events{};
+        void recieve(const EvSystemRan& event) { events.push_back(event); }
+    } listener{};
+
+    Graph graph{};
+    graph.bus.sink<EvSystemRan>().connect<&Listener::recieve>(listener);
+    std::vector<pac::SystemAccess> accesses = {worker_access(0u, component_mask<CA>()), worker_access(0u, component_mask<CB>()),
+                                              {component_mask<CC>(), 0u, true, false}, worker_access(0u, component_mask<CC>())};
+    for (std::size_t i = 0u; i < accesses.size(); ++i)
+    {
+        graph.add(accesses[i], [&bus = graph.bus, i] {
+            bus.enqueue(EvSystemRan{i, 0u});
+            spin_for(std::chrono::microseconds(i == 0u ? 2000 : 100));
+            bus.enqueue(EvSystemRan{i, 1u});
+        });
+    }
+    graph.scheduler->set_systems(graph.systems);
+
+    for (unsigned frame = 0u; frame < TEST_FRAMES; ++frame)
+    {
+        listener.events.clear();
+        graph.scheduler->run(0.f, graph.bus);
+
+        /* Nothing reaches the bus while the systems run, and all of it does once they are done */
+        PAC_CHECK(listener.events.empty());
+        graph.bus.update();
+
+        bool in_order = listener.events.size() == 2u * accesses.size();
+        for (std::size_t i = 0u; in_order && i < listener.events.size(); ++i)
+        {
+            in_order = listener.events[i].system == i / 2u && listener.events[i].part == i % 2u;
+        }
+        PAC_CHECK(in_order);
+    }
+    graph.bus.sink<EvSystemRan>().disconnect<&Listener::recieve>(listener);
+}
+
+PAC_TEST(system_scheduler, sequential_runs_in_list_order)
+{
+    using pac::component_mask;
+    Graph graph{};
+    graph.add(worker_access(0u, component_mask<CA>()));
+    graph.add(worker_access(0u, component_mask<CB>()));
+    graph.add({component_mask<CC>(), 0u, true, false});
+    graph.add(worker_access(0u, component_mask<CC>()));
+    graph.scheduler->set_systems(graph.systems);
+    graph.scheduler->set_parallel(false);
+
+    for (unsigned frame = 0u; frame < TEST_FRAMES; ++frame)
+    {
+        graph.scheduler->run(0.f, graph.bus);
+        bool in_order = graph.scheduler->get_stats().worker_systems == 0u;
+        for (std::size_t i = 0u; i < graph.systems.size(); ++i)
+        {
+            in_order = in_order && graph.at(i).m_thread == std::this_thread::get_id();
+            in_order = in_order && (i == 0u || graph.at(i).m_started == graph.at(i - 1u).m_finished + 1u);
+        }
+        PAC_CHECK(in_order);
+    }
+}
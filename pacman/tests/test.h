@@ -0,0 +1,48 @@
+/*!
+ * \file test.h contains a minimal test runner. Tests register themselves in a suite, and ctest runs every suite as its own
+ * test by passing its name to the pacman_tests executable.
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace pac::test
+{
+/*!
+ * \brief The TestCase struct is a registered test
+ */
+struct TestCase
+{
+    const char* suite = nullptr;
+    const char* name = nullptr;
+    void (*fn)() = nullptr;
+};
+
+/*!
+ * \brief get_tests returns every registered test, in the order they were registered
+ */
+std::vector<TestCase>& get_tests();
+
+/*!
+ * \brief check records a failure of the running test if ok is false, and logs the failing expression
+ */
+void check(bool ok, const char* expression, const char* file, int line);
+
+/*!
+ * \brief The Registration struct adds a test to get_tests() when it is constructed
+ */
+struct Registration
+{
+    Registration(const char* suite, const char* name, void (*fn)()) { get_tests().push_back({suite, name, fn}); }
+};
+}  // namespace pac::test
+
+/* Defines a test function and registers it in the suite */
+#define PAC_TEST(suite, name)                                                                                                \
+    static void suite##_##name();                                                                                            \
+    static const ::pac::test::Registration suite##_##name##_registration{#suite, #name, &suite##_##name};                     \
+    static void suite##_##name()
+
+/* Fails the running test (without stopping it) if the expression is false */
+#define PAC_CHECK(expression) ::pac::test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
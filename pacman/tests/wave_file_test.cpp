@@ -0,0 +1,231 @@
+#include "test.h"
+#include "audio/waveloader.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+/* The seed corpus is in corpus/wav. Files named ok_* must load, and files named bad_* must be rejected with a runtime_error.
+ * The waveform data of every ok_* file is the byte pattern of expected_byte. */
+
+namespace
+{
+namespace fs = std::filesystem;
+
+/* Random mutations of every seed, and the most bytes changed in one */
+constexpr unsigned MUTANTS_PER_SEED = 512u;
+constexpr unsigned MAX_MUTATED_BYTES = 4u;
+
+uint8_t expected_byte(std::size_t i) { return static_cast<uint8_t>(i * 7u + 3u); }
+
+std::vector<fs::path> corpus_files()
+{
+    std::vector<fs::path> files{};
+    for (const auto& entry : fs::directory_iterator(fs::path(PAC_TEST_CORPUS_DIR) / "wav"))
+    {
+        if (entry.path().extension() == ".wav")
+        {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool starts_with(const std::string& s, const char* prefix) { return s.rfind(prefix, 0u) == 0u; }
+
+std::vector<uint8_t> read_bytes(const fs::path& fp)
+{
+    std::ifstream file(fp, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void write_bytes(const fs::path& fp, const std::vector<uint8_t>& bytes)
+{
+    std::ofstream file(fp, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+/*!
+ * \brief load_any loads the file and touches every byte of the waveform data, so reading past the mapping crashes the test
+ * \param file_size is the size of the file, the waveform data must fit in it after the smallest possible headers
+ * \return true if the file loaded, false if it was rejected with an exception the loader documents
+ */
+bool load_any(const fs::path& fp, std::size_t file_size)
+{
+    /* RIFF header, fmt chunk and data chunk header */
+    constexpr std::size_t MIN_HEADERS_SIZE = 12u + 8u + 16u + 8u;
+
+    try
+    {
+        loadio::WaveFile wav(fp.string());
+        PAC_CHECK(wav.data() != nullptr);
+        PAC_CHECK(wav.size() + MIN_HEADERS_SIZE <= file_size);
+        PAC_CHECK(wav.blockAlign() > 0u && wav.size() % wav.blockAlign() == 0u);
+
+        unsigned sum = 0u;
+        for (std::size_t i = 0u; i < wav.size(); ++i)
+        {
+            sum += wav.data()[i];
+        }
+        static_cast<void>(sum);
+        return true;
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+    catch (const std::invalid_argument&)
+    {
+    }
+    return false;
+}
+
+/*!
+ * \brief xorshift is a small deterministic random generator, so failing mutants can be reproduced
+ */
+uint32_t xorshift(uint32_t& state)
+{
+    state ^= state << 13u;
+    state ^= state >> 17u;
+    state ^= state << 5u;
+    return state;
+}
+}  // namespace
+
+PAC_TEST(wave_file, corpus_is_not_empty)
+{
+    const auto files = corpus_files();
+    PAC_CHECK(std::any_of(files.begin(), files.end(), [](auto& fp) { return starts_with(fp.filename().string(), "ok_"); }));
+    PAC_CHECK(std::any_of(files.begin(), files.end(), [](auto& fp) { return starts_with(fp.filename().string(), "bad_"); }));
+}
+
+PAC_TEST(wave_file, loads_good_seeds)
+{
+    for (const auto& fp : corpus_files())
+    {
+        if (!starts_with(fp.filename().string(), "ok_"))
+        {
+            continue;
+        }
+
+        try
+        {
+            loadio::WaveFile wav(fp.string());
+            bool matches = wav.size() > 0u && wav.size() % wav.blockAlign() == 0u;
+            for (std::size_t i = 0u; matches && i < wav.size(); ++i)
+            {
+                matches = wav.data()[i] == expected_byte(i);
+            }
+
+            if (!matches)
+            {
+                std::fprintf(stderr, "Waveform data of %s is wrong.\n", fp.filename().string().c_str());
+            }
+            PAC_CHECK(matches);
+        }
+        catch (const std::exception& e)
+        {
+            std::fprintf(stderr, "%s was rejected: %s\n", fp.filename().string().c_str(), e.what());
+            PAC_CHECK(false);
+        }
+    }
+}
+
+PAC_TEST(wave_file, rejects_bad_seeds)
+{
+    for (const auto& fp : corpus_files())
+    {
+        if (!starts_with(fp.filename().string(), "bad_"))
+        {
+            continue;
+        }
+
+        bool rejected = false;
+        try
+        {
+            loadio::WaveFile wav(fp.string());
+        }
+        catch (const std::runtime_error&)
+        {
+            rejected = true;
+        }
+
+        if (!rejected)
+        {
+            std::fprintf(stderr, "%s was not rejected.\n", fp.filename().string().c_str());
+        }
+        PAC_CHECK(rejected);
+    }
+}
+
+PAC_TEST(wave_file, formats_of_good_seeds)
+{
+    const auto dir = fs::path(PAC_TEST_CORPUS_DIR) / "wav";
+
+    loadio::WaveFile stereo((dir / "ok_pcm16_stereo.wav").string());
+    PAC_CHECK(stereo.channels() == 2u && stereo.bitsPerSample() == 16u && stereo.frequency() == 22050u);
+    PAC_CHECK(stereo.getALformat() == AL_FORMAT_STEREO16 && stereo.size() == 64u);
+
+    loadio::WaveFile mono((dir / "ok_pcm8_mono.wav").string());
+    PAC_CHECK(mono.getALformat() == AL_FORMAT_MONO8 && mono.size() == 33u);
+
+    loadio::WaveFile extensible((dir / "ok_extensible_pcm16.wav").string());
+    PAC_CHECK(!extensible.isFloat() && extensible.getALformat() == AL_FORMAT_STEREO16);
+
+    loadio::WaveFile extensible_float((dir / "ok_extensible_float.wav").string());
+    PAC_CHECK(extensible_float.isFloat() && extensible_float.bitsPerSample() == 32u);
+
+    /* The data chunk claims 4096 bytes but only 61 are in the file, which is 15 whole frames */
+    loadio::WaveFile truncated((dir / "ok_truncated_data.wav").string());
+    PAC_CHECK(truncated.size() == 60u);
+}
+
+PAC_TEST(wave_file, survives_truncation)
+{
+    const auto fp = fs::temp_directory_path() / "pacman_wave_file_truncated.wav";
+    for (const auto& seed_fp : corpus_files())
+    {
+        const auto seed = read_bytes(seed_fp);
+        for (std::size_t length = 0u; length <= seed.size(); ++length)
+        {
+            write_bytes(fp, std::vector<uint8_t>(seed.begin(), seed.begin() + static_cast<std::ptrdiff_t>(length)));
+            load_any(fp, length);
+        }
+    }
+    fs::remove(fp);
+}
+
+PAC_TEST(wave_file, survives_mutation)
+{
+    const auto fp = fs::temp_directory_path() / "pacman_wave_file_mutant.wav";
+    uint32_t state = 0x9E3779B9u;
+    for (const auto& seed_fp : corpus_files())
+    {
+        const auto seed = read_bytes(seed_fp);
+        if (seed.empty())
+        {
+            continue;
+        }
+
+        for (unsigned mutant = 0u; mutant < MUTANTS_PER_SEED; ++mutant)
+        {
+            /* Chunk sizes are the interesting bytes, so half of the mutations set a byte to 0x00 or 0xFF */
+            auto bytes = seed;
+            const auto changes = 1u + xorshift(state) % MAX_MUTATED_BYTES;
+            for (unsigned i = 0u; i < changes; ++i)
+            {
+                const auto value = xorshift(state);
+                auto& byte = bytes[xorshift(state) % bytes.size()];
+                byte = (value & 1u) ? static_cast<uint8_t>(value >> 8u) : ((value & 2u) ? 0xFFu : 0x00u);
+            }
+            write_bytes(fp, bytes);
+            load_any(fp, bytes.size());
+        }
+    }
+    fs::remove(fp);
+}